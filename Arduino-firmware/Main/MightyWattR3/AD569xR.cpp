@@ -10,8 +10,9 @@
 
 /* <Includes> */ 
 
+#include "HAL.h"
 #include "AD569xR.h"
-#include <Wire.h>
+#include "I2CDMA.h"
 
 /* </Includes> */ 
 
@@ -26,11 +27,22 @@ static ErrorMessaging_Error AD569xRError;
 /* <Declarations (prototypes)> */ 
 
 /**
- * Sends a 16-bit word to AD569xR
+ * Sends a 16-bit word to AD569xR, waits for a transfer on the bus
  * 
  * @param data - Payload
+ *
+ * @return - true if the DAC acknowledged the transfer
+ */
+bool AD569xR_Send(uint8_t command, uint16_t data);
+
+/**
+ * Writes a 16-bit word to AD569xR
+ * 
+ * @param data - Payload
+ *
+ * @return - true if the DAC acknowledged the transfer
  */
-void AD569xR_Send(uint8_t command, uint16_t data);
+static bool AD569xR_Write(uint8_t command, uint16_t data);
 
 /* </Declarations (prototypes)> */ 
 
@@ -49,25 +61,39 @@ bool AD569xR_Set(uint16_t value)
 {
   if (value <= AD569xR_MAXIMUM_VALUE)
   {
-    AD569xR_Send(AD569xR_WRITE_DAC_AND_INPUT_REGISTERS, value); 
-    return true;
+    return AD569xR_Send(AD569xR_WRITE_DAC_AND_INPUT_REGISTERS, value); 
   }
   else
   {
     AD569xR_Send(AD569xR_WRITE_DAC_AND_INPUT_REGISTERS, AD569xR_MAXIMUM_VALUE); 
-    AD569xRError.errorCounter++;
-    AD569xRError.error = ErrorMessaging_AD569xR_Overload;
+    ErrorMessaging_Raise(&AD569xRError, ErrorMessaging_AD569xR_Overload);
     return false;
   }
 }
 
-void AD569xR_Send(uint8_t command, uint16_t data)
+bool AD569xR_SetFromTimer(uint16_t value)
+{
+  #ifdef ZERO
+    if (I2CDMA_GetState() == I2CDMA_Busy) /* Not waited for in the interrupt, the transfers keep clear of the callbacks (HAL_I2CReserve) */
+    {
+      return false;
+    }
+  #endif
+  return AD569xR_Write(AD569xR_WRITE_DAC_AND_INPUT_REGISTERS, value);
+}
+
+bool AD569xR_Send(uint8_t command, uint16_t data)
+{
+  #ifdef ZERO
+    I2CDMA_Wait(); /* The DAC shares the bus with the ADC transfers */
+  #endif
+  return AD569xR_Write(command, data);
+}
+
+static bool AD569xR_Write(uint8_t command, uint16_t data)
 {
-  Wire.beginTransmission(AD569xR_ADDRESS);  
-  Wire.write(command & 0xFF);
-  Wire.write((data >> 8) & 0xFF); /* MSB first */
-  Wire.write(data & 0xFF);
-  Wire.endTransmission();
+  const uint8_t message[3] = {(uint8_t)(command & 0xFF), (uint8_t)((data >> 8) & 0xFF), (uint8_t)(data & 0xFF)}; /* MSB first */
+  return HAL_I2CWrite(AD569xR_ADDRESS, message, sizeof(message));
 }
 
 const ErrorMessaging_Error * AD569xR_GetError(void)
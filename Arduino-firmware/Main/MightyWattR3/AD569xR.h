@@ -46,6 +46,15 @@ void AD569xR_Init(void);
  * @return - true if command succeeded, false otherwise
  */
 bool AD569xR_Set(uint16_t value);
+
+/**
+ * Sets a raw value to the DAC from the timer callback, does not wait for a transfer on the bus
+ *
+ * @param value - Value to set to the DAC
+ * 
+ * @return - true if command succeeded, false if the bus is busy or the DAC did not acknowledge
+ */
+bool AD569xR_SetFromTimer(uint16_t value);
  
 /**
  * Returns error structure for this module
@@ -10,8 +10,10 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "ADC.h"
+#include "EventBus.h"
+#include "Latency.h"
 
 /* </Includes> */ 
 
@@ -23,15 +25,25 @@ static bool ChannelIsFiltered[ADC_CHANNEL_COUNT];
 static uint8_t ChannelSkipRatio[ADC_CHANNEL_COUNT];
 static uint16_t ChannelCycleCounter[ADC_CHANNEL_COUNT];
 static uint32_t LastUpdate;
+static uint32_t ConversionStart; /* us, start of the conversion in progress */
+static bool ChannelIsBlanked[ADC_CHANNEL_COUNT];
+static uint32_t BlankingEnd[ADC_CHANNEL_COUNT]; /* us, conversions started before are dropped */
 static TSCADCLong Voltages[ADC_CHANNEL_COUNT];
 static ErrorMessaging_Error ADCError[ADC_CHANNEL_COUNT];
-static int32_t VoltageFilterData[ADC_V_CHANNEL_FILTER_SIZE],
+/* Filters keep raw 16-bit results with the range stored separately, the voltage is scaled back when needed */
+static int16_t VoltageFilterData[ADC_V_CHANNEL_FILTER_SIZE],
                CurrentFilterData[ADC_I_CHANNEL_FILTER_SIZE],
                TemperatureFilterData[ADC_T_CHANNEL_FILTER_SIZE];
-static ADC_TriangleFilterData VoltageFilter = {ADC_V_CHANNEL_FILTER_SIZE, VoltageFilterData, 0, 0, 0, false };
-static ADC_TriangleFilterData CurrentFilter = {ADC_I_CHANNEL_FILTER_SIZE, CurrentFilterData, 0, 0, 0, false };
-static ADC_TriangleFilterData TemperatureFilter = {ADC_T_CHANNEL_FILTER_SIZE, TemperatureFilterData, 0, 0, 0, false };
-static ADC_TriangleFilterData Filters[ADC_CHANNEL_COUNT] = {VoltageFilter, CurrentFilter, TemperatureFilter};
+static uint8_t VoltageFilterRanges[ADC_FILTER_RANGES_SIZE(ADC_V_CHANNEL_FILTER_SIZE)],
+               CurrentFilterRanges[ADC_FILTER_RANGES_SIZE(ADC_I_CHANNEL_FILTER_SIZE)],
+               TemperatureFilterRanges[ADC_FILTER_RANGES_SIZE(ADC_T_CHANNEL_FILTER_SIZE)];
+static ADC_TriangleFilterData Filters[ADC_CHANNEL_COUNT] = 
+{
+  {ADC_V_CHANNEL_FILTER_SIZE, VoltageFilterData, VoltageFilterRanges, 0, 0, 0, false},
+  {ADC_I_CHANNEL_FILTER_SIZE, CurrentFilterData, CurrentFilterRanges, 0, 0, 0, false},
+  {ADC_T_CHANNEL_FILTER_SIZE, TemperatureFilterData, TemperatureFilterRanges, 0, 0, 0, false}
+};
+static const EventBus_Events ChannelEvents[ADC_CHANNEL_COUNT] = {Event_ADC_V, Event_ADC_I, Event_ADC_T};
 
 /* </Module variables> */ 
 
@@ -41,10 +53,21 @@ static ADC_TriangleFilterData Filters[ADC_CHANNEL_COUNT] = {VoltageFilter, Curre
 /**
  * Adds a value to the triangle filter
  * 
- * @param value - new value to add
+ * @param rawResult - new raw ADC result to add
+ * @param range - range of the ADC result
  * @param filter - pointer to triangle filter data
  */
-void TriangleFilter_Add(int32_t value, ADC_TriangleFilterData * filter);
+void TriangleFilter_Add(int16_t rawResult, ADS1x15_Ranges range, ADC_TriangleFilterData * filter);
+
+/**
+ * Gets a stored sample as voltage
+ * 
+ * @param filter - pointer to triangle filter data
+ * @param index - index of the sample
+ *
+ * @return - voltage of the sample
+ */
+static int32_t TriangleFilter_GetSample(const ADC_TriangleFilterData * filter, int16_t index);
 
 /**
  * Gets filtered value with triangle-weighted filter
@@ -106,6 +129,10 @@ void ADC_Init(void)
   ChannelCycleCounter[ADC_V] = 0;
   ChannelCycleCounter[ADC_I] = 0;
   ChannelCycleCounter[ADC_T] = 0;
+
+  ChannelIsBlanked[ADC_V] = false;
+  ChannelIsBlanked[ADC_I] = false;
+  ChannelIsBlanked[ADC_T] = false;
   
   int16_t i;
   for (i = 0; i < ADC_CHANNEL_COUNT; i++)
@@ -120,7 +147,8 @@ void ADC_Init(void)
   
   ADS1x15_Init();
   ADS1x15_StartConversion(ChannelSettings[0]); /* Start conversion of the first channel */
-  LastUpdate = millis();  
+  ConversionStart = HAL_Microseconds();
+  LastUpdate = HAL_Milliseconds();  
 }
 
 void ADC_Do(void) /* Call periodically */
@@ -133,36 +161,46 @@ void ADC_Do(void) /* Call periodically */
   {
     repeatedConversion = false;
     rawResult = ADS1x15_GetRawResult();    
-    int32_t result = ADS1x15_Voltage(rawResult, ChannelSettings[i].range); /* Get the new voltage */     
-    if ((result > ADC_ABSOLUTEMAXIMUM) || (result < -ADC_ABSOLUTEMAXIMUM))
+    #ifdef LATENCY_ENABLED
+      Latency_Probe(Probe_SampleConverted);
+    #endif
+    if (ChannelIsBlanked[i] && ((int32_t)(ConversionStart - BlankingEnd[i]) >= 0))
     {
-      /* ADC negative or positive overload */
-      ADCError[i].errorCounter++;
-      ADCError[i].error = ErrorMessaging_ADC_Overload;      
+      ChannelIsBlanked[i] = false; /* The conversion started after the input settled */
     }
-    TriangleFilter_Add(result, &Filters[i]);
-    Voltages[i].unfilteredValue = TriangleFilter_GetUnfilteredValue(&Filters[i]);
-    if (ChannelIsFiltered[i])
-    {
-      Voltages[i].value = TriangleFilter_GetValue(&Filters[i]);
-    }
-    else
+    if (!ChannelIsBlanked[i]) /* A blanked result is dropped, the range of the channel is kept */
     {
-      Voltages[i].value = Voltages[i].unfilteredValue;
-    }
+      int32_t result = ADS1x15_Voltage(rawResult, ChannelSettings[i].range); /* Get the new voltage */     
+      if ((result > ADC_ABSOLUTEMAXIMUM) || (result < -ADC_ABSOLUTEMAXIMUM))
+      {
+        /* ADC negative or positive overload */
+        ErrorMessaging_Raise(&ADCError[i], ErrorMessaging_ADC_Overload);      
+      }
+      TriangleFilter_Add(rawResult, ChannelSettings[i].range, &Filters[i]);
+      Voltages[i].unfilteredValue = TriangleFilter_GetUnfilteredValue(&Filters[i]);
+      if (ChannelIsFiltered[i])
+      {
+        Voltages[i].value = TriangleFilter_GetValue(&Filters[i]);
+      }
+      else
+      {
+        Voltages[i].value = Voltages[i].unfilteredValue;
+      }
     
-    Voltages[i].milliseconds = millis();
-    Voltages[i].counter++;    
+      Voltages[i].milliseconds = HAL_Milliseconds();
+      Voltages[i].counter++;    
+      EventBus_Publish(ChannelEvents[i]);
 
-    if (ChannelSettings[i].autorange) /* Autoranging, if enabled */
-    {
-      ADS1x15_AutoRange(rawResult, &(ChannelSettings[i].range));
-    }
-    else /* Default range, if autoranging is disabled */
-    {
-      ChannelSettings[i].range = ADC_DEFAULT_RANGE;
+      if (ChannelSettings[i].autorange) /* Autoranging, if enabled */
+      {
+        ADS1x15_AutoRange(rawResult, &(ChannelSettings[i].range));
+      }
+      else /* Default range, if autoranging is disabled */
+      {
+        ChannelSettings[i].range = ADC_DEFAULT_RANGE;
+      }
     }
-    LastUpdate = millis();
+    LastUpdate = HAL_Milliseconds();
 
     do
     {      
@@ -183,21 +221,22 @@ void ADC_Do(void) /* Call periodically */
     } while ((ChannelCycleCounter[i] & ((1U << ChannelSkipRatio[i])) - 1U) > 0); /* Channel skipping */
     
     ADS1x15_StartConversion(ChannelSettings[i]); /* Start converting the next channel */    
+    ConversionStart = HAL_Microseconds();
   }
   
-  if ((millis() - LastUpdate) > ADC_TIMEOUT)
+  if ((HAL_Milliseconds() - LastUpdate) > ADC_TIMEOUT)
   {
     if (repeatedConversion == false)
     {
       repeatedConversion = true;
-      LastUpdate = millis();
+      LastUpdate = HAL_Milliseconds();
       ADS1x15_StartConversion(ChannelSettings[i]); /* Try repeating the last conversion */  
+      ConversionStart = HAL_Microseconds();
     }
     else
     {
       /* Error: ADC not responding */
-      ADCError[i].errorCounter++;
-      ADCError[i].error = ErrorMessaging_ADC_NotResponding;
+      ErrorMessaging_Raise(&ADCError[i], ErrorMessaging_ADC_NotResponding);
       repeatedConversion = false;
     }
   }
@@ -210,6 +249,16 @@ void ADC_SetupChannel(ADC_Channels adcChannel, ADC_RateRangingFilter rateRanging
   ChannelIsFiltered[adcChannel] = rateRangingFilter.filter;
 }
 
+void ADC_Blank(ADC_Channels adcChannel)
+{
+  BlankingEnd[adcChannel] = HAL_Microseconds() + ADC_BLANKING_TIME;
+  ChannelIsBlanked[adcChannel] = true;
+  if (ChannelSettings[adcChannel].autorange)
+  {
+    ChannelSettings[adcChannel].range = ADC_DEFAULT_RANGE; /* The new gain may overload the present range, autoranging starts over */
+  }
+}
+
 const TSCADCLong * ADC_GetVoltage(ADC_Channels adcChannel)
 {
   return &(Voltages[adcChannel]);
@@ -220,11 +269,23 @@ const ErrorMessaging_Error * ADC_GetError(ADC_Channels adcChannel)
   return &(ADCError[adcChannel]);
 }
 
-void TriangleFilter_Add(int32_t value, ADC_TriangleFilterData * filter)
+void TriangleFilter_Add(int16_t rawResult, ADS1x15_Ranges range, ADC_TriangleFilterData * filter)
 {
+  int32_t value = ADS1x15_Voltage(rawResult, range);
+  uint8_t * rangeByte = &(filter->ranges)[filter->index / 2];
+  uint8_t rangeBits = (uint8_t)(range >> 9); /* PGA bits of the configuration register */
+
   filter->triangleSum -= filter->sum;
-  filter->sum -= (filter->data)[filter->index];
-  (filter->data)[filter->index] = value;
+  filter->sum -= TriangleFilter_GetSample(filter, filter->index);
+  (filter->data)[filter->index] = rawResult;
+  if (filter->index & 1)
+  {
+    *rangeByte = (*rangeByte & 0x0F) | (rangeBits << 4);
+  }
+  else
+  {
+    *rangeByte = (*rangeByte & 0xF0) | rangeBits;
+  }
   filter->triangleSum += value * (int32_t)(filter->filterSize);
   filter->sum += value;
   
@@ -253,12 +314,22 @@ int32_t TriangleFilter_GetUnfilteredValue(ADC_TriangleFilterData * filter)
 {
   if (filter->index > 0)
   {
-    return (filter->data)[filter->index - 1];
+    return TriangleFilter_GetSample(filter, filter->index - 1);
   }
   else
   {
-    return (filter->data)[filter->filterSize - 1];
+    return TriangleFilter_GetSample(filter, filter->filterSize - 1);
+  }
+}
+
+static int32_t TriangleFilter_GetSample(const ADC_TriangleFilterData * filter, int16_t index)
+{
+  uint8_t rangeBits = (filter->ranges)[index / 2];
+  if (index & 1)
+  {
+    rangeBits >>= 4;
   }
+  return ADS1x15_Voltage((filter->data)[index], (ADS1x15_Ranges)((uint16_t)(rangeBits & 0x0F) << 9));
 }
 
 /* </Implementations> */ 
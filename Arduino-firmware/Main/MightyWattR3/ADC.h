@@ -27,6 +27,7 @@
 #define ADC_ABSOLUTEMAXIMUM          (ADC_RECIPROCAL_LSB * 3125L) /* 3125 mV */
 #define ADC_DEFAULT_RANGE            ADS1x15_PGA4096
 #define ADC_RECIPROCAL_LSB           128L /* mV^-1 */
+#define ADC_BLANKING_TIME            20U /* us, settling of the sense amplifiers after a change of their gain */
 //#define ADC_REFERENCE_VOLTAGE        ADS1x15_REFERENCE_VOLTAGE
 
 /* Mapping of ADC channels to physical channels */
@@ -38,6 +39,7 @@
 #define ADC_V_CHANNEL_FILTER_SIZE    42
 #define ADC_I_CHANNEL_FILTER_SIZE    42
 #define ADC_T_CHANNEL_FILTER_SIZE    1
+#define ADC_FILTER_RANGES_SIZE(x)    (((x) + 1) / 2) /* Bytes needed for the ranges of x samples, two ranges per byte */
 
 /* ADC cycle skipping */
 #define ADC_V_CHANNEL_SKIP_RATIO     0  /* No ADC cycle skipping */
@@ -74,7 +76,8 @@ struct ADC_RateRangingFilter
 struct ADC_TriangleFilterData
 {
   const uint16_t filterSize;
-  int32_t * data;
+  int16_t * data; /* Raw ADC results */
+  uint8_t * ranges; /* Ranges of the raw results (PGA bits), 4 bits per sample */
   int16_t index;
   int32_t sum;
   int32_t triangleSum;
@@ -105,6 +108,15 @@ void ADC_Do(void);
  */
 void ADC_SetupChannel(ADC_Channels adcChannel, ADC_RateRangingFilter rateRangingFilter);
 
+/**
+ * Drops the results of a channel whose conversion started before the input settles
+ * The conversion in progress and any that starts within ADC_BLANKING_TIME are neither filtered nor published,
+ * the next one starts on the default range, the other channels are not affected
+ *
+ * @param adcChannel - ADC channel whose input has changed
+ */
+void ADC_Blank(ADC_Channels adcChannel);
+
 /**
  * Return a constant pointer to the last measured voltage for a given channel
  *
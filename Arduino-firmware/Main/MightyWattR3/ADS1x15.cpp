@@ -10,9 +10,10 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "ADS1x15.h"
-#include <Wire.h>
+#include "FastPin.h"
+#include "I2CDMA.h"
 
 /* </Includes> */ 
 
@@ -22,6 +23,21 @@
 static bool conversionReady = false;
 static ErrorMessaging_Error ADS1x15Error;
 
+#ifdef ZERO
+/**
+ * Phases of the non-blocking conversion cycle on ZERO, each phase is one DMA transfer
+ */
+enum ADS1x15_Phases : uint8_t
+{
+  ADS1x15_PhaseIdle, /* No conversion started or a transfer has failed */
+  ADS1x15_PhaseWritingConfig, /* Config register write starts the conversion */
+  ADS1x15_PhaseWritingPointer, /* Pointer set back to the conversion register so that the result can be read without a pointer write */
+  ADS1x15_PhaseConverting, /* Waiting for the ALERT/RDY pin */
+  ADS1x15_PhaseReading /* Result read in progress */
+};
+static ADS1x15_Phases phase = ADS1x15_PhaseIdle;
+#endif
+
 /* </Module variables> */ 
 
 
@@ -50,7 +66,11 @@ uint16_t ADS1x15_Read(ADS1x15_Registers reg);
 
 void ADS1x15_Init(void)
 {
-  pinMode(ADS1x15_READY_PIN, INPUT);
+  HAL_PinMode(ADS1x15_READY_PIN, HAL_Input);
+  #ifdef ZERO
+    I2CDMA_Init();
+    phase = ADS1x15_PhaseIdle;
+  #endif
   ADS1x15_Send(ADS1x15_HiThresholdRegister, ADS1x15_HI_THRESH);
   ADS1x15_Send(ADS1x15_LoThresholdRegister, ADS1x15_LO_THRESH);  
   ADS1x15Error.errorCounter = 0;
@@ -60,15 +80,64 @@ void ADS1x15_Init(void)
 void ADS1x15_StartConversion(ADS1x15_ChannelSetting channelSetting)
 { 
   conversionReady = false;
-  ADS1x15_Send(ADS1x15_ConfigRegister, channelSetting.range | channelSetting.input | channelSetting.dataRate | ADS1x15_OS_BEGIN_CONVERSION | ADS1x15_MODE_SINGLE_SHOT | ADS1x15_COMP_LAT_LATCHING | ADS1x15_COMP_MODE_WINDOW);
+  uint16_t config = channelSetting.range | channelSetting.input | channelSetting.dataRate | ADS1x15_OS_BEGIN_CONVERSION | ADS1x15_MODE_SINGLE_SHOT | ADS1x15_COMP_LAT_LATCHING | ADS1x15_COMP_MODE_WINDOW;
+  #ifdef ZERO
+    const uint8_t message[3] = {ADS1x15_ConfigRegister, (uint8_t)(config >> 8), (uint8_t)(config & 0xFF)}; /* MSB first */
+    if (I2CDMA_GetState() == I2CDMA_Busy)
+    {
+      I2CDMA_Abort(); /* Repeated conversion after timeout */
+    }
+    phase = I2CDMA_Write(ADS1x15_ADDRESS, message, sizeof(message)) ? ADS1x15_PhaseWritingConfig : ADS1x15_PhaseIdle;
+  #else
+    ADS1x15_Send(ADS1x15_ConfigRegister, config);
+  #endif
 }
 
 bool ADS1x15_ConversionReady(void)
 {
-  if (!conversionReady)
-  {    
-    conversionReady = (digitalRead(ADS1x15_READY_PIN) == LOW);
-  }
+  #ifdef ZERO
+    /* Advance the conversion cycle, the CPU only starts the transfers */
+    if (!conversionReady)
+    {
+      I2CDMA_States transferState = I2CDMA_GetState();
+      if (transferState == I2CDMA_Error)
+      {
+        phase = ADS1x15_PhaseIdle; /* ADC timeout will repeat the conversion */
+      }
+      else if (transferState == I2CDMA_Idle)
+      {
+        switch (phase)
+        {
+          case ADS1x15_PhaseWritingConfig:
+          {
+            const uint8_t pointer = ADS1x15_ConversionRegister;
+            phase = I2CDMA_Write(ADS1x15_ADDRESS, &pointer, 1) ? ADS1x15_PhaseWritingPointer : ADS1x15_PhaseIdle;
+            break;
+          }
+          case ADS1x15_PhaseWritingPointer:
+            phase = ADS1x15_PhaseConverting;
+            /* falls through, the conversion may be ready already */
+          case ADS1x15_PhaseConverting:
+            if (!FastPin<ADS1x15_READY_PIN>::Read()) /* ALERT/RDY is active low */
+            {
+              phase = I2CDMA_Read(ADS1x15_ADDRESS, 2) ? ADS1x15_PhaseReading : ADS1x15_PhaseIdle;
+            }
+            break;
+          case ADS1x15_PhaseReading:
+            phase = ADS1x15_PhaseIdle;
+            conversionReady = true;
+            break;
+          default:
+            break;
+        }
+      }
+    }
+  #else
+    if (!conversionReady)
+    {    
+      conversionReady = !FastPin<ADS1x15_READY_PIN>::Read(); /* ALERT/RDY is active low */
+    }
+  #endif
   return conversionReady;
 }
 
@@ -78,13 +147,17 @@ int16_t ADS1x15_GetRawResult(void)
   if (conversionReady) /* update raw result if conversion ready */
   {
     conversionReady = false; 
-    rawResult = (int16_t)ADS1x15_Read(ADS1x15_ConversionRegister);
+    #ifdef ZERO
+      const uint8_t * data = I2CDMA_GetData(); /* Read by DMA in ADS1x15_ConversionReady */
+      rawResult = (int16_t)(((uint16_t)data[0] << 8) | data[1]); /* MSB first */
+    #else
+      rawResult = (int16_t)ADS1x15_Read(ADS1x15_ConversionRegister);
+    #endif
   }
   else
   {
     /* Requested result but ADC is not ready */
-    ADS1x15Error.errorCounter++;
-    ADS1x15Error.error = ErrorMessaging_ADS1x15_ResultNotReady;    
+    ErrorMessaging_Raise(&ADS1x15Error, ErrorMessaging_ADS1x15_ResultNotReady);    
   }
   return rawResult; /* Result is left-aligned */
 }
@@ -171,27 +244,26 @@ void ADS1x15_AutoRange(int16_t rawResult, ADS1x15_Ranges * range)
 
 void ADS1x15_Send(ADS1x15_Registers reg, uint16_t data)
 {
-  Wire.beginTransmission(ADS1x15_ADDRESS);  
-  Wire.write(reg & 0xFF);
-  Wire.write((data >> 8) & 0xFF); /* MSB first */
-  Wire.write(data & 0xFF); 
-  Wire.endTransmission();
+  #ifdef ZERO
+    I2CDMA_Wait();
+  #endif
+  const uint8_t message[3] = {(uint8_t)(reg & 0xFF), (uint8_t)((data >> 8) & 0xFF), (uint8_t)(data & 0xFF)}; /* MSB first */
+  HAL_I2CWrite(ADS1x15_ADDRESS, message, sizeof(message));
 }
 
 uint16_t ADS1x15_Read(ADS1x15_Registers reg)
 {
+  #ifdef ZERO
+    I2CDMA_Wait();
+  #endif
   /* set read register */
-  Wire.beginTransmission(ADS1x15_ADDRESS);
-  Wire.write(reg & 0xFF);
-  Wire.endTransmission();
+  const uint8_t pointer = reg & 0xFF;
+  HAL_I2CWrite(ADS1x15_ADDRESS, &pointer, 1);
 
   /* read from the register */
-  Wire.requestFrom(ADS1x15_ADDRESS, 2);
-  while(Wire.available() == 0) {}
-  uint16_t value;
-  value = (Wire.read() << 8); /* MSB first */
-  value |= Wire.read();
-  return value;
+  uint8_t data[2] = {0, 0};
+  HAL_I2CRead(ADS1x15_ADDRESS, data, sizeof(data));
+  return ((uint16_t)data[0] << 8) | data[1]; /* MSB first */
 }
 
 const ErrorMessaging_Error * ADS1x15_GetError(void)
@@ -9,13 +9,14 @@
  
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Ammeter.h"
 #include "ADC.h"
 #include "Configuration.h"
 #include "DACC.h"
 #include "RangeSwitcher.h"
 #include "Control.h"
+#include "EventBus.h"
 
 /* </Includes> */ 
 
@@ -24,7 +25,8 @@
 
 static const TSCADCLong * ADCRaw;
 static TSCADCULong current; /* contains current in microamps */
-static uint8_t adcCounter, adcErrorCounter;
+static EventBus_Subscription adcSubscription; /* New raw current from ADC */
+static uint8_t adcErrorCounter;
 static ErrorMessaging_Error AmmeterError;
 const static ErrorMessaging_Error * ADCError;
 
@@ -37,7 +39,7 @@ void Ammeter_Init(void)
 { 
   Ammeter_SetSpeed(AMMETER_DEFAULT_MEASUREMENT_SPEED);
   ADCRaw = ADC_GetVoltage(ADC_I);
-  adcCounter = ADCRaw->counter;
+  EventBus_Subscribe(&adcSubscription, Event_ADC_I);
   current.value = 0;
   current.unfilteredValue = 0;
   current.counter = 0;
@@ -53,9 +55,8 @@ void Ammeter_Do(void)
   int32_t signedCurrent, signedUnfilteredCurrent;    
   RangeSwitcher_CurrentRanges range = RangeSwitcher_GetCurrentRange();
   
-  if (adcCounter != ADCRaw->counter) /* Process only new reading from ADC */
+  if (EventBus_Take(&adcSubscription)) /* Process only new reading from ADC */
   {      
-    adcCounter = ADCRaw->counter;
     /* Finite state machine for hardware autoranging */
     switch (range)
     {
@@ -65,8 +66,7 @@ void Ammeter_Do(void)
           adcErrorCounter = ADCError->errorCounter;
           if (ADCError->error == ErrorMessaging_ADC_Overload)
           {
-              AmmeterError.errorCounter++;
-              AmmeterError.error = ErrorMessaging_Ammeter_CurrentOverload;
+              ErrorMessaging_Raise(&AmmeterError, ErrorMessaging_Ammeter_CurrentOverload);
           }          
         }        
             
@@ -96,8 +96,7 @@ void Ammeter_Do(void)
     if (signedUnfilteredCurrent < AMMETER_MINIMUM_CURRENT)
     {
       /* Signal negative current */
-      AmmeterError.errorCounter++;      
-      AmmeterError.error = ErrorMessaging_Ammeter_NegativeCurrent;
+      ErrorMessaging_Raise(&AmmeterError, ErrorMessaging_Ammeter_NegativeCurrent);
     }
     
     if (signedCurrent < 0)
@@ -133,10 +132,16 @@ void Ammeter_Do(void)
     }
 
     current.counter++;
-    current.milliseconds = millis();
+    current.milliseconds = HAL_Milliseconds();
+    EventBus_Publish(Event_Ammeter);
   }
 }
 
+bool Ammeter_DataReady(void)
+{
+  return EventBus_Pending(&adcSubscription);
+}
+
 void Ammeter_SetSpeed(Measurement_Speeds msp)
 {
   ADC_SetupChannel(ADC_I, Measurement_Speed[msp]);  
@@ -49,6 +49,14 @@ void Ammeter_Init(void);
  */
 void Ammeter_Do(void);
 
+/**
+ * Returns whether a new ADC reading is waiting to be processed
+ * Used as data-ready trigger by the scheduler
+ *
+ * @return - true if there is a new ADC reading
+ */
+bool Ammeter_DataReady(void);
+
 /**
  * Sets the measurement speed of the ammeter ADC
  *
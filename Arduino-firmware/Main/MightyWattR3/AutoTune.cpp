@@ -0,0 +1,354 @@
+/**
+ * AutoTune.cpp
+ * Identification of the source for the software-controlled modes
+ *
+ * 2018-02-27
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "AutoTune.h"
+#include "Configuration.h"
+#include "DACC.h"
+#include "Ammeter.h"
+#include "Voltmeter.h"
+#include "CurrentSetter.h"
+#include "VoltageSetter.h"
+#include "RangeSwitcher.h"
+#include "Measurement.h"
+#include "EventBus.h"
+
+/* </Includes> */
+
+
+/* <Enums> */
+
+enum AutoTune_Stages : uint8_t
+{
+  AutoTuneStage_Idle,
+  AutoTuneStage_Baseline, /* Averaging the operating point */
+  AutoTuneStage_Step, /* Averaging the response to the step */
+  AutoTuneStage_Return /* Waiting for half of the response after the return to the operating point */
+};
+
+/* </Enums> */
+
+
+/* <Module variables> */
+
+static AutoTune_Result result;
+static AutoTune_Stages stage = AutoTuneStage_Idle;
+static const Measurement_Values * measurementValues;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+static uint8_t sampleCount; /* Measurements processed in this stage */
+static uint32_t stageTime; /* ms, start of the stage */
+static uint32_t voltageSum, currentSum;
+static uint32_t setValue; /* Setter value of the operating point, uA in CC phase, uV in CV phase */
+static uint32_t stepLimit; /* Largest step */
+static uint32_t responseTarget; /* Response that ends the growth of the step, uV in CC phase, uA in CV phase */
+static uint32_t stepVoltage, stepCurrent; /* Averaged response to the last step */
+static bool lowerCurrent; /* Direction of the step, towards a lower current of the source when there is enough of it */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Starts a stage
+ *
+ * @param newStage - stage to start
+ */
+static void AutoTune_SetStage(AutoTune_Stages newStage);
+
+/**
+ * Adds the latest measurement to the averages of the stage
+ *
+ * @return - true when the averages are complete
+ */
+static bool AutoTune_Average(void);
+
+/**
+ * Sets the first step, its limit and the response target from the operating point
+ */
+static void AutoTune_Prepare(void);
+
+/**
+ * Sets the setter of the perturbed phase
+ *
+ * @param value - uA in CC phase, uV in CV phase
+ */
+static void AutoTune_Set(uint32_t value);
+
+/**
+ * Sets the operating point plus the present step in the direction of the identification
+ */
+static void AutoTune_Step(void);
+
+/**
+ * Computes the parameters from the identified source
+ */
+static void AutoTune_Compute(void);
+
+/**
+ * Returns to the operating point and ends the identification
+ *
+ * @param status - result of the identification
+ */
+static void AutoTune_Finish(AutoTune_Status status);
+
+/**
+ * Absolute difference of two unsigned values
+ *
+ * @return - |a - b|
+ */
+static uint32_t AutoTune_Difference(uint32_t a, uint32_t b);
+
+/**
+ * Limits a value to a closed interval
+ *
+ * @param value - value to limit
+ * @param minimum - lower limit
+ * @param maximum - upper limit
+ *
+ * @return - Limited value
+ */
+static uint32_t AutoTune_Limit(uint64_t value, uint32_t minimum, uint32_t maximum);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void AutoTune_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  result.status = AutoTune_NotTuned;
+  stage = AutoTuneStage_Idle;
+}
+
+void AutoTune_Do(void)
+{
+  if (stage == AutoTuneStage_Idle)
+  {
+    return;
+  }
+
+  if (HAL_Milliseconds() - stageTime > AUTOTUNE_TIMEOUT)
+  {
+    AutoTune_Finish(AutoTune_Failed);
+  }
+  else if (EventBus_Take(&measurementSubscription))
+  {
+    switch (stage)
+    {
+      case AutoTuneStage_Baseline:
+        if (AutoTune_Average())
+        {
+          result.voltage = voltageSum / AUTOTUNE_AVERAGE_MEASUREMENTS;
+          result.current = currentSum / AUTOTUNE_AVERAGE_MEASUREMENTS;
+          AutoTune_Prepare();
+          AutoTune_Step();
+        }
+      break;
+      case AutoTuneStage_Step:
+        if (AutoTune_Average())
+        {
+          stepVoltage = voltageSum / AUTOTUNE_AVERAGE_MEASUREMENTS;
+          stepCurrent = currentSum / AUTOTUNE_AVERAGE_MEASUREMENTS;
+          uint32_t response = (result.phase == Control_CCCV_CV) ? AutoTune_Difference(stepCurrent, result.current) : AutoTune_Difference(stepVoltage, result.voltage);
+          if ((response < responseTarget) && (result.perturbation < stepLimit))
+          {
+            result.perturbation = AutoTune_Limit(((uint64_t)result.perturbation) * 2, 0, stepLimit);
+            AutoTune_Step();
+          }
+          else if (AutoTune_Difference(stepCurrent, result.current) < AMMETER_THRESHOLD_VOLTAGE)
+          {
+            AutoTune_Finish(AutoTune_Failed); /* The current does not follow the step */
+          }
+          else
+          {
+            AutoTune_Set(setValue);
+            AutoTune_SetStage(AutoTuneStage_Return);
+          }
+        }
+      break;
+      case AutoTuneStage_Return:
+        if (AutoTune_Difference(measurementValues->unfilteredCurrent, result.current) * 2 <= AutoTune_Difference(stepCurrent, result.current))
+        {
+          result.delay = measurementValues->milliseconds - stageTime;
+          AutoTune_Compute();
+          AutoTune_Finish(AutoTune_Tuned);
+        }
+      break;
+      default:
+      break;
+    }
+  }
+
+  if (result.phase == Control_CCCV_CV)
+  {
+    VoltageSetter_Do();
+  }
+  else
+  {
+    CurrentSetter_Do();
+  }
+}
+
+void AutoTune_Start(void)
+{
+  result.phase = Control_GetCCCV();
+  if (result.phase == Control_CCCV_CC_SimpleAmmeter)
+  {
+    result.status = AutoTune_Failed; /* Nothing to control */
+    stage = AutoTuneStage_Idle;
+    return;
+  }
+  setValue = (result.phase == Control_CCCV_CV) ? VoltageSetter_GetVoltage() : CurrentSetter_GetCurrent();
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement); /* Only the measurements after the start */
+  result.status = AutoTune_Running;
+  AutoTune_SetStage(AutoTuneStage_Baseline);
+}
+
+void AutoTune_Cancel(void)
+{
+  if (stage != AutoTuneStage_Idle)
+  {
+    stage = AutoTuneStage_Idle;
+    result.status = AutoTune_Cancelled;
+  }
+}
+
+bool AutoTune_IsRunning(void)
+{
+  return stage != AutoTuneStage_Idle;
+}
+
+const AutoTune_Result * AutoTune_GetResult(void)
+{
+  return &result;
+}
+
+static void AutoTune_SetStage(AutoTune_Stages newStage)
+{
+  stage = newStage;
+  sampleCount = 0;
+  voltageSum = 0;
+  currentSum = 0;
+  stageTime = HAL_Milliseconds();
+}
+
+static bool AutoTune_Average(void)
+{
+  sampleCount++;
+  if (sampleCount > AUTOTUNE_SETTLE_MEASUREMENTS)
+  {
+    voltageSum += measurementValues->unfilteredVoltage;
+    currentSum += measurementValues->unfilteredCurrent;
+  }
+  return sampleCount >= AUTOTUNE_SETTLE_MEASUREMENTS + AUTOTUNE_AVERAGE_MEASUREMENTS;
+}
+
+static void AutoTune_Prepare(void)
+{
+  if (result.phase == Control_CCCV_CV)
+  {
+    bool highRange = RangeSwitcher_GetVoltageRange() == VoltageRange_HighVoltage;
+    result.perturbation = AUTOTUNE_FIRST_STEP * (highRange ? CONTROL_MINIMUM_HI_VOLTAGE_STEP : CONTROL_MINIMUM_LO_VOLTAGE_STEP);
+    responseTarget = AutoTune_Limit(result.current / AUTOTUNE_RESPONSE, AUTOTUNE_MINIMUM_CURRENT_RESPONSE, 0xFFFFFFFFUL);
+    lowerCurrent = (result.current / 4) >= responseTarget; /* A response twice the target still leaves current flowing */
+    stepLimit = AutoTune_Limit(result.voltage / AUTOTUNE_STEP_LIMIT, highRange ? CONTROL_PI_MINIMUM_HI_VOLTAGE_SCALE : CONTROL_PI_MINIMUM_LO_VOLTAGE_SCALE,
+                               lowerCurrent ? AutoTune_Difference(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1, setValue) : setValue);
+  }
+  else
+  {
+    bool highRange = RangeSwitcher_GetCurrentRange() == CurrentRange_HighCurrent;
+    result.perturbation = AUTOTUNE_FIRST_STEP * (highRange ? CONTROL_MINIMUM_HI_CURRENT_STEP : CONTROL_MINIMUM_LO_CURRENT_STEP);
+    responseTarget = AutoTune_Limit(result.voltage / AUTOTUNE_RESPONSE, AUTOTUNE_MINIMUM_VOLTAGE_RESPONSE, 0xFFFFFFFFUL);
+    stepLimit = AutoTune_Limit(result.current / AUTOTUNE_STEP_LIMIT, AUTOTUNE_MINIMUM_CURRENT_RESPONSE, 0xFFFFFFFFUL); /* The step must be seen by the ammeter */
+    lowerCurrent = setValue >= 2 * stepLimit;
+    if (!lowerCurrent && (stepLimit > AutoTune_Difference(CURRENT_SETTER_MAXIMUM_HICURRENT - 1, setValue)))
+    {
+      stepLimit = AutoTune_Difference(CURRENT_SETTER_MAXIMUM_HICURRENT - 1, setValue);
+    }
+  }
+  if (result.perturbation > stepLimit)
+  {
+    result.perturbation = stepLimit;
+  }
+}
+
+static void AutoTune_Set(uint32_t value)
+{
+  if (result.phase == Control_CCCV_CV)
+  {
+    VoltageSetter_SetVoltage(value);
+  }
+  else
+  {
+    CurrentSetter_SetCurrent(value);
+  }
+}
+
+static void AutoTune_Step(void)
+{
+  if ((result.phase == Control_CCCV_CV) == lowerCurrent)
+  {
+    AutoTune_Set(setValue + result.perturbation); /* Higher voltage in CV phase, higher current in CC phase */
+  }
+  else
+  {
+    AutoTune_Set(setValue - result.perturbation);
+  }
+  AutoTune_SetStage(AutoTuneStage_Step);
+}
+
+static void AutoTune_Compute(void)
+{
+  result.sourceResistance = (uint32_t)((((uint64_t)AutoTune_Difference(stepVoltage, result.voltage)) * 1000) / AutoTune_Difference(stepCurrent, result.current));
+  if (result.sourceResistance == 0)
+  {
+    result.sourceResistance = 1;
+  }
+
+  result.updateInterval = AutoTune_Limit(((uint32_t)AUTOTUNE_INTERVAL_DELAYS) * result.delay, 1, AUTOTUNE_MAXIMUM_INTERVAL);
+
+  /* Steps that change the other quantity by as much as the default largest step of its own setter */
+  result.maximumCurrentStep = AutoTune_Limit((((uint64_t)CONTROL_MAXIMUM_HI_VOLTAGE_STEP) * 1000) / result.sourceResistance, CONTROL_MINIMUM_HI_CURRENT_STEP, CONTROL_MAXIMUM_HI_CURRENT_STEP);
+  result.maximumVoltageStep = AutoTune_Limit((((uint64_t)CONTROL_MAXIMUM_HI_CURRENT_STEP) * result.sourceResistance) / 1000, CONTROL_MINIMUM_HI_VOLTAGE_STEP, CONTROL_MAXIMUM_HI_VOLTAGE_STEP);
+}
+
+static void AutoTune_Finish(AutoTune_Status status)
+{
+  if (stage != AutoTuneStage_Return)
+  {
+    AutoTune_Set(setValue);
+  }
+  stage = AutoTuneStage_Idle;
+  result.status = status;
+}
+
+static uint32_t AutoTune_Difference(uint32_t a, uint32_t b)
+{
+  return (a > b) ? (a - b) : (b - a);
+}
+
+static uint32_t AutoTune_Limit(uint64_t value, uint32_t minimum, uint32_t maximum)
+{
+  if (value < minimum)
+  {
+    value = minimum;
+  }
+  if (value > maximum)
+  {
+    value = maximum; /* The maximum wins if the interval is empty */
+  }
+  return (uint32_t)value;
+}
+
+/* </Implementations> */
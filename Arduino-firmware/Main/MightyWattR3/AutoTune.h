@@ -0,0 +1,132 @@
+/**
+ * AutoTune.h
+ * Identification of the source for the software-controlled modes
+ *
+ * 2018-02-27
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The setter of the present phase (current in CC, voltage in CV) is stepped away from the operating point
+ * with a step that doubles until the response is above the noise (voltage in CC, current in CV) or the step
+ * reaches its limit. The settled step gives the incremental resistance of the source, the return to the
+ * operating point gives the response delay of the load. From these, the update interval of the tuned phase
+ * and the largest steps of both setters are derived; the resistance also scales the PI controller in CV phase
+ * and starts the feed-forward source model.
+ * The step goes towards a lower current of the source when there is enough current, so that a power supply
+ * in current limit or a panel near short circuit is not pushed further.
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "Control.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define AUTOTUNE_ENABLED                 /* Identification of the source, left out on UNO with the other device modes for flash */
+#endif
+#define AUTOTUNE_SETTLE_MEASUREMENTS        8 /* Measurements skipped after every step */
+#define AUTOTUNE_AVERAGE_MEASUREMENTS       4 /* Measurements averaged for one operating point */
+#define AUTOTUNE_FIRST_STEP                 16 /* First step in DAC LSB */
+#define AUTOTUNE_STEP_LIMIT                 8 /* The step is at most 1/8 of the operating point */
+#define AUTOTUNE_RESPONSE                   32 /* The step is large enough when the response is 1/32 of the operating point */
+#define AUTOTUNE_MINIMUM_CURRENT_RESPONSE   CONTROL_FEEDFORWARD_MINIMUM_CURRENT_CHANGE /* uA */
+#define AUTOTUNE_MINIMUM_VOLTAGE_RESPONSE   VOLTMETER_THRESHOLD_VOLTAGE /* uV */
+#define AUTOTUNE_TIMEOUT                    2000 /* ms, longest time of one stage */
+#define AUTOTUNE_INTERVAL_DELAYS            1 /* Update interval in response delays, the next update sees at least half of the previous step */
+#define AUTOTUNE_MAXIMUM_INTERVAL           250 /* ms */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum AutoTune_Status : uint8_t
+{
+  AutoTune_NotTuned, /* No identification in this session */
+  AutoTune_Running,
+  AutoTune_Tuned, /* The result is valid and applied */
+  AutoTune_Failed, /* No response of the source or timeout, the previous parameters stay */
+  AutoTune_Cancelled /* Stopped by a new mode or by the limiter, the previous parameters stay */
+};
+
+/**
+ * data[0] of WriteCommand_AutoTune
+ */
+enum AutoTune_Commands : uint8_t
+{
+  AutoTuneCommand_Start = 0, /* Identify the source at the present operating point */
+  AutoTuneCommand_Clear = 1 /* Return to the default parameters */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Identified source and derived parameters
+ */
+struct AutoTune_Result
+{
+  AutoTune_Status status;
+  Control_CCCVStates phase; /* Phase that was perturbed, the update interval belongs to it */
+  uint16_t delay; /* ms, from the return step to half of the response */
+  uint16_t updateInterval; /* ms, smallest time between two updates of the control loop */
+  uint32_t voltage; /* uV, operating point */
+  uint32_t current; /* uA, operating point */
+  uint32_t perturbation; /* Last step, uA in CC phase, uV in CV phase */
+  uint32_t sourceResistance; /* mOhm, incremental resistance of the source */
+  uint32_t maximumCurrentStep; /* uA, the voltage changes by at most CONTROL_MAXIMUM_HI_VOLTAGE_STEP */
+  uint32_t maximumVoltageStep; /* uV, the current changes by at most CONTROL_MAXIMUM_HI_CURRENT_STEP */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void AutoTune_Init(void);
+
+/**
+ * Executable function which must be called periodically while the identification runs, instead of the keeper of the mode
+ */
+void AutoTune_Do(void);
+
+/**
+ * Starts the identification at the present operating point of the present phase
+ */
+void AutoTune_Start(void);
+
+/**
+ * Stops the identification, the setters are left to the caller
+ */
+void AutoTune_Cancel(void);
+
+/**
+ * Returns whether the identification runs
+ *
+ * @return - true while the setters are driven by this module
+ */
+bool AutoTune_IsRunning(void);
+
+/**
+ * Returns the result of the last identification
+ *
+ * @return - Pointer to constant result
+ */
+const AutoTune_Result * AutoTune_GetResult(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* AUTOTUNE_H */
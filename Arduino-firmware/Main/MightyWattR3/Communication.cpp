@@ -10,7 +10,7 @@
 
 /* <Includes> */
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Communication.h"
 #include "Configuration.h"
 #include "Ammeter.h"
@@ -28,6 +28,19 @@
 #include "Flashreader.h"
 #include "MightyWatt.h"
 #include "PinController.h"
+#include "Scheduler.h"
+#include "EventBus.h"
+#include "Latency.h"
+#include "RingBuffer.h"
+#include "AutoTune.h"
+#include "MPPT.h"
+#include "Sweep.h"
+#include "Sequencer.h"
+#include "Dynamic.h"
+#include "Waveform.h"
+#include "Discharge.h"
+#include "LoadLine.h"
+#include "Data.h"
 
 /* </Includes> */
 
@@ -37,12 +50,18 @@
 static const uint8_t dataLengthMapping[] = {0, 1, 2, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH};
 static Communication_WriteCommand writeCommand; /* Present command from the PC */
 static Communication_ReadCommand readCommand; /* Present command from the PC */
+static bool argumentsTaken; /* A command followed the last argument, the next argument starts a new list */
 static uint8_t lastSent;
 static ErrorMessaging_Error communicationError;
 static uint8_t measurementMessage[COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH];
 static const Measurement_Values * measurementValues;
 static const TSCUChar * temperature;
-static char textMessage[64];
+static EventBus_Subscription measurementSubscription; /* New measurement values to be sent */
+static uint16_t frameCRC; /* Running CRC of the binary frame that is being sent */
+#ifdef ZERO
+static uint8_t txQueue[COMMUNICATION_TX_QUEUE_SIZE]; /* Part of the binary frame waiting to be sent */
+static uint8_t txQueueLength;
+#endif
 
 static const char Name[] FLASHMEMORY = NAME " (" SN ")";
 static const char CalibrationDate[] FLASHMEMORY = CALIBRATION_DATE;
@@ -64,6 +83,57 @@ void Communication_Receive(void);
 */
 void Communication_Send(void);
 
+/**
+   Sends a null-terminated string from flash memory followed by a new line, without copying it to RAM
+*/
+static void Communication_PrintFlash(const char * text);
+
+/**
+   Sends an unsigned number as decimal text followed by a new line
+*/
+static void Communication_PrintNumber(uint32_t value);
+
+/**
+   Sends a new line (CR LF)
+*/
+static void Communication_PrintNewLine(void);
+
+/**
+   Starts sending a binary frame whose CRC is computed on the fly
+*/
+static void Communication_FrameStart(void);
+
+/**
+   Sends one byte of a binary frame
+*/
+static void Communication_FrameAdd(uint8_t value);
+
+/**
+   Sends a 16-bit value of a binary frame, LSB first
+*/
+static void Communication_FrameAddUInt(uint16_t value);
+
+/**
+   Sends a 32-bit value of a binary frame, LSB first
+*/
+static void Communication_FrameAddULong(uint32_t value);
+
+/**
+   Finishes a binary frame by sending its CRC
+*/
+static void Communication_FrameEnd(void);
+
+/**
+   Sends one byte of a binary frame without updating the CRC
+   On ZERO, the bytes are collected and handed to USB as whole packets
+*/
+static void Communication_FrameWrite(uint8_t value);
+
+/**
+   ZERO: hands the collected bytes of a binary frame to USB
+*/
+static void Communication_FrameFlush(void);
+
 /* </Declarations (prototypes)> */
 
 
@@ -72,6 +142,8 @@ void Communication_Send(void);
 void Communication_Init(void)
 {
   writeCommand.commandCounter = 0;
+  writeCommand.argumentCount = 0;
+  argumentsTaken = true;
   readCommand.commandCounter = 0;
   lastSent = 0;
 
@@ -81,11 +153,12 @@ void Communication_Init(void)
   communicationError.error = ErrorMessaging_Communication_CommandTimeout;
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement);
 }
 
 void Communication_Do(void)
 {
-  if (SerialPort.available() > 0)  /* Receive message if data is available */
+  if (HAL_SerialAvailable() > 0)  /* Receive message if data is available */
   {
     Communication_Receive();
   }
@@ -94,10 +167,8 @@ void Communication_Do(void)
 
 void Communication_Reset(void)
 {
-  SerialPort.end();
-  SerialPort.begin(COMMUNICATION_BAUDRATE);
-  while(!SerialPort){}; /* Wait for the initialization of serial port */
-  while(SerialPort.read() >= 0){}; /* Read all junk data already at the port */  
+  HAL_SerialInit(COMMUNICATION_BAUDRATE);
+  while(HAL_SerialRead() >= 0){}; /* Read all junk data already at the port */  
 }
 
 void Communication_Receive(void)
@@ -108,7 +179,7 @@ void Communication_Receive(void)
   uint16_t receivedCRC;
   static uint8_t message[COMMUNICATION_PAYLOAD_MAXIMUM_LENGTH + 1]; // payload + header
 
-  data = SerialPort.read();
+  data = HAL_SerialRead();
   if (data < 0)
   {
     return;
@@ -126,20 +197,19 @@ void Communication_Receive(void)
 
   /* Read all incoming bytes */
   i = 0;
-  startTime = millis();
+  startTime = HAL_Milliseconds();
   while (i < dataLength + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
   {
-    data = SerialPort.read();
+    data = HAL_SerialRead();
     if (data >= 0)
     {
       message[i + 1] = (uint8_t)data;
       i++;
     }
-    else if ((millis() - startTime) > COMMUNICATION_TIMEOUT)
+    else if ((HAL_Milliseconds() - startTime) > COMMUNICATION_TIMEOUT)
     {
       /* timeout - error */
-      communicationError.errorCounter++;
-      communicationError.error = ErrorMessaging_Communication_CommandTimeout;
+      ErrorMessaging_Raise(&communicationError, ErrorMessaging_Communication_CommandTimeout);
       return;
     }
   }
@@ -156,6 +226,23 @@ void Communication_Receive(void)
   if (COMMUNICATION_RW(message[0]) == COMMUNICATION_WRITE)
   {
     /* Write to load */
+    /* An argument is only staged, the command and its counter are left alone so the modules and the scheduler see
+     * complete commands only */
+    if (COMMUNICATION_COMMAND(message[0]) == WriteCommand_Argument)
+    {
+      if (argumentsTaken)
+      {
+        writeCommand.argumentCount = 0; /* First argument of a new command */
+        argumentsTaken = false;
+      }
+      if (writeCommand.argumentCount < COMMUNICATION_ARGUMENTS_COUNT)
+      {
+        writeCommand.arguments[writeCommand.argumentCount] = Data_GetULongFromUCharArray(&message[1]);
+        writeCommand.argumentCount++;
+      }
+      return;
+    }
+    argumentsTaken = true;
     writeCommand.commandCounter++;
     writeCommand.command = COMMUNICATION_COMMAND(message[0]);
     for (i = 0; i < dataLength; i++) /* copy data */
@@ -166,6 +253,9 @@ void Communication_Receive(void)
     {
       writeCommand.data[i] = 0;
     }
+    #ifdef LATENCY_ENABLED
+      Latency_Probe(Probe_FrameComplete);
+    #endif
   }
   else /* COMMUNICATION_READ */
   {
@@ -177,8 +267,6 @@ void Communication_Receive(void)
 
 void Communication_Send(void)
 {
-  static uint8_t measurementValuesCounter = 0;    
-  
   if (lastSent != readCommand.commandCounter)
   {
     uint8_t statusFlag = 0;
@@ -186,39 +274,275 @@ void Communication_Send(void)
     switch (readCommand.command)
     {
       case ReadCommand_IDN:
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)Name, sizeof(Name)/sizeof(Name[0]));
-        SerialPort.println(textMessage);
+        Communication_PrintFlash(Name);
         lastSent = readCommand.commandCounter;
         break;
       case ReadCommand_QDC:      
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)CalibrationDate, sizeof(CalibrationDate)/sizeof(CalibrationDate[0]));
-        SerialPort.println(textMessage);
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)FirmwareVersion, sizeof(FirmwareVersion)/sizeof(FirmwareVersion[0]));
-        SerialPort.println(textMessage);
-        Flashreader_Read((uint8_t*)textMessage, (uint8_t*)BoardRevision, sizeof(BoardRevision)/sizeof(BoardRevision[0]));
-        SerialPort.println(textMessage);
-        SerialPort.println(CURRENT_SETTER_MAXIMUM_HICURRENT + CURRENT_SETTER_MAXIMUM_HICURRENT / 65535);
-        SerialPort.println(AMMETER_MAXIMUM_CURRENT + AMMETER_MAXIMUM_CURRENT / 65535);
-        SerialPort.println(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE + VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE / 65535);
-        SerialPort.println(VOLTMETER_MAXIMUM_VOLTAGE + VOLTMETER_MAXIMUM_VOLTAGE / 65535);
-        SerialPort.println(MAXIMUM_POWER);
-        SerialPort.println(VOLTMETER_INPUT_RESISTANCE);
-        SerialPort.println(LIMITER_MAXIMUM_TEMPERATURE);
+        Communication_PrintFlash(CalibrationDate);
+        Communication_PrintFlash(FirmwareVersion);
+        Communication_PrintFlash(BoardRevision);
+        Communication_PrintNumber(CURRENT_SETTER_MAXIMUM_HICURRENT + CURRENT_SETTER_MAXIMUM_HICURRENT / 65535);
+        Communication_PrintNumber(AMMETER_MAXIMUM_CURRENT + AMMETER_MAXIMUM_CURRENT / 65535);
+        Communication_PrintNumber(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE + VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE / 65535);
+        Communication_PrintNumber(VOLTMETER_MAXIMUM_VOLTAGE + VOLTMETER_MAXIMUM_VOLTAGE / 65535);
+        Communication_PrintNumber(MAXIMUM_POWER);
+        Communication_PrintNumber(VOLTMETER_INPUT_RESISTANCE);
+        Communication_PrintNumber(LIMITER_MAXIMUM_TEMPERATURE);
         lastSent = readCommand.commandCounter;
         break;
       case ReadCommand_ErrorMessages:        
         uint8_t i;
-        SerialPort.write(ErrorMessaging_ErrorNamesCount()); /* Send the message length in lines as the first byte */
+        HAL_SerialWriteByte(ErrorMessaging_ErrorNamesCount()); /* Send the message length in lines as the first byte */
         for (i = 0; i < ErrorMessaging_ErrorNamesCount(); i++)
         {
-          ErrorMessaging_GetError(i, textMessage);
-          SerialPort.println(textMessage);
+          Communication_PrintFlash(ErrorMessaging_GetErrorName(i));
         }
         lastSent = readCommand.commandCounter;
         break;
+      case ReadCommand_Scheduler:
+      {
+        /* Task count, overrun counter and worst execution time (us) for each task, worst pass time (us),
+           event type count and the events of each type missed by its subscribers (EventBus_Events order) */
+        const Scheduler_TaskState * states = Scheduler_GetTaskStates();
+        Communication_FrameStart();
+        Communication_FrameAdd(Scheduler_GetTaskCount());
+        for (uint8_t j = 0; j < Scheduler_GetTaskCount(); j++)
+        {
+          Communication_FrameAddUInt(states[j].overrunCounter);
+          Communication_FrameAddUInt(states[j].worstTime);
+        }
+        Communication_FrameAddULong(Scheduler_GetWorstPassTime());
+        Communication_FrameAdd(EVENTBUS_EVENT_COUNT);
+        for (uint8_t j = 0; j < EVENTBUS_EVENT_COUNT; j++)
+        {
+          Communication_FrameAddUInt(EventBus_GetEventMissedCounter((EventBus_Events)j));
+        }
+        Communication_FrameEnd();
+        lastSent = readCommand.commandCounter;
+        break;
+      }
+      case ReadCommand_Profiler:
+      {
+        /* Task count, histogram bin count, time since reset (ms), pass count,
+           then for each task: call count, total time (us), worst time (us) and the histogram;
+           without the profiler (UNO) the task count is 0 and no task follows */
+        Communication_FrameStart();
+        #ifdef PROFILER_ENABLED
+          const Scheduler_TaskState * states = Scheduler_GetTaskStates();
+          Communication_FrameAdd(Scheduler_GetTaskCount());
+        #else
+          Communication_FrameAdd(0);
+        #endif
+        Communication_FrameAdd(PROFILER_HISTOGRAM_BINS);
+        Communication_FrameAddULong(Scheduler_GetProfilerTime());
+        Communication_FrameAddULong(Scheduler_GetPassCount());
+        #ifdef PROFILER_ENABLED
+          for (uint8_t j = 0; j < Scheduler_GetTaskCount(); j++)
+          {
+            Communication_FrameAddULong(states[j].profile.callCount);
+            Communication_FrameAddULong(states[j].profile.totalTime);
+            Communication_FrameAddUInt(states[j].worstTime);
+            for (uint8_t k = 0; k < PROFILER_HISTOGRAM_BINS; k++)
+            {
+              Communication_FrameAddUInt(states[j].profile.histogram[k]);
+            }
+          }
+        #endif
+        Communication_FrameEnd();
+        lastSent = readCommand.commandCounter;
+        break;
+      }
+      #ifdef LATENCY_ENABLED
+        case ReadCommand_Latency:
+        {
+          /* Path count, then for each path: trace count, minimum, mean, maximum and 99th percentile (us),
+             then the stage times of the last complete trace of each path (us, relative to the first stage) */
+          Communication_FrameStart();
+          Communication_FrameAdd(LATENCY_PATH_COUNT);
+          for (uint8_t j = 0; j < LATENCY_PATH_COUNT; j++)
+          {
+            const Latency_Statistics * latency = Latency_GetStatistics((Latency_Paths)j);
+            Communication_FrameAddULong(latency->count);
+            Communication_FrameAddULong((latency->count > 0) ? latency->minimum : 0);
+            Communication_FrameAddULong(Latency_GetMean((Latency_Paths)j));
+            Communication_FrameAddULong(latency->maximum);
+            Communication_FrameAddULong(Latency_GetP99((Latency_Paths)j));
+          }
+          for (uint8_t j = 0; j < LATENCY_PROBE_COUNT; j++)
+          {
+            Communication_FrameAddUInt(Latency_GetLastTrace((Latency_Probes)j));
+          }
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      case ReadCommand_Buffer:
+      {
+        /* Owner, record size, record count, then the records from the oldest one */
+        uint16_t count = RingBuffer_GetCount();
+        uint8_t recordSize = RingBuffer_GetRecordSize();
+        Communication_FrameStart();
+        Communication_FrameAdd(RingBuffer_GetOwner());
+        Communication_FrameAdd(recordSize);
+        Communication_FrameAddUInt(count);
+        for (uint16_t j = 0; j < count; j++)
+        {
+          const uint8_t * record = RingBuffer_Get(j);
+          for (uint8_t k = 0; k < recordSize; k++)
+          {
+            Communication_FrameAdd(record[k]); /* Records are stored LSB first on both boards */
+          }
+        }
+        Communication_FrameEnd();
+        lastSent = readCommand.commandCounter;
+        break;
+      }
+      #ifdef AUTOTUNE_ENABLED
+        case ReadCommand_AutoTune:
+        {
+          /* Status, tuned phase, response delay (ms), update interval (ms), operating point voltage (uV) and current (uA),
+             last step (uA or uV), source resistance (mOhm), largest current step (uA), largest voltage step (uV) */
+          const AutoTune_Result * tuning = AutoTune_GetResult();
+          Communication_FrameStart();
+          Communication_FrameAdd(tuning->status);
+          Communication_FrameAdd(tuning->phase);
+          Communication_FrameAddUInt(tuning->delay);
+          Communication_FrameAddUInt(tuning->updateInterval);
+          Communication_FrameAddULong(tuning->voltage);
+          Communication_FrameAddULong(tuning->current);
+          Communication_FrameAddULong(tuning->perturbation);
+          Communication_FrameAddULong(tuning->sourceResistance);
+          Communication_FrameAddULong(tuning->maximumCurrentStep);
+          Communication_FrameAddULong(tuning->maximumVoltageStep);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      #ifdef MPPT_ENABLED
+        case ReadCommand_MPPT:
+        {
+          /* Algorithm, stage, finished scans, maximum power of the last scan (uW) and its voltage (uV),
+             mean power since the last scan (uW), efficiency (0.01 %), time to the maximum power point (ms) */
+          const MPPT_Statistics * mppt = MPPT_GetStatistics();
+          Communication_FrameStart();
+          Communication_FrameAdd(mppt->algorithm);
+          Communication_FrameAdd(mppt->stage);
+          Communication_FrameAddUInt(mppt->scans);
+          Communication_FrameAddULong(mppt->maximumPower);
+          Communication_FrameAddULong(mppt->maximumPowerVoltage);
+          Communication_FrameAddULong(mppt->meanPower);
+          Communication_FrameAddUInt(mppt->efficiency);
+          Communication_FrameAddULong(mppt->timeToMPP);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      #ifdef SWEEP_ENABLED
+        case ReadCommand_Sweep:
+        {
+          /* Status, phase, requested points, finished points, duration (ms); the points are read by ReadCommand_Buffer */
+          const Sweep_State * sweep = Sweep_GetState();
+          Communication_FrameStart();
+          Communication_FrameAdd(sweep->status);
+          Communication_FrameAdd(sweep->phase);
+          Communication_FrameAddUInt(sweep->points);
+          Communication_FrameAddUInt(sweep->finishedPoints);
+          Communication_FrameAddULong(sweep->duration);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      #ifdef SEQUENCER_ENABLED
+        case ReadCommand_Sequencer:
+        {
+          /* Status, steps, running step, finished loops, time of the step (ms) */
+          const Sequencer_State * sequencer = Sequencer_GetState();
+          Communication_FrameStart();
+          Communication_FrameAdd(sequencer->status);
+          Communication_FrameAddUInt(sequencer->steps);
+          Communication_FrameAddUInt(sequencer->step);
+          Communication_FrameAddULong(sequencer->loops);
+          Communication_FrameAddULong(sequencer->stepTime);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      #ifdef DYNAMIC_ENABLED
+        case ReadCommand_Dynamic:
+        {
+          /* Status, present level (0 = A, 1 = B), locked current range, edges since the start, failed DAC writes since the start */
+          const Dynamic_State * dynamic = Dynamic_GetState();
+          Communication_FrameStart();
+          Communication_FrameAdd(dynamic->status);
+          Communication_FrameAdd(dynamic->level);
+          Communication_FrameAdd(dynamic->range);
+          Communication_FrameAddULong(dynamic->edges);
+          Communication_FrameAddUInt(dynamic->writeErrors);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      #ifdef WAVEFORM_ENABLED
+        case ReadCommand_Waveform:
+        {
+          /* Status, quantity, points, playing point, finished loops, underruns; the measured waveform is read by ReadCommand_Buffer */
+          const Waveform_State * waveform = Waveform_GetState();
+          Communication_FrameStart();
+          Communication_FrameAdd(waveform->status);
+          Communication_FrameAdd(waveform->quantity);
+          Communication_FrameAddUInt(waveform->points);
+          Communication_FrameAddUInt(waveform->point);
+          Communication_FrameAddULong(waveform->loops);
+          Communication_FrameAddULong(waveform->underruns);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      #ifdef DISCHARGE_ENABLED
+        case ReadCommand_Discharge:
+        {
+          /* Status, mode, duration (ms), charge (uAh), energy (uWh), first and last voltage (uV) */
+          const Discharge_State * discharge = Discharge_GetState();
+          Communication_FrameStart();
+          Communication_FrameAdd(discharge->status);
+          Communication_FrameAdd(discharge->mode);
+          Communication_FrameAddULong(discharge->duration);
+          Communication_FrameAddULong(discharge->charge);
+          Communication_FrameAddULong(discharge->energy);
+          Communication_FrameAddULong(discharge->startVoltage);
+          Communication_FrameAddULong(discharge->endVoltage);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
+      #ifdef LOADLINE_ENABLED
+        case ReadCommand_LoadLine:
+        {
+          /* Status, points, processed measurements, last current (uA), last and longest lookup time (us) */
+          const LoadLine_State * loadLine = LoadLine_GetState();
+          Communication_FrameStart();
+          Communication_FrameAdd(loadLine->status);
+          Communication_FrameAddUInt(loadLine->points);
+          Communication_FrameAddULong(loadLine->updates);
+          Communication_FrameAddULong(loadLine->current);
+          Communication_FrameAddUInt(loadLine->evaluationTime);
+          Communication_FrameAddUInt(loadLine->worstEvaluationTime);
+          Communication_FrameEnd();
+          lastSent = readCommand.commandCounter;
+          break;
+        }
+      #endif
       case ReadCommand_Measurement:
         uint16_t crc;
-        if (measurementValuesCounter != measurementValues->counter) /* Only send new measurement values */
+        if (EventBus_Take(&measurementSubscription)) /* Only send new measurement values */
         {
           l = measurementValues->current;
           measurementMessage[0] = l & 0xFF;
@@ -258,6 +582,10 @@ void Communication_Send(void)
           {
             statusFlag |= 1 << 5;
           }
+          if (Control_IsFoldingBack()) /* Bit 6: CC limited by the minimum voltage */
+          {
+            statusFlag |= 1 << 6;
+          }
           measurementMessage[9] = statusFlag;
 
           measurementMessage[10] = PinController_GetPins();
@@ -273,8 +601,7 @@ void Communication_Send(void)
           measurementMessage[15] = crc & 0xFF;
           measurementMessage[16] = (crc >> 8) & 0xFF;
 
-          SerialPort.write(measurementMessage, COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH);
-          measurementValuesCounter = measurementValues->counter;
+          HAL_SerialWrite(measurementMessage, COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH);
           lastSent = readCommand.commandCounter;
         }
         break;
@@ -300,22 +627,117 @@ const ErrorMessaging_Error * Communication_GetError(void)
   return &communicationError;
 }
 
+static void Communication_PrintFlash(const char * text)
+{
+  uint8_t c;
+  while ((c = Flashreader_ReadByte((const uint8_t *)text++)) != 0)
+  {
+    HAL_SerialWriteByte(c);
+  }
+  Communication_PrintNewLine();
+}
+
+static void Communication_PrintNumber(uint32_t value)
+{
+  uint8_t text[10]; /* Digits of the largest 32-bit number */
+  uint8_t i = sizeof(text);
+  do
+  {
+    text[--i] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+  HAL_SerialWrite(&text[i], sizeof(text) - i);
+  Communication_PrintNewLine();
+}
+
+static void Communication_PrintNewLine(void)
+{
+  HAL_SerialWriteByte('\r');
+  HAL_SerialWriteByte('\n');
+}
+
+static void Communication_FrameStart(void)
+{
+  frameCRC = 0;
+  #ifdef ZERO
+    txQueueLength = 0;
+  #endif
+}
+
+static void Communication_FrameAdd(uint8_t value)
+{
+  Communication_FrameWrite(value);
+  frameCRC = CRC16_Add(frameCRC, COMMUNICATION_CRC_POLYNOMIAL_VALUE, value);
+}
+
+static void Communication_FrameAddUInt(uint16_t value)
+{
+  Communication_FrameAdd(value & 0xFF);
+  Communication_FrameAdd((value >> 8) & 0xFF);
+}
+
+static void Communication_FrameAddULong(uint32_t value)
+{
+  Communication_FrameAdd(value & 0xFF);
+  Communication_FrameAdd((value >> 8) & 0xFF);
+  Communication_FrameAdd((value >> 16) & 0xFF);
+  Communication_FrameAdd((value >> 24) & 0xFF);
+}
+
+static void Communication_FrameEnd(void)
+{
+  Communication_FrameWrite(frameCRC & 0xFF);
+  Communication_FrameWrite((frameCRC >> 8) & 0xFF);
+  Communication_FrameFlush();
+}
+
+static void Communication_FrameWrite(uint8_t value)
+{
+  #ifdef ZERO
+    /* Writing single bytes to SerialUSB sends one USB packet per byte, the USB controller moves whole packets from RAM by itself */
+    txQueue[txQueueLength++] = value;
+    if (txQueueLength >= COMMUNICATION_TX_QUEUE_SIZE)
+    {
+      Communication_FrameFlush();
+    }
+  #else
+    HAL_SerialWriteByte(value);
+  #endif
+}
+
+static void Communication_FrameFlush(void)
+{
+  #ifdef ZERO
+    if (txQueueLength > 0)
+    {
+      HAL_SerialWrite(txQueue, txQueueLength);
+      txQueueLength = 0;
+    }
+  #endif
+}
+
 uint16_t CRC16(const uint16_t polynomial, const uint8_t * data, uint8_t dataLength)
 {
   uint16_t crc = 0;
   for (uint8_t i = 0; i < dataLength; i++)
   {
-    crc ^= (((uint16_t)data[i]) << 8);
-    for (uint8_t j = 0; j < 8; j++)
+    crc = CRC16_Add(crc, polynomial, data[i]);
+  }
+  return crc;
+}
+
+uint16_t CRC16_Add(uint16_t crc, const uint16_t polynomial, uint8_t data)
+{
+  crc ^= (((uint16_t)data) << 8);
+  for (uint8_t j = 0; j < 8; j++)
+  {
+    if ((crc & 0x8000U) > 0)
     {
-      if ((crc & 0x8000U) > 0)
-      {
-        crc = (crc << 1) ^ polynomial;
-      }
-      else
-      {
-        crc = crc << 1;
-      }
+      crc = (crc << 1) ^ polynomial;
+    }
+    else
+    {
+      crc = crc << 1;
     }
   }
   return crc;
@@ -32,6 +32,8 @@
 #define COMMUNICATION_MEASUREMENT_MESSAGE_LENGTH        (COMMUNICATION_MEASUREMENT_MESSAGE_DATA_LENGTH + COMMUNICATION_CRC_POLYNOMIAL_BYTE_LENGTH)
 #define COMMUNICATION_READ                              0
 #define COMMUNICATION_WRITE                             1
+#define COMMUNICATION_TX_QUEUE_SIZE                     64 /* ZERO: bytes of a binary frame collected before they are handed to USB, one full-speed bulk packet */
+#define COMMUNICATION_ARGUMENTS_COUNT                   8 /* 32-bit arguments staged by WriteCommand_Argument for the next command */
 
 /* </Defines> */ 
 
@@ -63,6 +65,16 @@ enum Communication_WriteCommands : uint8_t
   WriteCommand_CurrentRangeAuto = 16,
   WriteCommand_VoltageRangeAuto = 17,
   WriteCommand_Pins = 18,
+  WriteCommand_ResetStatistics = 19, /* data[0]: flags of the statistics to clear */
+  WriteCommand_ControlParameter = 20, /* data[0]: Control_Parameters, data[1..3]: value */
+  WriteCommand_AutoTune = 21, /* data[0]: AutoTune_Commands */
+  WriteCommand_Argument = 22, /* data: one 32-bit argument of the next command, the arguments keep the order in which they were sent; staged only, not counted as a command */
+  WriteCommand_Sweep = 23, /* data[0]: Sweep_Commands, arguments: Sweep_Arguments */
+  WriteCommand_Sequencer = 24, /* data[0]: Sequencer_Commands, data[1..3]: loops of SequencerCommand_Start, arguments: Sequencer_Arguments */
+  WriteCommand_Dynamic = 25, /* data[0]: Dynamic_Commands, arguments: Dynamic_Arguments */
+  WriteCommand_Waveform = 26, /* data[0]: Waveform_Commands, arguments: points of WaveformCommand_Add or Waveform_Arguments */
+  WriteCommand_Discharge = 27, /* data[0]: Discharge_Commands, arguments: Discharge_Arguments */
+  WriteCommand_LoadLine = 28 /* data[0]: LoadLine_Commands, arguments: points of LoadLineCommand_Add */
 };
 
 /**
@@ -75,7 +87,19 @@ enum Communication_ReadCommands : uint8_t
   ReadCommand_Measurement = 1,
   ReadCommand_IDN = 2,
   ReadCommand_QDC = 3,
-  ReadCommand_ErrorMessages = 4
+  ReadCommand_ErrorMessages = 4,
+  ReadCommand_Scheduler = 5,
+  ReadCommand_Profiler = 6,
+  ReadCommand_Latency = 7,
+  ReadCommand_Buffer = 8,
+  ReadCommand_AutoTune = 9,
+  ReadCommand_MPPT = 10,
+  ReadCommand_Sweep = 11,
+  ReadCommand_Sequencer = 12,
+  ReadCommand_Dynamic = 13,
+  ReadCommand_Waveform = 14,
+  ReadCommand_Discharge = 15,
+  ReadCommand_LoadLine = 16
 };
 
 /* </Enums> */ 
@@ -91,6 +115,8 @@ struct Communication_WriteCommand
   uint8_t commandCounter; /* "Unique" number of the received command for identification. Intentional wraparound. Useful for identification if the command has been processed. */
   uint8_t command; /* Number indicating what the load is supposed to do */
   uint8_t data[COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH]; /* Generic data for the command - will be interpreted based on command number */
+  uint32_t arguments[COMMUNICATION_ARGUMENTS_COUNT]; /* Arguments sent by WriteCommand_Argument right before this command, valid until the next argument */
+  uint8_t argumentCount;
 };
 
 /**
@@ -154,6 +180,17 @@ const ErrorMessaging_Error * Communication_GetError(void);
  */
 uint16_t CRC16(const uint16_t polynomial, const uint8_t * data, uint8_t dataLength);
 
+/**
+ * Adds one byte to a running 16-bit cyclic redundancy check
+ *
+ * @param crc - CRC of the preceding data (0 for the first byte)
+ * @param polynomial - CRC polynomial
+ * @param data - byte to add
+ *
+ * @return - 16-bit CRC of the preceding data and the added byte
+ */
+uint16_t CRC16_Add(uint16_t crc, const uint16_t polynomial, uint8_t data);
+
 /* </Declarations (prototypes)> */ 
 
 #endif /* COMMUNICATION_H */
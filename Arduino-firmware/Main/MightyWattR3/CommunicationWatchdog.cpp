@@ -9,7 +9,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "CommunicationWatchdog.h"
 #include "Control.h"
 #include "Communication.h"
@@ -35,27 +35,27 @@ void CommunicationWatchdog_Init(void)
   readCommand = Communication_GetReadCommand();
   writeCommandCounter = writeCommand->commandCounter;
   readCommandCounter = readCommand->commandCounter;
-  lastCommandMilliseconds = millis();
+  lastCommandMilliseconds = HAL_Milliseconds();
 }
 
 void CommunicationWatchdog_Do(void)
 {
   if (writeCommandCounter != writeCommand->commandCounter)
   {
-    lastCommandMilliseconds = millis();
+    lastCommandMilliseconds = HAL_Milliseconds();
     writeCommandCounter = writeCommand->commandCounter;
   }
  
   if (readCommandCounter != readCommand->commandCounter)
   {
-    lastCommandMilliseconds = millis();
+    lastCommandMilliseconds = HAL_Milliseconds();
     readCommandCounter = readCommand->commandCounter;
   }
   
-  if (millis() - lastCommandMilliseconds > COMMUNICATION_WATCHDOG_TIMEOUT)
+  if (HAL_Milliseconds() - lastCommandMilliseconds > COMMUNICATION_WATCHDOG_TIMEOUT)
   {
     /* Communication timeout */
-    lastCommandMilliseconds = millis();
+    lastCommandMilliseconds = HAL_Milliseconds();
     Control_StopLoad();
     Communication_Reset(); /* Reset COM port */
     MightyWatt_Init();
@@ -9,7 +9,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Ammeter.h"
 #include "Voltmeter.h"
 #include "DACC.h"
@@ -20,6 +20,18 @@
 #include "CurrentSetter.h"
 #include "VoltageSetter.h"
 #include "RangeSwitcher.h"
+#include "FastPin.h"
+#include "Latency.h"
+#include "PIController.h"
+#include "AutoTune.h"
+#include "MPPT.h"
+#include "Sweep.h"
+#include "Sequencer.h"
+#include "Dynamic.h"
+#include "Waveform.h"
+#include "Discharge.h"
+#include "LoadLine.h"
+#include "EventBus.h"
 
 /* </Includes> */ 
 
@@ -34,28 +46,58 @@ static const Communication_WriteCommand * writeCommand; /* Pointer to the write
 static uint8_t commandCounter = 0; /* Number of the last executed command from communication */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static uint8_t measurementCounter; /* Number of the last processed measurement data */
+static bool skipMeasurement; /* The next measurement may pair a voltage and a current taken on both sides of a reset of the software loop */
 static uint32_t measurementTimer; /* Time of the last processed measurement data */
-static uint32_t lastCurrent, lastPower, lastResistance, lastVoltage, lastLastPower; /* Saved values for software modes */
+static uint32_t lastPower, lastResistance, lastVoltage; /* Saved values for software modes */
 static ErrorMessaging_Error ControlError;
 const static ErrorMessaging_Error * CurrentSetterError;
 const static ErrorMessaging_Error * VoltageSetterError;
 static uint8_t currentSetterErrorCounter, voltageSetterErrorCounter;
 static Control_CCCVStates cccvState;
 static uint32_t stepSize; /* Software control loop step size */
-static bool MPPT_initialized;
+static Control_Algorithms algorithm = CONTROL_DEFAULT_ALGORITHM; /* Control loop of the software-controlled modes */
+static PIController_Gains ccGains = {CONTROL_PI_CC_PROPORTIONAL, CONTROL_PI_CC_INTEGRAL, CONTROL_PI_CC_DERIVATIVE}; /* Modes that drive the current setter */
+static PIController_Gains cvGains = {CONTROL_PI_CV_PROPORTIONAL, CONTROL_PI_CV_INTEGRAL, CONTROL_PI_CV_DERIVATIVE}; /* Modes that drive the voltage setter */
+static PIController_State piState;
+static uint32_t trimGain = CONTROL_FEEDFORWARD_TRIM_GAIN;
+static int32_t trim; /* Q16, relative correction of the feed-forward setpoint */
+static uint32_t sourceResistance; /* mOhm, incremental resistance of the source from the last two measurements, 0 if unknown */
+static uint32_t lastSourceVoltage, lastSourceCurrent; /* Operating point of the previous settled measurement for the source resistance */
+static uint8_t sourceCounter; /* Number of the measurement of the last CV update that follows the source */
+static bool sourceModelled; /* The last CV feed-forward update came from the source model */
+static uint32_t bandwidthLimitCC = CONTROL_BANDWIDTH_LIMIT_CC, bandwidthLimitCV = CONTROL_BANDWIDTH_LIMIT_CV; /* ms, update interval of the step search, also of PI and feed-forward once tuned */
+static uint32_t maximumCurrentStep = CONTROL_MAXIMUM_HI_CURRENT_STEP, maximumVoltageStep = CONTROL_MAXIMUM_HI_VOLTAGE_STEP; /* Largest steps of the step search in both ranges */
+static uint32_t tunedResistance; /* mOhm, source resistance found by the auto-tune, 0 if not tuned */
+static Communication_WriteCommands presentMode = WriteCommand_ConstantCurrent; /* Mode of the last Control_SetMode, CC after the load was switched off */
+static uint32_t slewCurrent, slewVoltage, slewPower, slewResistance; /* Per ms, 0 for a step */
+static bool rampActive; /* The set value of presentMode ramps to rampTarget */
+static uint32_t rampStart, rampTarget, rampRate; /* Unit of the mode and per ms */
+static uint32_t rampTime; /* us, time of rampStart */
+static void (* rampKeeper)(void); /* Keeper of the ramped mode, another keeper ends the ramp */
+static uint32_t minimumVoltage; /* uV, CC folds back below it, 0 for plain CC */
+static bool foldback; /* CC runs below the set current to hold the minimum voltage */
+static EventBus_Subscription foldbackSubscription; /* New measurement values for the foldback loop */
+static bool transfer; /* The mode being set takes over a loaded operating point from another mode */
 
 /* </Module variables> */ 
 
 
 /* <Declarations (prototypes)> */ 
 
+/**
+ * Stops the modes run by the device, called by every command that starts a mode
+ *
+ * @param except - mask of Control_DeviceModes that keep running
+ */
+void Control_StopDeviceModes(uint8_t except);
+
 /**
  * Sets the present value of "setCurrent" to DAC
  */
 void Control_SetCurrent(void);
 
 /**
- * Keeps constant current
+ * Keeps constant current, with a minimum voltage also the foldback loop on every measurement
  */
 void Control_KeepCurrent(void);
 
@@ -119,16 +161,56 @@ void Control_SetVoltageSoftware(void);
  */
 void Control_KeepVoltageSoftware(void);
 
+#ifdef MPPT_ENABLED
+  /**
+   * Set-ups control logic for maximum power point tracker
+   * Starting voltage is obtained from communication command
+   */
+  void Control_SetMPPT(void);
+
+  /**
+   * Keeps maximum power point using a software control loop (physically CV)
+   */
+  void Control_KeepMPPT(void);
+#endif
+
+#ifdef SWEEP_ENABLED
+  /**
+   * Runs the I-V sweep, switches the load off at its end
+   */
+  void Control_KeepSweep(void);
+#endif
+
+#ifdef DYNAMIC_ENABLED
+  /**
+   * Watches the dynamic load, the DAC is written by the timer callback and the current setter would unlock the range
+   */
+  void Control_KeepDynamic(void);
+#endif
+
+#ifdef WAVEFORM_ENABLED
+  /**
+   * Runs the waveform playback, switches the load off at its end
+   */
+  void Control_KeepWaveform(void);
+#endif
+
+#ifdef LOADLINE_ENABLED
+  /**
+   * Sets the current from the load-line table on every measurement
+   */
+  void Control_KeepLoadLine(void);
+#endif
+
 /**
- * Set-ups control logic for maximum power point tracker
- * Starting current is obtained from communication command
+ * Starts the current setter at the measured current, the new mode continues from the operating point
  */
-void Control_SetMPPT(void);
+void Control_TransferCurrent(void);
 
 /**
- * Keeps maximum power point using a software control loop (physically CC)
+ * Starts the voltage setter at the measured voltage, the new mode continues from the operating point
  */
-void Control_KeepMPPT(void);
+void Control_TransferVoltage(void);
 
 /*
  * Sets the maximum current at the present range
@@ -194,6 +276,170 @@ void Control_SWCC(uint32_t setValue, uint32_t * lastValue, uint32_t presentValue
  */
 void Control_SWCV(uint32_t setValue, uint32_t * lastValue, uint32_t presentValue, Control_VoltageActions * lastAction);
 
+/**
+ * PI control loop for CC mode, one update with the latest measurement
+ * 
+ * @param error - relative error in Q16, positive increases the current
+ * @param maximum - largest current in uA
+ */
+void Control_PICC(int32_t error, uint32_t maximum);
+
+/**
+ * PI control loop for CV-software mode, one update with the latest measurement
+ * Once the source resistance is known, the error is scaled by the current change V / r that changes the voltage by 100 %,
+ * a current source (power supply in current limit) then gets steps of milliamperes instead of amperes
+ * 
+ * @param error - relative error in Q16, positive increases the current
+ */
+void Control_PIVoltageCC(int32_t error);
+
+/**
+ * PI control loop for CV mode, one update with the latest measurement
+ * Once the source resistance is known (auto-tune, then the loop's own steps), the error is scaled by the voltage change
+ * that changes the power or the resistance by 100 % at the present operating point, so that the loop gain equals
+ * the integral gain on any source. The side of the maximum power point gives the direction of the power.
+ * Until the resistance is known, the source is taken as a voltage source and the scale is the smallest one.
+ * 
+ * @param error - relative error of the power or the resistance in Q16, positive if it is below the set value
+ * @param power - true for constant power, false for constant resistance
+ */
+void Control_PICV(int32_t error, bool power);
+
+/**
+ * Gets the voltage change that changes the power or the resistance by 100 % at the present operating point
+ * 
+ * @param power - true for constant power, false for constant resistance
+ *
+ * @return - Voltage change in uV, at least one step of the DAC, negative if a higher voltage lowers the power,
+ *           0 if the source resistance or the current are not known
+ */
+int32_t Control_GetSourceScale(bool power);
+
+/**
+ * Checks whether a relative error is smaller than half a step of the DAC, on a stiff source one step moves the power
+ * or the resistance by percent and such an error is left as it is instead of dithering between the neighbouring steps
+ * 
+ * @param error - relative error in Q16
+ * @param scale - voltage change in uV that corresponds to 100 % relative error
+ *
+ * @return - True if the error is below the resolution of the voltage setter
+ */
+bool Control_IsBelowVoltageStep(int32_t error, uint32_t scale);
+
+/**
+ * Feed-forward control loop for CP-CC and CR-CC, sets the ideal current computed from the latest measurement
+ * 
+ * @param current - ideal current in uA
+ */
+void Control_FeedForwardCC(uint64_t current);
+
+/**
+ * Feed-forward control loop for CP-CV and CR-CV, one update with the latest measurement
+ * The current follows the set voltage through the source, so the setpoint is the intersection of the source line
+ * (through the present operating point with the incremental resistance of the last two settled measurements)
+ * with V * I = P or V = R * I. Until the resistance is known the PI controller takes the sample.
+ * 
+ * @param power - true for constant power, false for constant resistance
+ */
+void Control_FeedForwardSourceCV(bool power);
+
+/**
+ * Integer square root, bit by bit without multiplication, so that the UNO does not link the float library
+ *
+ * @param value - radicand
+ *
+ * @return - Largest integer whose square is not above the value
+ */
+uint32_t Control_SquareRoot(uint64_t value);
+
+/**
+ * Checks whether the latest measurement was taken after the last setpoint change of the loops that follow the source
+ *
+ * @return - True if the measurement is to be processed
+ */
+bool Control_IsSourceSampleDue(void);
+
+/**
+ * Updates the incremental source resistance from the latest measurement and the value of the setter of the phase
+ *
+ * @return - True if the last step gave a new resistance
+ */
+bool Control_EstimateSource(void);
+
+/**
+ * Updates the feed-forward trim and applies it to the set value
+ * The ideal setpoint removes the error of the last measurement, the trim removes what remains (setter and meter offsets)
+ * 
+ * @param setValue - set power or resistance
+ * @param error - relative error of the process value in Q16
+ *
+ * @return - Trimmed set value used to compute the ideal setpoint
+ */
+uint32_t Control_TrimTarget(uint32_t setValue, int32_t error);
+
+/**
+ * Starts the PI controller and the feed-forward trim from the present actuator value
+ * 
+ * @param output - present value of the current or voltage setter
+ */
+void Control_ResetPI(uint32_t output);
+
+/**
+ * Decides whether the software control loop runs in this pass
+ * The PI controller and the feed-forward run once per measurement, the step search at most once per bandwidth limit
+ * 
+ * @param bandwidthLimit - minimum period of the step search in ms
+ *
+ * @return - true if the loop is due, the loop is then marked as done
+ */
+bool Control_IsLoopDue(uint32_t bandwidthLimit);
+
+/**
+ * Moves the set value of a ramp by its slew rate, called before the keeper of the mode
+ */
+void Control_Ramp(void);
+
+/**
+ * Sets the set value of a mode and the setter of CC and CV
+ *
+ * @param mode - write command of the mode
+ * @param value - set value in the unit of the mode
+ */
+void Control_ApplySetpoint(Communication_WriteCommands mode, uint32_t value);
+
+/**
+ * Returns the set value of a mode
+ *
+ * @param mode - write command of the mode
+ *
+ * @return - Set value in the unit of the mode
+ */
+uint32_t Control_GetSetValue(Communication_WriteCommands mode);
+
+/**
+ * Returns the slew rate of a mode
+ *
+ * @param mode - write command of the mode
+ *
+ * @return - Slew rate per ms, 0 if the mode steps
+ */
+uint32_t Control_GetSlewRate(Communication_WriteCommands mode);
+
+/**
+ * Sets the parameters of the control loops from the auto-tune, the loop continues from the present setter value
+ * 
+ * @param result - identified source, NULL for the default parameters
+ */
+void Control_ApplyTuning(const AutoTune_Result * result);
+
+/**
+ * Sets a parameter of the control loops
+ * 
+ * @param parameter - parameter to set
+ * @param value - new value
+ */
+void Control_SetParameter(Control_Parameters parameter, uint32_t value);
+
 /* </Declarations (prototypes)> */ 
 
 
@@ -201,15 +447,16 @@ void Control_SWCV(uint32_t setValue, uint32_t * lastValue, uint32_t presentValue
 
 void Control_Init(void)
 {
-  pinMode(CONTROL_CCCV_PIN, OUTPUT);
+  HAL_PinMode(CONTROL_CCCV_PIN, HAL_Output);
   Control_StopLoad();
   writeCommand = Communication_GetWriteCommand();
   measurementValues = Measurement_GetValues();
   measurementCounter = 0;
-  ControlError.errorCounter = 0;
-  ControlError.error = CurrentSetterError->error;
+  EventBus_Subscribe(&foldbackSubscription, Event_Measurement);
   CurrentSetterError = CurrentSetter_GetError();
   VoltageSetterError = VoltageSetter_GetError();  
+  ControlError.errorCounter = 0;
+  ControlError.error = CurrentSetterError->error;
 }
 
 void Control_Do(void)
@@ -217,54 +464,183 @@ void Control_Do(void)
   /* Check new command */
   if (writeCommand->commandCounter != commandCounter)
   {
+    #ifdef LATENCY_ENABLED
+      Latency_Probe(Probe_CommandDispatched);
+    #endif
     /* LSB first */
     switch (writeCommand->command)
     {
       case WriteCommand_ConstantCurrent:
-        setCurrent = Data_GetULongFromUCharArray(writeCommand->data);
-        Control_SetCurrent();
-        Control_Keep = &Control_KeepCurrent;
-      break;
       case WriteCommand_ConstantVoltage:
-        setVoltage = Data_GetULongFromUCharArray(writeCommand->data);
-        Control_SetVoltage();
-        Control_Keep = &Control_KeepVoltage;
-      break;
       case WriteCommand_ConstantPowerCC:
-        setPower = Data_GetULongFromUCharArray(writeCommand->data);
-        Control_SetPowerCC();
-        Control_Keep = &Control_KeepPowerCC;
-      break;
       case WriteCommand_ConstantPowerCV:
-        setPower = Data_GetULongFromUCharArray(writeCommand->data);
-        Control_SetPowerCV();
-        Control_Keep = &Control_KeepPowerCV;
-      break;
       case WriteCommand_ConstantResistanceCC:
-        setResistance = Data_GetULongFromUCharArray(writeCommand->data);
-        Control_SetResistanceCC();
-        Control_Keep = &Control_KeepResistanceCC;
-      break;
       case WriteCommand_ConstantResistanceCV:
-        setResistance = Data_GetULongFromUCharArray(writeCommand->data);
-        Control_SetResistanceCV();
-        Control_Keep = &Control_KeepResistanceCV;
-      break;
       case WriteCommand_ConstantVoltageSoftware:
-        setVoltage = Data_GetULongFromUCharArray(writeCommand->data);
-        Control_SetVoltageSoftware();
-        Control_Keep = &Control_KeepVoltageSoftware;
+      #ifdef MPPT_ENABLED
+        case WriteCommand_MPPT:
+      #endif
+      case WriteCommand_SimpleAmmeter:
+        Control_StopDeviceModes(ControlDeviceMode_None); /* The host takes over */
+        Control_SetMode((Communication_WriteCommands)writeCommand->command, Data_GetULongFromUCharArray(writeCommand->data));
       break;
-      case WriteCommand_MPPT:
-        //setCurrent = Data_GetULongFromUCharArray(writeCommand->data);            
-        setVoltage = Data_GetULongFromUCharArray(writeCommand->data);     
-        Control_SetMPPT();
-        Control_Keep = &Control_KeepMPPT;     
+      case WriteCommand_ControlParameter:
+        Control_SetParameter((Control_Parameters)writeCommand->data[0], Data_GetULongFromUCharArray(writeCommand->data) >> 8);
       break;
-      case WriteCommand_SimpleAmmeter:
-        Control_SetMaxCurrent();
-        Control_Keep = NULL; // No keeper necessary
-      break;      
+      #ifdef AUTOTUNE_ENABLED
+        case WriteCommand_AutoTune:
+          if (writeCommand->data[0] == AutoTuneCommand_Start)
+          {
+            Control_StopDeviceModes(ControlDeviceMode_AutoTune | ControlDeviceMode_MPPT | ControlDeviceMode_Sweep); /* They wait for the identification */
+            AutoTune_Start();
+          }
+          else if (writeCommand->data[0] == AutoTuneCommand_Clear)
+          {
+            AutoTune_Cancel();
+            Control_ApplyTuning(NULL);
+          }
+        break;
+      #endif
+      #ifdef SWEEP_ENABLED
+        case WriteCommand_Sweep:
+          if (writeCommand->data[0] == SweepCommand_Start)
+          {
+            if (Sweep_Start(writeCommand->arguments, writeCommand->argumentCount))
+            {
+              Control_StopDeviceModes(ControlDeviceMode_Sweep);
+              Control_Keep = &Control_KeepSweep;
+            }
+          }
+          else if (writeCommand->data[0] == SweepCommand_Abort)
+          {
+            Control_StopLoad();
+          }
+          else if (writeCommand->data[0] == SweepCommand_Release)
+          {
+            Sweep_Release();
+          }
+        break;
+      #endif
+      #ifdef SEQUENCER_ENABLED
+        case WriteCommand_Sequencer:
+          if (writeCommand->data[0] == SequencerCommand_Clear)
+          {
+            Sequencer_Clear();
+          }
+          else if (writeCommand->data[0] == SequencerCommand_Add)
+          {
+            Sequencer_Add(writeCommand->arguments, writeCommand->argumentCount);
+          }
+          else if (writeCommand->data[0] == SequencerCommand_Start)
+          {
+            if (Sequencer_Start(Data_GetULongFromUCharArray(writeCommand->data) >> 8))
+            {
+              Control_StopDeviceModes((uint8_t)~ControlDeviceMode_Discharge); /* The first step stopped the other modes (Control_SetMode) */
+            }
+          }
+          else if (writeCommand->data[0] == SequencerCommand_Stop)
+          {
+            Control_StopLoad();
+          }
+          else if (writeCommand->data[0] == SequencerCommand_Release)
+          {
+            Sequencer_Release();
+          }
+        break;
+      #endif
+      #ifdef DYNAMIC_ENABLED
+        case WriteCommand_Dynamic:
+          if (writeCommand->data[0] == DynamicCommand_Start)
+          {
+            #ifdef WAVEFORM_ENABLED
+              Waveform_Stop(); /* Frees the timer, the keeper switches the load off if the start fails */
+            #endif
+            if (Dynamic_Start(writeCommand->arguments, writeCommand->argumentCount))
+            {
+              Control_StopDeviceModes(ControlDeviceMode_Dynamic);
+              Control_Keep = &Control_KeepDynamic;
+            }
+          }
+          else if (writeCommand->data[0] == DynamicCommand_Stop)
+          {
+            Control_StopLoad();
+          }
+        break;
+      #endif
+      #ifdef DISCHARGE_ENABLED
+        case WriteCommand_Discharge:
+          if (writeCommand->data[0] == DischargeCommand_Start)
+          {
+            if (Discharge_Start(writeCommand->arguments, writeCommand->argumentCount)) /* Starts the mode of the test */
+            {
+              Control_StopDeviceModes((uint8_t)~ControlDeviceMode_Sequencer); /* The mode of the test stopped the other modes (Control_SetMode) */
+            }
+          }
+          else if (writeCommand->data[0] == DischargeCommand_Stop)
+          {
+            Control_StopLoad();
+          }
+        break;
+      #endif
+      #ifdef WAVEFORM_ENABLED
+        case WriteCommand_Waveform:
+          if (writeCommand->data[0] == WaveformCommand_Clear)
+          {
+            Waveform_Clear();
+          }
+          else if (writeCommand->data[0] == WaveformCommand_Add)
+          {
+            Waveform_Add(writeCommand->arguments, writeCommand->argumentCount);
+          }
+          else if (writeCommand->data[0] == WaveformCommand_Start)
+          {
+            #ifdef DYNAMIC_ENABLED
+              Dynamic_Stop(); /* Frees the timer, the keeper switches the load off if the start fails */
+            #endif
+            if (Waveform_Start(writeCommand->arguments, writeCommand->argumentCount))
+            {
+              Control_StopDeviceModes(ControlDeviceMode_Waveform);
+              Control_Keep = &Control_KeepWaveform;
+            }
+          }
+          else if (writeCommand->data[0] == WaveformCommand_Stop)
+          {
+            Control_StopLoad();
+          }
+          else if (writeCommand->data[0] == WaveformCommand_Release)
+          {
+            Waveform_Release();
+          }
+        break;
+      #endif
+      #ifdef LOADLINE_ENABLED
+        case WriteCommand_LoadLine:
+          if (writeCommand->data[0] == LoadLineCommand_Clear)
+          {
+            LoadLine_Clear();
+          }
+          else if (writeCommand->data[0] == LoadLineCommand_Add)
+          {
+            LoadLine_Add(writeCommand->arguments, writeCommand->argumentCount);
+          }
+          else if (writeCommand->data[0] == LoadLineCommand_Start)
+          {
+            if (LoadLine_Start())
+            {
+              Control_StopDeviceModes(ControlDeviceMode_LoadLine);
+              Control_Keep = &Control_KeepLoadLine;
+            }
+          }
+          else if (writeCommand->data[0] == LoadLineCommand_Stop)
+          {
+            Control_StopLoad();
+          }
+          else if (writeCommand->data[0] == LoadLineCommand_Release)
+          {
+            LoadLine_Release();
+          }
+        break;
+      #endif
       default:
       /* command handled by other modules */
       break;
@@ -272,40 +648,344 @@ void Control_Do(void)
     commandCounter = writeCommand->commandCounter;
   }  
   
+  #ifdef SEQUENCER_ENABLED
+    if (Sequencer_IsRunning())
+    {
+      Sequencer_Do(); /* Sets the mode of its step, the keeper of the mode runs below */
+      if (!Sequencer_IsRunning())
+      {
+        Control_StopLoad(); /* End of the program or stop condition */
+      }
+    }
+  #endif
+
+  #ifdef DISCHARGE_ENABLED
+    if (Discharge_IsRunning())
+    {
+      Discharge_Do(); /* The mode of the test runs below */
+      if (!Discharge_IsRunning())
+      {
+        Control_StopLoad(); /* Cutoff or limit, in the pass of the measurement */
+      }
+    }
+  #endif
+
+  #ifdef AUTOTUNE_ENABLED
+    if (AutoTune_IsRunning())
+    {
+      AutoTune_Do(); /* The mode waits, the setter of its phase is driven by the identification */
+      if (!AutoTune_IsRunning() && (AutoTune_GetResult()->status == AutoTune_Tuned))
+      {
+        Control_ApplyTuning(AutoTune_GetResult());
+      }
+    }
+    else
+  #endif
   if (Control_Keep != NULL)
   {
+    Control_Ramp();
     Control_Keep();
   }
+  #ifdef LATENCY_ENABLED
+    Latency_Cancel(Path_Command); /* Commands that did not reach the DAC in the pass they were dispatched are not traced */
+  #endif
 
   if (currentSetterErrorCounter != CurrentSetterError->errorCounter)
   {
     currentSetterErrorCounter = CurrentSetterError->errorCounter;
-    ControlError.errorCounter++;
-    ControlError.error = CurrentSetterError->error;
+    ErrorMessaging_Raise(&ControlError, CurrentSetterError->error);
   }
 
   if (voltageSetterErrorCounter != VoltageSetterError->errorCounter)
   {
     voltageSetterErrorCounter = VoltageSetterError->errorCounter;
-    ControlError.errorCounter++;
-    ControlError.error = VoltageSetterError->error;
+    ErrorMessaging_Raise(&ControlError, VoltageSetterError->error);
   }
 }
 
 void Control_StopLoad(void)
 {
+  Control_StopDeviceModes(ControlDeviceMode_None);
+  rampActive = false;
+  presentMode = WriteCommand_ConstantCurrent;
+  foldback = false;
   setCurrent = 0;
   CurrentSetter_SetZero();
   Control_Keep = &Control_KeepCurrent;
 }
 
+void Control_StopDeviceModes(uint8_t except)
+{
+  #ifdef AUTOTUNE_ENABLED
+    if (!(except & ControlDeviceMode_AutoTune))
+    {
+      AutoTune_Cancel();
+    }
+  #endif
+  #ifdef MPPT_ENABLED
+    if (!(except & ControlDeviceMode_MPPT))
+    {
+      MPPT_Stop();
+    }
+  #endif
+  #ifdef SWEEP_ENABLED
+    if (!(except & ControlDeviceMode_Sweep))
+    {
+      Sweep_Abort();
+    }
+  #endif
+  #ifdef SEQUENCER_ENABLED
+    if (!(except & ControlDeviceMode_Sequencer))
+    {
+      Sequencer_Stop();
+    }
+  #endif
+  #ifdef DISCHARGE_ENABLED
+    if (!(except & ControlDeviceMode_Discharge))
+    {
+      Discharge_Stop();
+    }
+  #endif
+  #ifdef DYNAMIC_ENABLED
+    if (!(except & ControlDeviceMode_Dynamic))
+    {
+      Dynamic_Stop();
+    }
+  #endif
+  #ifdef WAVEFORM_ENABLED
+    if (!(except & ControlDeviceMode_Waveform))
+    {
+      Waveform_Stop();
+    }
+  #endif
+  #ifdef LOADLINE_ENABLED
+    if (!(except & ControlDeviceMode_LoadLine))
+    {
+      LoadLine_Stop();
+    }
+  #endif
+}
+
+void Control_SetMode(Communication_WriteCommands mode, uint32_t value)
+{
+  Control_StopDeviceModes(CONTROL_PROGRAM_DEVICE_MODES); /* The new mode owns the setters, the program that sets it keeps running */
+
+  /* The same mode ramps from its set value, a new mode from the measured value */
+  uint32_t target = value;
+  uint32_t rate = Control_GetSlewRate(mode);
+  if (rate > 0)
+  {
+    value = (mode == presentMode) ? Control_GetSetValue(mode) : Control_GetPresentValue(mode);
+  }
+  /* Bumpless transfer: a software mode that takes over a loaded operating point starts its setter there */
+  transfer = (mode != presentMode) && (Control_Keep != NULL) && (measurementValues->unfilteredCurrent > AMMETER_THRESHOLD_VOLTAGE);
+  presentMode = mode;
+  foldback = false; /* CC starts at its set current */
+  EventBus_Subscribe(&foldbackSubscription, Event_Measurement); /* The foldback loop starts with the measurements of the mode */
+
+  switch (mode)
+  {
+    case WriteCommand_ConstantCurrent:
+      setCurrent = value;
+      Control_SetCurrent();
+      Control_Keep = &Control_KeepCurrent;
+    break;
+    case WriteCommand_ConstantVoltage:
+      setVoltage = value;
+      Control_SetVoltage();
+      Control_Keep = &Control_KeepVoltage;
+    break;
+    case WriteCommand_ConstantPowerCC:
+      setPower = value;
+      Control_SetPowerCC();
+      Control_Keep = &Control_KeepPowerCC;
+    break;
+    case WriteCommand_ConstantPowerCV:
+      setPower = value;
+      Control_SetPowerCV();
+      Control_Keep = &Control_KeepPowerCV;
+    break;
+    case WriteCommand_ConstantResistanceCC:
+      setResistance = value;
+      Control_SetResistanceCC();
+      Control_Keep = &Control_KeepResistanceCC;
+    break;
+    case WriteCommand_ConstantResistanceCV:
+      setResistance = value;
+      Control_SetResistanceCV();
+      Control_Keep = &Control_KeepResistanceCV;
+    break;
+    case WriteCommand_ConstantVoltageSoftware:
+      setVoltage = value;
+      Control_SetVoltageSoftware();
+      Control_Keep = &Control_KeepVoltageSoftware;
+    break;
+    #ifdef MPPT_ENABLED
+      case WriteCommand_MPPT:
+        setVoltage = value;
+        Control_SetMPPT();
+        Control_Keep = &Control_KeepMPPT;
+      break;
+    #endif
+    case WriteCommand_SimpleAmmeter:
+      Control_SetMaxCurrent();
+      Control_Keep = NULL; // No keeper necessary
+    break;
+    default:
+    break;
+  }
+
+  rampActive = value != target;
+  rampStart = value;
+  rampTarget = target;
+  rampRate = rate;
+  rampTime = HAL_Microseconds();
+  rampKeeper = Control_Keep;
+}
+
+void Control_SetSetpoint(Communication_WriteCommands mode, uint32_t value)
+{
+  rampActive = false; /* The caller ramps by itself */
+  Control_ApplySetpoint(mode, value);
+}
+
+uint32_t Control_GetPresentValue(Communication_WriteCommands mode)
+{
+  switch (mode)
+  {
+    case WriteCommand_ConstantCurrent:
+      return measurementValues->current;
+    case WriteCommand_ConstantPowerCC:
+    case WriteCommand_ConstantPowerCV:
+      return measurementValues->power;
+    case WriteCommand_ConstantResistanceCC:
+    case WriteCommand_ConstantResistanceCV:
+      return measurementValues->resistance;
+    case WriteCommand_SimpleAmmeter:
+      return 0;
+    default:
+      return measurementValues->voltage; /* CV, CV software and MPPT */
+  }
+}
+
+void Control_Ramp(void)
+{
+  if (!rampActive)
+  {
+    return;
+  }
+  if (Control_Keep != rampKeeper)
+  {
+    rampActive = false; /* Another module drives the setters */
+    return;
+  }
+
+  uint32_t now = HAL_Microseconds();
+  uint32_t span = (rampTarget > rampStart) ? (rampTarget - rampStart) : (rampStart - rampTarget);
+  uint64_t change = (((uint64_t)rampRate) * (now - rampTime)) / 1000;
+  uint32_t value = rampTarget;
+
+  if (change < span)
+  {
+    value = (rampTarget > rampStart) ? (rampStart + (uint32_t)change) : (rampStart - (uint32_t)change);
+    if (now - rampTime >= CONTROL_RAMP_REBASE_TIME)
+    {
+      rampStart = value; /* Long ramps outlast the wrap of the microsecond clock */
+      rampTime = now;
+    }
+  }
+  else
+  {
+    rampActive = false;
+  }
+  Control_ApplySetpoint(presentMode, value);
+}
+
+void Control_ApplySetpoint(Communication_WriteCommands mode, uint32_t value)
+{
+  switch (mode)
+  {
+    case WriteCommand_ConstantCurrent:
+      setCurrent = value;
+      Control_SetCurrent();
+    break;
+    case WriteCommand_ConstantVoltage:
+      setVoltage = value;
+      Control_SetVoltage();
+    break;
+    case WriteCommand_ConstantPowerCC:
+    case WriteCommand_ConstantPowerCV:
+      setPower = value; /* The control loop follows */
+    break;
+    case WriteCommand_ConstantResistanceCC:
+    case WriteCommand_ConstantResistanceCV:
+      setResistance = value;
+    break;
+    case WriteCommand_ConstantVoltageSoftware:
+      setVoltage = value;
+    break;
+    default:
+    break;
+  }
+}
+
+uint32_t Control_GetSetValue(Communication_WriteCommands mode)
+{
+  switch (mode)
+  {
+    case WriteCommand_ConstantCurrent:
+      return setCurrent;
+    case WriteCommand_ConstantPowerCC:
+    case WriteCommand_ConstantPowerCV:
+      return setPower;
+    case WriteCommand_ConstantResistanceCC:
+    case WriteCommand_ConstantResistanceCV:
+      return setResistance;
+    default:
+      return setVoltage;
+  }
+}
+
+uint32_t Control_GetSlewRate(Communication_WriteCommands mode)
+{
+  switch (mode)
+  {
+    case WriteCommand_ConstantCurrent:
+      return slewCurrent;
+    case WriteCommand_ConstantVoltage:
+    case WriteCommand_ConstantVoltageSoftware:
+      return slewVoltage;
+    case WriteCommand_ConstantPowerCC:
+    case WriteCommand_ConstantPowerCV:
+      return slewPower;
+    case WriteCommand_ConstantResistanceCC:
+    case WriteCommand_ConstantResistanceCV:
+      return slewResistance;
+    default:
+      return 0; /* MPPT and simple ammeter */
+  }
+}
+
 void Control_SetCurrent(void)
 {  
-  CurrentSetter_SetCurrent(setCurrent);
+  /* A lower set current applies at once; a higher one only while the voltage does not limit, the loop then finds the limit again */
+  if (!foldback || (setCurrent < CurrentSetter_GetCurrent()))
+  {
+    foldback = false;
+    PIController_Reset(&piState, setCurrent);
+    CurrentSetter_SetCurrent(setCurrent);
+  }
 }
 
 void Control_KeepCurrent(void)
 {
+  /* Foldback on every measurement, independent of the algorithm and the bandwidth limit of the software modes */
+  if ((minimumVoltage != 0) && EventBus_Take(&foldbackSubscription))
+  {
+    measurementTimer = measurementValues->milliseconds;
+    Control_PICC(-PIController_RelativeError(minimumVoltage, measurementValues->unfilteredVoltage), setCurrent); /* Higher current, lower voltage */
+    foldback = CurrentSetter_GetCurrent() < setCurrent;
+  }
   CurrentSetter_Do();
 }
 
@@ -325,7 +1005,11 @@ void Control_SetPowerCC(void)
   Control_LimitCurrentStepSize(&stepSize);
   lastPower = measurementValues->unfilteredPower;
   
-  if ((setPower > 0) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE)) // initial estimate I = P/V
+  if (transfer && (setPower > 0))
+  {
+    Control_TransferCurrent();
+  }
+  else if ((setPower > 0) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE)) // initial estimate I = P/V
   {     
     uint64_t current = (((uint64_t)setPower) * 1000000) / measurementValues->unfilteredVoltage;
 
@@ -342,25 +1026,37 @@ void Control_SetPowerCC(void)
   {
     CurrentSetter_SetCurrent(0);
   }
+  Control_ResetPI(CurrentSetter_GetCurrent());
 }
 
 void Control_KeepPowerCC(void)
 {
   static Control_CurrentActions lastAction = Control_CurrentUp;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CC)
+  if (Control_IsLoopDue(bandwidthLimitCC))
   {
     if ((setPower > 0) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE))
     { 
-      Control_SWCC(setPower, &lastPower, measurementValues->unfilteredPower, &lastAction);
+      if (algorithm == Control_PI)
+      {
+        Control_PICC(PIController_RelativeError(setPower, measurementValues->unfilteredPower), (uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1));
+      }
+      else if (algorithm == Control_FeedForward)
+      {
+        Control_FeedForwardCC((((uint64_t)Control_TrimTarget(setPower, PIController_RelativeError(setPower, measurementValues->unfilteredPower))) * 1000000) / measurementValues->unfilteredVoltage);
+      }
+      else
+      {
+        Control_SWCC(setPower, &lastPower, measurementValues->unfilteredPower, &lastAction);
+      }
     }
     else
     {
       CurrentSetter_SetCurrent(0);
       stepSize = 0;
       Control_LimitCurrentStepSize(&stepSize);
+      Control_ResetPI(0);
     }
-    measurementTimer = measurementValues->milliseconds;
   }
   CurrentSetter_Do();
 }
@@ -371,7 +1067,11 @@ void Control_SetPowerCV(void)
   Control_LimitVoltageStepSize(&stepSize);
   lastPower = measurementValues->unfilteredPower;
 
-  if ((setPower > 0))
+  if (transfer && (setPower > 0))
+  {
+    Control_TransferVoltage();
+  }
+  else if ((setPower > 0))
   { 
     uint64_t voltage;
     
@@ -397,25 +1097,41 @@ void Control_SetPowerCV(void)
   {
     VoltageSetter_SetVoltage((uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1));
   }
+  Control_ResetPI(VoltageSetter_GetVoltage());
 }
 
 void Control_KeepPowerCV(void)
 {
   static Control_VoltageActions lastAction = Control_VoltageDown;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CV)
+  if (Control_IsLoopDue(bandwidthLimitCV))
   {
     if ((setPower > 0) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE))
     { 
-      Control_SWCV(setPower, &lastPower, measurementValues->unfilteredPower, &lastAction);
+      if (algorithm == Control_PI)
+      {
+        if (Control_IsSourceSampleDue())
+        {
+          Control_EstimateSource();
+          Control_PICV(PIController_RelativeError(setPower, measurementValues->unfilteredPower), true);
+        }
+      }
+      else if (algorithm == Control_FeedForward)
+      {
+        Control_FeedForwardSourceCV(true);
+      }
+      else
+      {
+        Control_SWCV(setPower, &lastPower, measurementValues->unfilteredPower, &lastAction);
+      }
     }
     else
     {
       VoltageSetter_SetVoltage((uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1));      
       stepSize = 0;
       Control_LimitVoltageStepSize(&stepSize);
+      Control_ResetPI((uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1));
     }
-    measurementTimer = measurementValues->milliseconds;
   }
   VoltageSetter_Do();
 }
@@ -425,7 +1141,11 @@ void Control_SetResistanceCC(void)
   stepSize = 0;
   Control_LimitCurrentStepSize(&stepSize);
   lastResistance = measurementValues->unfilteredResistance;
-  if ((setResistance < VOLTMETER_INPUT_RESISTANCE) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE)) // initial estimate I = V/R
+  if (transfer && (setResistance < VOLTMETER_INPUT_RESISTANCE))
+  {
+    Control_TransferCurrent();
+  }
+  else if ((setResistance < VOLTMETER_INPUT_RESISTANCE) && (measurementValues->unfilteredVoltage > VOLTMETER_THRESHOLD_VOLTAGE)) // initial estimate I = 3/4 * V/R
   { 
     if (setResistance >= VOLTMETER_INPUT_RESISTANCE)
     {    
@@ -433,7 +1153,8 @@ void Control_SetResistanceCC(void)
     }
     else if (setResistance > 0)
     {
-      uint64_t current = (((uint64_t)measurementValues->unfilteredVoltage) * 1000) / setResistance;
+      /* The open-circuit voltage drops under load, I = V/R would end below the set resistance by the source resistance */
+      uint64_t current = (((uint64_t)measurementValues->unfilteredVoltage) * 750) / setResistance;
 
       if (current >= (uint64_t)CURRENT_SETTER_MAXIMUM_HICURRENT) 
       {
@@ -450,13 +1171,14 @@ void Control_SetResistanceCC(void)
       CurrentSetter_SetCurrent((uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1));
     }
   }
+  Control_ResetPI(CurrentSetter_GetCurrent());
 }
 
 void Control_KeepResistanceCC(void)
 {
   static Control_CurrentActions lastAction = Control_CurrentUp;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CC)
+  if (Control_IsLoopDue(bandwidthLimitCC))
   {    
     if (setResistance >= VOLTMETER_INPUT_RESISTANCE)
     {
@@ -464,13 +1186,23 @@ void Control_KeepResistanceCC(void)
     }
     else if (setResistance > 0)
     {            
-      Control_SWCC(setResistance, &lastResistance, measurementValues->unfilteredResistance, &lastAction);
+      if (algorithm == Control_PI)
+      {
+        Control_PICC(-PIController_RelativeError(setResistance, measurementValues->unfilteredResistance), (uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1)); /* Higher current, lower resistance */
+      }
+      else if (algorithm == Control_FeedForward)
+      {
+        Control_FeedForwardCC((((uint64_t)measurementValues->unfilteredVoltage) * 1000) / Control_TrimTarget(setResistance, PIController_RelativeError(setResistance, measurementValues->unfilteredResistance)));
+      }
+      else
+      {
+        Control_SWCC(setResistance, &lastResistance, measurementValues->unfilteredResistance, &lastAction);
+      }
     }        
     else
     {
       CurrentSetter_SetCurrent((uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1));
     } 
-    measurementTimer = measurementValues->milliseconds;    
   }  
   CurrentSetter_Do();
 }
@@ -480,7 +1212,11 @@ void Control_SetResistanceCV(void)
   stepSize = 0;
   Control_LimitVoltageStepSize(&stepSize);
   lastResistance = measurementValues->unfilteredResistance;
-  if ((setResistance < VOLTMETER_INPUT_RESISTANCE) && (measurementValues->unfilteredCurrent > AMMETER_THRESHOLD_VOLTAGE)) // initial estimate V = R * I
+  if (transfer && (setResistance < VOLTMETER_INPUT_RESISTANCE))
+  {
+    Control_TransferVoltage();
+  }
+  else if ((setResistance < VOLTMETER_INPUT_RESISTANCE) && (measurementValues->unfilteredCurrent > AMMETER_THRESHOLD_VOLTAGE)) // initial estimate V = R * I
   { 
     if (setResistance >= VOLTMETER_INPUT_RESISTANCE)
     {    
@@ -488,7 +1224,7 @@ void Control_SetResistanceCV(void)
     }
     else if (setResistance > 0)
     {
-      uint64_t voltage = ((((uint64_t)measurementValues->unfilteredVoltage)) * setResistance) / 1000;
+      uint64_t voltage = (((uint64_t)measurementValues->unfilteredCurrent) * setResistance) / 1000;
 
       if (voltage >= (uint64_t)VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE)
       {
@@ -505,13 +1241,18 @@ void Control_SetResistanceCV(void)
       VoltageSetter_SetVoltage(0);
     }
   }
+  else if ((setResistance < VOLTMETER_INPUT_RESISTANCE) && (algorithm != Control_StepSearch))
+  {
+    VoltageSetter_SetVoltage(measurementValues->unfilteredVoltage); // no current, the PI controller starts from the open-circuit voltage
+  }
+  Control_ResetPI(VoltageSetter_GetVoltage());
 }
 
 void Control_KeepResistanceCV(void)
 {
   static Control_VoltageActions lastAction = Control_VoltageDown;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CV)
+  if (Control_IsLoopDue(bandwidthLimitCV))
   {    
     if (setResistance >= VOLTMETER_INPUT_RESISTANCE)
     {
@@ -519,13 +1260,27 @@ void Control_KeepResistanceCV(void)
     }
     else if (setResistance > 0)
     {            
-      Control_SWCV(setResistance, &lastResistance, measurementValues->unfilteredResistance, &lastAction);
+      if (algorithm == Control_PI)
+      {
+        if (Control_IsSourceSampleDue())
+        {
+          Control_EstimateSource();
+          Control_PICV(PIController_RelativeError(setResistance, measurementValues->unfilteredResistance), false);
+        }
+      }
+      else if (algorithm == Control_FeedForward)
+      {
+        Control_FeedForwardSourceCV(false);
+      }
+      else
+      {
+        Control_SWCV(setResistance, &lastResistance, measurementValues->unfilteredResistance, &lastAction);
+      }
     }        
     else
     {
       VoltageSetter_SetVoltage(0);
     } 
-    measurementTimer = measurementValues->milliseconds;    
   }  
   VoltageSetter_Do();
 }
@@ -545,241 +1300,124 @@ void Control_SetVoltageSoftware(void)
   {
     VoltageSetter_SetVoltage((uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1)); 
   }
+  if (transfer)
+  {
+    Control_TransferCurrent();
+  }
+  Control_ResetPI(measurementValues->unfilteredCurrent); /* Physically CC, continues from the present current */
 }
 
 void Control_KeepVoltageSoftware(void)
 {
   static Control_CurrentActions lastAction = Control_CurrentUp;
   
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CC)
+  if (Control_IsLoopDue(bandwidthLimitCC))
   {    
     if (setVoltage == 0)
     {
       CurrentSetter_SetCurrent((uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1));
     }
-    else if (measurementValues->unfilteredVoltage < VOLTMETER_THRESHOLD_VOLTAGE)
+    else if ((measurementValues->unfilteredVoltage < VOLTMETER_THRESHOLD_VOLTAGE) && ((algorithm == Control_StepSearch) || (measurementValues->unfilteredCurrent <= AMMETER_THRESHOLD_VOLTAGE)))
     {
       CurrentSetter_SetCurrent(0);
+      Control_ResetPI(0);
+    }
+    else if (algorithm != Control_StepSearch) /* No analytic setpoint, feed-forward uses the PI controller too */
+    {
+      Control_EstimateSource();
+      Control_PIVoltageCC(-PIController_RelativeError(setVoltage, measurementValues->unfilteredVoltage)); /* Higher current, lower voltage */
     }
     else
     {            
       Control_SWCC(setVoltage, &lastVoltage, measurementValues->unfilteredVoltage, &lastAction);
     }   
-         
-    measurementTimer = measurementValues->milliseconds;
   }  
   CurrentSetter_Do();
 }
 
+#ifdef MPPT_ENABLED
 void Control_SetMPPT(void)
-{  
-  lastPower = measurementValues->unfilteredPower;
-  lastLastPower = measurementValues->unfilteredPower;
-
-  stepSize = 0;
-  Control_LimitVoltageStepSize(&stepSize);
-
-  if (setVoltage == 0) // zero set voltage will attempt to initialize automatically
+{
+  if (transfer && (setVoltage == 0))
   {
-    CurrentSetter_SetCurrent(0);
-    CurrentSetter_Do();
-    MPPT_initialized = false;
+    Control_TransferVoltage();
+    MPPT_Start(VoltageSetter_GetVoltage()); /* Tracks from the operating point, the scans follow the scan period */
   }
   else
   {
-    VoltageSetter_SetVoltage(setVoltage);
-    VoltageSetter_Do();
-    MPPT_initialized = true;
+    MPPT_Start(setVoltage); /* Zero set voltage starts with a scan of the whole curve */
   }
-  measurementCounter = measurementValues->counter;
+  VoltageSetter_Do();
 }
 
 void Control_KeepMPPT(void)
 {
-  static Control_VoltageActions MPPTAction = Control_VoltageDown;
-  static Control_VoltageActions lastMPPTAction = Control_VoltageDown;
-  static Control_VoltageActions action;
+  MPPT_Do(bandwidthLimitCV);
+  VoltageSetter_Do();
+}
+#endif
 
-  // initialization
-  if (!MPPT_initialized)
+#ifdef SWEEP_ENABLED
+void Control_KeepSweep(void)
+{
+  Sweep_Do();
+  if (!Sweep_IsRunning())
   {
-    if (measurementValues->counter == (uint8_t)(measurementCounter + 5))
-    {      
-      VoltageSetter_SetVoltage((measurementValues->unfilteredVoltage * 9) / 10); // set 90% of open-circuit voltage
-      VoltageSetter_Do();
-      measurementCounter = measurementValues->counter;
-      MPPT_initialized = true;
-    }
-    else
-    {
-      CurrentSetter_Do();
-    }
-    return;
+    Control_StopLoad();
   }
+}
+#endif
 
-  // main loop
-  if (measurementValues->milliseconds - measurementTimer > CONTROL_BANDWIDTH_LIMIT_CV)
-  { 
-    action = MPPTAction;
-    if (measurementValues->unfilteredVoltage < VOLTMETER_THRESHOLD_VOLTAGE) /* Increase voltage on zero voltage */
-    {
-      stepSize = 0;
-      Control_LimitVoltageStepSize(&stepSize);
-      MPPTAction = Control_VoltageUp;
-    }
-    else if (measurementValues->unfilteredCurrent < AMMETER_THRESHOLD_VOLTAGE) /* Decrease voltage on zero current */
-    {
-      stepSize = 0;
-      Control_LimitVoltageStepSize(&stepSize);
-      MPPTAction = Control_VoltageDown;
-    }
-    else if (MPPTAction != lastMPPTAction) /* Different former actions - choose the one that led to more favourable outcome */
-    {
-      if ((measurementValues->unfilteredPower / 2 + lastLastPower / 2) < lastPower)
-      {
-        MPPTAction = lastMPPTAction; 
-      }
-    }
-    else if (lastPower > measurementValues->unfilteredPower) /* Both former action were the same,
-                                                                then judge if the last one was efficient or not.
-                                                                If the previous power was larger, reverse the action,
-                                                                otherwise stay with the current course */
-    {
-      if (MPPTAction == Control_VoltageUp)
-      {
-        MPPTAction = Control_VoltageDown;
-      }
-      else
-      {
-        MPPTAction = Control_VoltageUp;
-      }
-    }
-    
-    /* Now perform the computed action */
-    if (MPPTAction == lastMPPTAction) /* Increase step size when action did not change - dynamic step size */
-    {
-      Control_StepSizeVoltagePlus();
-    }
-    else /* Decrease step size when action is reversed */
-    {
-      Control_StepSizeVoltageMinus();
-    }  
-    
-    if (MPPTAction == Control_VoltageUp)
-    {        
-      VoltageSetter_Plus(stepSize); 
-    }
-    else
-    {
-      VoltageSetter_Minus(stepSize); 
-    }
-    
-    lastMPPTAction = action;
-    lastLastPower = lastPower;
-    lastPower = measurementValues->unfilteredPower;
-    measurementTimer = measurementValues->milliseconds;
+#ifdef DYNAMIC_ENABLED
+void Control_KeepDynamic(void)
+{
+  if (!Dynamic_IsRunning())
+  {
+    Control_StopLoad();
   }
-  VoltageSetter_Do();  
 }
+#endif
 
-//void Control_KeepMPPT(void)
-//{
-//  static Control_CurrentActions MPPTAction = Control_CurrentUp;
-//  static Control_CurrentActions lastMPPTAction = Control_CurrentUp;
-//  static Control_CurrentActions action;
-//
-//  if (MPPT_initialized == 0)
-//  {
-//    if (measurementValues->counter == measurementCounter + 10)
-//    {      
-//      VoltageSetter_SetVoltage((measurementValues->voltage * 9) / 10);
-//      VoltageSetter_Do();    
-//      measurementCounter = measurementValues->counter;
-//      MPPT_initialized = 1;
-//    }
-//    else
-//    {
-//      CurrentSetter_Do();
-//    }
-//    return;
-//  }
-//  else if (MPPT_initialized == 1)
-//  {
-//    if (measurementValues->counter == measurementCounter + 10)
-//    {
-//      MPPT_initialized = 2;
-//      CurrentSetter_SetCurrent(measurementValues->current);
-//      measurementCounter = measurementValues->counter;
-//      CurrentSetter_Do();
-//    }
-//    else
-//    {       
-//      VoltageSetter_Do();         
-//    }
-//    return;  
-//  }
-//  
-//  if (measurementCounter != measurementValues->counter)
-//  { 
-//    action = MPPTAction;
-//    if (measurementValues->current == 0) /* Increase current on zero current */
-//    {
-//      stepSize = CONTROL_MINIMUM_CURRENT_STEP;
-//      MPPTAction = Control_CurrentUp;
-//    }
-//    else if (measurementValues->voltage == 0) /* Decrease current on zero voltage */
-//    {
-//      stepSize = CONTROL_MINIMUM_CURRENT_STEP;
-//      MPPTAction = Control_CurrentDown;
-//    }
-//    else if (MPPTAction != lastMPPTAction) /* Different former actions - choose the one that led to more favourable outcome */
-//    {
-//      if ((measurementValues->power / 2 + lastLastPower / 2) < lastPower)
-//      {
-//        MPPTAction = lastMPPTAction; 
-//      }
-//    }
-//    else if (lastPower > measurementValues->power) /* Both former action were the same,
-//                                                      then judge if the last one was efficient or not.
-//                                                      If the previous power was larger, reverse the action,
-//                                                      otherwise stay with the current course */
-//    {
-//      if (MPPTAction == Control_CurrentUp)
-//      {
-//        MPPTAction = Control_CurrentDown;
-//      }
-//      else
-//      {
-//        MPPTAction = Control_CurrentUp;
-//      }
-//    }
-//    
-//    /* Now perform the computed action */
-//    if (MPPTAction == lastMPPTAction) /* Increase step size when action did not change - dynamic step size */
-//    {
-//      Control_StepSizeCurrentPlus();
-//    }
-//    else /* Decrease step size when action is reversed */
-//    {
-//      Control_StepSizeCurrentMinus();
-//    }  
-//    
-//    if (MPPTAction == Control_CurrentUp)
-//    {        
-//      CurrentSetter_Plus(stepSize); 
-//    }
-//    else
-//    {
-//      CurrentSetter_Minus(stepSize); 
-//    }
-//    
-//    lastMPPTAction = action;
-//    lastLastPower = lastPower;
-//    lastPower = measurementValues->power;
-//    measurementCounter = measurementValues->counter;
-//  }
-//  CurrentSetter_Do();  
-//}
+#ifdef WAVEFORM_ENABLED
+void Control_KeepWaveform(void)
+{
+  Waveform_Do();
+  if (!Waveform_IsRunning())
+  {
+    Control_StopLoad();
+  }
+}
+#endif
+
+#ifdef LOADLINE_ENABLED
+void Control_KeepLoadLine(void)
+{
+  LoadLine_Do();
+  CurrentSetter_Do();
+}
+#endif
+
+void Control_TransferCurrent(void)
+{
+  uint32_t current = measurementValues->current;
+
+  if (current >= (uint32_t)CURRENT_SETTER_MAXIMUM_HICURRENT)
+  {
+    current = (uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1);
+  }
+  CurrentSetter_SetCurrent(current);
+}
+
+void Control_TransferVoltage(void)
+{
+  uint32_t voltage = measurementValues->voltage;
+
+  if (voltage >= (uint32_t)VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE)
+  {
+    voltage = (uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1);
+  }
+  VoltageSetter_SetVoltage(voltage);
+}
 
 void Control_SetMaxCurrent(void)
 {
@@ -791,15 +1429,15 @@ void Control_SetCCCV(Control_CCCVStates state)
   switch (state)
   {
     case Control_CCCV_CC:
-      digitalWrite(CONTROL_CCCV_PIN, LOW);
+      FastPin<CONTROL_CCCV_PIN>::Clear();
       cccvState = state;
     break;
     case Control_CCCV_CV:
-      digitalWrite(CONTROL_CCCV_PIN, HIGH);
+      FastPin<CONTROL_CCCV_PIN>::Set();
       cccvState = state;
     break;
     case Control_CCCV_CC_SimpleAmmeter:
-      digitalWrite(CONTROL_CCCV_PIN, LOW);
+      FastPin<CONTROL_CCCV_PIN>::Clear();
       cccvState = state;
     break;
     default:
@@ -830,6 +1468,10 @@ void Control_LimitCurrentStepSize(uint32_t * stepSize)
   /* Get limit according to current range */
   RangeSwitcher_CurrentRanges currentRange = RangeSwitcher_GetCurrentRange();
   uint32_t maximumStep = currentRange == CurrentRange_HighCurrent ? CONTROL_MAXIMUM_HI_CURRENT_STEP : CONTROL_MAXIMUM_LO_CURRENT_STEP;
+  if (maximumStep > maximumCurrentStep)
+  {
+    maximumStep = maximumCurrentStep; /* Limit from the auto-tune */
+  }
   uint32_t minimumStep = currentRange == CurrentRange_HighCurrent ? CONTROL_MINIMUM_HI_CURRENT_STEP : CONTROL_MINIMUM_LO_CURRENT_STEP;
 
   /* Limit relative step size to under 40% of the measured current value */
@@ -883,6 +1525,10 @@ void Control_LimitVoltageStepSize(uint32_t * stepSize)
   /* Get limit according to voltage range */
   RangeSwitcher_VoltageRanges voltageRange = RangeSwitcher_GetVoltageRange();
   uint32_t maximumStep = voltageRange == VoltageRange_HighVoltage ? CONTROL_MAXIMUM_HI_VOLTAGE_STEP : CONTROL_MAXIMUM_LO_VOLTAGE_STEP;
+  if (maximumStep > maximumVoltageStep)
+  {
+    maximumStep = maximumVoltageStep; /* Limit from the auto-tune */
+  }
   uint32_t minimumStep = voltageRange == VoltageRange_HighVoltage ? CONTROL_MINIMUM_HI_VOLTAGE_STEP : CONTROL_MINIMUM_LO_VOLTAGE_STEP;
 
   /* Limit relative step size to under 40% of the measured voltage value */
@@ -1024,6 +1670,17 @@ void Control_SWCV(uint32_t setValue, uint32_t * lastValue, uint32_t presentValue
   *lastValue = presentValue;
 }
 
+bool Control_IsFoldingBack(void)
+{
+  #ifdef AUTOTUNE_ENABLED
+    if (AutoTune_IsRunning())
+    {
+      return false;
+    }
+  #endif
+  return foldback && (Control_Keep == &Control_KeepCurrent);
+}
+
 Control_CCCVStates Control_GetCCCV(void)
 {
   return cccvState;
@@ -1034,4 +1691,437 @@ const ErrorMessaging_Error * Control_GetError(void)
   return &ControlError;
 }
 
+void Control_PICC(int32_t error, uint32_t maximum)
+{
+  RangeSwitcher_CurrentRanges currentRange = RangeSwitcher_GetCurrentRange();
+  uint32_t scale = currentRange == CurrentRange_HighCurrent ? CONTROL_PI_MINIMUM_HI_CURRENT_SCALE : CONTROL_PI_MINIMUM_LO_CURRENT_SCALE;
+
+  /* Relative error is converted to current at the present operating point */
+  if (measurementValues->unfilteredCurrent > scale)
+  {
+    scale = measurementValues->unfilteredCurrent;
+  }
+  CurrentSetter_SetCurrent(PIController_Update(&piState, &ccGains, error, scale, maximum));
+}
+
+void Control_PICV(int32_t error, bool power)
+{
+  int32_t scale = Control_GetSourceScale(power);
+
+  if (scale == 0)
+  {
+    /* Until the source is known it is taken as a voltage source, as seen from the open circuit, with the smallest scale */
+    scale = (RangeSwitcher_GetVoltageRange() == VoltageRange_HighVoltage) ? CONTROL_PI_MINIMUM_HI_VOLTAGE_SCALE : CONTROL_PI_MINIMUM_LO_VOLTAGE_SCALE;
+    if (power)
+    {
+      error = -error;
+    }
+  }
+  else
+  {
+    if (scale < 0)
+    {
+      scale = -scale;
+      error = -error;
+    }
+    if (Control_IsBelowVoltageStep(error, scale))
+    {
+      return;
+    }
+  }
+  VoltageSetter_SetVoltage(PIController_Update(&piState, &cvGains, error, scale, (uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1)));
+}
+
+void Control_PIVoltageCC(int32_t error)
+{
+  RangeSwitcher_CurrentRanges currentRange = RangeSwitcher_GetCurrentRange();
+  uint32_t step = (currentRange == CurrentRange_HighCurrent) ? CONTROL_MINIMUM_HI_CURRENT_STEP : CONTROL_MINIMUM_LO_CURRENT_STEP;
+  uint32_t maximumScale = (currentRange == CurrentRange_HighCurrent) ? CONTROL_PI_MINIMUM_HI_CURRENT_SCALE : CONTROL_PI_MINIMUM_LO_CURRENT_SCALE;
+  uint64_t scale;
+
+  if (measurementValues->unfilteredVoltage < VOLTMETER_THRESHOLD_VOLTAGE)
+  {
+    PIController_Reset(&piState, measurementValues->unfilteredCurrent); /* The load asks for more than the source gives, the integral continues from the current of the source */
+  }
+  if (sourceResistance == 0)
+  {
+    Control_PICC(error, (uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1));
+    return;
+  }
+
+  /* The relative error is a part of the set voltage. The scale of a stiff source is limited to the present current as in
+   * Control_PICC, the knee of a current limit is not seen in the resistance until the voltage collapses */
+  scale = (((uint64_t)setVoltage) * 1000) / sourceResistance;
+  if (measurementValues->unfilteredCurrent > maximumScale)
+  {
+    maximumScale = measurementValues->unfilteredCurrent;
+  }
+  if (scale > maximumScale)
+  {
+    scale = maximumScale;
+  }
+  else if (scale < step)
+  {
+    scale = step;
+  }
+
+  /* An error below half a step of the DAC is left as it is, as in Control_IsBelowVoltageStep */
+  if (((uint64_t)((error < 0) ? -error : error)) * scale < ((uint64_t)step) * (PICONTROLLER_ONE / 2))
+  {
+    return;
+  }
+  CurrentSetter_SetCurrent(PIController_Update(&piState, &ccGains, error, (uint32_t)scale, (uint32_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1)));
+}
+
+int32_t Control_GetSourceScale(bool power)
+{
+  uint64_t voltage = measurementValues->unfilteredVoltage;
+  uint64_t drop = (((uint64_t)measurementValues->unfilteredCurrent) * sourceResistance) / 1000;
+  uint64_t divisor = voltage + drop;
+  uint64_t scale;
+  uint32_t step = (RangeSwitcher_GetVoltageRange() == VoltageRange_HighVoltage) ? CONTROL_MINIMUM_HI_VOLTAGE_STEP : CONTROL_MINIMUM_LO_VOLTAGE_STEP;
+
+  if ((sourceResistance == 0) || (measurementValues->unfilteredCurrent <= AMMETER_THRESHOLD_VOLTAGE))
+  {
+    return 0;
+  }
+
+  /* dV changes the current by -dV / r: dP / P = dV * (r * I - V) / (V * r * I), dR / R = dV * (V + r * I) / (V * r * I) */
+  if (power)
+  {
+    divisor = (drop > voltage) ? (drop - voltage) : (voltage - drop);
+  }
+  scale = (divisor > 0) ? ((voltage * drop) / divisor) : voltage;
+  if (scale > voltage)
+  {
+    scale = voltage; /* Flat power around the maximum power point */
+  }
+  else if (scale < step)
+  {
+    scale = step;
+  }
+  return (power && (drop <= voltage)) ? -(int32_t)scale : (int32_t)scale; /* Voltage source side of the maximum power point, higher voltage, lower power */
+}
+
+bool Control_IsBelowVoltageStep(int32_t error, uint32_t scale)
+{
+  uint32_t step = (RangeSwitcher_GetVoltageRange() == VoltageRange_HighVoltage) ? CONTROL_MINIMUM_HI_VOLTAGE_STEP : CONTROL_MINIMUM_LO_VOLTAGE_STEP;
+
+  return ((uint64_t)((error < 0) ? -error : error)) * scale < ((uint64_t)step) * (PICONTROLLER_ONE / 2);
+}
+
+void Control_FeedForwardCC(uint64_t current)
+{
+  if (current >= (uint64_t)CURRENT_SETTER_MAXIMUM_HICURRENT)
+  {
+    current = (uint64_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1);
+  }
+  CurrentSetter_SetCurrent((uint32_t)current);
+}
+
+void Control_FeedForwardSourceCV(bool power)
+{
+  uint64_t openVoltage, voltage;
+  int32_t error = power ? PIController_RelativeError(setPower, measurementValues->unfilteredPower) : PIController_RelativeError(setResistance, measurementValues->unfilteredResistance);
+
+  if (!Control_IsSourceSampleDue())
+  {
+    return;
+  }
+  if (!Control_EstimateSource() && sourceModelled && ((error > CONTROL_FEEDFORWARD_MAXIMUM_TRIM) || (error < -CONTROL_FEEDFORWARD_MAXIMUM_TRIM)))
+  {
+    sourceResistance = 0; /* The source left the line (current limit, knee of a panel), the PI controller finds the new one */
+  }
+  if ((sourceResistance == 0) || (measurementValues->unfilteredCurrent <= AMMETER_THRESHOLD_VOLTAGE))
+  {
+    Control_PICV(error, power);
+    sourceModelled = false;
+    return;
+  }
+  if (Control_IsBelowVoltageStep(error, abs(Control_GetSourceScale(power))))
+  {
+    sourceModelled = true;
+    return; /* Also the trim holds, it would walk the setpoint to the next step and back */
+  }
+
+  /* The load holds the set voltage, it is free of the noise of the voltmeter that on a stiff source means amperes */
+  openVoltage = ((uint64_t)VoltageSetter_GetVoltage()) + (((uint64_t)measurementValues->unfilteredCurrent) * sourceResistance) / 1000;
+  if (power)
+  {
+    /* V * (Voc - V) / r = P, the root on the side of the maximum power point where the source presently is */
+    uint64_t product = ((uint64_t)Control_TrimTarget(setPower, PIController_RelativeError(setPower, measurementValues->unfilteredPower))) * sourceResistance * 4000; /* 4 * P * r in uV^2 */
+    uint64_t square = openVoltage * openVoltage;
+    uint64_t root = (square > product) ? Control_SquareRoot(square - product) : 0; /* No solution above the maximum power of the line, aim at its maximum */
+    if (2 * ((uint64_t)VoltageSetter_GetVoltage()) > openVoltage)
+    {
+      voltage = (openVoltage + root) / 2;
+    }
+    else
+    {
+      voltage = (openVoltage - root) / 2;
+    }
+  }
+  else
+  {
+    uint32_t resistance = Control_TrimTarget(setResistance, PIController_RelativeError(setResistance, measurementValues->unfilteredResistance));
+    voltage = (openVoltage * resistance) / (resistance + sourceResistance); /* Divider of the source resistance and R */
+  }
+
+  if (voltage >= (uint64_t)VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE)
+  {
+    voltage = (uint64_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1);
+  }
+  VoltageSetter_SetVoltage((uint32_t)voltage);
+  PIController_Reset(&piState, (uint32_t)voltage); /* The PI controller continues from here if the source resistance is lost */
+  sourceModelled = true;
+}
+
+uint32_t Control_SquareRoot(uint64_t value)
+{
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62; /* Highest power of four */
+
+  while (bit > value)
+  {
+    bit >>= 2;
+  }
+  while (bit != 0)
+  {
+    if (value >= root + bit)
+    {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+bool Control_IsSourceSampleDue(void)
+{
+  if ((uint8_t)(measurementValues->counter - sourceCounter) < 2)
+  {
+    return false; /* The voltage and the current of this measurement may come from both sides of the last setpoint change */
+  }
+  sourceCounter = measurementValues->counter;
+  return true;
+}
+
+bool Control_EstimateSource(void)
+{
+  bool updated = false;
+  uint32_t voltage = measurementValues->unfilteredVoltage;
+  uint32_t current = measurementValues->unfilteredCurrent;
+  uint32_t voltageChange;
+  uint32_t currentChange;
+  uint32_t currentNoise = AMMETER_THRESHOLD_VOLTAGE;
+
+  /* The steps of the setter of the phase are exact, its meter adds only noise. Not if the source cannot follow the setter. */
+  if ((cccvState == Control_CCCV_CV) && (current > AMMETER_THRESHOLD_VOLTAGE))
+  {
+    voltage = VoltageSetter_GetVoltage();
+  }
+  else if ((cccvState != Control_CCCV_CV) && (voltage > VOLTMETER_THRESHOLD_VOLTAGE))
+  {
+    current = CurrentSetter_GetCurrent();
+    currentNoise = (RangeSwitcher_GetCurrentRange() == CurrentRange_HighCurrent) ? CONTROL_MINIMUM_HI_CURRENT_STEP : CONTROL_MINIMUM_LO_CURRENT_STEP;
+  }
+  voltageChange = (voltage > lastSourceVoltage) ? (voltage - lastSourceVoltage) : (lastSourceVoltage - voltage);
+  currentChange = (current > lastSourceCurrent) ? (current - lastSourceCurrent) : (lastSourceCurrent - current);
+
+  /* Only steps well above the noise and with opposite signs (a source, not a load) give the slope. A voltage step that
+   * leaves the current within the noise is a current source (power supply in current limit, panel below its knee),
+   * its slope is at least the step over the noise. */
+  if ((((currentChange > CONTROL_FEEDFORWARD_MINIMUM_CURRENT_CHANGE) && (currentChange > current / 64)) || (voltageChange > CONTROL_FEEDFORWARD_MINIMUM_VOLTAGE_CHANGE)) &&
+      (((voltage > lastSourceVoltage) != (current > lastSourceCurrent)) || (currentChange <= currentNoise)))
+  {
+    if (currentChange < currentNoise)
+    {
+      currentChange = currentNoise;
+    }
+    sourceResistance = (uint32_t)((((uint64_t)voltageChange) * 1000) / currentChange);
+    if (sourceResistance == 0)
+    {
+      sourceResistance = 1;
+    }
+    updated = true;
+  }
+  lastSourceVoltage = voltage;
+  lastSourceCurrent = current;
+  return updated;
+}
+
+uint32_t Control_TrimTarget(uint32_t setValue, int32_t error)
+{
+  int64_t trimmed;
+
+  if ((error < CONTROL_FEEDFORWARD_MAXIMUM_TRIM) && (error > -CONTROL_FEEDFORWARD_MAXIMUM_TRIM)) /* Large errors are the job of the setpoint, not of the trim */
+  {
+    trim += (int32_t)((((int64_t)error) * trimGain) >> 16);
+    if (trim > CONTROL_FEEDFORWARD_MAXIMUM_TRIM)
+    {
+      trim = CONTROL_FEEDFORWARD_MAXIMUM_TRIM;
+    }
+    else if (trim < -CONTROL_FEEDFORWARD_MAXIMUM_TRIM)
+    {
+      trim = -CONTROL_FEEDFORWARD_MAXIMUM_TRIM;
+    }
+  }
+
+  trimmed = (int64_t)setValue + ((((int64_t)setValue) * trim) >> 16);
+  if ((trimmed <= 0) || (trimmed > 0xFFFFFFFFLL))
+  {
+    return setValue;
+  }
+  return (uint32_t)trimmed;
+}
+
+void Control_ResetPI(uint32_t output)
+{
+  PIController_Reset(&piState, output);
+  trim = 0;
+  sourceResistance = tunedResistance;
+  sourceModelled = false;
+  lastSourceVoltage = measurementValues->unfilteredVoltage;
+  lastSourceCurrent = measurementValues->unfilteredCurrent;
+  sourceCounter = measurementValues->counter;
+  measurementCounter = measurementValues->counter; /* The first update waits for a measurement taken after the reset */
+  skipMeasurement = true;
+}
+
+bool Control_IsLoopDue(uint32_t bandwidthLimit)
+{
+  if (algorithm != Control_StepSearch)
+  {
+    if (measurementValues->counter == measurementCounter)
+    {
+      return false;
+    }
+    if (skipMeasurement) /* The voltmeter and the ammeter convert one after the other, the first measurement may still be half old */
+    {
+      skipMeasurement = false;
+      measurementCounter = measurementValues->counter;
+      return false;
+    }
+    if ((tunedResistance != 0) && (measurementValues->milliseconds - measurementTimer < bandwidthLimit)) /* Untuned, every measurement is processed */
+    {
+      return false;
+    }
+  }
+  else if (measurementValues->milliseconds - measurementTimer <= bandwidthLimit)
+  {
+    return false;
+  }
+  measurementCounter = measurementValues->counter;
+  measurementTimer = measurementValues->milliseconds;
+  return true;
+}
+
+void Control_ApplyTuning(const AutoTune_Result * result)
+{
+  if (result != NULL)
+  {
+    if (result->phase == Control_CCCV_CV)
+    {
+      bandwidthLimitCV = result->updateInterval;
+    }
+    else
+    {
+      bandwidthLimitCC = result->updateInterval;
+    }
+    maximumCurrentStep = result->maximumCurrentStep;
+    maximumVoltageStep = result->maximumVoltageStep;
+    tunedResistance = result->sourceResistance;
+  }
+  else
+  {
+    bandwidthLimitCC = CONTROL_BANDWIDTH_LIMIT_CC;
+    bandwidthLimitCV = CONTROL_BANDWIDTH_LIMIT_CV;
+    maximumCurrentStep = CONTROL_MAXIMUM_HI_CURRENT_STEP;
+    maximumVoltageStep = CONTROL_MAXIMUM_HI_VOLTAGE_STEP;
+    tunedResistance = 0;
+  }
+  Control_ResetPI(cccvState == Control_CCCV_CV ? VoltageSetter_GetVoltage() : CurrentSetter_GetCurrent());
+}
+
+void Control_SetParameter(Control_Parameters parameter, uint32_t value)
+{
+  switch (parameter)
+  {
+    case ControlParameter_Algorithm:
+      if (value < Control_AlgorithmsCount)
+      {
+        algorithm = (Control_Algorithms)value;
+        /* Continue from the present setter value */
+        Control_ResetPI(cccvState == Control_CCCV_CV ? VoltageSetter_GetVoltage() : CurrentSetter_GetCurrent());
+      }
+    break;
+    case ControlParameter_CCProportional:
+      ccGains.proportional = value;
+    break;
+    case ControlParameter_CCIntegral:
+      ccGains.integral = value;
+    break;
+    case ControlParameter_CCDerivative:
+      ccGains.derivative = value;
+    break;
+    case ControlParameter_CVProportional:
+      cvGains.proportional = value;
+    break;
+    case ControlParameter_CVIntegral:
+      cvGains.integral = value;
+    break;
+    case ControlParameter_CVDerivative:
+      cvGains.derivative = value;
+    break;
+    case ControlParameter_FeedForwardTrim:
+      trimGain = value;
+    break;
+    #ifdef MPPT_ENABLED
+      case ControlParameter_MPPTAlgorithm:
+        if (value < MPPT_AlgorithmsCount)
+        {
+          MPPT_SetAlgorithm((MPPT_Algorithms)value);
+        }
+      break;
+      case ControlParameter_MPPTScanPeriod:
+        MPPT_SetScanPeriod(value);
+      break;
+    #endif
+    case ControlParameter_SlewCurrent:
+      slewCurrent = value;
+    break;
+    case ControlParameter_SlewVoltage:
+      slewVoltage = value;
+    break;
+    case ControlParameter_SlewPower:
+      slewPower = value;
+    break;
+    case ControlParameter_SlewResistance:
+      slewResistance = value;
+    break;
+    case ControlParameter_MinimumVoltage:
+      minimumVoltage = value * 1000;
+      foldback = false;
+      EventBus_Subscribe(&foldbackSubscription, Event_Measurement);
+      #ifdef AUTOTUNE_ENABLED
+        if (AutoTune_IsRunning())
+        {
+          break; /* The identification drives the setter */
+        }
+      #endif
+      if (Control_Keep == &Control_KeepCurrent)
+      {
+        Control_SetCurrent(); /* The loop starts again from the set current */
+      }
+    break;
+    default:
+    break;
+  }
+}
+
 /* </Implementations> */ 
@@ -14,6 +14,7 @@
 
 #include "MightyWatt.h"
 #include "ErrorMessaging.h"
+#include "Communication.h"
 
 /* </Includes> */ 
 
@@ -35,6 +36,27 @@
 #define CONTROL_MINIMUM_HI_VOLTAGE_STEP    ((uint32_t)(VOLTSETTER_SLOPE_HI / (uint32_t)DAC_MAXIMUM + 1)) /* microvolts */
 #define CONTROL_MINIMUM_LO_VOLTAGE_STEP    ((uint32_t)(VOLTSETTER_SLOPE_LO / (uint32_t)DAC_MAXIMUM + 1)) /* microvolts */
 
+/* No gain keeps CV software, CP-CV and CR-CV off the knee of a supply in current limit: the knee is not seen before it
+ * is crossed and a step of one DAC code past it moves the voltage by volts, so the first step overshoots (the step search
+ * does not settle there at all) */
+#define CONTROL_DEFAULT_ALGORITHM          Control_PI
+#define CONTROL_PI_CC_PROPORTIONAL         6554 /* Q16, 0.1 */
+#define CONTROL_PI_CC_INTEGRAL             32768 /* Q16, 0.5 */
+#define CONTROL_PI_CC_DERIVATIVE           0
+#define CONTROL_PI_CV_PROPORTIONAL         0
+#define CONTROL_PI_CV_INTEGRAL             32768 /* Q16, 0.5, the error is scaled by the source resistance */
+#define CONTROL_PI_CV_DERIVATIVE           0
+#define CONTROL_RAMP_REBASE_TIME           1000000UL /* us, a ramp restarts from its present value once a second */
+#define CONTROL_FEEDFORWARD_TRIM_GAIN      16384 /* Q16, 0.25, integral gain of the trim on the relative error */
+#define CONTROL_FEEDFORWARD_MAXIMUM_TRIM   4096 /* Q16, the trim corrects the feed-forward setpoint by at most 1/16 */
+#define CONTROL_FEEDFORWARD_MINIMUM_CURRENT_CHANGE (AMMETER_THRESHOLD_VOLTAGE * 10) /* uA, smallest current step that gives the source resistance */
+#define CONTROL_FEEDFORWARD_MINIMUM_VOLTAGE_CHANGE VOLTMETER_THRESHOLD_VOLTAGE /* uV, smallest voltage step that gives the source resistance */
+#define CONTROL_PI_MINIMUM_HI_CURRENT_SCALE (CONTROL_MAXIMUM_HI_CURRENT_STEP / 16) /* 1/256 of the range, lets the PI controller start from zero current */
+#define CONTROL_PI_MINIMUM_LO_CURRENT_SCALE (CONTROL_MAXIMUM_LO_CURRENT_STEP / 16) /* 1/256 of the range */
+#define CONTROL_PI_MINIMUM_HI_VOLTAGE_SCALE (CONTROL_MAXIMUM_HI_VOLTAGE_STEP / 16) /* 1/256 of the range */
+#define CONTROL_PI_MINIMUM_LO_VOLTAGE_SCALE (CONTROL_MAXIMUM_LO_VOLTAGE_STEP / 16) /* 1/256 of the range */
+#define CONTROL_PROGRAM_DEVICE_MODES       (ControlDeviceMode_Sequencer | ControlDeviceMode_Discharge) /* Drive the setters through Control_SetMode */
+
 /* </Defines> */ 
 
 
@@ -62,6 +84,56 @@ enum Control_VoltageActions : uint8_t
   Control_VoltageUp
 };
 
+/**
+ * Control loops of the software-controlled modes (CP, CR, CV software)
+ */
+enum Control_Algorithms : uint8_t
+{
+  Control_StepSearch, /* Step up or down, enlarge the step while the direction holds, shrink it on reversal */
+  Control_PI, /* Fixed-point PI(D) controller, one update per measurement */
+  Control_FeedForward, /* Setpoint computed from every measurement (CC: I = P/V, I = V/R; CV: on the source line through the last two measurements) with a small integral trim; CV software uses the PI controller */
+  Control_AlgorithmsCount
+};
+
+/**
+ * Modes run by the device itself, bits of the mask of Control_StopDeviceModes
+ */
+enum Control_DeviceModes : uint8_t
+{
+  ControlDeviceMode_None = 0x00,
+  ControlDeviceMode_AutoTune = 0x01,
+  ControlDeviceMode_MPPT = 0x02,
+  ControlDeviceMode_Sweep = 0x04,
+  ControlDeviceMode_Sequencer = 0x08,
+  ControlDeviceMode_Discharge = 0x10,
+  ControlDeviceMode_Dynamic = 0x20,
+  ControlDeviceMode_Waveform = 0x40,
+  ControlDeviceMode_LoadLine = 0x80
+};
+
+/**
+ * Parameters set by WriteCommand_ControlParameter
+ * data[0]: parameter, data[1..3]: value (LSB first)
+ */
+enum Control_Parameters : uint8_t
+{
+  ControlParameter_Algorithm = 0, /* Control_Algorithms */
+  ControlParameter_CCProportional = 1, /* Q16, modes that drive the current setter (CP-CC, CR-CC, CV software) */
+  ControlParameter_CCIntegral = 2, /* Q16 */
+  ControlParameter_CCDerivative = 3, /* Q16 */
+  ControlParameter_CVProportional = 4, /* Q16, modes that drive the voltage setter (CP-CV, CR-CV) */
+  ControlParameter_CVIntegral = 5, /* Q16 */
+  ControlParameter_CVDerivative = 6, /* Q16 */
+  ControlParameter_FeedForwardTrim = 7, /* Q16, integral gain of the feed-forward trim */
+  ControlParameter_MPPTAlgorithm = 8, /* MPPT_Algorithms */
+  ControlParameter_MPPTScanPeriod = 9, /* ms, period of the global scan of MPPT, 0 scans only at the start and on a change */
+  ControlParameter_SlewCurrent = 10, /* uA/ms of CC, 0 applies the set value at once */
+  ControlParameter_SlewVoltage = 11, /* uV/ms of CV and CV software, 0 applies the set value at once */
+  ControlParameter_SlewPower = 12, /* uW/ms of CP-CC and CP-CV, 0 applies the set value at once */
+  ControlParameter_SlewResistance = 13, /* mOhm/ms of CR-CC and CR-CV, 0 applies the set value at once */
+  ControlParameter_MinimumVoltage = 14 /* mV, CC reduces the current to hold the voltage at or above it, 0 for plain CC */
+};
+
 /* </Enums> */ 
 
 
@@ -82,6 +154,43 @@ void Control_Do(void);
  */
 void Control_StopLoad(void);
 
+/**
+ * Starts a mode as its write command does
+ * Without a slew rate of the mode the set value is applied at once. With a slew rate the set value ramps to the
+ * new value: from the present set value if the mode runs, otherwise from the measured value of the mode, which
+ * soft-starts the load from zero current or power (and CV from the open-circuit voltage).
+ * A software mode (CP, CR, CV software, MPPT without a start voltage) that takes over a loaded operating point
+ * from another mode starts its setter at the measured current or voltage, so the switch does not move the load.
+ *
+ * @param mode - write command of the mode, WriteCommand_ConstantCurrent to WriteCommand_SimpleAmmeter
+ * @param value - set value in the unit of the mode (uA, uV, uW, mOhm)
+ */
+void Control_SetMode(Communication_WriteCommands mode, uint32_t value);
+
+/**
+ * Changes the set value of the running mode without restarting its control loop (ramps)
+ *
+ * @param mode - write command of the running mode, WriteCommand_ConstantCurrent to WriteCommand_ConstantVoltageSoftware
+ * @param value - set value in the unit of the mode (uA, uV, uW, mOhm)
+ */
+void Control_SetSetpoint(Communication_WriteCommands mode, uint32_t value);
+
+/**
+ * Returns the filtered measured value of a mode, the start of a ramp from the present operating point
+ *
+ * @param mode - write command of the mode
+ *
+ * @return - Measured value in the unit of the mode
+ */
+uint32_t Control_GetPresentValue(Communication_WriteCommands mode);
+
+/**
+ * Returns whether CC runs below its set current to hold the minimum voltage (ControlParameter_MinimumVoltage)
+ *
+ * @return - true if the minimum voltage limits the current, false if the set current does
+ */
+bool Control_IsFoldingBack(void);
+
 /**
  * Sets the desired phase for the op-amp that keeps constant values. 
  * Current and voltage have opposing phases for control and must be set according to the mode of the load.
@@ -15,6 +15,7 @@
 #include "CurrentSetter.h"
 #include "Configuration.h"
 #include "RangeSwitcher.h"
+#include "Latency.h"
 
 /* </Includes> */ 
 
@@ -23,21 +24,58 @@
 
 static ErrorMessaging_Error CurrentSetterError;
 static uint32_t presentCurrent;
+static bool dirty; /* Set when the set current changed and range, DAC value and CC/CV phase must be recomputed */
+static bool cachedAutorange; /* Autoranging permission used for the last computation */
+static RangeSwitcher_CurrentRanges cachedRange; /* Range resulting from the last computation */
+static uint16_t cachedDac; /* DAC value resulting from the last computation */
+static bool cachedOverload; /* The set current of the last computation was above the range, raised again on every pass */
 
 /* </Module variables> */ 
 
 
+/* <Declarations (prototypes)> */ 
+
+/**
+ * Switches the range with the DAC value of the new range, through an intermediate DAC value that shortens the glitch
+ * between the DAC update and the range pin
+ *
+ * @param range - new range
+ * @param dac - DAC value of the set current on the new range
+ *
+ * @return - true if the DAC was written
+ */
+static bool CurrentSetter_SwitchRange(RangeSwitcher_CurrentRanges range, uint16_t dac);
+
+/* </Declarations (prototypes)> */ 
+
+
 /* <Implementations> */ 
 
 void CurrentSetter_Init(void)
 {
   CurrentSetterError.errorCounter = 0;
   CurrentSetterError.error = ErrorMessaging_CurrentSetter_SetCurrentOverload;
+  dirty = true;
 }
 
 void CurrentSetter_Do(void)
 {
+  /* Skip the computation if nothing that affects the result has changed since the last pass */
+  if (!dirty &&
+      (cachedAutorange == RangeSwitcher_CanAutorangeCurrent()) &&
+      (cachedRange == RangeSwitcher_GetCurrentRange()) &&
+      (cachedDac == DACC_GetValue()) &&
+      (Control_GetCCCV() == Control_CCCV_CC))
+  {
+    if (cachedOverload)
+    {
+      ErrorMessaging_Raise(&CurrentSetterError, ErrorMessaging_CurrentSetter_SetCurrentOverload);
+    }
+    return;
+  }
+  
   uint32_t dac = 0;
+  bool overload = false;
   RangeSwitcher_CurrentRanges previousRange = RangeSwitcher_GetCurrentRange();
   Control_CCCVStates previousCCCVState = Control_GetCCCV();
   RangeSwitcher_CurrentRanges range = RangeSwitcher_CanAutorangeCurrent() ? CurrentRange_LowCurrent : CurrentRange_HighCurrent;
@@ -59,32 +97,15 @@ void CurrentSetter_Do(void)
     }
 
     /* Calculate DAC value */
-    switch (range)
+    dac = CurrentSetter_GetDAC(presentCurrent, range);
+    if (dac > DAC_MAXIMUM) /* Set current higher than maximum */
     {
-      case CurrentRange_HighCurrent:    
-        if ((int32_t)presentCurrent + CURRENTSETTER_OFFSET_HI > 0)
-        {
-          dac = ((((uint64_t)((int32_t)presentCurrent + CURRENTSETTER_OFFSET_HI))) << 16) / CURRENTSETTER_SLOPE_HI;        
-          if (dac > DAC_MAXIMUM) /* Set current higher than maximum */
-          {
-            CurrentSetterError.errorCounter++;
-            CurrentSetterError.error = ErrorMessaging_CurrentSetter_SetCurrentOverload;
-            dac = DAC_MAXIMUM;
-          }      
-        }
-      break;
-      case CurrentRange_LowCurrent:
-        if ((int32_t)presentCurrent + CURRENTSETTER_OFFSET_LO > 0)
-        {        
-          dac = ((((uint64_t)((int32_t)presentCurrent + CURRENTSETTER_OFFSET_LO))) << 16) / CURRENTSETTER_SLOPE_LO;
-          if (dac > DAC_MAXIMUM) /* Set current higher than maximum */
-          {
-            dac = DAC_MAXIMUM;
-          }          
-        }        
-      break;
-      default:      
-      return;
+      if (range == CurrentRange_HighCurrent)
+      {
+        ErrorMessaging_Raise(&CurrentSetterError, ErrorMessaging_CurrentSetter_SetCurrentOverload);
+        overload = true;
+      }
+      dac = DAC_MAXIMUM;
     }
   }
   else
@@ -92,40 +113,47 @@ void CurrentSetter_Do(void)
     dac = 0;
   }
 
-  /* Set range if low current */
-  if (range == CurrentRange_LowCurrent)
+  /* Set calculated DAC value, a new range with its DAC value precomputed */
+  #ifdef LATENCY_ENABLED
+    Latency_Probe(Probe_SetterComputed);
+  #endif
+  if ((range == previousRange) ? DACC_SetVoltage(dac & 0xFFFF) : CurrentSetter_SwitchRange(range, dac & 0xFFFF))
   {
-    RangeSwitcher_SetCurrentRange(range);
+    dirty = false;
   }
-  /* Set calculated DAC value */
-  if (!DACC_SetVoltage(dac & 0xFFFF))
+  else
   {
-    CurrentSetterError.errorCounter++;
-    CurrentSetterError.error = ErrorMessaging_CurrentSetter_SetCurrentOverload; 
+    ErrorMessaging_Raise(&CurrentSetterError, ErrorMessaging_CurrentSetter_SetCurrentOverload); 
   }
-  /* Set range if high current */
-  if (range == CurrentRange_HighCurrent)
-  {
-    RangeSwitcher_SetCurrentRange(range);
-  }  
   /* Set phase CC */
   Control_SetCCCV(Control_CCCV_CC);
 
-  /* If range or mode has changed, invalidate the next measurement because the measurement may occur during the change */
-  if ((previousRange != range) || (previousCCCVState != Control_CCCV_CC))
+  /* If mode has changed, invalidate the next measurement because the measurement may occur during the change, a range change blanks only the current */
+  if (previousCCCVState != Control_CCCV_CC)
   {
     Measurement_Invalidate();
   }
+
+  /* Remember the inputs and the result for the next pass */
+  cachedAutorange = RangeSwitcher_CanAutorangeCurrent();
+  cachedRange = range;
+  cachedDac = dac & 0xFFFF;
+  cachedOverload = overload;
 }
 
 void CurrentSetter_SetCurrent(uint32_t current)
 {
-  presentCurrent = current;
+  if (presentCurrent != current)
+  {
+    presentCurrent = current;
+    dirty = true;
+  }
 }
 
 void CurrentSetter_SetZero()
 {
   presentCurrent = 0;
+  dirty = true;
   Control_SetCCCV(Control_CCCV_CC); /* Set phase CC */  
   DACC_SetVoltage(0);
 }
@@ -166,6 +194,22 @@ void CurrentSetter_SetMaxCurrentThisRange(void)
   Control_SetCCCV(Control_CCCV_CC_SimpleAmmeter);
 }
 
+uint32_t CurrentSetter_GetDAC(uint32_t current, RangeSwitcher_CurrentRanges range)
+{
+  if (range == CurrentRange_HighCurrent)
+  {
+    if ((int32_t)current + CURRENTSETTER_OFFSET_HI > 0)
+    {
+      return ((((uint64_t)((int32_t)current + CURRENTSETTER_OFFSET_HI))) << 16) / CURRENTSETTER_SLOPE_HI;
+    }
+  }
+  else if ((int32_t)current + CURRENTSETTER_OFFSET_LO > 0)
+  {
+    return ((((uint64_t)((int32_t)current + CURRENTSETTER_OFFSET_LO))) << 16) / CURRENTSETTER_SLOPE_LO;
+  }
+  return 0;
+}
+
 uint32_t CurrentSetter_GetCurrent(void)
 {
   return presentCurrent;
@@ -176,4 +220,48 @@ const ErrorMessaging_Error * CurrentSetter_GetError(void)
   return &CurrentSetterError;
 }
 
+static bool CurrentSetter_SwitchRange(RangeSwitcher_CurrentRanges range, uint16_t dac)
+{
+  bool result;
+  uint32_t intermediate;
+  int32_t previousCurrent;
+
+  /* The high range sinks 8 times the current of the low range at the same DAC value. Between the DAC update and the
+   * range pin, for the stop condition of the I2C transaction, the new DAC value is on the old range. Between the pin
+   * and the DAC update, for the whole transaction, the old DAC value is on the new range. So the DAC first moves to the
+   * set current on the old range, then the new DAC value follows and the pin changes right after it, the current loop
+   * cannot follow the stop condition. Going up, the new DAC value on the low range sinks 8 times less. Going down, it
+   * sinks 8 times more, allowed up to twice the previous current. A larger step down changes the pin first, the old DAC
+   * value on the low range sinks 1/8 of the previous current, less than half the new one, for the transaction; the DAC
+   * then holds the previous current on the low range for one more transaction to shorten the recovery. The failure of
+   * an intermediate value is reported by DACC, the switch goes on with the new value. */
+  if (range == CurrentRange_LowCurrent)
+  {
+    previousCurrent = (int32_t)((((uint64_t)DACC_GetValue()) * CURRENTSETTER_SLOPE_HI) >> 16) - CURRENTSETTER_OFFSET_HI;
+    if (previousCurrent < 0)
+    {
+      previousCurrent = 0;
+    }
+    if (dac > CurrentSetter_GetDAC(((uint32_t)previousCurrent) << 1, CurrentRange_HighCurrent))
+    {
+      RangeSwitcher_SetCurrentRange(range);
+      intermediate = CurrentSetter_GetDAC((uint32_t)previousCurrent, CurrentRange_LowCurrent);
+      if (intermediate > dac)
+      {
+        DACC_SetVoltage((intermediate > DAC_MAXIMUM) ? DAC_MAXIMUM : intermediate);
+      }
+      return DACC_SetVoltage(dac);
+    }
+    intermediate = CurrentSetter_GetDAC(presentCurrent, CurrentRange_HighCurrent);
+  }
+  else
+  {
+    intermediate = CurrentSetter_GetDAC(presentCurrent, CurrentRange_LowCurrent);
+  }
+  DACC_SetVoltage((intermediate > DAC_MAXIMUM) ? DAC_MAXIMUM : intermediate);
+  result = DACC_SetVoltage(dac);
+  RangeSwitcher_SetCurrentRange(range);
+  return result;
+}
+
 /* </Implementations> */ 
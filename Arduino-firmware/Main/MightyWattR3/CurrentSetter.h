@@ -13,6 +13,7 @@
 
 #include "MightyWatt.h"
 #include "ErrorMessaging.h"
+#include "RangeSwitcher.h"
 
 /* </Includes> */ 
 
@@ -75,6 +76,16 @@ void CurrentSetter_Minus(uint32_t value);
  */
 void CurrentSetter_SetMaxCurrentThisRange(void);
 
+/**
+ * Computes the DAC value of a current in a range, without changing the setter
+ *
+ * @param current - current in uA
+ * @param range - current range in which the value is computed
+ *
+ * @return - DAC value, may be above DAC_MAXIMUM if the current is out of the range
+ */
+uint32_t CurrentSetter_GetDAC(uint32_t current, RangeSwitcher_CurrentRanges range);
+
 /**
  * Returns the current that is supposed to be set
  *
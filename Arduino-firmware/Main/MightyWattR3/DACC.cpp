@@ -10,15 +10,17 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "DACC.h"
+#include "Latency.h"
 
 /* </Includes> */ 
 
 
 /* <Module variables> */ 
 
-static uint16_t dacValue;
+static volatile uint16_t dacValue; /* Written by the timer callback too, the main loop accesses it with the interrupts disabled */
+static volatile uint16_t timerErrors; /* Failed writes of the timer callback, saturates */
 static ErrorMessaging_Error dacError;
 const static ErrorMessaging_Error * AD569xRError;
 
@@ -31,6 +33,7 @@ void DACC_Init(void)
 {
   AD569xR_Init();
   dacValue = 0;
+  timerErrors = 0;
   dacError.errorCounter = 0;
   dacError.error = ErrorMessaging_DACC_UpperLimitReached;
   AD569xRError = AD569xR_GetError();
@@ -38,23 +41,53 @@ void DACC_Init(void)
 
 bool DACC_SetVoltage(uint16_t value)
 {        
-  if (dacValue != value) /* Only update value if different from previous value */
+  if (DACC_GetValue() != value) /* Only update value if different from previous value */
   {
     if (AD569xR_Set(value)) /* check command success */
     {
+      HAL_DisableInterrupts();
       dacValue = value;
+      HAL_EnableInterrupts();
     }
     else
     {
-      dacError.errorCounter++;
-      dacError.error = AD569xRError->error;
+      ErrorMessaging_Raise(&dacError, AD569xRError->error);
       return false;
     }     
   }
   
+  #ifdef LATENCY_ENABLED
+    Latency_Probe(Probe_DACWritten);
+  #endif
   return true;
 }
 
+bool DACC_SetVoltageFromTimer(uint16_t value)
+{
+  /* No other callback nor the main loop runs until the callback returns, the value is accessed directly */
+  if (dacValue != value)
+  {
+    if (!AD569xR_SetFromTimer(value))
+    {
+      if (timerErrors < 0xFFFF)
+      {
+        timerErrors++;
+      }
+      return false;
+    }
+    dacValue = value;
+  }
+  return true;
+}
+
+uint16_t DACC_GetTimerErrors(void)
+{
+  HAL_DisableInterrupts();
+  uint16_t errors = timerErrors;
+  HAL_EnableInterrupts();
+  return errors;
+}
+
 bool DACC_SetPercentOfRange(uint8_t percentage)
 {  
   if (percentage >= 100)
@@ -70,14 +103,14 @@ bool DACC_SetPercentOfRange(uint8_t percentage)
 bool DACC_Plus(uint16_t value)
 {
   bool result = false;
-  if ((uint32_t)value + (uint32_t)dacValue <= DAC_MAXIMUM)
+  uint16_t present = DACC_GetValue();
+  if ((uint32_t)value + (uint32_t)present <= DAC_MAXIMUM)
   {
-    result = DACC_SetVoltage(dacValue + value);
+    result = DACC_SetVoltage(present + value);
   }
   else if (DACC_SetVoltage(DAC_MAXIMUM))
   {
-    dacError.errorCounter++;
-    dacError.error = ErrorMessaging_DACC_UpperLimitReached;
+    ErrorMessaging_Raise(&dacError, ErrorMessaging_DACC_UpperLimitReached);
   }
   return result;
 }
@@ -85,21 +118,24 @@ bool DACC_Plus(uint16_t value)
 bool DACC_Minus(uint16_t value)
 { 
   bool result = false;
-  if (dacValue >= value)
+  uint16_t present = DACC_GetValue();
+  if (present >= value)
   {
-    result = DACC_SetVoltage(dacValue - value);
+    result = DACC_SetVoltage(present - value);
   }
   else if (DACC_SetVoltage(0))
   {
-    dacError.errorCounter++;
-    dacError.error = ErrorMessaging_DACC_LowerLimitReached;
+    ErrorMessaging_Raise(&dacError, ErrorMessaging_DACC_LowerLimitReached);
   }
   return result;
 }
 
 uint16_t DACC_GetValue()
 {
-  return dacValue;
+  HAL_DisableInterrupts();
+  uint16_t value = dacValue;
+  HAL_EnableInterrupts();
+  return value;
 }
 
 const ErrorMessaging_Error * DACC_GetError(void)
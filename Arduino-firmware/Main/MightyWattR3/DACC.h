@@ -42,6 +42,23 @@ void DACC_Init(void);
  */
 bool DACC_SetVoltage(uint16_t value);
 
+/**
+ * Sets raw value to the DAC from the timer callback, not traced, a failed write is counted (DACC_GetTimerErrors)
+ * and keeps the previous value
+ *
+ * @param value - Raw voltage in LSBs, at most DAC_MAXIMUM
+ *
+ * @return - true if the DAC has the value
+ */
+bool DACC_SetVoltageFromTimer(uint16_t value);
+
+/**
+ * Gets the number of failed writes of the timer callback since the start
+ *
+ * @return - Number of failed writes, saturates
+ */
+uint16_t DACC_GetTimerErrors(void);
+
 /**
  * Sets value to the DAC corresponding to a percentage of full-scale range
  *
@@ -0,0 +1,193 @@
+/**
+ * Discharge.cpp
+ * Battery discharge test with the cutoff and the capacity accounting on the device
+ *
+ * 2018-03-05
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "Discharge.h"
+#include "Communication.h"
+#include "Control.h"
+#include "Measurement.h"
+#include "EventBus.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define DISCHARGE_MILLISECONDS_PER_HOUR     3600000UL
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+static Discharge_State state;
+static const Measurement_Values * measurementValues;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+static uint32_t cutoff; /* uV */
+static uint32_t debounce; /* ms */
+static uint32_t maximumTime; /* ms */
+static uint32_t maximumCharge; /* uAh */
+static uint32_t startTime; /* ms */
+static uint32_t lastTime; /* ms, end of the last integrated measurement */
+static uint32_t belowTime; /* ms, first measurement of the present run below the cutoff */
+static bool below; /* The last measurement was below the cutoff */
+static bool measured; /* A measurement of the test was integrated */
+static uint64_t chargeSum; /* uA * ms */
+static uint64_t energySum; /* uW * ms */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Ends the test
+ *
+ * @param status - reason of the end
+ */
+static void Discharge_Finish(Discharge_Status status);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Discharge_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  state.status = Discharge_Idle;
+}
+
+void Discharge_Do(void)
+{
+  if (state.status != Discharge_Running)
+  {
+    return;
+  }
+
+  if (EventBus_Take(&measurementSubscription))
+  {
+
+    /* Rectangle rule, the measurement stands for the time since the previous one */
+    uint32_t time = measurementValues->milliseconds;
+    chargeSum += ((uint64_t)measurementValues->unfilteredCurrent) * (time - lastTime);
+    energySum += ((uint64_t)measurementValues->unfilteredPower) * (time - lastTime);
+    lastTime = time;
+    state.charge = (uint32_t)(chargeSum / DISCHARGE_MILLISECONDS_PER_HOUR);
+    state.energy = (uint32_t)(energySum / DISCHARGE_MILLISECONDS_PER_HOUR);
+    if (!measured)
+    {
+      state.startVoltage = measurementValues->unfilteredVoltage;
+      measured = true;
+    }
+    state.endVoltage = measurementValues->unfilteredVoltage;
+
+    if (measurementValues->unfilteredVoltage < cutoff)
+    {
+      if (!below)
+      {
+        below = true;
+        belowTime = time;
+      }
+      if (time - belowTime >= debounce)
+      {
+        Discharge_Finish(Discharge_Cutoff);
+        return;
+      }
+    }
+    else
+    {
+      below = false;
+    }
+
+    if ((maximumCharge != DISCHARGE_NO_LIMIT) && (state.charge >= maximumCharge))
+    {
+      Discharge_Finish(Discharge_ChargeLimit);
+      return;
+    }
+  }
+
+  state.duration = HAL_Milliseconds() - startTime;
+  if ((maximumTime != DISCHARGE_NO_LIMIT) && (state.duration >= maximumTime))
+  {
+    Discharge_Finish(Discharge_TimeLimit);
+  }
+}
+
+bool Discharge_Start(const uint32_t * arguments, uint8_t count)
+{
+  bool valid = count >= DischargeArgument_Count;
+
+  if (valid)
+  {
+    uint32_t mode = arguments[DischargeArgument_Mode];
+    valid = (mode == WriteCommand_ConstantCurrent) || (mode == WriteCommand_ConstantPowerCC) || (mode == WriteCommand_ConstantPowerCV)
+            || (mode == WriteCommand_ConstantResistanceCC) || (mode == WriteCommand_ConstantResistanceCV);
+  }
+
+  if (!valid)
+  {
+    if (state.status != Discharge_Running)
+    {
+      state.status = Discharge_Invalid;
+    }
+    return false;
+  }
+
+  state.mode = (uint8_t)arguments[DischargeArgument_Mode];
+  cutoff = arguments[DischargeArgument_Cutoff];
+  debounce = arguments[DischargeArgument_Debounce];
+  maximumTime = arguments[DischargeArgument_MaximumTime];
+  maximumCharge = arguments[DischargeArgument_MaximumCharge];
+  Control_SetMode((Communication_WriteCommands)state.mode, arguments[DischargeArgument_Value]);
+
+  state.duration = 0;
+  state.charge = 0;
+  state.energy = 0;
+  state.startVoltage = 0;
+  state.endVoltage = 0;
+  chargeSum = 0;
+  energySum = 0;
+  below = false;
+  measured = false;
+  startTime = HAL_Milliseconds();
+  lastTime = startTime;
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement); /* Only the measurements after the start */
+  state.status = Discharge_Running;
+  return true;
+}
+
+void Discharge_Stop(void)
+{
+  if (state.status == Discharge_Running)
+  {
+    Discharge_Finish(Discharge_Aborted);
+  }
+}
+
+bool Discharge_IsRunning(void)
+{
+  return state.status == Discharge_Running;
+}
+
+const Discharge_State * Discharge_GetState(void)
+{
+  return &state;
+}
+
+static void Discharge_Finish(Discharge_Status status)
+{
+  state.status = status;
+  state.duration = HAL_Milliseconds() - startTime;
+}
+
+/* </Implementations> */
@@ -0,0 +1,138 @@
+/**
+ * Discharge.h
+ * Battery discharge test with the cutoff and the capacity accounting on the device
+ *
+ * 2018-03-05
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The test runs a CC, CP or CR mode and integrates the charge and the energy from every measurement (unfiltered
+ * current and power times the time since the previous measurement). The load is switched off in the pass of the
+ * measurement that ends the test: the voltage below the cutoff for the debounce time, the maximum time or the
+ * maximum charge. The host reads the summary when it likes, its speed does not change the result.
+ * A mode command, another device-resident mode or the limiter aborts the test, the summary then holds the values
+ * until the abort.
+ */
+
+#ifndef DISCHARGE_H
+#define DISCHARGE_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define DISCHARGE_ENABLED                /* Battery tests with cutoff, not on UNO (flash) */
+#endif
+#define DISCHARGE_NO_LIMIT                  0 /* Maximum time or charge that does not end the test */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum Discharge_Status : uint8_t
+{
+  Discharge_Idle, /* No test since power-up */
+  Discharge_Running,
+  Discharge_Cutoff, /* The voltage stayed below the cutoff for the debounce time, the load is off */
+  Discharge_TimeLimit, /* The maximum time elapsed, the load is off */
+  Discharge_ChargeLimit, /* The maximum charge was drawn, the load is off */
+  Discharge_Aborted, /* Stop command, mode command or limiter */
+  Discharge_Invalid /* The last start command had invalid arguments, nothing was changed */
+};
+
+/**
+ * data[0] of WriteCommand_Discharge
+ */
+enum Discharge_Commands : uint8_t
+{
+  DischargeCommand_Start = 0, /* Starts the test with the arguments in the order of Discharge_Arguments */
+  DischargeCommand_Stop = 1 /* Stops the test and switches the load off */
+};
+
+/**
+ * Arguments of DischargeCommand_Start, sent by WriteCommand_Argument in this order
+ */
+enum Discharge_Arguments : uint8_t
+{
+  DischargeArgument_Mode, /* WriteCommand_ConstantCurrent or a CP or CR write command */
+  DischargeArgument_Value, /* uA, uW or mOhm */
+  DischargeArgument_Cutoff, /* uV */
+  DischargeArgument_Debounce, /* ms below the cutoff that end the test, 0 ends it on the first measurement */
+  DischargeArgument_MaximumTime, /* ms, DISCHARGE_NO_LIMIT for none */
+  DischargeArgument_MaximumCharge, /* uAh, DISCHARGE_NO_LIMIT for none */
+  DischargeArgument_Count
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Summary of the last test
+ */
+struct Discharge_State
+{
+  Discharge_Status status;
+  uint8_t mode; /* Write command of the mode */
+  uint32_t duration; /* ms, from the start to the end, or until now while running */
+  uint32_t charge; /* uAh */
+  uint32_t energy; /* uWh */
+  uint32_t startVoltage; /* uV, first measurement of the test */
+  uint32_t endVoltage; /* uV, last measurement of the test */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void Discharge_Init(void);
+
+/**
+ * Executable function which must be called periodically while the test runs, before the keeper of the mode
+ */
+void Discharge_Do(void);
+
+/**
+ * Starts a test and its mode
+ *
+ * @param arguments - array of DischargeArgument_Count arguments in the order of Discharge_Arguments
+ * @param count - number of the arguments in the array
+ *
+ * @return - true if the arguments are valid and the test runs
+ */
+bool Discharge_Start(const uint32_t * arguments, uint8_t count);
+
+/**
+ * Stops a running test, the setters are left to the caller
+ */
+void Discharge_Stop(void);
+
+/**
+ * Returns whether the test runs
+ *
+ * @return - true while the test watches the measurements
+ */
+bool Discharge_IsRunning(void);
+
+/**
+ * Returns the summary of the last test
+ *
+ * @return - Pointer to constant state
+ */
+const Discharge_State * Discharge_GetState(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* DISCHARGE_H */
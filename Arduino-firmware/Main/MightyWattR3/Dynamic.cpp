@@ -0,0 +1,221 @@
+/**
+ * Dynamic.cpp
+ * Dynamic (transient) load, the current alternates between two levels on the timer interrupt
+ *
+ * 2018-03-03
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "Dynamic.h"
+#include "Control.h"
+#include "CurrentSetter.h"
+#include "DACC.h"
+#include "Measurement.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static Dynamic_State state;
+static uint16_t dacs[2]; /* DAC values of levels A and B in the locked range */
+static uint32_t levelTimes[2]; /* us, parts of the period at levels A and B including the edge into them */
+static uint32_t steps; /* DAC writes of one edge, the last one sets the level */
+static uint32_t stepTime; /* us, between the writes of an edge */
+static int32_t increments[2]; /* Q16 DAC step of the edges into levels A and B */
+static uint16_t startErrors; /* DACC_GetTimerErrors at the start */
+
+/* Written by the timer callback */
+static volatile uint8_t presentLevel; /* Level of the last write */
+static volatile uint32_t edges;
+static uint8_t nextLevel; /* Level of the next write */
+static uint32_t nextStep; /* Write of the edge at the next callback, 1 to steps */
+static uint32_t position; /* Q16 DAC value of the last write of the edge */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Timer callback, writes the DAC and plans the period that follows the next callback
+ */
+static void Dynamic_Tick(void);
+
+/**
+ * Returns the time from a write to the next one
+ *
+ * @param level - 0 for level A, 1 for level B
+ * @param step - write of the edge, 1 to steps
+ *
+ * @return - Time in us
+ */
+static uint32_t Dynamic_GetDuration(uint8_t level, uint32_t step);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Dynamic_Init(void)
+{
+  state.status = Dynamic_Idle;
+  state.range = CurrentRange_HighCurrent;
+  state.writeErrors = 0;
+}
+
+bool Dynamic_Start(const uint32_t * arguments, uint8_t count)
+{
+  uint32_t period = 0;
+  uint64_t transition = 0; /* us, time of one edge */
+  uint32_t times[2] = {0, 0};
+  uint32_t edgeSteps = 1;
+  bool valid = count >= DynamicArgument_Count;
+
+  if (valid)
+  {
+    valid = (arguments[DynamicArgument_LevelA] < CURRENT_SETTER_MAXIMUM_HICURRENT) && (arguments[DynamicArgument_LevelB] < CURRENT_SETTER_MAXIMUM_HICURRENT)
+            && (arguments[DynamicArgument_Frequency] > 0) && (arguments[DynamicArgument_Duty] <= DYNAMIC_DUTY_SCALE);
+  }
+
+  if (valid)
+  {
+    period = 1000000000UL / arguments[DynamicArgument_Frequency];
+    times[0] = (uint32_t)(((uint64_t)period * arguments[DynamicArgument_Duty]) / DYNAMIC_DUTY_SCALE);
+    times[1] = period - times[0];
+    if (arguments[DynamicArgument_SlewRate] > 0)
+    {
+      uint32_t span = (arguments[DynamicArgument_LevelA] > arguments[DynamicArgument_LevelB]) ? (arguments[DynamicArgument_LevelA] - arguments[DynamicArgument_LevelB]) : (arguments[DynamicArgument_LevelB] - arguments[DynamicArgument_LevelA]);
+      transition = ((uint64_t)span * 1000) / arguments[DynamicArgument_SlewRate];
+    }
+    /* Both levels must be held after their edge for at least one interval */
+    valid = (period <= DYNAMIC_MAXIMUM_PERIOD) && (transition + DYNAMIC_MINIMUM_INTERVAL <= times[0]) && (transition + DYNAMIC_MINIMUM_INTERVAL <= times[1]);
+  }
+
+  if (!valid)
+  {
+    if (state.status != Dynamic_Running)
+    {
+      state.status = Dynamic_Invalid;
+    }
+    return false;
+  }
+
+  HAL_TimerStop();
+  edgeSteps = (uint32_t)(transition / DYNAMIC_MINIMUM_INTERVAL);
+  if (edgeSteps < 1)
+  {
+    edgeSteps = 1; /* Faster than the DAC can follow, one step */
+  }
+  steps = edgeSteps;
+  stepTime = (uint32_t)(transition / edgeSteps);
+  levelTimes[0] = times[0];
+  levelTimes[1] = times[1];
+
+  /* The range that fits both levels is kept until the stop */
+  uint32_t highest = (arguments[DynamicArgument_LevelA] > arguments[DynamicArgument_LevelB]) ? arguments[DynamicArgument_LevelA] : arguments[DynamicArgument_LevelB];
+  state.range = ((highest > CURRENTSETTER_HYSTERESIS_UP) || (RangeSwitcher_CanAutorangeCurrent() == false)) ? CurrentRange_HighCurrent : CurrentRange_LowCurrent;
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    uint32_t dac = 0; /* True zero on zero current, as the current setter */
+    if (arguments[DynamicArgument_LevelA + i] > 0)
+    {
+      dac = CurrentSetter_GetDAC(arguments[DynamicArgument_LevelA + i], state.range);
+    }
+    dacs[i] = (dac > DAC_MAXIMUM) ? DAC_MAXIMUM : (uint16_t)dac;
+  }
+  /* Steps of one edge computed from Q16 ends, a single step sets the level directly */
+  increments[0] = (steps > 1) ? (int32_t)((((int64_t)dacs[0] - dacs[1]) << 16) / (int32_t)steps) : 0;
+  increments[1] = (steps > 1) ? (int32_t)((((int64_t)dacs[1] - dacs[0]) << 16) / (int32_t)steps) : 0;
+
+  /* Level A, the range switches on the side of the smaller current as in the current setter */
+  if (state.range == CurrentRange_LowCurrent)
+  {
+    RangeSwitcher_SetCurrentRange(state.range);
+  }
+  DACC_SetVoltage(dacs[0]);
+  if (state.range == CurrentRange_HighCurrent)
+  {
+    RangeSwitcher_SetCurrentRange(state.range);
+  }
+  Control_SetCCCV(Control_CCCV_CC);
+  Measurement_Invalidate();
+
+  presentLevel = 0;
+  edges = 0;
+  startErrors = DACC_GetTimerErrors();
+  state.writeErrors = 0;
+  nextLevel = 1;
+  nextStep = 1;
+  position = ((uint32_t)dacs[0]) << 16;
+  state.status = Dynamic_Running;
+  HAL_TimerStart(Dynamic_GetDuration(0, steps), &Dynamic_Tick);
+  HAL_TimerSetPeriod(Dynamic_GetDuration(nextLevel, nextStep));
+  return true;
+}
+
+void Dynamic_Stop(void)
+{
+  if (state.status == Dynamic_Running)
+  {
+    HAL_TimerStop();
+    state.status = Dynamic_Idle;
+  }
+}
+
+bool Dynamic_IsRunning(void)
+{
+  return state.status == Dynamic_Running;
+}
+
+const Dynamic_State * Dynamic_GetState(void)
+{
+  HAL_DisableInterrupts();
+  state.level = presentLevel;
+  state.edges = edges;
+  HAL_EnableInterrupts();
+  if (state.status == Dynamic_Running)
+  {
+    state.writeErrors = DACC_GetTimerErrors() - startErrors;
+  }
+  return &state;
+}
+
+static void Dynamic_Tick(void)
+{
+  presentLevel = nextLevel;
+  if (nextStep == 1)
+  {
+    edges++;
+  }
+  if (nextStep < steps)
+  {
+    position += increments[nextLevel];
+    DACC_SetVoltageFromTimer((uint16_t)(position >> 16));
+    nextStep++;
+  }
+  else
+  {
+    DACC_SetVoltageFromTimer(dacs[nextLevel]); /* Exact level at the end of the edge */
+    position = ((uint32_t)dacs[nextLevel]) << 16;
+    nextLevel ^= 1;
+    nextStep = 1;
+  }
+  HAL_TimerSetPeriod(Dynamic_GetDuration(nextLevel, nextStep));
+}
+
+static uint32_t Dynamic_GetDuration(uint8_t level, uint32_t step)
+{
+  if (step < steps)
+  {
+    return stepTime;
+  }
+  return levelTimes[level] - (steps - 1) * stepTime;
+}
+
+/* </Implementations> */
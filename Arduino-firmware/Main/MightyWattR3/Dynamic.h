@@ -0,0 +1,133 @@
+/**
+ * Dynamic.h
+ * Dynamic (transient) load, the current alternates between two levels on the timer interrupt
+ *
+ * 2018-03-03
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The current steps from level A to level B and back at the set frequency and duty cycle, for transient tests
+ * of power supplies. The DAC is written by the timer callback (HAL_TimerStart), the main loop and the host do not
+ * take part in the waveform. The edges are on the timer schedule: the I2C transfers of the main loop (ADC, DAC)
+ * start only when they end before the next callback (HAL_I2CReserve), so the edge is late by the interrupt latency
+ * and the own DAC write (about 400 us at 100 kHz, the same on every edge) and the main loop waits instead. A write
+ * that fails (DAC not acknowledging, a transfer that overran its estimate) keeps the previous value and is counted
+ * in the state. The DAC values of both levels are computed at the start and the current range is locked for the
+ * whole waveform, a range switch would glitch the current.
+ * With a slew rate, the edge is a staircase of DAC writes at least DYNAMIC_MINIMUM_INTERVAL apart that runs
+ * for the time the slew rate gives, starting at the edge.
+ */
+
+#ifndef DYNAMIC_H
+#define DYNAMIC_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "RangeSwitcher.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define DYNAMIC_ENABLED                  /* Two-level load on the timer, not on UNO (flash) */
+#endif
+#define DYNAMIC_MINIMUM_INTERVAL            1000 /* us, between DAC writes: one write and one waited transfer on the I2C bus */
+#define DYNAMIC_MAXIMUM_PERIOD              100000000UL /* us, period at the lowest frequency (10 mHz) */
+#define DYNAMIC_DUTY_SCALE                  10000 /* Duty cycle of 100 % */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum Dynamic_Status : uint8_t
+{
+  Dynamic_Idle, /* No waveform, stopped by the stop command, a new mode or the limiter */
+  Dynamic_Running,
+  Dynamic_Invalid /* The last start command had invalid arguments, nothing was changed */
+};
+
+/**
+ * data[0] of WriteCommand_Dynamic
+ */
+enum Dynamic_Commands : uint8_t
+{
+  DynamicCommand_Start = 0, /* Starts the waveform with the arguments in the order of Dynamic_Arguments */
+  DynamicCommand_Stop = 1 /* Stops the waveform and switches the load off */
+};
+
+/**
+ * Arguments of DynamicCommand_Start, sent by WriteCommand_Argument in this order
+ */
+enum Dynamic_Arguments : uint8_t
+{
+  DynamicArgument_LevelA, /* uA, the waveform starts at this level */
+  DynamicArgument_LevelB, /* uA */
+  DynamicArgument_Frequency, /* mHz */
+  DynamicArgument_Duty, /* 0.01 %, part of the period at level A */
+  DynamicArgument_SlewRate, /* uA/ms of both edges, 0 for a step */
+  DynamicArgument_Count
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * State of the waveform
+ */
+struct Dynamic_State
+{
+  Dynamic_Status status;
+  uint8_t level; /* 0 at or towards level A, 1 at or towards level B */
+  RangeSwitcher_CurrentRanges range; /* Locked current range */
+  uint32_t edges; /* Edges since the start */
+  uint16_t writeErrors; /* Failed DAC writes since the start, saturates */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void Dynamic_Init(void);
+
+/**
+ * Starts the waveform, a running waveform is restarted
+ *
+ * @param arguments - array of DynamicArgument_Count arguments in the order of Dynamic_Arguments
+ * @param count - number of the arguments in the array
+ *
+ * @return - true if the arguments are valid and the waveform runs
+ */
+bool Dynamic_Start(const uint32_t * arguments, uint8_t count);
+
+/**
+ * Stops the waveform, the DAC is left at its last value for the caller
+ */
+void Dynamic_Stop(void);
+
+/**
+ * Returns whether the waveform runs
+ *
+ * @return - true while the DAC is written by this module
+ */
+bool Dynamic_IsRunning(void);
+
+/**
+ * Returns the state of the waveform
+ *
+ * @return - Pointer to constant state, consistent with the timer callback at the time of the call
+ */
+const Dynamic_State * Dynamic_GetState(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* DYNAMIC_H */
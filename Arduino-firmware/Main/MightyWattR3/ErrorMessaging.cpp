@@ -8,23 +8,10 @@
  
 /* <Includes> */ 
 
-#include "AD569xR.h"
-#include "ADC.h"
-#include "ADS1x15.h"
-#include "Ammeter.h"
-#include "Communication.h"
-#include "Control.h"
-#include "CurrentSetter.h"
-#include "DACC.h"
-#include "Limiter.h"
-#include "Measurement.h"
-#include "Thermometer.h"
-#include "VoltageSetter.h"
-#include "Voltmeter.h"
 #include "Flashreader.h"
 #include "ErrorMessaging.h"
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "MightyWatt.h"
 
 /* </Includes> */ 
@@ -61,7 +48,7 @@ static const char VoltageSetter_SetVoltageOverload[] FLASHMEMORY = "Requested vo
 static const char Voltmeter_VoltageOverload[] FLASHMEMORY = "Voltmeter overload";
 static const char Voltmeter_NegativeVoltage[] FLASHMEMORY = "Voltmeter negative voltage detected";
 
-const char * ErrorMessaging_ErrorNames[] = 
+static const char * const ErrorMessaging_ErrorNames[] FLASHMEMORY = 
 {
   ADC_Overload, ADC_NotResponding, ADS1x15_ResultNotReady, AD569xR_Overload, Ammeter_CurrentOverload, Ammeter_NegativeCurrent,
   Communication_CommandTimeout, CurrentSetter_SetCurrentOverload, DACC_Overload, DACC_UpperLimitReached, DACC_LowerLimitReached,
@@ -69,73 +56,7 @@ const char * ErrorMessaging_ErrorNames[] =
   Measurement_Invalid, Thermometer_HardwareFault, VoltageSetter_SetVoltageOverload, Voltmeter_VoltageOverload, Voltmeter_NegativeVoltage
 };
 
-const uint8_t ErrorMessaging_ErrorSizes[] =
-{
-  sizeof(ADC_Overload) / sizeof(char),
-  sizeof(ADC_NotResponding) / sizeof(char),
-  sizeof(ADS1x15_ResultNotReady) / sizeof(char),
-  sizeof(AD569xR_Overload) / sizeof(char),
-  sizeof(Ammeter_CurrentOverload) / sizeof(char),
-  sizeof(Ammeter_NegativeCurrent) / sizeof(char),
-  
-  sizeof(Communication_CommandTimeout) / sizeof(char),
-  sizeof(CurrentSetter_SetCurrentOverload) / sizeof(char),
-  sizeof(DACC_Overload) / sizeof(char),
-  sizeof(DACC_UpperLimitReached) / sizeof(char),
-  sizeof(DACC_LowerLimitReached) / sizeof(char),
-  
-  sizeof(Limiter_CurrentOverload) / sizeof(char),
-  sizeof(Limiter_VoltageOverload) / sizeof(char),
-  sizeof(Limiter_PowerOverload) / sizeof(char),
-  sizeof(Limiter_SOAExceeded) / sizeof(char),
-  sizeof(Limiter_Overheat) / sizeof(char),
-  sizeof(Limiter_HardwareFault) / sizeof(char),
-  
-  sizeof(Measurement_Invalid) / sizeof(char),
-  sizeof(Thermometer_HardwareFault) / sizeof(char),
-  sizeof(VoltageSetter_SetVoltageOverload) / sizeof(char),
-  sizeof(Voltmeter_VoltageOverload) / sizeof(char),
-  sizeof(Voltmeter_NegativeVoltage) / sizeof(char)
-};
-
-static const ErrorMessaging_Error * AD569xRError;
-static uint8_t AD569xRErrorCounter;
-
-static const ErrorMessaging_Error * ADCError[ADC_CHANNEL_COUNT];
-static uint8_t ADCErrorCounter[ADC_CHANNEL_COUNT];
-
-static const ErrorMessaging_Error * ADS1x15Error;
-static uint8_t ADS1x15ErrorCounter;
-
-static const ErrorMessaging_Error * AmmeterError;
-static uint8_t AmmeterErrorCounter;
-
-static const ErrorMessaging_Error * CommunicationError;
-static uint8_t CommunicationErrorCounter;
-
-static const ErrorMessaging_Error * ControlError;
-static uint8_t ControlErrorCounter;
-
-static const ErrorMessaging_Error * CurrentSetterError;
-static uint8_t CurrentSetterErrorCounter;
-
-static const ErrorMessaging_Error * DACError;
-static uint8_t DACErrorCounter;
-
-static const ErrorMessaging_Error * LimiterError;
-static uint8_t LimiterErrorCounter;
-
-static const ErrorMessaging_Error * MeasurementError;
-static uint8_t MeasurementErrorCounter;
-
-static const ErrorMessaging_Error * ThermometerError;
-static uint8_t ThermometerErrorCounter;
-
-static const ErrorMessaging_Error * VoltageSetterError;
-static uint8_t VoltageSetterErrorCounter;
-
-static const ErrorMessaging_Error * VoltmeterError;
-static uint8_t VoltmeterErrorCounter;
+static uint32_t errorFlags; /* Errors raised since the last read of the flags, one bit per error */
 
 /* </Module variables> */ 
 
@@ -144,148 +65,33 @@ static uint8_t VoltmeterErrorCounter;
 
 void ErrorMessaging_Init(void)
 {  
-  uint8_t i;
-  
-  AD569xRError = AD569xR_GetError();
-  AD569xRErrorCounter = AD569xRError->errorCounter;
-  
-  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
-  {
-    ADCError[i] = ADC_GetError((ADC_Channels)i);
-    ADCErrorCounter[i] = ADCError[i]->errorCounter;
-  }
+  errorFlags = 0;
+}
 
-  ADS1x15Error = ADS1x15_GetError();
-  ADS1x15ErrorCounter = ADS1x15Error->errorCounter;
-  
-  AmmeterError = Ammeter_GetError();
-  AmmeterErrorCounter = AmmeterError->errorCounter;
-  
-  CommunicationError = Communication_GetError();
-  CommunicationErrorCounter = CommunicationError->errorCounter;
-  
-  ControlError = Control_GetError();
-  ControlErrorCounter = ControlError->errorCounter;
-  
-  CurrentSetterError = CurrentSetter_GetError();
-  CurrentSetterErrorCounter = CurrentSetterError->errorCounter;
-  
-  DACError = DACC_GetError();
-  DACErrorCounter = DACError->errorCounter;
-  
-  LimiterError = Limiter_GetError();
-  LimiterErrorCounter = LimiterError->errorCounter;
-  
-  MeasurementError = Measurement_GetError();
-  MeasurementErrorCounter = MeasurementError->errorCounter;
-  
-  ThermometerError = Thermometer_GetError();
-  ThermometerErrorCounter = ThermometerError->errorCounter;
-  
-  VoltageSetterError = VoltageSetter_GetError();
-  VoltageSetterErrorCounter = VoltageSetterError->errorCounter;
-  
-  VoltmeterError = Voltmeter_GetError();
-  VoltmeterErrorCounter = VoltmeterError->errorCounter;
+void ErrorMessaging_Raise(ErrorMessaging_Error * error, ErrorMessaging_Errors code)
+{
+  error->errorCounter++;
+  error->error = code;
+  errorFlags |= 1UL << ((uint8_t)code);
 }
 
 uint32_t ErrorMessaging_GetErrorFlags(void)
 {
-  uint8_t i;
-  uint32_t flag = 0;  
-  
-  if (AD569xRErrorCounter != AD569xRError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(AD569xRError->error));
-    AD569xRErrorCounter = AD569xRError->errorCounter;
-  }
-  
-  for (i = 0; i < ADC_CHANNEL_COUNT; i++)
-  {
-    if (ADCErrorCounter[i] != ADCError[i]->errorCounter)
-    {
-      flag |= 1UL << ((uint8_t)(ADCError[i]->error));
-      ADCErrorCounter[i] = ADCError[i]->errorCounter;
-    }
-  }
-  
-  if (ADS1x15ErrorCounter != ADS1x15Error->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(ADS1x15Error->error));
-    ADS1x15ErrorCounter = ADS1x15Error->errorCounter;
-  }
-  
-  if (AmmeterErrorCounter != AmmeterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(AmmeterError->error));
-    AmmeterErrorCounter = AmmeterError->errorCounter;
-  }
-  
-  if (CommunicationErrorCounter != CommunicationError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(CommunicationError->error));
-    CommunicationErrorCounter = CommunicationError->errorCounter;
-  }
-  
-  if (ControlErrorCounter != ControlError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(ControlError->error));
-    ControlErrorCounter = ControlError->errorCounter;
-  }
-  
-  if (CurrentSetterErrorCounter != CurrentSetterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(CurrentSetterError->error));
-    CurrentSetterErrorCounter = CurrentSetterError->errorCounter;
-  }
-  
-  if (DACErrorCounter != DACError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(DACError->error));
-    DACErrorCounter = DACError->errorCounter;
-  }
-  
-  if (LimiterErrorCounter != LimiterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(LimiterError->error));
-    LimiterErrorCounter = LimiterError->errorCounter;
-  }
-  
-  if (MeasurementErrorCounter != MeasurementError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(MeasurementError->error));
-    MeasurementErrorCounter = MeasurementError->errorCounter;
-  }
-  
-  if (ThermometerErrorCounter != ThermometerError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(ThermometerError->error));
-    ThermometerErrorCounter = ThermometerError->errorCounter;
-  }
-    
-  if (VoltageSetterErrorCounter != VoltageSetterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(VoltageSetterError->error));
-    VoltageSetterErrorCounter = VoltageSetterError->errorCounter;
-  }
-  
-  if (VoltmeterErrorCounter != VoltmeterError->errorCounter)
-  {
-    flag |= 1UL << ((uint8_t)(VoltmeterError->error));
-    VoltmeterErrorCounter = VoltmeterError->errorCounter;
-  }
-  
-  return flag;
+  uint32_t flags = errorFlags;
+  errorFlags = 0;
+  return flags;
 }
 
 uint8_t ErrorMessaging_ErrorNamesCount(void)
 {
-  return sizeof(ErrorMessaging_ErrorNames)/sizeof(char *);
+  return sizeof(ErrorMessaging_ErrorNames)/sizeof(ErrorMessaging_ErrorNames[0]);
 }
 
-void ErrorMessaging_GetError(uint8_t errorNumber, char * message)
+const char * ErrorMessaging_GetErrorName(uint8_t errorNumber)
 {
-  Flashreader_Read((uint8_t*)message, (uint8_t*)(ErrorMessaging_ErrorNames[errorNumber]), ErrorMessaging_ErrorSizes[errorNumber]);
+  const char * name;
+  Flashreader_Read((uint8_t*)&name, (const uint8_t*)&(ErrorMessaging_ErrorNames[errorNumber]), sizeof(name));
+  return name;
 }
 
 /* </Implementations> */
@@ -66,16 +66,6 @@ struct ErrorMessaging_Error
 /* </Structs> */
 
 
-/* <Exported variables> */
-
-/**
- * Pointer to array of error names
- */
-extern const char * ErrorMessaging_ErrorNames[];
-
-/* </Exported variables> */
-
-
 /* <Declarations (prototypes)> */
 
 /**
@@ -84,7 +74,15 @@ extern const char * ErrorMessaging_ErrorNames[];
 void ErrorMessaging_Init(void);
 
 /**
- * Gets a flag word indicating which errors are active
+ * Raises an error of a module: increments its error counter, sets the error and flags it for the next flag word
+ *
+ * @param error - pointer to the error structure of the module
+ * @param code - error that has occured
+ */
+void ErrorMessaging_Raise(ErrorMessaging_Error * error, ErrorMessaging_Errors code);
+
+/**
+ * Gets a flag word indicating which errors have been raised since the last call
  *
  * @return - flag word with active errors
  */
@@ -101,9 +99,10 @@ uint8_t ErrorMessaging_ErrorNamesCount(void);
  * Gets an error message string description
  *
  * @param errorNumber - the number of unique error
- * @param message - pointer to char array where the message will be copied to
+ *
+ * @return - pointer to the null-terminated message in flash memory (FLASHMEMORY)
  */
-void ErrorMessaging_GetError(uint8_t errorNumber, char * message);
+const char * ErrorMessaging_GetErrorName(uint8_t errorNumber);
 
 /* </Declarations (prototypes)> */
 
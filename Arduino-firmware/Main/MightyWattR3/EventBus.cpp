@@ -0,0 +1,105 @@
+/**
+ * EventBus.cpp
+ * Data-ready notification between producer and consumer modules
+ *
+ * 2018-02-14
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "EventBus.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static uint16_t eventSequence[EVENTBUS_EVENT_COUNT]; /* Sequence number of the last published event of each type, intentional wraparound */
+static uint16_t eventMissed[EVENTBUS_EVENT_COUNT]; /* Events of each type missed by all subscriptions together, saturates */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Adds to a saturating counter
+ *
+ * @param counter - counter value
+ * @param value - addition
+ *
+ * @return - sum, 0xFFFF on overflow
+ */
+static uint16_t EventBus_AddSaturated(uint16_t counter, uint16_t value);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void EventBus_Init(void)
+{
+  for (uint8_t i = 0; i < EVENTBUS_EVENT_COUNT; i++)
+  {
+    eventSequence[i] = 0;
+    eventMissed[i] = 0;
+  }
+}
+
+void EventBus_Publish(EventBus_Events event)
+{
+  eventSequence[event]++;
+}
+
+void EventBus_Subscribe(EventBus_Subscription * subscription, EventBus_Events event)
+{
+  subscription->event = event;
+  subscription->sequence = eventSequence[event];
+  subscription->missedCounter = 0;
+}
+
+bool EventBus_Pending(const EventBus_Subscription * subscription)
+{
+  return subscription->sequence != eventSequence[subscription->event];
+}
+
+bool EventBus_Take(EventBus_Subscription * subscription)
+{
+  uint16_t published = eventSequence[subscription->event] - subscription->sequence;
+
+  if (published == 0)
+  {
+    return false;
+  }
+
+  /* Only the latest event can be processed, the older ones are lost */
+  published--;
+  subscription->missedCounter = EventBus_AddSaturated(subscription->missedCounter, published);
+  eventMissed[subscription->event] = EventBus_AddSaturated(eventMissed[subscription->event], published);
+  subscription->sequence = eventSequence[subscription->event];
+  return true;
+}
+
+uint16_t EventBus_GetMissedCounter(const EventBus_Subscription * subscription)
+{
+  return subscription->missedCounter;
+}
+
+uint16_t EventBus_GetEventMissedCounter(EventBus_Events event)
+{
+  return eventMissed[event];
+}
+
+static uint16_t EventBus_AddSaturated(uint16_t counter, uint16_t value)
+{
+  if ((uint16_t)(counter + value) < counter)
+  {
+    return 0xFFFF;
+  }
+  return counter + value;
+}
+
+/* </Implementations> */
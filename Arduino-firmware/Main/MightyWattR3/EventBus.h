@@ -0,0 +1,117 @@
+/**
+ * EventBus.h
+ * Data-ready notification between producer and consumer modules
+ *
+ * 2018-02-14
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Enums> */
+
+/**
+ * Events raised by producers when they have written new data
+ */
+enum EventBus_Events : uint8_t
+{
+  Event_ADC_V, /* New raw voltage channel value */
+  Event_ADC_I, /* New raw current channel value */
+  Event_ADC_T, /* New raw temperature channel value */
+  Event_Voltmeter, /* New voltage */
+  Event_Ammeter, /* New current */
+  Event_Thermometer, /* New temperature */
+  Event_Measurement, /* New voltage, current, power and resistance */
+  EVENTBUS_EVENT_COUNT
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Subscription of one consumer to one event type, owned by the consumer
+ */
+struct EventBus_Subscription
+{
+  EventBus_Events event; /* Subscribed event */
+  uint16_t sequence; /* Sequence number of the last taken event */
+  uint16_t missedCounter; /* Number of events that were published but never taken, saturates */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the event bus
+ * Must be called before any module subscribes
+ */
+void EventBus_Init(void);
+
+/**
+ * Raises an event, called by the producer after the new data has been written
+ *
+ * @param event - event to raise
+ */
+void EventBus_Publish(EventBus_Events event);
+
+/**
+ * Subscribes to an event, the events published before the subscription are not pending
+ *
+ * @param subscription - pointer to the subscription of the consumer
+ * @param event - event to subscribe to
+ */
+void EventBus_Subscribe(EventBus_Subscription * subscription, EventBus_Events event);
+
+/**
+ * Returns whether there is a new event for the subscription, without taking it
+ *
+ * @param subscription - pointer to the subscription of the consumer
+ *
+ * @return - true if at least one event was published since the last take
+ */
+bool EventBus_Pending(const EventBus_Subscription * subscription);
+
+/**
+ * Takes all pending events for the subscription
+ * Events published more than once since the last take are counted as missed
+ *
+ * @param subscription - pointer to the subscription of the consumer
+ *
+ * @return - true if at least one event was published since the last take
+ */
+bool EventBus_Take(EventBus_Subscription * subscription);
+
+/**
+ * Gets the number of events the subscription missed since it subscribed
+ *
+ * @param subscription - pointer to the subscription of the consumer
+ *
+ * @return - Number of events published but never taken, saturates
+ */
+uint16_t EventBus_GetMissedCounter(const EventBus_Subscription * subscription);
+
+/**
+ * Gets the number of events of a type missed by all its subscriptions together since the start
+ *
+ * @param event - event type
+ *
+ * @return - Number of events published but never taken, saturates
+ */
+uint16_t EventBus_GetEventMissedCounter(EventBus_Events event);
+
+/* </Declarations (prototypes)> */
+
+#endif /* EVENTBUS_H */
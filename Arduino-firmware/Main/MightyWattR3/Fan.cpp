@@ -10,7 +10,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Fan.h"
 
 /* </Includes> */ 
@@ -27,7 +27,7 @@ static Fan_States fanState; /* Present fan state */
 
 void Fan_Init(void)
 {
-  pinMode(FAN_PIN, OUTPUT);
+  HAL_PinMode(FAN_PIN, HAL_Output);
   fanState = FAN_DEFAULT_STATE;
   Fan_Set(fanState);
 }
@@ -38,11 +38,11 @@ void Fan_Set(Fan_States state)
   {
     case Fan_On:
       fanState = state;
-      digitalWrite(FAN_PIN, HIGH);
+      HAL_DigitalWrite(FAN_PIN, true);
     break;
     case Fan_Off:
       fanState = state;
-      digitalWrite(FAN_PIN, LOW);
+      HAL_DigitalWrite(FAN_PIN, false);
     break;
     default:
     break;
@@ -9,12 +9,13 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Fan.h"
 #include "Communication.h"
 #include "Measurement.h"
 #include "Thermometer.h"
 #include "FanController.h"
+#include "EventBus.h"
 
 /* </Includes> */ 
 
@@ -24,7 +25,8 @@
 static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static const TSCUChar * temperature; /* Pointer to structure where temperature can be found */
-static uint8_t commandCounter/*, measurementCounter, temperatureCounter*/; /* Number of the last executed command from communication, number of the last measurement data, number of the last temperature data */
+static uint8_t commandCounter; /* Number of the last executed command from communication */
+static EventBus_Subscription measurementSubscription, temperatureSubscription; /* New measurement values, new temperature */
 static FanController_Rules FanRules; /* Describes under which circumstances the fan will be on and off */
 void (* FanController_Keep)(void); /* Pointer to the constant keeper function */
 static uint32_t FanStartTime; /* Time when fan started, to avoid excessive on/off switching */
@@ -50,6 +52,8 @@ void FanController_Init(void)
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
   commandCounter = 0;
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement);
+  EventBus_Subscribe(&temperatureSubscription, Event_Thermometer);
   FanRules = FAN_CONTROLLER_DEFAULT_RULE;
   FanController_Keep = &FanController_KeepRule;
   FanStartTime = 0;
@@ -70,7 +74,7 @@ void FanController_Do(void)
         {
           FanRules = (FanController_Rules)newRules;
           FanController_Keep = &FanController_KeepRule;
-          FanStartTime = millis() - FAN_CONTROLLER_MINIMUM_ONTIME; /* allows immediate change upon receiving command */
+          FanStartTime = HAL_Milliseconds() - FAN_CONTROLLER_MINIMUM_ONTIME; /* allows immediate change upon receiving command */
         }          
         break;
       }
@@ -89,50 +93,46 @@ void FanController_Do(void)
 
 void FanController_KeepRule(void)
 { 
-  static uint8_t measurementCounter = 0, temperatureCounter = 0; /* Number of the last executed command from communication, number of the last measurement data, number of the last temperature data */  
-  
   switch (FanRules)
   {
     case FanRule_AutoHigh:
-      if ((measurementCounter != measurementValues->counter) && (temperatureCounter != temperature->counter)) /* Only process new values */
+      if (EventBus_Pending(&measurementSubscription) && EventBus_Pending(&temperatureSubscription)) /* Only process new values */
       {
+        EventBus_Take(&measurementSubscription);
+        EventBus_Take(&temperatureSubscription);
         if ((temperature->value > FAN_CONTROLLER_AUTOHIGH_TEMP_UP) || (measurementValues->power > FAN_CONTROLLER_AUTOHIGH_P_UP))
         {
           Fan_Set(Fan_On);
-          FanStartTime = millis();
+          FanStartTime = HAL_Milliseconds();
         }
-        else if ((temperature->value < FAN_CONTROLLER_AUTOHIGH_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOHIGH_P_DOWN) && ((millis() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
+        else if ((temperature->value < FAN_CONTROLLER_AUTOHIGH_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOHIGH_P_DOWN) && ((HAL_Milliseconds() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
         {
           Fan_Set(Fan_Off);  
         }
         /* Otherwise no change */
-        
-        measurementCounter = measurementValues->counter;
-        temperatureCounter = temperature->counter;
       }        
     break;
     case FanRule_AutoLow:
-      if ((measurementCounter != measurementValues->counter) && (temperatureCounter != temperature->counter)) /* Only process new values */
+      if (EventBus_Pending(&measurementSubscription) && EventBus_Pending(&temperatureSubscription)) /* Only process new values */
       {
+        EventBus_Take(&measurementSubscription);
+        EventBus_Take(&temperatureSubscription);
         if ((temperature->value > FAN_CONTROLLER_AUTOLOW_TEMP_UP) || (measurementValues->power > FAN_CONTROLLER_AUTOLOW_P_UP))
         {
           Fan_Set(Fan_On);
-          FanStartTime = millis();
+          FanStartTime = HAL_Milliseconds();
         }
-        else if ((temperature->value < FAN_CONTROLLER_AUTOLOW_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOLOW_P_DOWN) && ((millis() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
+        else if ((temperature->value < FAN_CONTROLLER_AUTOLOW_TEMP_DOWN) && (measurementValues->power < FAN_CONTROLLER_AUTOLOW_P_DOWN) && ((HAL_Milliseconds() - FanStartTime) > FAN_CONTROLLER_MINIMUM_ONTIME))
         {
           Fan_Set(Fan_Off);  
         }
         /* Otherwise no change */
-        
-        measurementCounter = measurementValues->counter;
-        temperatureCounter = temperature->counter;
       }
     break;
     case FanRule_AlwaysOn:
     default:
       Fan_Set(Fan_On);
-      FanStartTime = millis();
+      FanStartTime = HAL_Milliseconds();
     break;
   }
 }
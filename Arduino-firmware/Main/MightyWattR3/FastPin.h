@@ -0,0 +1,219 @@
+/**
+ * FastPin.h
+ * Direct port access for pins on the time-critical path
+ *
+ * 2018-02-10
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The pin number is a template parameter so that the port register and the bit mask
+ * are resolved by the compiler. On UNO, a write compiles to a single sbi/cbi instruction
+ * and a read to a single sbis/sbic (or in) instruction. On ZERO, the port group and the bit
+ * are taken from the variant pin table and written to PORT->Group registers directly.
+ * In the host build (NATIVE), the calls are forwarded to the native back end of the HAL.
+ * Pin direction is still configured by HAL_PinMode in the Init functions (not time-critical).
+ */
+
+#ifndef FASTPIN_H
+#define FASTPIN_H
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Templates> */
+
+#ifdef UNO
+
+/**
+ * Arduino Uno mapping: digital pins 0-7 are PORTD, 8-13 are PORTB, 14-19 (A0-A5) are PORTC
+ */
+template <uint8_t pin>
+struct FastPin
+{
+  static_assert(pin < 20, "Pin does not exist on Arduino Uno");
+
+  /**
+   * Sets the pin to logical high
+   */
+  static inline void Set(void)
+  {
+    if (pin < 8)
+    {
+      PORTD |= (uint8_t)(1 << pin);
+    }
+    else if (pin < 14)
+    {
+      PORTB |= (uint8_t)(1 << (pin - 8));
+    }
+    else
+    {
+      PORTC |= (uint8_t)(1 << (pin - 14));
+    }
+  }
+
+  /**
+   * Sets the pin to logical low
+   */
+  static inline void Clear(void)
+  {
+    if (pin < 8)
+    {
+      PORTD &= (uint8_t)~(1 << pin);
+    }
+    else if (pin < 14)
+    {
+      PORTB &= (uint8_t)~(1 << (pin - 8));
+    }
+    else
+    {
+      PORTC &= (uint8_t)~(1 << (pin - 14));
+    }
+  }
+
+  /**
+   * Reads the logical state of the pin
+   *
+   * @return - true if the pin is high, false if low
+   */
+  static inline bool Read(void)
+  {
+    if (pin < 8)
+    {
+      return (PIND & (uint8_t)(1 << pin)) != 0;
+    }
+    else if (pin < 14)
+    {
+      return (PINB & (uint8_t)(1 << (pin - 8))) != 0;
+    }
+    else
+    {
+      return (PINC & (uint8_t)(1 << (pin - 14))) != 0;
+    }
+  }
+
+  /**
+   * Sets the pin to the requested logical state
+   *
+   * @param high - true for logical high, false for logical low
+   */
+  static inline void Write(bool high)
+  {
+    if (high)
+    {
+      Set();
+    }
+    else
+    {
+      Clear();
+    }
+  }
+};
+
+#elif defined(ZERO)
+
+/**
+ * Arduino Zero / M0 mapping is taken from the variant pin table (g_APinDescription)
+ * which differs between board vendors
+ */
+template <uint8_t pin>
+struct FastPin
+{
+  /**
+   * Sets the pin to logical high
+   */
+  static inline void Set(void)
+  {
+    PORT->Group[g_APinDescription[pin].ulPort].OUTSET.reg = (1UL << g_APinDescription[pin].ulPin);
+  }
+
+  /**
+   * Sets the pin to logical low
+   */
+  static inline void Clear(void)
+  {
+    PORT->Group[g_APinDescription[pin].ulPort].OUTCLR.reg = (1UL << g_APinDescription[pin].ulPin);
+  }
+
+  /**
+   * Reads the logical state of the pin
+   *
+   * @return - true if the pin is high, false if low
+   */
+  static inline bool Read(void)
+  {
+    return (PORT->Group[g_APinDescription[pin].ulPort].IN.reg & (1UL << g_APinDescription[pin].ulPin)) != 0;
+  }
+
+  /**
+   * Sets the pin to the requested logical state
+   *
+   * @param high - true for logical high, false for logical low
+   */
+  static inline void Write(bool high)
+  {
+    if (high)
+    {
+      Set();
+    }
+    else
+    {
+      Clear();
+    }
+  }
+};
+
+#elif defined(NATIVE)
+
+/**
+ * Host build: pins are simulated by the native back end of the HAL
+ */
+template <uint8_t pin>
+struct FastPin
+{
+  /**
+   * Sets the pin to logical high
+   */
+  static inline void Set(void)
+  {
+    HAL_DigitalWrite(pin, true);
+  }
+
+  /**
+   * Sets the pin to logical low
+   */
+  static inline void Clear(void)
+  {
+    HAL_DigitalWrite(pin, false);
+  }
+
+  /**
+   * Reads the logical state of the pin
+   *
+   * @return - true if the pin is high, false if low
+   */
+  static inline bool Read(void)
+  {
+    return HAL_DigitalRead(pin);
+  }
+
+  /**
+   * Sets the pin to the requested logical state
+   *
+   * @param high - true for logical high, false for logical low
+   */
+  static inline void Write(bool high)
+  {
+    HAL_DigitalWrite(pin, high);
+  }
+};
+
+#endif
+
+/* </Templates> */
+
+#endif /* FASTPIN_H */
@@ -8,7 +8,7 @@
  
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "MightyWatt.h"
 
 /* </Includes> */ 
@@ -27,12 +27,19 @@ void Flashreader_Read(uint8_t* to_ptr, const uint8_t* from_ptr, uint8_t array_le
   {
     #ifdef UNO
       to_ptr[i] = pgm_read_byte(&(from_ptr[i]));
-    #elif defined(ZERO)
-      to_ptr[i] = from_ptr[i];
     #else
-      return;
+      to_ptr[i] = from_ptr[i];
     #endif
   }
 }
 
+uint8_t Flashreader_ReadByte(const uint8_t* from_ptr)
+{
+  #ifdef UNO
+    return pgm_read_byte(from_ptr);
+  #else
+    return *from_ptr;
+  #endif
+}
+
 /* </Implementations> */ 
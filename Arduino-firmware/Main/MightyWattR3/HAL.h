@@ -0,0 +1,216 @@
+/**
+ * HAL.h
+ * Hardware abstraction layer: I2C transactions, serial stream, clock, timer interrupt, GPIO and PWM
+ *
+ * 2018-02-24
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The modules reach the hardware only through these functions. HAL_Arduino.cpp implements them
+ * with the Arduino core (Wire, SerialPort, millis, pinMode, ...), the native back end in "Main/native"
+ * implements them on Linux so that the firmware can be built and profiled on a PC (NATIVE defined).
+ * Board-specific register code (FastPin, I2CDMA, watchdog) stays in the modules behind UNO/ZERO; the timer interrupt
+ * is here because the native back end runs it on its clock.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#ifdef NATIVE
+  #include <stddef.h>
+  #include <string.h>
+  #include <math.h>
+#else
+  #include "Arduino.h"
+#endif
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define HAL_TIMER_MINIMUM_PERIOD             100 /* us */
+#define HAL_I2C_BYTE_TIME                    100 /* us, one byte with its acknowledge at the 100 kHz of Wire, with the software overhead */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Direction of a digital pin
+ */
+enum HAL_PinModes : uint8_t
+{
+  HAL_Input,
+  HAL_Output
+};
+
+/* </Enums> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Gets the time elapsed since start, intentional wraparound
+ *
+ * @return - Elapsed time in ms
+ */
+uint32_t HAL_Milliseconds(void);
+
+/**
+ * Gets the time elapsed since start, intentional wraparound
+ *
+ * @return - Elapsed time in us
+ */
+uint32_t HAL_Microseconds(void);
+
+/**
+ * Starts the periodic timer interrupt, a running timer is restarted
+ * The callback runs in interrupt context with the interrupts enabled, it is never nested. It is held back while a
+ * blocking I2C transaction (HAL_I2CWrite, HAL_I2CRead) of the main loop is in progress and runs right after it, so
+ * the callback may use the bus. Data it shares with the main loop is volatile and accessed by the main loop with the
+ * interrupts disabled (HAL_DisableInterrupts).
+ * The transactions of the main loop wait for a callback that is due before they would end (HAL_I2CReserve),
+ * so a callback is held back only by a transaction that takes longer than its estimate.
+ *
+ * @param period - us, time to the first callback and between the callbacks, at least HAL_TIMER_MINIMUM_PERIOD
+ * @param callback - function called on every period
+ */
+void HAL_TimerStart(uint32_t period, void (* callback)(void));
+
+/**
+ * Sets the period that starts with the next callback, the time to the next callback is kept
+ * The callbacks stay on schedule even when one of them is held back.
+ *
+ * @param period - us, at least HAL_TIMER_MINIMUM_PERIOD
+ */
+void HAL_TimerSetPeriod(uint32_t period);
+
+/**
+ * Stops the timer interrupt, no callback runs after the return
+ */
+void HAL_TimerStop(void);
+
+/**
+ * Disables the interrupts, data shared with the timer callback can be accessed atomically
+ */
+void HAL_DisableInterrupts(void);
+
+/**
+ * Enables the interrupts again
+ */
+void HAL_EnableInterrupts(void);
+
+/**
+ * Sets the direction of a digital pin
+ *
+ * @param pin - Arduino pin number
+ * @param mode - HAL_Input or HAL_Output
+ */
+void HAL_PinMode(uint8_t pin, HAL_PinModes mode);
+
+/**
+ * Sets the logical state of a digital output
+ *
+ * @param pin - Arduino pin number
+ * @param high - true for logical high, false for logical low
+ */
+void HAL_DigitalWrite(uint8_t pin, bool high);
+
+/**
+ * Reads the logical state of a digital pin
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - true if the pin is high, false if low
+ */
+bool HAL_DigitalRead(uint8_t pin);
+
+/**
+ * Sets the duty cycle of a PWM output
+ *
+ * @param pin - Arduino pin number
+ * @param duty - Duty cycle, 0 is always low, 255 is always high
+ */
+void HAL_PWMWrite(uint8_t pin, uint8_t duty);
+
+/**
+ * Initializes the I2C bus as master
+ */
+void HAL_I2CInit(void);
+
+/**
+ * Reserves the I2C bus for the timer callbacks: waits until the next callback is not due before a transaction of the
+ * main loop would end, so the callback finds the bus free and runs on time
+ * Returns at once in the callback and when the timer is stopped. HAL_I2CWrite and HAL_I2CRead call it themselves,
+ * the transfers that do not use them (I2CDMA) call it before they start.
+ *
+ * @param length - number of data bytes of the transaction
+ */
+void HAL_I2CReserve(uint8_t length);
+
+/**
+ * Writes bytes to an I2C slave in one transaction (START, address, data, STOP)
+ *
+ * @param address - 7-bit slave address
+ * @param data - pointer to the bytes to write
+ * @param length - number of bytes to write
+ *
+ * @return - true if the slave acknowledged the transfer
+ */
+bool HAL_I2CWrite(uint8_t address, const uint8_t * data, uint8_t length);
+
+/**
+ * Reads bytes from an I2C slave in one transaction (START, address, data, STOP)
+ *
+ * @param address - 7-bit slave address
+ * @param data - pointer to where the read bytes will be stored
+ * @param length - number of bytes to read
+ *
+ * @return - true if all bytes were received
+ */
+bool HAL_I2CRead(uint8_t address, uint8_t * data, uint8_t length);
+
+/**
+ * (Re)opens the serial stream to the PC and waits until it is ready
+ *
+ * @param baudrate - Baud rate (not used by USB and native ports)
+ */
+void HAL_SerialInit(uint32_t baudrate);
+
+/**
+ * Gets the number of received bytes that can be read
+ *
+ * @return - Number of bytes
+ */
+int16_t HAL_SerialAvailable(void);
+
+/**
+ * Reads one received byte
+ *
+ * @return - Received byte or -1 if there is none
+ */
+int16_t HAL_SerialRead(void);
+
+/**
+ * Sends one byte
+ *
+ * @param value - Byte to send
+ */
+void HAL_SerialWriteByte(uint8_t value);
+
+/**
+ * Sends bytes
+ *
+ * @param data - pointer to the bytes to send
+ * @param length - number of bytes to send
+ */
+void HAL_SerialWrite(const uint8_t * data, uint16_t length);
+
+/* </Declarations (prototypes)> */
+
+#endif /* HAL_H */
@@ -0,0 +1,378 @@
+/**
+ * HAL_Arduino.cpp
+ * Hardware abstraction layer, Arduino core back end
+ *
+ * 2018-02-24
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#ifndef NATIVE
+  #include <Wire.h>
+#endif
+
+/* </Includes> */
+
+#ifndef NATIVE
+
+/* <Defines> */
+
+#ifdef UNO
+  #define HAL_TIMER_TICKS_PER_MICROSECOND  2 /* Timer1, 16 MHz / 8 */
+  #define HAL_TIMER_MAXIMUM_CHUNK          30000 /* us, longest compare interval of the 16-bit counter */
+#elif defined(ZERO)
+  #define HAL_TIMER_TICKS_PER_MICROSECOND  3 /* TC4, 48 MHz / 16 */
+  #define HAL_TIMER_MAXIMUM_CHUNK          20000 /* us, longest compare interval of the 16-bit counter */
+#endif
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+static void (* timerCallback)(void);
+static uint32_t timerNextPeriod; /* us, period loaded at the next callback */
+static uint32_t timerRemaining; /* us of the running period after the present compare interval */
+static volatile bool timerPending; /* A callback was held back */
+static volatile bool timerRunning; /* A callback is in progress */
+static volatile bool i2cBusy; /* A blocking transaction of the main loop is in progress */
+static volatile bool timerEnabled;
+static volatile uint8_t timerCount; /* Ends of the periods, intentional wraparound */
+static uint16_t timerCompare; /* Timer ticks of the present compare interval */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Loads the next compare interval of the running period, long periods are split into several intervals
+ */
+static void HAL_TimerLoad(void);
+
+/**
+ * Handles the compare interrupt, runs or holds back the callback at the end of a period
+ */
+static void HAL_TimerEvent(void);
+
+/**
+ * Runs the callback and the callbacks that were held back meanwhile
+ */
+static void HAL_TimerRun(void);
+
+/**
+ * Runs a held back callback after a blocking I2C transaction
+ */
+static void HAL_TimerRunPending(void);
+
+/**
+ * Gets the time to the end of the running period
+ *
+ * @return - Time in us
+ */
+static uint32_t HAL_TimerGetTimeToCallback(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+uint32_t HAL_Milliseconds(void)
+{
+  return millis();
+}
+
+uint32_t HAL_Microseconds(void)
+{
+  return micros();
+}
+
+void HAL_PinMode(uint8_t pin, HAL_PinModes mode)
+{
+  pinMode(pin, (mode == HAL_Output) ? OUTPUT : INPUT);
+}
+
+void HAL_DigitalWrite(uint8_t pin, bool high)
+{
+  digitalWrite(pin, high ? HIGH : LOW);
+}
+
+bool HAL_DigitalRead(uint8_t pin)
+{
+  return digitalRead(pin) == HIGH;
+}
+
+void HAL_PWMWrite(uint8_t pin, uint8_t duty)
+{
+  analogWrite(pin, duty);
+}
+
+void HAL_I2CInit(void)
+{
+  Wire.begin();
+}
+
+void HAL_I2CReserve(uint8_t length)
+{
+  uint32_t duration = ((uint32_t)length + 2) * HAL_I2C_BYTE_TIME; /* Data, address, start and stop */
+  uint8_t count = timerCount;
+
+  if (timerRunning)
+  {
+    return; /* The callback is the user of the bus */
+  }
+  while (timerEnabled && (timerCount == count) && (HAL_TimerGetTimeToCallback() < duration)) {};
+}
+
+bool HAL_I2CWrite(uint8_t address, const uint8_t * data, uint8_t length)
+{
+  bool result;
+
+  HAL_I2CReserve(length);
+  i2cBusy = true;
+  Wire.beginTransmission(address);
+  Wire.write(data, length);
+  result = Wire.endTransmission() == 0;
+  i2cBusy = false;
+  HAL_TimerRunPending();
+  return result;
+}
+
+bool HAL_I2CRead(uint8_t address, uint8_t * data, uint8_t length)
+{
+  bool result = true;
+
+  HAL_I2CReserve(length);
+  i2cBusy = true;
+  if (Wire.requestFrom(address, length) != length)
+  {
+    result = false;
+  }
+  else
+  {
+    for (uint8_t i = 0; i < length; i++)
+    {
+      data[i] = Wire.read();
+    }
+  }
+  i2cBusy = false;
+  HAL_TimerRunPending();
+  return result;
+}
+
+void HAL_SerialInit(uint32_t baudrate)
+{
+  SerialPort.end();
+  SerialPort.begin(baudrate);
+  while(!SerialPort){}; /* Wait for the initialization of serial port */
+}
+
+int16_t HAL_SerialAvailable(void)
+{
+  return SerialPort.available();
+}
+
+int16_t HAL_SerialRead(void)
+{
+  return SerialPort.read();
+}
+
+void HAL_SerialWriteByte(uint8_t value)
+{
+  SerialPort.write(value);
+}
+
+void HAL_SerialWrite(const uint8_t * data, uint16_t length)
+{
+  SerialPort.write(data, length);
+}
+
+void HAL_TimerStart(uint32_t period, void (* callback)(void))
+{
+  HAL_TimerStop();
+  timerCallback = callback;
+  timerNextPeriod = period;
+  timerRemaining = period;
+  timerPending = false;
+  timerRunning = false;
+  timerEnabled = true;
+  #ifdef UNO
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    HAL_TimerLoad();
+    TIFR1 = (1 << OCF1A);
+    TIMSK1 |= (1 << OCIE1A);
+    TCCR1B = (1 << WGM12) | (1 << CS11); /* CTC on OCR1A, clock / 8 */
+  #elif defined(ZERO)
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TC4_TC5;
+    while (GCLK->STATUS.bit.SYNCBUSY) {};
+    TC4->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+    while (TC4->COUNT16.CTRLA.bit.SWRST) {};
+    TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV16; /* Reset on CC0 */
+    HAL_TimerLoad();
+    TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    TC4->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+    NVIC_SetPriority(TC4_IRQn, (1 << __NVIC_PRIO_BITS) - 1); /* Below SysTick, the callback may wait with HAL_Milliseconds */
+    NVIC_EnableIRQ(TC4_IRQn);
+    TC4->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY) {};
+  #endif
+}
+
+void HAL_TimerSetPeriod(uint32_t period)
+{
+  HAL_DisableInterrupts();
+  timerNextPeriod = period;
+  HAL_EnableInterrupts();
+}
+
+void HAL_TimerStop(void)
+{
+  #ifdef UNO
+    TIMSK1 &= ~(1 << OCIE1A);
+    TCCR1B = 0;
+  #elif defined(ZERO)
+    NVIC_DisableIRQ(TC4_IRQn);
+    TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY) {};
+  #endif
+  timerPending = false;
+  timerEnabled = false;
+}
+
+void HAL_DisableInterrupts(void)
+{
+  noInterrupts();
+}
+
+void HAL_EnableInterrupts(void)
+{
+  interrupts();
+}
+
+#ifdef UNO
+ISR(TIMER1_COMPA_vect)
+{
+  HAL_TimerEvent();
+}
+#elif defined(ZERO)
+void TC4_Handler(void)
+{
+  TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  HAL_TimerEvent();
+}
+#endif
+
+static void HAL_TimerLoad(void)
+{
+  uint32_t interval = timerRemaining;
+
+  /* The last interval is never short, the counter must not have passed it when it is loaded */
+  if (interval > 2 * HAL_TIMER_MAXIMUM_CHUNK)
+  {
+    interval = HAL_TIMER_MAXIMUM_CHUNK;
+  }
+  else if (interval > HAL_TIMER_MAXIMUM_CHUNK)
+  {
+    interval /= 2;
+  }
+  timerRemaining -= interval;
+  timerCompare = (uint16_t)(interval * HAL_TIMER_TICKS_PER_MICROSECOND - 1);
+  #ifdef UNO
+    OCR1A = timerCompare;
+  #elif defined(ZERO)
+    TC4->COUNT16.CC[0].reg = timerCompare;
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY) {};
+  #endif
+}
+
+static void HAL_TimerEvent(void)
+{
+  if (timerRemaining > 0)
+  {
+    HAL_TimerLoad(); /* Inside a long period */
+    return;
+  }
+  timerRemaining = timerNextPeriod;
+  HAL_TimerLoad();
+  timerCount++;
+  if (i2cBusy || timerRunning)
+  {
+    timerPending = true; /* Runs when the transaction or the callback ends */
+    return;
+  }
+  HAL_TimerRun();
+}
+
+static void HAL_TimerRun(void)
+{
+  bool again;
+
+  /* The callback runs with the interrupts enabled, UNO: Wire needs the TWI interrupt. Its I2C transactions are safe
+   * there because Wire is never entered twice: the callback does not start during a transaction of the main loop
+   * (i2cBusy holds it back until HAL_TimerRunPending), the main loop does not run until the callback returns and the
+   * next compare can only mark the callback pending (timerRunning). The other interrupts do not use the bus.
+   * HAL_I2CReserve only keeps the callbacks on time, the exclusion does not rely on it. */
+  timerRunning = true;
+  do
+  {
+    HAL_EnableInterrupts();
+    timerCallback();
+    HAL_DisableInterrupts();
+    again = timerPending;
+    timerPending = false;
+    if (!again)
+    {
+      timerRunning = false;
+    }
+    HAL_EnableInterrupts();
+  } while (again);
+}
+
+static void HAL_TimerRunPending(void)
+{
+  HAL_DisableInterrupts();
+  bool run = timerPending && !timerRunning && !i2cBusy;
+  if (run)
+  {
+    timerPending = false;
+  }
+  HAL_EnableInterrupts();
+  if (run)
+  {
+    HAL_DisableInterrupts(); /* As in the interrupt */
+    HAL_TimerRun();
+  }
+}
+
+static uint32_t HAL_TimerGetTimeToCallback(void)
+{
+  uint32_t time = 0;
+
+  HAL_DisableInterrupts();
+  #ifdef UNO
+    if (!(TIFR1 & (1 << OCF1A))) /* A compare that was not handled yet ends the interval */
+    {
+      time = (timerCompare - TCNT1) / HAL_TIMER_TICKS_PER_MICROSECOND;
+    }
+  #elif defined(ZERO)
+    TC4->COUNT16.READREQ.reg = TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY) {};
+    if (!(TC4->COUNT16.INTFLAG.reg & TC_INTFLAG_MC0))
+    {
+      time = (timerCompare - TC4->COUNT16.COUNT.reg) / HAL_TIMER_TICKS_PER_MICROSECOND;
+    }
+  #endif
+  time += timerRemaining;
+  HAL_EnableInterrupts();
+  return time;
+}
+
+/* </Implementations> */
+
+#endif /* NATIVE */
@@ -0,0 +1,58 @@
+/**
+ * History.cpp
+ * History of measurement values kept in the shared ring buffer
+ *
+ * 2018-02-20
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "History.h"
+#include "RingBuffer.h"
+#include "Measurement.h"
+#include "EventBus.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static const Measurement_Values * measurementValues;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+
+/* </Module variables> */
+
+
+/* <Implementations> */
+
+void History_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement);
+  RingBuffer_Acquire(RingBuffer_History, sizeof(History_Record));
+}
+
+void History_Do(void)
+{
+  if (EventBus_Take(&measurementSubscription))
+  {
+    /* Take the buffer back when another module has released it */
+    if ((RingBuffer_GetOwner() == RingBuffer_History) || RingBuffer_Acquire(RingBuffer_History, sizeof(History_Record)))
+    {
+      History_Record record;
+      record.current = measurementValues->current;
+      record.voltage = measurementValues->voltage;
+      RingBuffer_Push(&record);
+    }
+  }
+}
+
+bool History_DataReady(void)
+{
+  return EventBus_Pending(&measurementSubscription);
+}
+
+/* </Implementations> */
@@ -0,0 +1,57 @@
+/**
+ * History.h
+ * History of measurement values kept in the shared ring buffer
+ *
+ * 2018-02-20
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Structs> */
+
+/**
+ * One history record
+ */
+struct History_Record
+{
+  uint32_t current; /* uA */
+  uint32_t voltage; /* uV */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the history and takes the ring buffer if it is free
+ */
+void History_Init(void);
+
+/**
+ * Executable function which must be called periodically
+ * Stores new measurement values while the ring buffer is not used by another module
+ */
+void History_Do(void);
+
+/**
+ * Returns whether new measurement values are waiting to be stored
+ * Used as data-ready trigger by the scheduler
+ *
+ * @return - true if there are new measurement values
+ */
+bool History_DataReady(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* HISTORY_H */
@@ -0,0 +1,224 @@
+/**
+ * I2CDMA.cpp
+ * DMA-driven I2C master transfers on the Wire SERCOM (ZERO only)
+ *
+ * 2018-02-22
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "I2CDMA.h"
+
+/* </Includes> */
+
+#ifdef ZERO
+
+/* <Defines> */
+
+#define I2CDMA_BUSSTATE_IDLE            1
+#define I2CDMA_TIMEOUT                  2 /* ms, I2CDMA_Wait gives up after this time */
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+/* The DMAC reads the descriptors from RAM, both tables must be 128-bit aligned and cover all channels up to the used one */
+static DmacDescriptor descriptors[I2CDMA_CHANNEL + 1] __attribute__((aligned(16)));
+static volatile DmacDescriptor writeback[I2CDMA_CHANNEL + 1] __attribute__((aligned(16)));
+static uint8_t buffer[I2CDMA_MAXIMUM_LENGTH];
+static volatile I2CDMA_States state; /* Also checked by the timer callback (AD569xR_SetFromTimer) */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Sets up the descriptor and the trigger of the channel and enables it
+ *
+ * @param trigger - SERCOM TX or RX trigger
+ * @param length - number of bytes
+ */
+static void I2CDMA_StartChannel(uint8_t trigger, uint8_t length);
+
+/**
+ * Starts the address phase of a transfer with automatic length
+ *
+ * @param address - 7-bit I2C address
+ * @param read - true for read transfer
+ * @param length - number of bytes
+ */
+static void I2CDMA_StartAddress(uint8_t address, bool read, uint8_t length);
+
+/**
+ * Stops the transfer in progress and forces the bus state to idle, called with interrupts disabled
+ */
+static void I2CDMA_Stop(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void I2CDMA_Init(void)
+{
+  PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+  PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+  DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+  DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+  while (DMAC->CTRL.reg & DMAC_CTRL_SWRST) {}
+  DMAC->BASEADDR.reg = (uint32_t)descriptors;
+  DMAC->WRBADDR.reg = (uint32_t)writeback;
+  DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+  state = I2CDMA_Idle;
+}
+
+bool I2CDMA_Write(uint8_t address, const uint8_t * data, uint8_t length)
+{
+  if ((I2CDMA_GetState() == I2CDMA_Busy) || (length == 0) || (length > I2CDMA_MAXIMUM_LENGTH))
+  {
+    return false;
+  }
+  for (uint8_t i = 0; i < length; i++)
+  {
+    buffer[i] = data[i];
+  }
+  HAL_I2CReserve(length);
+  HAL_DisableInterrupts(); /* The timer callback may use the bus, it must not find a transfer half started */
+  I2CDMA_StartChannel(I2CDMA_TRIGGER_TX, length);
+  I2CDMA_StartAddress(address, false, length);
+  HAL_EnableInterrupts();
+  return true;
+}
+
+bool I2CDMA_Read(uint8_t address, uint8_t length)
+{
+  if ((I2CDMA_GetState() == I2CDMA_Busy) || (length == 0) || (length > I2CDMA_MAXIMUM_LENGTH))
+  {
+    return false;
+  }
+  HAL_I2CReserve(length);
+  HAL_DisableInterrupts(); /* The timer callback may use the bus, it must not find a transfer half started */
+  I2CDMA_StartChannel(I2CDMA_TRIGGER_RX, length);
+  I2CDMA_StartAddress(address, true, length);
+  HAL_EnableInterrupts();
+  return true;
+}
+
+I2CDMA_States I2CDMA_GetState(void)
+{
+  I2CDMA_States result;
+
+  /* The channel select, the flags and the state change must not be split by the timer callback,
+     it could select the channel, clear the flags or start a new transfer meanwhile */
+  HAL_DisableInterrupts();
+  if (state == I2CDMA_Busy)
+  {
+    uint16_t status = I2CDMA_SERCOM->I2CM.STATUS.reg;
+    DMAC->CHID.reg = DMAC_CHID_ID(I2CDMA_CHANNEL);
+    uint8_t flags = DMAC->CHINTFLAG.reg;
+
+    if ((flags & DMAC_CHINTFLAG_TERR) || (status & (SERCOM_I2CM_STATUS_RXNACK | SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST)))
+    {
+      I2CDMA_Stop();
+      state = I2CDMA_Error;
+    }
+    else if ((flags & DMAC_CHINTFLAG_TCMPL) && (((status & SERCOM_I2CM_STATUS_BUSSTATE_Msk) >> SERCOM_I2CM_STATUS_BUSSTATE_Pos) == I2CDMA_BUSSTATE_IDLE))
+    {
+      DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+      state = I2CDMA_Idle;
+    }
+  }
+  result = state;
+  HAL_EnableInterrupts();
+  return result;
+}
+
+const uint8_t * I2CDMA_GetData(void)
+{
+  return buffer;
+}
+
+void I2CDMA_Wait(void)
+{
+  uint32_t startTime = HAL_Milliseconds();
+  while (I2CDMA_GetState() == I2CDMA_Busy)
+  {
+    if ((HAL_Milliseconds() - startTime) > I2CDMA_TIMEOUT)
+    {
+      HAL_DisableInterrupts();
+      I2CDMA_Stop();
+      state = I2CDMA_Error;
+      HAL_EnableInterrupts();
+    }
+  }
+}
+
+void I2CDMA_Abort(void)
+{
+  HAL_DisableInterrupts();
+  I2CDMA_Stop();
+  HAL_EnableInterrupts();
+}
+
+static void I2CDMA_Stop(void)
+{
+  DMAC->CHID.reg = DMAC_CHID_ID(I2CDMA_CHANNEL);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR | DMAC_CHINTFLAG_SUSP;
+
+  /* Send STOP and force the bus state to idle so that Wire can continue */
+  I2CDMA_SERCOM->I2CM.CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+  while (I2CDMA_SERCOM->I2CM.SYNCBUSY.bit.SYSOP) {}
+  I2CDMA_SERCOM->I2CM.STATUS.reg = SERCOM_I2CM_STATUS_BUSSTATE(I2CDMA_BUSSTATE_IDLE) | SERCOM_I2CM_STATUS_RXNACK | SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST;
+  while (I2CDMA_SERCOM->I2CM.SYNCBUSY.bit.SYSOP) {}
+  state = I2CDMA_Idle;
+}
+
+static void I2CDMA_StartChannel(uint8_t trigger, uint8_t length)
+{
+  DmacDescriptor * descriptor = &descriptors[I2CDMA_CHANNEL];
+
+  DMAC->CHID.reg = DMAC_CHID_ID(I2CDMA_CHANNEL);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+  while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST) {}
+  DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(trigger) | DMAC_CHCTRLB_TRIGACT_BEAT;
+
+  descriptor->BTCNT.reg = length;
+  descriptor->DESCADDR.reg = 0; /* Single block */
+  if (trigger == I2CDMA_TRIGGER_TX)
+  {
+    /* Memory to DATA, the source address is the end of the block when the address is incremented */
+    descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    descriptor->SRCADDR.reg = (uint32_t)buffer + length;
+    descriptor->DSTADDR.reg = (uint32_t)&(I2CDMA_SERCOM->I2CM.DATA.reg);
+  }
+  else
+  {
+    /* DATA to memory */
+    descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    descriptor->SRCADDR.reg = (uint32_t)&(I2CDMA_SERCOM->I2CM.DATA.reg);
+    descriptor->DSTADDR.reg = (uint32_t)buffer + length;
+  }
+
+  DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+  state = I2CDMA_Busy;
+}
+
+static void I2CDMA_StartAddress(uint8_t address, bool read, uint8_t length)
+{
+  while (I2CDMA_SERCOM->I2CM.SYNCBUSY.bit.SYSOP) {}
+  I2CDMA_SERCOM->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR((address << 1) | (read ? 1 : 0)) | SERCOM_I2CM_ADDR_LENEN | SERCOM_I2CM_ADDR_LEN(length);
+}
+
+/* </Implementations> */
+
+#endif /* ZERO */
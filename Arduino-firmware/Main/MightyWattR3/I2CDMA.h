@@ -0,0 +1,108 @@
+/**
+ * I2CDMA.h
+ * DMA-driven I2C master transfers on the Wire SERCOM (ZERO only)
+ *
+ * 2018-02-22
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The SERCOM is configured by HAL_I2CInit() (Wire.begin), this module only starts transfers.
+ * The address phase is started by the CPU (one register write), the data bytes are moved by a DMAC channel
+ * and the SERCOM sends NACK/STOP by itself after the programmed length (ADDR.LENEN), so no CPU time is spent
+ * while the bytes are on the bus. Completion is polled, the module does not use interrupts.
+ * Blocking HAL_I2CWrite/HAL_I2CRead transactions on the same bus must call I2CDMA_Wait first.
+ * A transfer starts only when it ends before the next timer callback (HAL_I2CReserve), the callback does not wait for it.
+ */
+
+#ifndef I2CDMA_H
+#define I2CDMA_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+#ifdef ZERO
+
+/* <Defines> */
+
+#define I2CDMA_SERCOM                   SERCOM3 /* Wire on Arduino Zero / M0 */
+#define I2CDMA_TRIGGER_TX               SERCOM3_DMAC_ID_TX
+#define I2CDMA_TRIGGER_RX               SERCOM3_DMAC_ID_RX
+#define I2CDMA_CHANNEL                  0
+#define I2CDMA_MAXIMUM_LENGTH           4 /* Bytes per transfer */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum I2CDMA_States : uint8_t
+{
+  I2CDMA_Idle, /* No transfer or the last transfer has finished successfully */
+  I2CDMA_Busy, /* Transfer in progress */
+  I2CDMA_Error /* The last transfer has failed (NACK, bus error, lost arbitration or DMA error) */
+};
+
+/* </Enums> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Enables the DMA controller and configures the channel
+ */
+void I2CDMA_Init(void);
+
+/**
+ * Starts a write transfer, the data are copied so the caller does not need to keep them
+ *
+ * @param address - 7-bit I2C address
+ * @param data - pointer to the bytes to send
+ * @param length - number of bytes, 1 to I2CDMA_MAXIMUM_LENGTH
+ *
+ * @return - false if a transfer is already in progress or the length is invalid
+ */
+bool I2CDMA_Write(uint8_t address, const uint8_t * data, uint8_t length);
+
+/**
+ * Starts a read transfer, the data can be taken by I2CDMA_GetData when the state is idle
+ *
+ * @param address - 7-bit I2C address
+ * @param length - number of bytes, 1 to I2CDMA_MAXIMUM_LENGTH
+ *
+ * @return - false if a transfer is already in progress or the length is invalid
+ */
+bool I2CDMA_Read(uint8_t address, uint8_t length);
+
+/**
+ * Gets the state of the last transfer, a transfer is finished when the DMA has moved all bytes and the bus is idle again
+ * Safe to call from the timer callback, the check runs with interrupts disabled
+ *
+ * @return - state of the last transfer
+ */
+I2CDMA_States I2CDMA_GetState(void);
+
+/**
+ * Gets the data of the last read transfer
+ *
+ * @return - pointer to the received bytes
+ */
+const uint8_t * I2CDMA_GetData(void);
+
+/**
+ * Waits until the transfer in progress has finished, used before blocking HAL_I2CWrite/HAL_I2CRead transactions
+ */
+void I2CDMA_Wait(void);
+
+/**
+ * Stops the transfer in progress and forces the bus state to idle
+ */
+void I2CDMA_Abort(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* ZERO */
+
+#endif /* I2CDMA_H */
@@ -10,7 +10,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "LED.h"
 
 /* </Includes> */ 
@@ -27,7 +27,7 @@ bool ledIsOn;
 
 void LED_Init(void)
 {
-  pinMode(LED_PIN, OUTPUT);
+  HAL_PinMode(LED_PIN, HAL_Output);
   LED_Off();
 }
 
@@ -35,7 +35,7 @@ void LED_Set(uint8_t brightness)
 {
   if (brightness > 0)
   {  
-    analogWrite(LED_PIN, (uint8_t)brightness);
+    HAL_PWMWrite(LED_PIN, (uint8_t)brightness);
     ledIsOn = true;
   }
   else
@@ -47,7 +47,7 @@ void LED_Set(uint8_t brightness)
 void LED_Off(void)
 {
   //digitalWrite(LED_PIN, LOW);
-  analogWrite(LED_PIN, 0);
+  HAL_PWMWrite(LED_PIN, 0);
   ledIsOn = false;
 }
 
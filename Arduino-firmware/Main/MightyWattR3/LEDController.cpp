@@ -9,7 +9,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "LED.h"
 #include "Communication.h"
 #include "Measurement.h"
@@ -18,6 +18,7 @@
 #include "Configuration.h"
 #include "Voltmeter.h"
 #include "Ammeter.h"
+#include "EventBus.h"
 
 /* </Includes> */ 
 
@@ -27,7 +28,8 @@
 static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static const TSCUChar * temperature; /* Pointer to structure where temperature can be found */
-static uint8_t commandCounter, measurementCounter, temperatureCounter; /* Number of the last executed command from communication, number of the last measurement data, number of the last temperature data */
+static uint8_t commandCounter; /* Number of the last executed command from communication */
+static EventBus_Subscription measurementSubscription, temperatureSubscription; /* New measurement values, new temperature */
 static uint8_t LEDBrightness; /* Indicates the brightness of the LED when on*/
 static uint8_t LEDLightRules; /* Describes under which circumstances the LED will light */
 void (* LEDController_Keep)(void); /* Pointer to the constant keeper function */
@@ -53,8 +55,8 @@ void LEDController_Init(void)
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
   commandCounter = 0;
-  measurementCounter = 0;
-  temperatureCounter = 0;
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement);
+  EventBus_Subscribe(&temperatureSubscription, Event_Thermometer);
   LEDBrightness = LED_CONTROLLER_DEFAULT_BRIGHTNESS;
   LEDLightRules = LED_CONTROLLER_DEFAULT_RULE;
   LEDController_Keep = &LEDController_KeepRule;
@@ -107,7 +109,7 @@ void LEDController_KeepRule(void)
     LEDWord &= ~LEDRule_AlwaysOn;
   }
    
-  if (measurementCounter != measurementValues->counter) /* Only process new values */
+  if (EventBus_Take(&measurementSubscription)) /* Only process new values */
   {
     /* Power > 1 % rule */ 
     if ((LEDLightRules & LEDRule_P1) > 0)
@@ -210,11 +212,9 @@ void LEDController_KeepRule(void)
     {
       LEDWord &= ~LEDRule_I10;
     }
-    
-    measurementCounter = measurementValues->counter;
   }
   
-  if (temperatureCounter != temperature->counter) /* Only process new values */
+  if (EventBus_Take(&temperatureSubscription)) /* Only process new values */
   {
     /* Temperature rule */       
     if ((LEDLightRules & LEDRule_T50) > 0)
@@ -232,7 +232,6 @@ void LEDController_KeepRule(void)
     {
       LEDWord &= ~LEDRule_T50;
     }
-    temperatureCounter = temperature->counter;
   }
   
   /* Apply rules */
@@ -0,0 +1,227 @@
+/**
+ * Latency.cpp
+ * End-to-end latency tracing of the command path and the trip path
+ *
+ * 2018-02-18
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "Latency.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static uint32_t timestamps[LATENCY_PROBE_COUNT]; /* Stage times of the traces in progress, us */
+static uint8_t nextStage[LATENCY_PATH_COUNT]; /* Next expected stage of the trace in progress, 0 = no trace */
+static uint16_t lastTrace[LATENCY_PROBE_COUNT]; /* Stage times of the last complete traces relative to the first stage, us */
+static Latency_Statistics statistics[LATENCY_PATH_COUNT];
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Adds a complete trace to the statistics of its path
+ *
+ * @param path - path of the trace
+ */
+static void Latency_Complete(Latency_Paths path);
+
+/**
+ * Returns the half-octave histogram bin of a latency
+ *
+ * @param latency - latency in us
+ *
+ * @return - bin index
+ */
+static uint8_t Latency_GetBin(uint32_t latency);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Latency_Init(void)
+{
+  for (uint8_t i = 0; i < LATENCY_PATH_COUNT; i++)
+  {
+    nextStage[i] = 0;
+  }
+  for (uint8_t i = 0; i < LATENCY_PROBE_COUNT; i++)
+  {
+    lastTrace[i] = 0;
+  }
+  Latency_Reset();
+}
+
+void Latency_Reset(void)
+{
+  for (uint8_t i = 0; i < LATENCY_PATH_COUNT; i++)
+  {
+    statistics[i].count = 0;
+    statistics[i].totalTime = 0;
+    statistics[i].minimum = 0xFFFFFFFF;
+    statistics[i].maximum = 0;
+    for (uint8_t j = 0; j < LATENCY_HISTOGRAM_BINS; j++)
+    {
+      statistics[i].histogram[j] = 0;
+    }
+  }
+}
+
+void Latency_Probe(Latency_Probes probe)
+{
+  Latency_Paths path = (Latency_Paths)(probe / LATENCY_STAGES_PER_PATH);
+  uint8_t stage = probe % LATENCY_STAGES_PER_PATH;
+
+  if (stage == 0)
+  {
+    /* Start a new trace, a trace in progress is abandoned */
+    timestamps[probe] = HAL_Microseconds();
+    nextStage[path] = 1;
+  }
+  else if (nextStage[path] == stage)
+  {
+    timestamps[probe] = HAL_Microseconds();
+    if (stage == (LATENCY_STAGES_PER_PATH - 1))
+    {
+      Latency_Complete(path);
+      nextStage[path] = 0;
+    }
+    else
+    {
+      nextStage[path]++;
+    }
+  }
+}
+
+void Latency_Cancel(Latency_Paths path)
+{
+  nextStage[path] = 0;
+}
+
+static void Latency_Complete(Latency_Paths path)
+{
+  uint8_t first = path * LATENCY_STAGES_PER_PATH;
+  uint32_t latency = timestamps[first + LATENCY_STAGES_PER_PATH - 1] - timestamps[first];
+  Latency_Statistics * s = &statistics[path];
+  uint8_t i;
+
+  for (i = 0; i < LATENCY_STAGES_PER_PATH; i++)
+  {
+    uint32_t t = timestamps[first + i] - timestamps[first];
+    lastTrace[first + i] = (t > 0xFFFF) ? 0xFFFF : (uint16_t)t;
+  }
+
+  if (s->totalTime + latency >= s->totalTime)
+  {
+    s->totalTime += latency;
+    s->count++;
+  }
+  if (latency < s->minimum)
+  {
+    s->minimum = latency;
+  }
+  if (latency > s->maximum)
+  {
+    s->maximum = latency;
+  }
+
+  uint8_t bin = Latency_GetBin(latency);
+  if (s->histogram[bin] == 0xFFFF)
+  {
+    /* Keep the shape of the distribution instead of saturating one bin */
+    for (i = 0; i < LATENCY_HISTOGRAM_BINS; i++)
+    {
+      s->histogram[i] >>= 1;
+    }
+  }
+  s->histogram[bin]++;
+}
+
+static uint8_t Latency_GetBin(uint32_t latency)
+{
+  if (latency < (1UL << LATENCY_HISTOGRAM_FIRST_BIN_BITS))
+  {
+    return 0;
+  }
+
+  /* Two bins per octave: the highest set bit selects the octave, the bit below it selects the half */
+  uint8_t msb = LATENCY_HISTOGRAM_FIRST_BIN_BITS;
+  while ((latency >> (msb + 1)) > 0)
+  {
+    msb++;
+  }
+  uint16_t bin = 1 + 2 * (msb - LATENCY_HISTOGRAM_FIRST_BIN_BITS) + ((latency >> (msb - 1)) & 1);
+  return (bin < LATENCY_HISTOGRAM_BINS) ? (uint8_t)bin : (LATENCY_HISTOGRAM_BINS - 1);
+}
+
+const Latency_Statistics * Latency_GetStatistics(Latency_Paths path)
+{
+  return &statistics[path];
+}
+
+uint32_t Latency_GetMean(Latency_Paths path)
+{
+  if (statistics[path].count == 0)
+  {
+    return 0;
+  }
+  return statistics[path].totalTime / statistics[path].count;
+}
+
+uint32_t Latency_GetP99(Latency_Paths path)
+{
+  const Latency_Statistics * s = &statistics[path];
+  uint32_t total = 0, cumulative = 0, upperBound;
+  uint8_t i;
+
+  for (i = 0; i < LATENCY_HISTOGRAM_BINS; i++)
+  {
+    total += s->histogram[i];
+  }
+  if (total == 0)
+  {
+    return 0;
+  }
+
+  total = total - total / 100; /* Number of traces at or below the 99th percentile, rounded up */
+  for (i = 0; i < (LATENCY_HISTOGRAM_BINS - 1); i++)
+  {
+    cumulative += s->histogram[i];
+    if (cumulative >= total)
+    {
+      break;
+    }
+  }
+
+  if (i == 0)
+  {
+    upperBound = 1UL << LATENCY_HISTOGRAM_FIRST_BIN_BITS;
+  }
+  else if (i == (LATENCY_HISTOGRAM_BINS - 1))
+  {
+    upperBound = s->maximum; /* Open-ended bin */
+  }
+  else
+  {
+    uint8_t octave = LATENCY_HISTOGRAM_FIRST_BIN_BITS + (i - 1) / 2;
+    upperBound = ((i - 1) & 1) ? (1UL << (octave + 1)) : (3UL << (octave - 1));
+  }
+  return (upperBound < s->maximum) ? upperBound : s->maximum;
+}
+
+uint16_t Latency_GetLastTrace(Latency_Probes probe)
+{
+  return lastTrace[probe];
+}
+
+/* </Implementations> */
@@ -0,0 +1,145 @@
+/**
+ * Latency.h
+ * End-to-end latency tracing of the command path and the trip path
+ *
+ * 2018-02-18
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define LATENCY_ENABLED                  /* Probes in the control paths, a diagnostic the UNO has no flash for */
+#endif
+#define LATENCY_RESET                       (1 << 2) /* Reset statistics command flag: latency statistics */
+#define LATENCY_HISTOGRAM_BINS              16 /* Number of half-octave histogram bins used for the percentile */
+#define LATENCY_HISTOGRAM_FIRST_BIN_BITS    7 /* The first bin holds latencies below 2^7 = 128 us, the last bin is open-ended */
+#define LATENCY_STAGES_PER_PATH             4 /* Number of probes on each path, the first one starts the trace and the last one completes it */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Probes in the order of the stages, LATENCY_STAGES_PER_PATH for each path
+ */
+enum Latency_Probes : uint8_t
+{
+  Probe_FrameComplete, /* Command path: write command frame received and checked */
+  Probe_CommandDispatched, /* Command path: command taken by Control */
+  Probe_SetterComputed, /* Command path: DAC value calculated by a setter */
+  Probe_DACWritten, /* Command path: DAC holds the new value */
+  Probe_SampleConverted, /* Trip path: ADC sample read */
+  Probe_MeasurementPublished, /* Trip path: new measurement values published */
+  Probe_LimiterEvaluated, /* Trip path: measurement values checked by the limiter */
+  Probe_LoadStopped, /* Trip path: load stopped by the limiter */
+  LATENCY_PROBE_COUNT
+};
+
+enum Latency_Paths : uint8_t
+{
+  Path_Command, /* Frame complete to DAC written */
+  Path_Trip, /* Sample converted to load stopped */
+  LATENCY_PATH_COUNT
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Running statistics of the complete traces of one path
+ */
+struct Latency_Statistics
+{
+  uint32_t count; /* Number of complete traces, stops together with totalTime when totalTime would overflow */
+  uint32_t totalTime; /* Sum of latencies in us */
+  uint32_t minimum; /* Shortest latency in us */
+  uint32_t maximum; /* Longest latency in us */
+  uint16_t histogram[LATENCY_HISTOGRAM_BINS]; /* Number of traces per half-octave bin, all bins are halved when one would overflow */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes latency tracing and clears the statistics
+ */
+void Latency_Init(void);
+
+/**
+ * Clears the statistics
+ */
+void Latency_Reset(void);
+
+/**
+ * Timestamps a stage
+ * The first probe of a path starts a new trace, the other probes are only taken if the previous stage of the same trace has been reached,
+ * the last probe completes the trace and adds it to the statistics
+ *
+ * @param probe - stage that has been reached
+ */
+void Latency_Probe(Latency_Probes probe);
+
+/**
+ * Abandons the trace of a path that is in progress
+ *
+ * @param path - path whose trace is abandoned
+ */
+void Latency_Cancel(Latency_Paths path);
+
+/**
+ * Gets the statistics of a path
+ *
+ * @param path - path
+ *
+ * @return - Pointer to constant statistics
+ */
+const Latency_Statistics * Latency_GetStatistics(Latency_Paths path);
+
+/**
+ * Gets the mean latency of a path
+ *
+ * @param path - path
+ *
+ * @return - Mean latency in us, 0 if there is no complete trace
+ */
+uint32_t Latency_GetMean(Latency_Paths path);
+
+/**
+ * Gets the 99th percentile of the latency of a path
+ * The value is the upper bound of the histogram bin (at most 41 % above the true value) but not more than the maximum
+ *
+ * @param path - path
+ *
+ * @return - 99th percentile in us, 0 if there is no complete trace
+ */
+uint32_t Latency_GetP99(Latency_Paths path);
+
+/**
+ * Gets the time of a stage of the last complete trace, relative to the start of its path
+ *
+ * @param probe - stage
+ *
+ * @return - Time from the first stage of the path in us, saturates
+ */
+uint16_t Latency_GetLastTrace(Latency_Probes probe);
+
+/* </Declarations (prototypes)> */
+
+#endif /* LATENCY_H */
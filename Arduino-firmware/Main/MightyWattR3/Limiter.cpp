@@ -9,7 +9,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Thermometer.h"
 #include "Measurement.h"
 #include "Communication.h"
@@ -21,6 +21,8 @@
 #include "VoltageSetter.h"
 #include "CurrentSetter.h"
 #include "Integrator.h"
+#include "EventBus.h"
+#include "Latency.h"
 
 /* </Includes> */ 
 
@@ -30,7 +32,8 @@
 static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
 static const Measurement_Values * measurementValues; /* Pointer to the latest measured voltage, current, power and resistance */
 static const TSCUChar * temperature; /* Pointer to structure where temperature can be found */
-static uint8_t commandCounter, temperatureCounter; /* Number of the last executed command from communication, number of the last temperature data */
+static uint8_t commandCounter; /* Number of the last executed command from communication */
+static EventBus_Subscription measurementSubscription, temperatureSubscription; /* New measurement values, new temperature */
 static uint8_t measurementErrorCounter, thermometerErrorCounter, ADCErrorCounter[ADC_CHANNEL_COUNT]; /* Error counters for measurement, thermometer and ADC modules */
 static uint16_t SeriesResistance; /* Series resistance for calculating allowed P in 4-wire mode, in mOhm (max 65.535 Ohm) */
 const static ErrorMessaging_Error * MeasurementError; /* Pointer to error structure from measurement */
@@ -62,6 +65,8 @@ void Limiter_Init(void)
   writeCommand = Communication_GetWriteCommand();  
   measurementValues = Measurement_GetValues();
   temperature = Thermometer_GetTemperature();
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement);
+  EventBus_Subscribe(&temperatureSubscription, Event_Thermometer);
   
   SeriesResistance = 0;
   
@@ -150,7 +155,7 @@ static void Limiter_Keep(void)
   }
   
   /* Temperature check */
-  if (temperatureCounter != temperature->counter)
+  if (EventBus_Take(&temperatureSubscription))
   {
     if (temperature->value > LIMITER_MAXIMUM_TEMPERATURE)
     {
@@ -161,11 +166,10 @@ static void Limiter_Keep(void)
 //      Serial.print(temperature->value);
 //      Serial.println(" °C");
     }    
-    temperatureCounter = temperature->counter;
   }  
   
   /* Voltage, current and power check */
-  if (lastValues.counter != measurementValues->counter)
+  if (EventBus_Take(&measurementSubscription))
   { 
     /* V check */
     if (measurementValues->voltage > VOLTMETER_MAXIMUM_VOLTAGE)
@@ -221,18 +225,23 @@ static void Limiter_Keep(void)
       LimiterError.error = ErrorMessaging_Limiter_SOAExceeded;
     }    
         
-    lastValues.counter = measurementValues->counter;
     lastValues.milliseconds = measurementValues->milliseconds;
     lastValues.power = measurementValues->power;
     lastValues.voltage = measurementValues->voltage;
     lastValues.current = measurementValues->current;
+    #ifdef LATENCY_ENABLED
+      Latency_Probe(Probe_LimiterEvaluated);
+    #endif
   }
   
   /* Execute actions */
   if (fatalError)
   {
     Control_StopLoad();
-    LimiterError.errorCounter++;
+    #ifdef LATENCY_ENABLED
+      Latency_Probe(Probe_LoadStopped);
+    #endif
+    ErrorMessaging_Raise(&LimiterError, LimiterError.error);
   }
 }
 
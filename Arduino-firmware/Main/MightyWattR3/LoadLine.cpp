@@ -0,0 +1,253 @@
+/**
+ * LoadLine.cpp
+ * Load-line emulation, the current follows an uploaded piecewise-linear I(V) table
+ *
+ * 2018-03-06
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include <string.h>
+#include "HAL.h"
+#include "LoadLine.h"
+#include "CurrentSetter.h"
+#include "Measurement.h"
+#include "EventBus.h"
+#include "RingBuffer.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define LOADLINE_MAXIMUM_EVALUATION_TIME    0xFFFF /* us, saturation of the reported times */
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+static LoadLine_State state;
+static const Measurement_Values * measurementValues;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Sets the current setter from the latest measurement and times the lookup
+ */
+static void LoadLine_Update(void);
+
+/**
+ * Looks up the current of a voltage in the table
+ *
+ * @param voltage - uV
+ *
+ * @return - Interpolated current in uA
+ */
+static uint32_t LoadLine_Evaluate(uint32_t voltage);
+
+/**
+ * Copies a point of the table, the records of the buffer need not be aligned
+ *
+ * @param index - index of the point
+ * @param point - pointer to the copy
+ */
+static void LoadLine_GetPoint(uint16_t index, LoadLine_Point * point);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void LoadLine_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  state.status = LoadLine_Idle;
+  state.points = 0;
+}
+
+void LoadLine_Do(void)
+{
+  if ((state.status == LoadLine_Running) && EventBus_Take(&measurementSubscription))
+  {
+    LoadLine_Update();
+  }
+}
+
+bool LoadLine_Clear(void)
+{
+  if (state.status == LoadLine_Running)
+  {
+    return false;
+  }
+
+  /* The history gives way to the table */
+  RingBuffer_Release(RingBuffer_History);
+  if (!RingBuffer_Acquire(RingBuffer_LoadLine, sizeof(LoadLine_Point)))
+  {
+    state.status = LoadLine_Invalid;
+    return false;
+  }
+  state.status = LoadLine_Idle;
+  state.points = 0;
+  return true;
+}
+
+bool LoadLine_Add(const uint32_t * arguments, uint8_t count)
+{
+  bool valid = (state.status != LoadLine_Running) && (count > 0) && ((count & 1) == 0) && (RingBuffer_GetOwner() == RingBuffer_LoadLine)
+               && ((uint32_t)RingBuffer_GetCount() + count / 2 <= RingBuffer_GetCapacity());
+  LoadLine_Point point;
+
+  /* The voltages rise from the last point of the table through the new ones */
+  if (valid && (state.points > 0))
+  {
+    LoadLine_GetPoint(state.points - 1, &point);
+    valid = arguments[0] > point.voltage;
+  }
+  for (uint8_t i = 0; valid && (i < count); i += 2)
+  {
+    valid = (arguments[i + 1] < CURRENT_SETTER_MAXIMUM_HICURRENT) && ((i == 0) || (arguments[i] > arguments[i - 2]));
+  }
+
+  if (!valid)
+  {
+    if (state.status != LoadLine_Running)
+    {
+      state.status = LoadLine_Invalid;
+    }
+    return false;
+  }
+
+  for (uint8_t i = 0; i < count; i += 2)
+  {
+    point.voltage = arguments[i];
+    point.current = arguments[i + 1];
+    RingBuffer_Push(&point);
+  }
+  state.points = RingBuffer_GetCount();
+  return true;
+}
+
+bool LoadLine_Start(void)
+{
+  if ((RingBuffer_GetOwner() != RingBuffer_LoadLine) || (state.points < 2))
+  {
+    if (state.status != LoadLine_Running)
+    {
+      state.status = LoadLine_Invalid;
+    }
+    return false;
+  }
+
+  state.updates = 0;
+  state.evaluationTime = 0;
+  state.worstEvaluationTime = 0;
+  state.status = LoadLine_Running;
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement);
+  LoadLine_Update(); /* The latest measurement gives the first current */
+  return true;
+}
+
+void LoadLine_Stop(void)
+{
+  if (state.status == LoadLine_Running)
+  {
+    state.status = LoadLine_Stopped;
+  }
+}
+
+void LoadLine_Release(void)
+{
+  if (state.status != LoadLine_Running)
+  {
+    RingBuffer_Release(RingBuffer_LoadLine);
+    state.points = 0;
+  }
+}
+
+bool LoadLine_IsRunning(void)
+{
+  return state.status == LoadLine_Running;
+}
+
+const LoadLine_State * LoadLine_GetState(void)
+{
+  return &state;
+}
+
+static void LoadLine_Update(void)
+{
+  uint32_t start = HAL_Microseconds();
+  uint32_t time;
+
+  state.current = LoadLine_Evaluate(measurementValues->unfilteredVoltage);
+  CurrentSetter_SetCurrent(state.current);
+
+  time = HAL_Microseconds() - start;
+  if (time > LOADLINE_MAXIMUM_EVALUATION_TIME)
+  {
+    time = LOADLINE_MAXIMUM_EVALUATION_TIME;
+  }
+  state.evaluationTime = (uint16_t)time;
+  if (state.evaluationTime > state.worstEvaluationTime)
+  {
+    state.worstEvaluationTime = state.evaluationTime;
+  }
+  state.updates++;
+}
+
+static uint32_t LoadLine_Evaluate(uint32_t voltage)
+{
+  LoadLine_Point low, high, point;
+  uint16_t first = 0;
+  uint16_t last = state.points - 1;
+
+  LoadLine_GetPoint(first, &low);
+  if (voltage <= low.voltage)
+  {
+    return low.current;
+  }
+  LoadLine_GetPoint(last, &high);
+  if (voltage >= high.voltage)
+  {
+    return high.current;
+  }
+
+  /* Binary search of the segment, the voltage stays between the points first and last */
+  while (last - first > 1)
+  {
+    uint16_t middle = (first + last) / 2;
+    LoadLine_GetPoint(middle, &point);
+    if (point.voltage <= voltage)
+    {
+      first = middle;
+      low = point;
+    }
+    else
+    {
+      last = middle;
+      high = point;
+    }
+  }
+
+  if (high.current >= low.current)
+  {
+    return low.current + (uint32_t)((((uint64_t)(high.current - low.current)) * (voltage - low.voltage)) / (high.voltage - low.voltage));
+  }
+  return low.current - (uint32_t)((((uint64_t)(low.current - high.current)) * (voltage - low.voltage)) / (high.voltage - low.voltage));
+}
+
+static void LoadLine_GetPoint(uint16_t index, LoadLine_Point * point)
+{
+  memcpy(point, RingBuffer_Get(index), sizeof(LoadLine_Point));
+}
+
+/* </Implementations> */
@@ -0,0 +1,150 @@
+/**
+ * LoadLine.h
+ * Load-line emulation, the current follows an uploaded piecewise-linear I(V) table
+ *
+ * 2018-03-06
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The load behaves like a nonlinear device (LED string, diode, battery, resistor with a knee) for tests of chargers,
+ * solar regulators and LED drivers. The table is stored in the shared ring buffer (20 points on UNO, 512 on ZERO)
+ * as voltage and current pairs with rising voltages. Every new measurement (the ADC rate is the only limit) looks up
+ * its unfiltered voltage by a binary search, interpolates the current linearly and hands it to the current setter.
+ * Below the first point and above the last point the current of the end point holds.
+ * The time of the lookup is measured and reported with the state.
+ */
+
+#ifndef LOADLINE_H
+#define LOADLINE_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define LOADLINE_ENABLED                 /* Table lookup per measurement, not on UNO (flash) */
+#endif
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum LoadLine_Status : uint8_t
+{
+  LoadLine_Idle, /* No emulation since the table was cleared */
+  LoadLine_Running,
+  LoadLine_Stopped, /* Stop command, mode command or limiter, the load is off */
+  LoadLine_Invalid /* The last command was rejected, the table was not changed */
+};
+
+/**
+ * data[0] of WriteCommand_LoadLine
+ */
+enum LoadLine_Commands : uint8_t
+{
+  LoadLineCommand_Clear = 0, /* Takes the ring buffer and empties the table */
+  LoadLineCommand_Add = 1, /* Appends the staged arguments as points, pairs of voltage (uV) and current (uA) */
+  LoadLineCommand_Start = 2, /* Starts the emulation */
+  LoadLineCommand_Stop = 3, /* Stops the emulation and switches the load off */
+  LoadLineCommand_Release = 4 /* Returns the ring buffer to the history, the table is lost */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * One point of the table, one record of the ring buffer
+ */
+struct LoadLine_Point
+{
+  uint32_t voltage; /* uV, higher than the voltage of the previous point */
+  uint32_t current; /* uA */
+};
+
+/**
+ * State of the emulation
+ */
+struct LoadLine_State
+{
+  LoadLine_Status status;
+  uint16_t points; /* Points in the table */
+  uint32_t updates; /* Measurements processed since the start */
+  uint32_t current; /* uA, last current from the table */
+  uint16_t evaluationTime; /* us, last lookup and interpolation */
+  uint16_t worstEvaluationTime; /* us, longest lookup since the start, saturates */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void LoadLine_Init(void);
+
+/**
+ * Executable function which must be called periodically while the emulation runs, before the current setter
+ */
+void LoadLine_Do(void);
+
+/**
+ * Takes the ring buffer and empties the table
+ *
+ * @return - true if the buffer could be taken
+ */
+bool LoadLine_Clear(void);
+
+/**
+ * Appends points to the table
+ *
+ * @param arguments - array of pairs of voltage (uV) and current (uA)
+ * @param count - number of the arguments in the array, even
+ *
+ * @return - true if all points fit in the table and their voltages rise
+ */
+bool LoadLine_Add(const uint32_t * arguments, uint8_t count);
+
+/**
+ * Starts the emulation, the current setter is set from the latest measurement
+ *
+ * @return - true if the table is valid and the emulation runs
+ */
+bool LoadLine_Start(void);
+
+/**
+ * Stops a running emulation, the current setter is left to the caller
+ */
+void LoadLine_Stop(void);
+
+/**
+ * Returns the ring buffer to the history when no emulation runs
+ */
+void LoadLine_Release(void);
+
+/**
+ * Returns whether the emulation runs
+ *
+ * @return - true while the current setter follows the table
+ */
+bool LoadLine_IsRunning(void);
+
+/**
+ * Returns the state of the emulation
+ *
+ * @return - Pointer to constant state
+ */
+const LoadLine_State * LoadLine_GetState(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* LOADLINE_H */
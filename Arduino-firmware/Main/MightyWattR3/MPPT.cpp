@@ -0,0 +1,452 @@
+/**
+ * MPPT.cpp
+ * Maximum power point tracker with local tracking and global scan
+ *
+ * 2018-02-28
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "MPPT.h"
+#include "Configuration.h"
+#include "DACC.h"
+#include "Control.h"
+#include "Ammeter.h"
+#include "Voltmeter.h"
+#include "VoltageSetter.h"
+#include "RangeSwitcher.h"
+#include "Measurement.h"
+#include "EventBus.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static MPPT_Statistics statistics;
+static uint32_t scanPeriod = MPPT_DEFAULT_SCAN_PERIOD;
+static const Measurement_Values * measurementValues;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+static uint8_t skippedCount, averagedCount; /* Measurements skipped and averaged since the last change of the voltage */
+static uint32_t stepTime; /* ms, last change of the voltage */
+static uint32_t voltageSum, currentSum;
+static uint8_t scanPoint; /* Index of the present point of the scan, 0 is the open circuit */
+static uint32_t openVoltage; /* uV, measured at the first point of the scan */
+static uint32_t scanPower, scanVoltage; /* uW, uV, largest power of the present scan and its voltage */
+static uint32_t scanTime; /* ms, start of the last scan */
+static uint32_t scanEndTime; /* ms, end of the last scan */
+static uint32_t triggerTime; /* ms, start, change or periodic scan that the time to the maximum power point is measured from */
+static uint64_t powerSum; /* uW, sum of the measured power since the last scan */
+static uint32_t powerCount;
+static bool tracked; /* The last operating point of the local tracking is valid */
+static uint32_t lastVoltage, lastCurrent, lastPower; /* Last operating point of the local tracking */
+static bool increase; /* Direction of the local tracking */
+static uint32_t step; /* uV, step of the local tracking */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Sets a new voltage and restarts the averaging
+ *
+ * @param voltage - uV
+ */
+static void MPPT_SetVoltage(uint32_t voltage);
+
+/**
+ * Restarts the averaging, the voltage was changed or is held
+ */
+static void MPPT_Wait(void);
+
+/**
+ * Adds the latest measurement to the averages when the operating point has settled
+ *
+ * @param interval - ms, time after the change of the voltage before the averaging
+ *
+ * @return - true when the averages are complete
+ */
+static bool MPPT_Average(uint32_t interval);
+
+/**
+ * Starts a global scan with the open circuit
+ */
+static void MPPT_StartScan(void);
+
+/**
+ * Processes one point of the scan and sets the next one
+ *
+ * @param voltage - uV, averaged voltage of the point
+ * @param current - uA, averaged current of the point
+ */
+static void MPPT_ScanPoint(uint32_t voltage, uint32_t current);
+
+/**
+ * Ends the scan at the point of the largest power and starts the local tracking there
+ */
+static void MPPT_EndScan(void);
+
+/**
+ * Processes one operating point of the local tracking and sets the next one
+ *
+ * @param voltage - uV, averaged voltage of the point
+ * @param current - uA, averaged current of the point
+ */
+static void MPPT_Track(uint32_t voltage, uint32_t current);
+
+/**
+ * Updates the mean power, efficiency and time to the maximum power point, raises the maximum power to a larger tracked one
+ *
+ * @param voltage - uV, averaged voltage of the present operating point
+ * @param power - uW, averaged power of the present operating point
+ */
+static void MPPT_UpdateStatistics(uint32_t voltage, uint32_t power);
+
+/**
+ * Computes d(ln P) / d(ln V) from the changes of an operating point
+ *
+ * @param change - change of the power (perturb and observe) or of the current (incremental conductance)
+ * @param value - power or current of the operating point
+ * @param voltageChange - uV, change of the voltage, not zero
+ * @param voltage - uV, voltage of the operating point
+ *
+ * @return - (change / value) / (voltageChange / voltage) in Q16
+ */
+static int64_t MPPT_Slope(int64_t change, uint32_t value, int32_t voltageChange, uint32_t voltage);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void MPPT_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  statistics.algorithm = MPPT_DEFAULT_ALGORITHM;
+  statistics.stage = MPPTStage_Idle;
+  statistics.timeToMPP = MPPT_NOT_CONVERGED;
+}
+
+void MPPT_Do(uint32_t interval)
+{
+  if ((statistics.stage == MPPTStage_Idle) || !EventBus_Take(&measurementSubscription))
+  {
+    return;
+  }
+
+  if (statistics.stage == MPPTStage_Scan)
+  {
+    if (MPPT_Average(0))
+    {
+      MPPT_ScanPoint(voltageSum / MPPT_AVERAGE_MEASUREMENTS, currentSum / MPPT_AVERAGE_MEASUREMENTS);
+    }
+    return;
+  }
+
+  powerSum += measurementValues->unfilteredPower;
+  powerCount++;
+  if ((scanPeriod != 0) && (HAL_Milliseconds() - scanTime >= scanPeriod))
+  {
+    triggerTime = HAL_Milliseconds();
+    MPPT_StartScan();
+  }
+  else if (MPPT_Average(interval))
+  {
+    MPPT_Track(voltageSum / MPPT_AVERAGE_MEASUREMENTS, currentSum / MPPT_AVERAGE_MEASUREMENTS);
+  }
+}
+
+void MPPT_Start(uint32_t voltage)
+{
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement); /* Only the measurements after the start */
+  triggerTime = HAL_Milliseconds();
+  statistics.timeToMPP = MPPT_NOT_CONVERGED;
+  statistics.maximumPower = 0;
+  statistics.maximumPowerVoltage = 0;
+  statistics.meanPower = 0;
+  statistics.efficiency = 0;
+  powerSum = 0;
+  powerCount = 0;
+  if (voltage == 0)
+  {
+    MPPT_StartScan();
+  }
+  else
+  {
+    scanTime = triggerTime; /* The first periodic scan comes one period after the start */
+    scanEndTime = triggerTime;
+    tracked = false;
+    statistics.stage = MPPTStage_Track;
+    MPPT_SetVoltage(voltage);
+  }
+}
+
+void MPPT_Stop(void)
+{
+  statistics.stage = MPPTStage_Idle;
+}
+
+void MPPT_SetAlgorithm(MPPT_Algorithms algorithm)
+{
+  statistics.algorithm = algorithm;
+  tracked = false; /* The new algorithm starts from the next operating point */
+}
+
+void MPPT_SetScanPeriod(uint32_t period)
+{
+  scanPeriod = period;
+}
+
+const MPPT_Statistics * MPPT_GetStatistics(void)
+{
+  return &statistics;
+}
+
+static void MPPT_SetVoltage(uint32_t voltage)
+{
+  VoltageSetter_SetVoltage(voltage);
+  MPPT_Wait();
+}
+
+static void MPPT_Wait(void)
+{
+  stepTime = HAL_Milliseconds();
+  skippedCount = 0;
+  averagedCount = 0;
+  voltageSum = 0;
+  currentSum = 0;
+}
+
+static bool MPPT_Average(uint32_t interval)
+{
+  /* The first skipped measurements may have been taken before the change, their timestamps are not compared */
+  if ((skippedCount < MPPT_SETTLE_MEASUREMENTS) || (measurementValues->milliseconds - stepTime < interval))
+  {
+    if (skippedCount < MPPT_SETTLE_MEASUREMENTS)
+    {
+      skippedCount++;
+    }
+    return false;
+  }
+  voltageSum += measurementValues->unfilteredVoltage;
+  currentSum += measurementValues->unfilteredCurrent;
+  averagedCount++;
+  return averagedCount >= MPPT_AVERAGE_MEASUREMENTS;
+}
+
+static void MPPT_StartScan(void)
+{
+  statistics.stage = MPPTStage_Scan;
+  statistics.timeToMPP = MPPT_NOT_CONVERGED;
+  scanTime = HAL_Milliseconds();
+  scanPoint = 0;
+  scanPower = 0;
+  scanVoltage = 0;
+  MPPT_SetVoltage((uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1));
+}
+
+static void MPPT_ScanPoint(uint32_t voltage, uint32_t current)
+{
+  uint32_t power = (uint32_t)((((uint64_t)voltage) * current) / 1000000);
+
+  if (scanPoint == 0)
+  {
+    openVoltage = voltage;
+  }
+  else if (power > scanPower)
+  {
+    scanPower = power;
+    scanVoltage = voltage;
+  }
+
+  scanPoint++;
+  if ((scanPoint < MPPT_SCAN_POINTS) && (openVoltage >= VOLTMETER_THRESHOLD_VOLTAGE))
+  {
+    MPPT_SetVoltage((uint32_t)((((uint64_t)openVoltage) * (MPPT_SCAN_POINTS - scanPoint)) / MPPT_SCAN_POINTS));
+  }
+  else
+  {
+    MPPT_EndScan();
+  }
+}
+
+static void MPPT_EndScan(void)
+{
+  statistics.scans++;
+  statistics.maximumPower = scanPower;
+  statistics.maximumPowerVoltage = scanVoltage;
+  statistics.meanPower = 0;
+  statistics.efficiency = 0;
+  statistics.stage = MPPTStage_Track;
+  powerSum = 0;
+  powerCount = 0;
+  scanEndTime = HAL_Milliseconds();
+  tracked = false;
+  if (scanPower > 0)
+  {
+    MPPT_SetVoltage(scanVoltage);
+  }
+  else
+  {
+    MPPT_SetVoltage((uint32_t)(VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE - 1)); /* No power anywhere, wait in open circuit */
+  }
+}
+
+static void MPPT_Track(uint32_t voltage, uint32_t current)
+{
+  uint32_t power = (uint32_t)((((uint64_t)voltage) * current) / 1000000);
+  int32_t voltageChange = (int32_t)(voltage - lastVoltage);
+  int32_t currentChange = (int32_t)(current - lastCurrent);
+  int64_t powerChange = ((int64_t)power) - lastPower;
+  uint32_t absoluteVoltageChange = (voltageChange >= 0) ? voltageChange : -voltageChange;
+  uint64_t absolutePowerChange = (powerChange >= 0) ? powerChange : -powerChange;
+  bool hold = false;
+  uint32_t minimumStep = RangeSwitcher_GetVoltageRange() == VoltageRange_HighVoltage ? CONTROL_MINIMUM_HI_VOLTAGE_STEP : CONTROL_MINIMUM_LO_VOLTAGE_STEP;
+
+  MPPT_UpdateStatistics(voltage, power);
+
+  if (!tracked)
+  {
+    tracked = true;
+    increase = true;
+    step = 0; /* Smallest step, the scan ends next to the maximum */
+  }
+  else if (((voltage < VOLTMETER_THRESHOLD_VOLTAGE) || ((absolutePowerChange * MPPT_CHANGE > lastPower) && (absolutePowerChange * lastVoltage > ((uint64_t)absoluteVoltageChange) * lastPower * MPPT_CHANGE_SLOPE))
+            || (((uint64_t)power) * MPPT_CHANGE < ((uint64_t)statistics.maximumPower) * (MPPT_CHANGE - 1)))
+           && (HAL_Milliseconds() - scanEndTime >= MPPT_SCAN_HOLDOFF))
+  {
+    triggerTime = HAL_Milliseconds(); /* The source changed, the maximum may have moved to another peak */
+    MPPT_StartScan();
+    return;
+  }
+  else if (voltage < VOLTMETER_THRESHOLD_VOLTAGE) /* Zero voltage, the next scan looks for the source */
+  {
+    hold = true;
+  }
+  else if (current < AMMETER_THRESHOLD_VOLTAGE) /* Decrease voltage on zero current */
+  {
+    increase = false;
+    step = voltage / MPPT_MAXIMUM_STEP;
+  }
+  else
+  {
+    /* The slope is known when the voltage moved by at least half of the smallest step */
+    bool known = ((uint64_t)absoluteVoltageChange) * MPPT_MINIMUM_STEP * 2 >= voltage;
+    int64_t slope = 0;
+
+    if (statistics.algorithm == MPPT_IncrementalConductance)
+    {
+      if (known)
+      {
+        slope = MPPT_ONE + MPPT_Slope(currentChange, current, voltageChange, voltage); /* dI/dV + I/V relative to I/V */
+        if ((slope < MPPT_INCREMENTAL_CONDUCTANCE_BAND) && (slope > -MPPT_INCREMENTAL_CONDUCTANCE_BAND))
+        {
+          hold = true;
+        }
+        increase = slope > 0;
+      }
+      else if ((currentChange > (int32_t)AMMETER_THRESHOLD_VOLTAGE) || (currentChange < -(int32_t)AMMETER_THRESHOLD_VOLTAGE))
+      {
+        increase = currentChange > 0; /* More light at the same voltage moves the maximum to a higher voltage */
+        step = 0;
+      }
+      else
+      {
+        hold = true;
+      }
+    }
+    else
+    {
+      if (known)
+      {
+        slope = MPPT_Slope(powerChange, power, voltageChange, voltage);
+      }
+      if (powerChange < 0)
+      {
+        increase = !increase;
+      }
+    }
+
+    if (known)
+    {
+      if (slope < 0)
+      {
+        slope = -slope;
+      }
+      step = (uint32_t)((((uint64_t)voltage) * slope) / (MPPT_ONE * MPPT_STEP_GAIN));
+    }
+  }
+
+  lastVoltage = voltage;
+  lastCurrent = current;
+  lastPower = power;
+
+  if (hold)
+  {
+    MPPT_Wait();
+    return;
+  }
+
+  /* Step between 1/256 and 1/16 of the voltage and not below the resolution of the setter */
+  if (step > voltage / MPPT_MAXIMUM_STEP)
+  {
+    step = voltage / MPPT_MAXIMUM_STEP;
+  }
+  if (step < voltage / MPPT_MINIMUM_STEP)
+  {
+    step = voltage / MPPT_MINIMUM_STEP;
+  }
+  if (step < minimumStep)
+  {
+    step = minimumStep;
+  }
+
+  if (increase)
+  {
+    VoltageSetter_Plus(step);
+  }
+  else
+  {
+    VoltageSetter_Minus(step);
+  }
+  MPPT_Wait();
+}
+
+static void MPPT_UpdateStatistics(uint32_t voltage, uint32_t power)
+{
+  if (powerCount > 0)
+  {
+    statistics.meanPower = (uint32_t)(powerSum / powerCount);
+  }
+  if ((statistics.maximumPower > 0) && (power > statistics.maximumPower))
+  {
+    /* The source gives more than at the scan (more light), the tracked power is the new reference */
+    statistics.maximumPower = power;
+    statistics.maximumPowerVoltage = voltage;
+  }
+  if (statistics.maximumPower > 0)
+  {
+    uint64_t efficiency = (((uint64_t)statistics.meanPower) * 10000) / statistics.maximumPower;
+    statistics.efficiency = (efficiency > 10000) ? 10000 : (uint16_t)efficiency; /* The mean includes samples above the reference before it was raised */
+    if ((statistics.timeToMPP == MPPT_NOT_CONVERGED) && (power >= statistics.maximumPower - statistics.maximumPower / MPPT_CONVERGENCE_BAND))
+    {
+      statistics.timeToMPP = HAL_Milliseconds() - triggerTime;
+    }
+  }
+}
+
+static int64_t MPPT_Slope(int64_t change, uint32_t value, int32_t voltageChange, uint32_t voltage)
+{
+  if (value == 0)
+  {
+    return 0;
+  }
+  return ((((change * MPPT_ONE) / value) * voltage) / voltageChange);
+}
+
+/* </Implementations> */
@@ -0,0 +1,144 @@
+/**
+ * MPPT.h
+ * Maximum power point tracker with local tracking and global scan
+ *
+ * 2018-02-28
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The tracker sets the voltage setter (CV phase). A global scan sets the open circuit, then sweeps the voltage
+ * from the open-circuit voltage towards zero in MPPT_SCAN_POINTS steps and moves to the point of the largest
+ * power, so that a local maximum of a partially shaded panel is not kept. Local tracking continues from there
+ * with one of the algorithms; both use a step proportional to the logarithmic slope of the power,
+ * d(ln P) / d(ln V), which is 1 on the current-source side of the curve and 0 at the maximum.
+ * A scan runs at the start (with no start voltage), periodically, when the power changes by more than the
+ * step of the voltage explains (change of irradiance or shading) and when the tracked power falls below the power
+ * found by the scan by more than MPPT_CHANGE (a change during which the CV loop moved the voltage as well).
+ */
+
+#ifndef MPPT_H
+#define MPPT_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define MPPT_ENABLED                     /* Tracker and scans, about 2 KB of code, UNO runs without them */
+#endif
+#define MPPT_ONE                            65536L /* Slopes are in Q16 */
+#define MPPT_DEFAULT_ALGORITHM              MPPT_PerturbObserve
+#define MPPT_DEFAULT_SCAN_PERIOD            60000 /* ms, 0 scans only at the start and on a change */
+#define MPPT_SCAN_POINTS                    24 /* Points of the global scan including the open circuit */
+#define MPPT_SETTLE_MEASUREMENTS            2 /* Measurements skipped after every change of the voltage, the whole settling of a scan point */
+#define MPPT_SCAN_HOLDOFF                   250 /* ms, shortest time from the end of a scan to a scan started by a change */
+#define MPPT_AVERAGE_MEASUREMENTS           2 /* Measurements averaged for one operating point */
+#define MPPT_STEP_GAIN                      8 /* The step is V * |d(ln P) / d(ln V)| / MPPT_STEP_GAIN */
+#define MPPT_MINIMUM_STEP                   256 /* The step is at least 1/256 of the voltage, well above the noise */
+#define MPPT_MAXIMUM_STEP                   16 /* The step is at most 1/16 of the voltage */
+#define MPPT_INCREMENTAL_CONDUCTANCE_BAND   2048 /* Q16, |d(ln P) / d(ln V)| below 1/32 holds the voltage */
+#define MPPT_CHANGE                         16 /* A change of the power above 1/16 ... */
+#define MPPT_CHANGE_SLOPE                   4 /* ... and above 4 times the relative change of the voltage starts a scan, so does a power 1/16 below the maximum power */
+#define MPPT_CONVERGENCE_BAND               64 /* The maximum power point is reached within 1/64 of the power found by the scan */
+#define MPPT_NOT_CONVERGED                  0xFFFFFFFFUL /* Time to the maximum power point that has not been reached */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Local tracking algorithms
+ */
+enum MPPT_Algorithms : uint8_t
+{
+  MPPT_PerturbObserve, /* Perturb and observe, the direction reverses when the power drops */
+  MPPT_IncrementalConductance, /* Direction from dI/dV + I/V, holds the voltage at the maximum, follows the current when the voltage does not move */
+  MPPT_AlgorithmsCount
+};
+
+enum MPPT_Stages : uint8_t
+{
+  MPPTStage_Idle, /* Not in MPPT mode */
+  MPPTStage_Scan,
+  MPPTStage_Track
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Tracking statistics, the reference is the largest power found by the last scan or tracked since
+ */
+struct MPPT_Statistics
+{
+  MPPT_Algorithms algorithm;
+  MPPT_Stages stage;
+  uint16_t scans; /* Finished scans, intentional wraparound */
+  uint32_t maximumPower; /* uW, largest power found by the last scan or tracked since */
+  uint32_t maximumPowerVoltage; /* uV, voltage of that power */
+  uint32_t meanPower; /* uW, mean power of the tracking since the last scan */
+  uint16_t efficiency; /* 0.01 %, mean power relative to the maximum power, at most 100.00 % */
+  uint32_t timeToMPP; /* ms, from the start, the change or the periodic scan to the maximum power point, MPPT_NOT_CONVERGED until reached */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void MPPT_Init(void);
+
+/**
+ * Executable function which must be called periodically in MPPT mode, the caller runs the voltage setter
+ *
+ * @param interval - ms, time for the load and the source to settle after a step of the local tracking
+ */
+void MPPT_Do(uint32_t interval);
+
+/**
+ * Starts the tracking
+ *
+ * @param voltage - uV, voltage where the local tracking starts, 0 starts with a scan
+ */
+void MPPT_Start(uint32_t voltage);
+
+/**
+ * Ends the tracking, the setters are left to the caller
+ */
+void MPPT_Stop(void);
+
+/**
+ * Sets the local tracking algorithm
+ *
+ * @param algorithm - new algorithm, must be below MPPT_AlgorithmsCount
+ */
+void MPPT_SetAlgorithm(MPPT_Algorithms algorithm);
+
+/**
+ * Sets the period of the global scan
+ *
+ * @param period - ms, 0 scans only at the start and on a change
+ */
+void MPPT_SetScanPeriod(uint32_t period);
+
+/**
+ * Returns the tracking statistics
+ *
+ * @return - Pointer to constant statistics
+ */
+const MPPT_Statistics * MPPT_GetStatistics(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* MPPT_H */
@@ -8,12 +8,14 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Measurement.h"
 #include "Ammeter.h"
 #include "Voltmeter.h"
 #include "Configuration.h"
 #include "Communication.h"
+#include "EventBus.h"
+#include "Latency.h"
 
 /* </Includes> */ 
  
@@ -23,7 +25,8 @@
 static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
 static const TSCADCULong * voltage;
 static const TSCADCULong * current;
-static uint8_t voltageCounter, currentCounter, voltageErrorCounter, currentErrorCounter;
+static EventBus_Subscription voltageSubscription, currentSubscription; /* New voltage from voltmeter, new current from ammeter */
+static uint8_t voltageErrorCounter, currentErrorCounter;
 static Measurement_Values measurementValues;
 static ErrorMessaging_Error MeasurementError;
 static uint8_t commandCounter;
@@ -54,8 +57,8 @@ void Measurement_Init(void)
 {
   voltage = Voltmeter_GetVoltage();
   current = Ammeter_GetCurrent();
-  voltageCounter = 0;
-  currentCounter = 0;
+  EventBus_Subscribe(&voltageSubscription, Event_Voltmeter);
+  EventBus_Subscribe(&currentSubscription, Event_Ammeter);
   measurementValues.counter = 0;
   measurementValues.milliseconds = 0;
   measurementValues.voltage = 0;
@@ -106,10 +109,10 @@ void Measurement_Do(void)
     commandCounter = writeCommand->commandCounter;
   }
 
-  if ((voltageCounter != voltage->counter) && (currentCounter != current->counter)) /* Calculate values when both voltage and current are updated */
+  if (Measurement_DataReady()) /* Calculate values when both voltage and current are updated */
   {       
-    voltageCounter = voltage->counter;
-    currentCounter = current->counter;
+    EventBus_Take(&voltageSubscription);
+    EventBus_Take(&currentSubscription);
     
     if (invalidated)
     {
@@ -160,13 +163,16 @@ void Measurement_Do(void)
       }
       measurementValues.unfilteredResistance = (uint32_t)unfilteredResistance;             
       measurementValues.counter++;
-      measurementValues.milliseconds = millis();
+      measurementValues.milliseconds = HAL_Milliseconds();
+      EventBus_Publish(Event_Measurement);
+      #ifdef LATENCY_ENABLED
+        Latency_Probe(Probe_MeasurementPublished);
+      #endif
         
       if ((currentErrorCounter != AmmeterError->errorCounter) || (voltageErrorCounter != VoltmeterError->errorCounter))
       {
         /* Measurement invalid */
-        MeasurementError.error = ErrorMessaging_Measurement_Invalid;
-        MeasurementError.errorCounter++;
+        ErrorMessaging_Raise(&MeasurementError, ErrorMessaging_Measurement_Invalid);
         currentErrorCounter = AmmeterError->errorCounter;
         voltageErrorCounter = VoltmeterError->errorCounter;
       }
@@ -174,6 +180,11 @@ void Measurement_Do(void)
   }
 }
 
+bool Measurement_DataReady(void)
+{
+  return EventBus_Pending(&voltageSubscription) && EventBus_Pending(&currentSubscription);
+}
+
 const Measurement_Values * Measurement_GetValues(void)
 {
   return &measurementValues;
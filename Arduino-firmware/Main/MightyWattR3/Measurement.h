@@ -91,6 +91,14 @@ void Measurement_Init(void);
  */
 void Measurement_Do(void);
 
+/**
+ * Returns whether both new voltage and new current are waiting to be processed
+ * Used as data-ready trigger by the scheduler
+ *
+ * @return - true if both voltage and current were updated
+ */
+bool Measurement_DataReady(void);
+
 /**
  * Gets a pointer to the structure containing voltage, current, power and resistance
  *
@@ -8,6 +8,7 @@
 
 /* <Includes> */ 
 
+#include "HAL.h"
 #include "Configuration.h"
 #include "Communication.h"
 #include "ADC.h"
@@ -24,19 +25,73 @@
 #include "CurrentSetter.h"
 #include "Thermometer.h"
 #include "Control.h"
+#include "AutoTune.h"
+#include "MPPT.h"
+#include "Sweep.h"
+#include "Sequencer.h"
+#include "Dynamic.h"
+#include "Waveform.h"
+#include "Discharge.h"
+#include "LoadLine.h"
 #include "Measurement.h"
 #include "Limiter.h"
 #include "ErrorMessaging.h"
 #include "CommunicationWatchdog.h"
 #include "RangeSwitcher.h"
+#include "Scheduler.h"
+#include "EventBus.h"
+#include "Latency.h"
+#include "RingBuffer.h"
+#include "History.h"
 
 /* </Includes> */ 
 
 
+/* <Defines> */ 
+
+#define MIGHTYWATT_TASK_COUNT      (sizeof(Tasks) / sizeof(Scheduler_Task))
+
+/* </Defines> */ 
+
+
+/* <Module variables> */ 
+
+/**
+ * Task table in the order of execution
+ * Safety and acquisition tasks are critical and run on every pass, housekeeping tasks run at low rates
+ * Columns: function, data-ready trigger, period (ms), priority, budget (us)
+ */
+static const Scheduler_Task Tasks[] = 
+{
+  {&Communication_Do,          NULL,                    SCHEDULER_EVERY_PASS, SCHEDULER_PRIORITY_CRITICAL, 2000},
+  {&ADC_Do,                    NULL,                    SCHEDULER_EVERY_PASS, SCHEDULER_PRIORITY_CRITICAL, 1500},
+  {&Voltmeter_Do,              &Voltmeter_DataReady,    0,                    SCHEDULER_PRIORITY_CRITICAL, 500},
+  {&Ammeter_Do,                &Ammeter_DataReady,      0,                    SCHEDULER_PRIORITY_CRITICAL, 500},
+  {&Thermometer_Do,            &Thermometer_DataReady,  0,                    SCHEDULER_PRIORITY_CRITICAL, 1000},
+  {&Measurement_Do,            &Measurement_DataReady,  0,                    SCHEDULER_PRIORITY_CRITICAL, 1000},
+  {&RangeSwitcher_Do,          NULL,                    SCHEDULER_EVERY_PASS, SCHEDULER_PRIORITY_CRITICAL, 100},
+  {&Control_Do,                NULL,                    SCHEDULER_EVERY_PASS, SCHEDULER_PRIORITY_CRITICAL, 1500},
+  {&LEDController_Do,          NULL,                    20,                   2,                           300},
+  {&PinController_Do,          NULL,                    10,                   1,                           200},
+  {&FanController_Do,          NULL,                    100,                  3,                           200},
+  {&Limiter_Do,                NULL,                    SCHEDULER_EVERY_PASS, SCHEDULER_PRIORITY_CRITICAL, 500},
+  {&History_Do,                &History_DataReady,      0,                    SCHEDULER_PRIORITY_CRITICAL, 200},
+  {&CommunicationWatchdog_Do,  NULL,                    SCHEDULER_EVERY_PASS, SCHEDULER_PRIORITY_CRITICAL, 100}
+};
+static Scheduler_TaskState TaskStates[MIGHTYWATT_TASK_COUNT]; /* Run-time states of the tasks, in the order of the task table */
+
+/* </Module variables> */ 
+
+
 /* <Implementations> */ 
 
 void MightyWatt_Init(void)
 {
+  EventBus_Init();
+  #ifdef LATENCY_ENABLED
+    Latency_Init();
+  #endif
+  RingBuffer_Init();
   Communication_Init();
   ADC_Init();
   DACC_Init();
@@ -51,29 +106,43 @@ void MightyWatt_Init(void)
   Thermometer_Init();
   Measurement_Init();
   Control_Init();
+  #ifdef AUTOTUNE_ENABLED
+    AutoTune_Init();
+  #endif
+  #ifdef MPPT_ENABLED
+    MPPT_Init();
+  #endif
+  #ifdef SWEEP_ENABLED
+    Sweep_Init();
+  #endif
+  #ifdef SEQUENCER_ENABLED
+    Sequencer_Init();
+  #endif
+  #ifdef DYNAMIC_ENABLED
+    Dynamic_Init();
+  #endif
+  #ifdef WAVEFORM_ENABLED
+    Waveform_Init();
+  #endif
+  #ifdef DISCHARGE_ENABLED
+    Discharge_Init();
+  #endif
+  #ifdef LOADLINE_ENABLED
+    LoadLine_Init();
+  #endif
   LEDController_Init();
   PinController_Init();
   FanController_Init();
   Limiter_Init();
   ErrorMessaging_Init();
   CommunicationWatchdog_Init();
+  History_Init();
+  Scheduler_Init(Tasks, TaskStates, MIGHTYWATT_TASK_COUNT);
 }
 
 void MightyWatt_Do(void)
 {
-  Communication_Do();
-  ADC_Do();
-  Voltmeter_Do();
-  Ammeter_Do();  
-  Thermometer_Do();
-  Measurement_Do();
-  RangeSwitcher_Do();
-  Control_Do();
-  LEDController_Do();
-  PinController_Do();
-  FanController_Do();
-  Limiter_Do();  
-  CommunicationWatchdog_Do();
+  Scheduler_Do();
 }
   
 /* </Implementations> */
@@ -23,10 +23,16 @@
 #define NAME                       "MightyWatt R3"
 #define FIRMWARE_VERSION           "3.1.5"
 
+#ifdef NATIVE
+  /* Host build: the board selected in Configuration.h is replaced by the native back end of the HAL */
+  #undef UNO
+  #undef ZERO
+#endif
+
 #ifdef UNO
   #include <avr/pgmspace.h>
   #define FLASHMEMORY PROGMEM
-#elif defined(ZERO)
+#elif defined(ZERO) || defined(NATIVE)
   #define FLASHMEMORY 
 #endif
 
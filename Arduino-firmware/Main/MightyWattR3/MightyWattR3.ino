@@ -6,59 +6,22 @@
 #include "MightyWatt.h"
 #include <math.h>
 #include <Wire.h>
+#include "HAL.h"
 
 
-#define CYCLE_COUNTER_ENABLE       false
-
-#if (CYCLE_COUNTER_ENABLE == true)
-#include "Configuration.h"
-#include "Measurement.h"
-const static Measurement_Values * measurementValues;
-static uint8_t measurementValues_Counter = 0;
-#endif
-
 void setup() 
 {  
   delay(20); /* delay to give the hardware some time to stabilize */  
-  Wire.begin();   
+  HAL_I2CInit();
   Watchdog_Init(); /* system watchdog */
   MightyWatt_Init();
   delay(10); /* delay after init to give the hardware some time to stabilize */  
-
-  #if (CYCLE_COUNTER_ENABLE == true)
-    measurementValues = Measurement_GetValues();
-  #endif
 }
 
 void loop() 
 { 
   Watchdog_Reset(); /* system watchdog reset */    
   MightyWatt_Do();
-
-  #if (CYCLE_COUNTER_ENABLE == true)
-    static uint32_t measurementCycleCounter = 0;
-    static uint32_t loopCycleCounter = 0;
-    static uint32_t lastUpdate = 0;
-    uint32_t now = millis();
-    static bool toggle = false;
-  
-    if ((now - lastUpdate) > 10000)
-    {         
-      SerialPort.print("Meas/s: ");
-      SerialPort.print((measurementCycleCounter * 1000UL) / (now - lastUpdate));
-      SerialPort.print("\tMain loop/s: ");
-      SerialPort.println((loopCycleCounter * 1000UL) / (now - lastUpdate));
-      measurementCycleCounter = 0;
-      loopCycleCounter = 0;
-      lastUpdate = now;     
-    }
-    if (measurementValues_Counter != measurementValues->counter)
-    {
-      measurementCycleCounter++;  
-      measurementValues_Counter = measurementValues->counter;
-    }    
-    loopCycleCounter++;
-  #endif
 }
 
 static void Watchdog_Init(void)
@@ -0,0 +1,103 @@
+/**
+ * PIController.cpp
+ * Generic fixed-point discrete PI(D) controller with anti-windup
+ *
+ * 2018-02-26
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "PIController.h"
+
+/* </Includes> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Multiplies a relative value by a gain and a scale
+ *
+ * @param value - relative value in Q16
+ * @param gain - gain in Q16
+ * @param scale - actuator units that correspond to 100 %
+ *
+ * @return - Product in actuator units
+ */
+static int64_t PIController_Multiply(int32_t value, uint32_t gain, uint32_t scale);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void PIController_Reset(PIController_State * state, uint32_t output)
+{
+  state->integral = (int32_t)output;
+  state->lastError = 0;
+}
+
+uint32_t PIController_Update(PIController_State * state, const PIController_Gains * gains, int32_t error, uint32_t scale, uint32_t maximum)
+{
+  int64_t integral, output;
+
+  if (error > PICONTROLLER_ONE)
+  {
+    error = PICONTROLLER_ONE;
+  }
+  else if (error < -PICONTROLLER_ONE)
+  {
+    error = -PICONTROLLER_ONE;
+  }
+
+  /* Integral part, clamped to the output range so that it does not wind up while the actuator is saturated */
+  integral = state->integral + PIController_Multiply(error, gains->integral, scale);
+  if (integral < 0)
+  {
+    integral = 0;
+  }
+  else if (integral > (int64_t)maximum)
+  {
+    integral = maximum;
+  }
+  state->integral = (int32_t)integral;
+
+  output = integral + PIController_Multiply(error, gains->proportional, scale) + PIController_Multiply(error - state->lastError, gains->derivative, scale);
+  state->lastError = error;
+
+  if (output < 0)
+  {
+    return 0;
+  }
+  else if (output > (int64_t)maximum)
+  {
+    return maximum;
+  }
+  return (uint32_t)output;
+}
+
+int32_t PIController_RelativeError(uint32_t setValue, uint32_t presentValue)
+{
+  int64_t error;
+
+  if (setValue == 0)
+  {
+    return (presentValue > 0) ? -PICONTROLLER_ONE : 0;
+  }
+  error = ((((int64_t)setValue) - ((int64_t)presentValue)) * PICONTROLLER_ONE) / setValue;
+  if (error < -PICONTROLLER_ONE)
+  {
+    return -PICONTROLLER_ONE;
+  }
+  return (int32_t)error; /* At most +100 % for a non-negative present value */
+}
+
+static int64_t PIController_Multiply(int32_t value, uint32_t gain, uint32_t scale)
+{
+  /* |value| <= 2^17 and scale < 2^26, the intermediate product stays far below 2^63 for any 32-bit gain */
+  return ((((int64_t)value) * scale) >> 16) * gain >> 16;
+}
+
+/* </Implementations> */
@@ -0,0 +1,92 @@
+/**
+ * PIController.h
+ * Generic fixed-point discrete PI(D) controller with anti-windup
+ *
+ * 2018-02-26
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The error is relative to the set value (Q16, 65536 = 100 %) and is converted to the units of the actuator
+ * (uA for the current setter, uV for the voltage setter) by a scale supplied on every update. With the scale
+ * equal to the present operating point of the actuator the loop gain does not depend on the operating point:
+ * a gain of 1 removes the whole error in one sample for a process value proportional to the actuator.
+ */
+
+#ifndef PICONTROLLER_H
+#define PICONTROLLER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define PICONTROLLER_ONE                    65536L /* Gains and relative errors are in Q16 */
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * Gains in Q16 (65536 = 1) per processed sample
+ */
+struct PIController_Gains
+{
+  uint32_t proportional;
+  uint32_t integral;
+  uint32_t derivative; /* Zero for a PI controller */
+};
+
+/**
+ * State of one controller
+ */
+struct PIController_State
+{
+  int32_t integral; /* Integral part of the output in actuator units, kept within 0 and the maximum output */
+  int32_t lastError; /* Relative error of the previous sample for the derivative part */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Prepares the controller for a bumpless start, the output equals the initial value until an error appears
+ *
+ * @param state - pointer to the controller state
+ * @param output - present actuator value in actuator units
+ */
+void PIController_Reset(PIController_State * state, uint32_t output);
+
+/**
+ * Processes one sample and returns the new actuator value
+ * The integral part is stopped at the limits of the output (anti-windup)
+ *
+ * @param state - pointer to the controller state
+ * @param gains - pointer to the gains
+ * @param error - relative error in Q16, positive increases the output, limited to +-100 %
+ * @param scale - actuator units that correspond to 100 % relative error
+ * @param maximum - largest output in actuator units
+ *
+ * @return - New actuator value, between 0 and maximum
+ */
+uint32_t PIController_Update(PIController_State * state, const PIController_Gains * gains, int32_t error, uint32_t scale, uint32_t maximum);
+
+/**
+ * Computes the relative error of a process value
+ *
+ * @param setValue - target value
+ * @param presentValue - measured value
+ *
+ * @return - (setValue - presentValue) / setValue in Q16, limited to +-100 %
+ */
+int32_t PIController_RelativeError(uint32_t setValue, uint32_t presentValue);
+
+/* </Declarations (prototypes)> */
+
+#endif /* PICONTROLLER_H */
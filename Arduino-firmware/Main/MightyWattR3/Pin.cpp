@@ -10,8 +10,9 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Pin.h"
+#include "FastPin.h"
 
 /* </Includes> */ 
 
@@ -19,7 +20,7 @@
 /* <Module variables> */ 
 
 // Mapping of logical pins to physical pins on Arduino
-static const uint8_t pinMapping[] = {2, 6, 7, 10, 13};
+static const uint8_t pinMapping[] = {PIN_MAPPING_0, PIN_MAPPING_1, PIN_MAPPING_2, PIN_MAPPING_3, PIN_MAPPING_4};
 
 // Complete status of the pins
 static uint8_t statusWord = 0;
@@ -34,25 +35,20 @@ void Pin_Init(void)
   statusWord = 0;
   for (uint8_t i = 0; i < sizeof(pinMapping) / sizeof(uint8_t); i++)
   {
-    pinMode(pinMapping[i], OUTPUT);
-    digitalWrite(pinMapping[i], LOW);
+    HAL_PinMode(pinMapping[i], HAL_Output);
+    HAL_DigitalWrite(pinMapping[i], false);
   }
 }
 
 void Pin_Set(uint8_t pinWord)
 {
   statusWord = pinWord & ((1 << (sizeof(pinMapping) / sizeof(uint8_t))) - 1);
-  for (uint8_t i = 0; i < sizeof(pinMapping) / sizeof(uint8_t); i++)
-  {
-    if (((1 << i) & statusWord) > 0)
-    {
-      digitalWrite(pinMapping[i], HIGH);
-    }
-    else
-    {
-      digitalWrite(pinMapping[i], LOW);
-    }    
-  }
+  /* Unrolled so that each physical pin is resolved to a port register at compile time */
+  FastPin<PIN_MAPPING_0>::Write((statusWord & (1 << 0)) > 0);
+  FastPin<PIN_MAPPING_1>::Write((statusWord & (1 << 1)) > 0);
+  FastPin<PIN_MAPPING_2>::Write((statusWord & (1 << 2)) > 0);
+  FastPin<PIN_MAPPING_3>::Write((statusWord & (1 << 3)) > 0);
+  FastPin<PIN_MAPPING_4>::Write((statusWord & (1 << 4)) > 0);
 }
 
 uint8_t Pin_Get(void)
@@ -17,6 +17,18 @@
 /* </Includes> */ 
 
 
+/* <Defines> */ 
+
+/* Mapping of logical pins to physical pins on Arduino */
+#define PIN_MAPPING_0              2
+#define PIN_MAPPING_1              6
+#define PIN_MAPPING_2              7
+#define PIN_MAPPING_3              10
+#define PIN_MAPPING_4              13
+
+/* </Defines> */ 
+
+
 /* <Declarations (prototypes)> */ 
 
 /**
@@ -8,7 +8,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Pin.h"
 #include "Communication.h"
 #include "PinController.h"
@@ -48,16 +48,7 @@ void PinController_Do(void)
     switch (writeCommand->command)
     {
       case WriteCommand_Pins:
-        if (PINCONTROLLER_ISSET((writeCommand->data)[0]))
-        {
-          // set pins
-          Pin_Set(PinController_GetPins() | (writeCommand->data)[0] & 0x7F);
-        }
-        else
-        {
-          // reset pins
-          Pin_Set(PinController_GetPins() & ~((writeCommand->data)[0]) & 0x7F);
-        }
+        PinController_Apply((writeCommand->data)[0]);
       break;
       default:
       /* command handled by other modules */
@@ -72,5 +63,19 @@ uint8_t PinController_GetPins(void)
   return Pin_Get();
 }
 
+void PinController_Apply(uint8_t pinWord)
+{
+  if (PINCONTROLLER_ISSET(pinWord))
+  {
+    // set pins
+    Pin_Set(PinController_GetPins() | (pinWord & 0x7F));
+  }
+  else
+  {
+    // reset pins
+    Pin_Set(PinController_GetPins() & ~pinWord & 0x7F);
+  }
+}
+
 /* </Implementations> */ 
 
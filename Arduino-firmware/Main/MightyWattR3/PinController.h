@@ -36,6 +36,13 @@ void PinController_Do(void);
  */
 uint8_t PinController_GetPins(void);
 
+/**
+ * Sets or resets pins as WriteCommand_Pins does
+ *
+ * @param pinWord - bit 7: set (1) or reset (0), bits 0-6: logical pins to change
+ */
+void PinController_Apply(uint8_t pinWord);
+
 /* </Declarations (prototypes)> */ 
 
 #endif /* PINCONTROLLER_H */
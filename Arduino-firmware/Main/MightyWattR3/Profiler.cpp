@@ -0,0 +1,61 @@
+/**
+ * Profiler.cpp
+ * Execution-time statistics of the module "Do" functions
+ *
+ * 2018-02-16
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "Profiler.h"
+
+/* </Includes> */
+
+
+/* <Implementations> */
+
+void Profiler_Reset(Profiler_Entry * entry)
+{
+  entry->callCount = 0;
+  entry->totalTime = 0;
+  for (uint8_t i = 0; i < PROFILER_HISTOGRAM_BINS; i++)
+  {
+    entry->histogram[i] = 0;
+  }
+}
+
+void Profiler_Record(Profiler_Entry * entry, uint32_t executionTime)
+{
+  uint8_t i;
+
+  /* Mean time is totalTime / callCount, both stop when the sum is full (after about 71 minutes of execution time) */
+  if (entry->totalTime + executionTime >= entry->totalTime)
+  {
+    entry->totalTime += executionTime;
+    entry->callCount++;
+  }
+
+  /* Find the bin: position of the highest set bit above the first bin */
+  uint8_t bin = 0;
+  executionTime >>= PROFILER_HISTOGRAM_FIRST_BIN_BITS;
+  while ((executionTime > 0) && (bin < (PROFILER_HISTOGRAM_BINS - 1)))
+  {
+    executionTime >>= 1;
+    bin++;
+  }
+
+  if (entry->histogram[bin] == 0xFFFF)
+  {
+    /* Keep the shape of the distribution instead of saturating one bin */
+    for (i = 0; i < PROFILER_HISTOGRAM_BINS; i++)
+    {
+      entry->histogram[i] >>= 1;
+    }
+  }
+  entry->histogram[bin]++;
+}
+
+/* </Implementations> */
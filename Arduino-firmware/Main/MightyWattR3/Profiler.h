@@ -0,0 +1,65 @@
+/**
+ * Profiler.h
+ * Execution-time statistics of the module "Do" functions
+ *
+ * 2018-02-16
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define PROFILER_ENABLED                 /* Per-task statistics of the scheduler, UNO has no RAM for 24 bytes per task */
+#endif
+#define PROFILER_HISTOGRAM_BINS            8 /* Number of log2 histogram bins */
+#define PROFILER_HISTOGRAM_FIRST_BIN_BITS  4 /* The first bin holds times below 2^4 = 16 us, each next bin doubles, the last bin is open-ended (1024 us and more) */
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * Execution-time statistics of one function
+ */
+struct Profiler_Entry
+{
+  uint32_t callCount; /* Number of recorded calls, stops together with totalTime when totalTime would overflow */
+  uint32_t totalTime; /* Cumulative execution time in us */
+  uint16_t histogram[PROFILER_HISTOGRAM_BINS]; /* Number of calls per log2 execution-time bin, all bins are halved when one would overflow */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Clears the statistics
+ *
+ * @param entry - pointer to the statistics
+ */
+void Profiler_Reset(Profiler_Entry * entry);
+
+/**
+ * Adds one execution to the statistics
+ *
+ * @param entry - pointer to the statistics
+ * @param executionTime - execution time in us
+ */
+void Profiler_Record(Profiler_Entry * entry, uint32_t executionTime);
+
+/* </Declarations (prototypes)> */
+
+#endif /* PROFILER_H */
@@ -10,9 +10,11 @@
  
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "RangeSwitcher.h"
+#include "FastPin.h"
 #include "Communication.h"
+#include "ADC.h"
 //#include "Measurement.h"
 //#include "CurrentSetter.h"
 //#include "VoltageSetter.h"
@@ -35,8 +37,8 @@ static uint8_t commandCounter; /* Number of the last executed command from commu
 
 void RangeSwitcher_Init(void)
 {
-  pinMode(CURRENT_GAIN_PIN, OUTPUT);
-  pinMode(VOLTAGE_GAIN_PIN, OUTPUT);
+  HAL_PinMode(CURRENT_GAIN_PIN, HAL_Output);
+  HAL_PinMode(VOLTAGE_GAIN_PIN, HAL_Output);
   RangeSwitcher_SetCurrentRange(CURRENT_DEFAULT_HARDWARE_RANGE);
   RangeSwitcher_SetVoltageRange(VOLTAGE_DEFAULT_HARDWARE_RANGE);
   currentRangeAuto = true;
@@ -69,36 +71,50 @@ void RangeSwitcher_Do(void)
 
 void RangeSwitcher_SetCurrentRange(RangeSwitcher_CurrentRanges range)
 {  
+  bool changed = (range != currentRange);
   currentRange = range;
   
   switch (currentRange)
   {
     case CurrentRange_LowCurrent:
-      digitalWrite(CURRENT_GAIN_PIN, HIGH);
+      FastPin<CURRENT_GAIN_PIN>::Set();
     break;
     case CurrentRange_HighCurrent:
-      digitalWrite(CURRENT_GAIN_PIN, LOW);
+      FastPin<CURRENT_GAIN_PIN>::Clear();
     break;
     default:
     break;
   }
+
+  /* The gain of the ammeter changes with the pin, only the current conversion across the change is dropped */
+  if (changed)
+  {
+    ADC_Blank(ADC_I);
+  }
 }
 
 void RangeSwitcher_SetVoltageRange(RangeSwitcher_VoltageRanges range)
 {  
+  bool changed = (range != voltageRange);
   voltageRange = range;
 
   switch (voltageRange)
   {
     case VoltageRange_LowVoltage:
-      digitalWrite(VOLTAGE_GAIN_PIN, HIGH);
+      FastPin<VOLTAGE_GAIN_PIN>::Set();
     break;
     case VoltageRange_HighVoltage:
-      digitalWrite(VOLTAGE_GAIN_PIN, LOW);
+      FastPin<VOLTAGE_GAIN_PIN>::Clear();
     break;
     default:
     break;
   }
+
+  /* The gain of the voltmeter changes with the pin, only the voltage conversion across the change is dropped */
+  if (changed)
+  {
+    ADC_Blank(ADC_V);
+  }
 }
 
 RangeSwitcher_CurrentRanges RangeSwitcher_GetCurrentRange(void)
@@ -65,6 +65,7 @@ void RangeSwitcher_Do(void);
 
 /**
  * Sets requested current range
+ * A change of the range blanks the current conversion in progress
  * 
  * @param range - Current range to set
  */
@@ -72,6 +73,7 @@ void RangeSwitcher_SetCurrentRange(RangeSwitcher_CurrentRanges range);
 
 /**
  * Sets requested voltage range
+ * A change of the range blanks the voltage conversion in progress
  * 
  * @param range - Voltage range to set
  */
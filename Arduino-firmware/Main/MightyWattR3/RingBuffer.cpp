@@ -0,0 +1,133 @@
+/**
+ * RingBuffer.cpp
+ * Shared RAM buffer of fixed-size records for sample history and capture
+ *
+ * 2018-02-20
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "RingBuffer.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static uint8_t buffer[RINGBUFFER_SIZE];
+static RingBuffer_Owners owner;
+static uint8_t recordSize;
+static uint16_t capacity; /* Records */
+static uint16_t head; /* Index of the oldest record */
+static uint16_t count; /* Number of stored records */
+
+/* </Module variables> */
+
+
+/* <Implementations> */
+
+void RingBuffer_Init(void)
+{
+  owner = RingBuffer_Free;
+  recordSize = 1;
+  capacity = 0;
+  RingBuffer_Clear();
+}
+
+bool RingBuffer_Acquire(RingBuffer_Owners newOwner, uint8_t newRecordSize)
+{
+  if (((owner != RingBuffer_Free) && (owner != newOwner)) || (newRecordSize == 0))
+  {
+    return false;
+  }
+  owner = newOwner;
+  recordSize = newRecordSize;
+  capacity = RINGBUFFER_SIZE / newRecordSize;
+  RingBuffer_Clear();
+  return true;
+}
+
+void RingBuffer_Release(RingBuffer_Owners oldOwner)
+{
+  if (owner == oldOwner)
+  {
+    owner = RingBuffer_Free;
+    capacity = 0;
+    RingBuffer_Clear();
+  }
+}
+
+RingBuffer_Owners RingBuffer_GetOwner(void)
+{
+  return owner;
+}
+
+uint8_t RingBuffer_GetRecordSize(void)
+{
+  return recordSize;
+}
+
+uint16_t RingBuffer_GetCapacity(void)
+{
+  return capacity;
+}
+
+uint16_t RingBuffer_GetCount(void)
+{
+  return count;
+}
+
+void RingBuffer_Clear(void)
+{
+  head = 0;
+  count = 0;
+}
+
+void RingBuffer_Push(const void * record)
+{
+  if (capacity == 0)
+  {
+    return;
+  }
+
+  uint16_t index = head + count;
+  if (index >= capacity)
+  {
+    index -= capacity;
+  }
+  memcpy(&buffer[index * recordSize], record, recordSize);
+
+  if (count < capacity)
+  {
+    count++;
+  }
+  else
+  {
+    /* Full, the oldest record has been overwritten */
+    head++;
+    if (head >= capacity)
+    {
+      head = 0;
+    }
+  }
+}
+
+uint8_t * RingBuffer_Get(uint16_t index)
+{
+  if (index >= count)
+  {
+    return NULL;
+  }
+  index += head;
+  if (index >= capacity)
+  {
+    index -= capacity;
+  }
+  return &buffer[index * recordSize];
+}
+
+/* </Implementations> */
@@ -0,0 +1,124 @@
+/**
+ * RingBuffer.h
+ * Shared RAM buffer of fixed-size records for sample history and capture
+ *
+ * 2018-02-20
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#ifdef UNO
+  #define RINGBUFFER_SIZE                  160 /* Bytes, taken from the RAM reclaimed from the ADC filters, text buffers and error counters */
+#elif defined(ZERO) || defined(NATIVE)
+  #define RINGBUFFER_SIZE                  4096 /* Bytes */
+#endif
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Users of the buffer, only one can own it at a time
+ */
+enum RingBuffer_Owners : uint8_t
+{
+  RingBuffer_Free, /* Nobody uses the buffer */
+  RingBuffer_History, /* History of measurement values */
+  RingBuffer_Sweep, /* Points of the last I-V sweep */
+  RingBuffer_Sequencer, /* Steps of the program */
+  RingBuffer_Waveform, /* Points of the waveform table and the measured waveform */
+  RingBuffer_LoadLine /* Points of the load-line table */
+};
+
+/* </Enums> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the buffer as free
+ */
+void RingBuffer_Init(void);
+
+/**
+ * Takes the buffer for a user and clears it
+ *
+ * @param owner - new owner
+ * @param recordSize - size of one record in bytes
+ *
+ * @return - true if the buffer was free or already owned by the same owner
+ */
+bool RingBuffer_Acquire(RingBuffer_Owners owner, uint8_t recordSize);
+
+/**
+ * Frees the buffer if it is owned by the owner
+ *
+ * @param owner - owner that releases the buffer
+ */
+void RingBuffer_Release(RingBuffer_Owners owner);
+
+/**
+ * Gets the present owner
+ *
+ * @return - owner of the buffer
+ */
+RingBuffer_Owners RingBuffer_GetOwner(void);
+
+/**
+ * Gets the size of one record
+ *
+ * @return - record size in bytes
+ */
+uint8_t RingBuffer_GetRecordSize(void);
+
+/**
+ * Gets the maximum number of records
+ *
+ * @return - capacity in records
+ */
+uint16_t RingBuffer_GetCapacity(void);
+
+/**
+ * Gets the number of stored records
+ *
+ * @return - number of records
+ */
+uint16_t RingBuffer_GetCount(void);
+
+/**
+ * Removes all records
+ */
+void RingBuffer_Clear(void);
+
+/**
+ * Adds a record, the oldest record is overwritten when the buffer is full
+ *
+ * @param record - pointer to the record of the size given at acquisition
+ */
+void RingBuffer_Push(const void * record);
+
+/**
+ * Gets a stored record
+ *
+ * @param index - index of the record, 0 is the oldest one
+ *
+ * @return - pointer to the record, NULL if the index is out of range
+ */
+uint8_t * RingBuffer_Get(uint16_t index);
+
+/* </Declarations (prototypes)> */
+
+#endif /* RINGBUFFER_H */
@@ -0,0 +1,214 @@
+/**
+ * Scheduler.cpp
+ * Time-triggered cooperative scheduler for the module "Do" functions
+ *
+ * 2018-02-12
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "Scheduler.h"
+#include "Communication.h"
+#include "Latency.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static const Scheduler_Task * taskTable; /* Pointer to the task table */
+static Scheduler_TaskState * taskStates; /* Pointer to the run-time states of the tasks */
+static uint8_t taskTableCount; /* Number of tasks in the task table */
+static uint32_t worstPassTime; /* Longest pass in us */
+static uint32_t passCount; /* Number of passes since the last reset of the profiler */
+static uint32_t profilerResetMilliseconds; /* Time of the last reset of the profiler */
+static const Communication_WriteCommand * writeCommand; /* Pointer to the write command where new data from communication can be found */
+static uint8_t commandCounter; /* Number of the last command that all tasks have seen */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Returns whether the task should run in this pass, not considering the one-per-pass rule for non-critical tasks
+ *
+ * @param task - pointer to the task
+ * @param state - pointer to the run-time state of the task
+ * @param now - present time in ms (lower 16 bits)
+ *
+ * @return - true if the task is due
+ */
+static bool Scheduler_IsDue(const Scheduler_Task * task, const Scheduler_TaskState * state, uint16_t now);
+
+/**
+ * Clears the run-time statistics selected by the flags
+ *
+ * @param flags - SCHEDULER_RESET_PROFILER, SCHEDULER_RESET_OVERRUNS and/or LATENCY_RESET
+ */
+static void Scheduler_ResetStatistics(uint8_t flags);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Scheduler_Init(const Scheduler_Task * tasks, Scheduler_TaskState * states, uint8_t taskCount)
+{
+  taskTable = tasks;
+  taskStates = states;
+  taskTableCount = taskCount;
+  writeCommand = Communication_GetWriteCommand();
+  commandCounter = writeCommand->commandCounter;
+
+  uint16_t now = (uint16_t)HAL_Milliseconds();
+  for (uint8_t i = 0; i < taskTableCount; i++)
+  {
+    taskStates[i].lastRun = now;
+  }
+  Scheduler_ResetStatistics(SCHEDULER_RESET_PROFILER | SCHEDULER_RESET_OVERRUNS);
+}
+
+void Scheduler_Do(void)
+{
+  uint32_t passStart = HAL_Microseconds();
+  uint16_t now = (uint16_t)HAL_Milliseconds();
+  uint8_t selected = taskTableCount; /* Non-critical task selected for this pass, none by default */
+  uint8_t i;
+
+  /* Select the highest priority non-critical task that is due */
+  for (i = 0; i < taskTableCount; i++)
+  {
+    if ((taskTable[i].priority != SCHEDULER_PRIORITY_CRITICAL) && Scheduler_IsDue(&taskTable[i], &taskStates[i], now))
+    {
+      if ((selected == taskTableCount) || (taskTable[i].priority < taskTable[selected].priority))
+      {
+        selected = i;
+      }
+    }
+  }
+
+  /* The execution time of a task includes its own check in this loop, the check of a skipped task with a ready
+   * function is not charged to the next task; the pass time includes everything */
+  uint32_t taskStart = HAL_Microseconds();
+  for (i = 0; i < taskTableCount; i++)
+  {
+    const Scheduler_Task * task = &taskTable[i];
+    Scheduler_TaskState * state = &taskStates[i];
+
+    /* All tasks see a newly received command in the same pass, as without the scheduler, otherwise a task that is not due could miss a command */
+    if ((commandCounter != writeCommand->commandCounter) || ((task->priority == SCHEDULER_PRIORITY_CRITICAL) ? Scheduler_IsDue(task, state, now) : (i == selected)))
+    {
+      task->function();
+      state->lastRun = now;
+
+      uint32_t taskEnd = HAL_Microseconds();
+      uint32_t executionTime = taskEnd - taskStart;
+      #ifdef PROFILER_ENABLED
+        Profiler_Record(&state->profile, executionTime);
+      #endif
+      if (executionTime > 0xFFFF)
+      {
+        state->worstTime = 0xFFFF;
+      }
+      else if (executionTime > state->worstTime)
+      {
+        state->worstTime = (uint16_t)executionTime;
+      }
+      if ((executionTime > task->budget) && (state->overrunCounter < 0xFFFF))
+      {
+        state->overrunCounter++;
+      }
+      taskStart = taskEnd;
+    }
+    else if ((task->ready != NULL) && (task->priority == SCHEDULER_PRIORITY_CRITICAL))
+    {
+      taskStart = HAL_Microseconds();
+    }
+  }
+  if (taskStart - passStart > worstPassTime)
+  {
+    worstPassTime = taskStart - passStart;
+  }
+  passCount++;
+
+  if (commandCounter != writeCommand->commandCounter)
+  {
+    if (writeCommand->command == WriteCommand_ResetStatistics)
+    {
+      Scheduler_ResetStatistics(writeCommand->data[0]);
+    }
+    commandCounter = writeCommand->commandCounter;
+  }
+}
+
+static bool Scheduler_IsDue(const Scheduler_Task * task, const Scheduler_TaskState * state, uint16_t now)
+{
+  if (task->ready != NULL)
+  {
+    return task->ready();
+  }
+  return (task->period == SCHEDULER_EVERY_PASS) || ((uint16_t)(now - state->lastRun) >= task->period);
+}
+
+static void Scheduler_ResetStatistics(uint8_t flags)
+{
+  uint8_t i;
+  if (flags & SCHEDULER_RESET_PROFILER)
+  {
+    for (i = 0; i < taskTableCount; i++)
+    {
+      taskStates[i].worstTime = 0;
+      #ifdef PROFILER_ENABLED
+        Profiler_Reset(&taskStates[i].profile);
+      #endif
+    }
+    passCount = 0;
+    profilerResetMilliseconds = HAL_Milliseconds();
+  }
+  if (flags & SCHEDULER_RESET_OVERRUNS)
+  {
+    for (i = 0; i < taskTableCount; i++)
+    {
+      taskStates[i].overrunCounter = 0;
+    }
+    worstPassTime = 0;
+  }
+  #ifdef LATENCY_ENABLED
+    if (flags & LATENCY_RESET)
+    {
+      Latency_Reset();
+    }
+  #endif
+}
+
+const Scheduler_TaskState * Scheduler_GetTaskStates(void)
+{
+  return taskStates;
+}
+
+uint8_t Scheduler_GetTaskCount(void)
+{
+  return taskTableCount;
+}
+
+uint32_t Scheduler_GetWorstPassTime(void)
+{
+  return worstPassTime;
+}
+
+uint32_t Scheduler_GetPassCount(void)
+{
+  return passCount;
+}
+
+uint32_t Scheduler_GetProfilerTime(void)
+{
+  return HAL_Milliseconds() - profilerResetMilliseconds;
+}
+
+/* </Implementations> */
@@ -0,0 +1,116 @@
+/**
+ * Scheduler.h
+ * Time-triggered cooperative scheduler for the module "Do" functions
+ *
+ * 2018-02-12
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "Profiler.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define SCHEDULER_EVERY_PASS               0 /* Period of tasks that run on every pass */
+#define SCHEDULER_PRIORITY_CRITICAL        0 /* Critical tasks run whenever they are due, other tasks run at most one per pass */
+#define SCHEDULER_RESET_PROFILER           (1 << 0) /* Reset statistics command flag: execution-time statistics of the tasks */
+#define SCHEDULER_RESET_OVERRUNS           (1 << 1) /* Reset statistics command flag: overrun counters and the worst pass time */
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * Scheduled task configuration
+ */
+struct Scheduler_Task
+{
+  void (* function)(void); /* Task "Do" function */
+  bool (* ready)(void); /* Data-ready trigger, the task is due when it returns true; NULL for periodic tasks */
+  uint16_t period; /* Period in ms, SCHEDULER_EVERY_PASS for tasks that run on every pass; not used for data-ready tasks */
+  uint8_t priority; /* SCHEDULER_PRIORITY_CRITICAL or higher number for lower priority */
+  uint16_t budget; /* Allowed execution time in us, longer execution is counted as overrun */
+};
+
+/**
+ * Run-time state and statistics of a scheduled task
+ */
+struct Scheduler_TaskState
+{
+  uint16_t lastRun; /* Time of the last run in ms (lower 16 bits) */
+  uint16_t overrunCounter; /* Number of executions that exceeded the budget, saturates */
+  uint16_t worstTime; /* Longest execution time in us, saturates */
+  #ifdef PROFILER_ENABLED
+    Profiler_Entry profile; /* Execution-time statistics */
+  #endif
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the scheduler with a task table
+ * Tasks are executed in the order of the table, critical tasks first if they are due,
+ * and at most one non-critical task per pass (the highest priority one that is due)
+ *
+ * @param tasks - pointer to the task table
+ * @param states - pointer to the run-time states, one per task
+ * @param taskCount - number of tasks in the table
+ */
+void Scheduler_Init(const Scheduler_Task * tasks, Scheduler_TaskState * states, uint8_t taskCount);
+
+/**
+ * Executes one pass of the scheduler
+ */
+void Scheduler_Do(void);
+
+/**
+ * Gets the run-time states of the tasks, in the order of the task table
+ *
+ * @return - Pointer to constant task states
+ */
+const Scheduler_TaskState * Scheduler_GetTaskStates(void);
+
+/**
+ * Gets the number of tasks in the task table
+ *
+ * @return - Number of tasks
+ */
+uint8_t Scheduler_GetTaskCount(void);
+
+/**
+ * Gets the longest pass duration
+ *
+ * @return - Longest pass duration in us
+ */
+uint32_t Scheduler_GetWorstPassTime(void);
+
+/**
+ * Gets the number of passes since the last reset of the profiler
+ *
+ * @return - Number of passes
+ */
+uint32_t Scheduler_GetPassCount(void);
+
+/**
+ * Gets the time elapsed since the last reset of the profiler
+ *
+ * @return - Elapsed time in ms
+ */
+uint32_t Scheduler_GetProfilerTime(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,351 @@
+/**
+ * Sequencer.cpp
+ * List-mode program sequencer, runs programs uploaded by the host without the host in the loop
+ *
+ * 2018-03-02
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include <string.h>
+#include "HAL.h"
+#include "Sequencer.h"
+#include "Communication.h"
+#include "Control.h"
+#include "Measurement.h"
+#include "EventBus.h"
+#include "Thermometer.h"
+#include "PinController.h"
+#include "RingBuffer.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static Sequencer_State state;
+static Sequencer_Step step; /* Copy of the running step, the records of the buffer need not be aligned */
+static const Measurement_Values * measurementValues;
+static const TSCUChar * temperature;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+static uint32_t loopCount; /* Requested loops of the program */
+static uint32_t stepStart; /* ms, planned start of the running step */
+static uint32_t startValue; /* Set value at the start of the running step */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Starts the step at state.step, runs the steps that take no time before it and ends the program after its last loop
+ */
+static void Sequencer_Begin(void);
+
+/**
+ * Checks the condition of the running step on the latest measurement
+ *
+ * @return - true if the quantity crossed the threshold
+ */
+static bool Sequencer_IsCondition(void);
+
+/**
+ * Ends the program
+ *
+ * @param status - Sequencer_Done, Sequencer_Stopped or Sequencer_Aborted
+ */
+static void Sequencer_Finish(Sequencer_Status status);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Sequencer_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  temperature = Thermometer_GetTemperature();
+  state.status = Sequencer_Idle;
+  state.steps = 0;
+}
+
+void Sequencer_Do(void)
+{
+  if (state.status != Sequencer_Running)
+  {
+    return;
+  }
+
+  if ((step.type == SequencerStep_Pin) || (step.type == SequencerStep_Loop))
+  {
+    Sequencer_Begin(); /* The last pass ran its limit of steps that take no time */
+    return;
+  }
+
+  uint32_t now = HAL_Milliseconds();
+  bool skip = false;
+  if (EventBus_Take(&measurementSubscription))
+  {
+    if (Sequencer_IsCondition())
+    {
+      if ((step.comparison == SequencerComparison_StopBelow) || (step.comparison == SequencerComparison_StopAbove))
+      {
+        Sequencer_Finish(Sequencer_Stopped);
+        return;
+      }
+      skip = true;
+    }
+  }
+
+  if (skip)
+  {
+    stepStart = now; /* The next step runs for its full duration */
+    state.step++;
+    Sequencer_Begin();
+  }
+  else if (now - stepStart >= step.duration)
+  {
+    if (step.type == SequencerStep_Ramp)
+    {
+      Control_SetSetpoint((Communication_WriteCommands)step.mode, step.target);
+    }
+    stepStart += step.duration; /* Planned time, late passes do not shift the program */
+    state.step++;
+    Sequencer_Begin();
+  }
+  else if (step.type == SequencerStep_Ramp)
+  {
+    int64_t span = ((int64_t)step.target) - startValue;
+    Control_SetSetpoint((Communication_WriteCommands)step.mode, (uint32_t)(startValue + (span * (now - stepStart)) / step.duration));
+  }
+
+  if (state.status == Sequencer_Running)
+  {
+    state.stepTime = HAL_Milliseconds() - stepStart;
+  }
+}
+
+bool Sequencer_Clear(void)
+{
+  if (state.status == Sequencer_Running)
+  {
+    return false;
+  }
+
+  /* The history gives way to the program */
+  RingBuffer_Release(RingBuffer_History);
+  if (!RingBuffer_Acquire(RingBuffer_Sequencer, sizeof(Sequencer_Step)))
+  {
+    state.status = Sequencer_Invalid;
+    return false;
+  }
+  state.status = Sequencer_Idle;
+  state.steps = 0;
+  state.step = 0;
+  state.loops = 0;
+  state.stepTime = 0;
+  return true;
+}
+
+bool Sequencer_Add(const uint32_t * arguments, uint8_t count)
+{
+  bool valid = (count >= SequencerArgument_Count) && (RingBuffer_GetOwner() == RingBuffer_Sequencer) && (RingBuffer_GetCount() < RingBuffer_GetCapacity());
+
+  if (valid)
+  {
+    uint32_t mode = arguments[SequencerArgument_Mode];
+    switch (arguments[SequencerArgument_Type])
+    {
+      case SequencerStep_Constant:
+        valid = (mode >= WriteCommand_ConstantCurrent) && (mode <= WriteCommand_SimpleAmmeter);
+      break;
+      case SequencerStep_Ramp:
+        valid = (mode >= WriteCommand_ConstantCurrent) && (mode <= WriteCommand_ConstantVoltageSoftware);
+      break;
+      case SequencerStep_Pin:
+        valid = mode <= 0xFF;
+      break;
+      case SequencerStep_Loop:
+        valid = mode < RingBuffer_GetCount(); /* Only back to a step that exists */
+      break;
+      default:
+        valid = false;
+      break;
+    }
+    valid = valid && (arguments[SequencerArgument_Quantity] < SequencerQuantity_Count) && (arguments[SequencerArgument_Comparison] < SequencerComparison_Count);
+  }
+
+  if (!valid || (state.status == Sequencer_Running))
+  {
+    if (state.status != Sequencer_Running)
+    {
+      state.status = Sequencer_Invalid;
+    }
+    return false;
+  }
+
+  Sequencer_Step newStep;
+  newStep.type = (Sequencer_StepTypes)arguments[SequencerArgument_Type];
+  newStep.mode = (uint8_t)arguments[SequencerArgument_Mode];
+  newStep.quantity = (Sequencer_Quantities)arguments[SequencerArgument_Quantity];
+  newStep.comparison = (Sequencer_Comparisons)arguments[SequencerArgument_Comparison];
+  newStep.value = arguments[SequencerArgument_Value];
+  newStep.target = (newStep.type == SequencerStep_Loop) ? 0 : arguments[SequencerArgument_Target];
+  newStep.duration = arguments[SequencerArgument_Duration];
+  newStep.threshold = arguments[SequencerArgument_Threshold];
+  RingBuffer_Push(&newStep);
+  state.steps = RingBuffer_GetCount();
+  return true;
+}
+
+bool Sequencer_Start(uint32_t loops)
+{
+  if ((RingBuffer_GetOwner() != RingBuffer_Sequencer) || (RingBuffer_GetCount() == 0))
+  {
+    if (state.status != Sequencer_Running)
+    {
+      state.status = Sequencer_Invalid;
+    }
+    return false;
+  }
+
+  /* Loops of the previous run may have been left unfinished */
+  for (uint16_t i = 0; i < state.steps; i++)
+  {
+    memcpy(&step, RingBuffer_Get(i), sizeof(Sequencer_Step));
+    if (step.type == SequencerStep_Loop)
+    {
+      step.target = 0;
+      memcpy(RingBuffer_Get(i), &step, sizeof(Sequencer_Step));
+    }
+  }
+
+  loopCount = loops;
+  state.status = Sequencer_Running;
+  state.step = 0;
+  state.loops = 0;
+  state.stepTime = 0;
+  stepStart = HAL_Milliseconds();
+  Sequencer_Begin();
+  return true;
+}
+
+void Sequencer_Stop(void)
+{
+  if (state.status == Sequencer_Running)
+  {
+    Sequencer_Finish(Sequencer_Aborted);
+  }
+}
+
+void Sequencer_Release(void)
+{
+  if (state.status != Sequencer_Running)
+  {
+    RingBuffer_Release(RingBuffer_Sequencer);
+    state.steps = 0;
+  }
+}
+
+bool Sequencer_IsRunning(void)
+{
+  return state.status == Sequencer_Running;
+}
+
+const Sequencer_State * Sequencer_GetState(void)
+{
+  return &state;
+}
+
+static void Sequencer_Begin(void)
+{
+  /* A program of steps that take no time continues in the next pass */
+  for (uint16_t i = 0; i <= state.steps; i++)
+  {
+    if (state.step >= state.steps)
+    {
+      state.loops++;
+      if ((loopCount != SEQUENCER_INFINITE_LOOPS) && (state.loops >= loopCount))
+      {
+        state.step = state.steps - 1;
+        Sequencer_Finish(Sequencer_Done);
+        return;
+      }
+      state.step = 0;
+    }
+
+    uint8_t * record = RingBuffer_Get(state.step);
+    memcpy(&step, record, sizeof(Sequencer_Step));
+    switch (step.type)
+    {
+      case SequencerStep_Pin:
+        PinController_Apply(step.mode);
+        state.step++;
+      break;
+      case SequencerStep_Loop:
+        if (step.target < step.value)
+        {
+          step.target++;
+          state.step = step.mode;
+        }
+        else
+        {
+          step.target = 0; /* An outer loop runs this loop again */
+          state.step++;
+        }
+        memcpy(record, &step, sizeof(Sequencer_Step));
+      break;
+      default:
+        startValue = (step.value == SEQUENCER_PRESENT_VALUE) ? Control_GetPresentValue((Communication_WriteCommands)step.mode) : step.value;
+        Control_SetMode((Communication_WriteCommands)step.mode, startValue);
+        EventBus_Subscribe(&measurementSubscription, Event_Measurement); /* The condition is checked on the measurements of this step */
+        state.stepTime = 0;
+        return;
+    }
+  }
+}
+
+static bool Sequencer_IsCondition(void)
+{
+  uint32_t value;
+
+  switch (step.quantity)
+  {
+    case SequencerQuantity_Current:
+      value = measurementValues->unfilteredCurrent;
+    break;
+    case SequencerQuantity_Voltage:
+      value = measurementValues->unfilteredVoltage;
+    break;
+    case SequencerQuantity_Power:
+      value = measurementValues->unfilteredPower;
+    break;
+    case SequencerQuantity_Resistance:
+      value = measurementValues->unfilteredResistance;
+    break;
+    case SequencerQuantity_Temperature:
+      value = temperature->value;
+    break;
+    default:
+      return false;
+  }
+
+  if ((step.comparison == SequencerComparison_SkipBelow) || (step.comparison == SequencerComparison_StopBelow))
+  {
+    return value < step.threshold;
+  }
+  else
+  {
+    return value > step.threshold;
+  }
+}
+
+static void Sequencer_Finish(Sequencer_Status status)
+{
+  state.status = status;
+}
+
+/* </Implementations> */
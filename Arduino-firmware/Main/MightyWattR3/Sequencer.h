@@ -0,0 +1,210 @@
+/**
+ * Sequencer.h
+ * List-mode program sequencer, runs programs uploaded by the host without the host in the loop
+ *
+ * 2018-03-02
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * A program is a list of steps stored in the shared ring buffer (8 steps on UNO, 204 on ZERO). The host clears
+ * the list, adds the steps one by one (arguments staged by WriteCommand_Argument) and starts the program with
+ * the number of its loops. Every step starts when the previous one ends, the times are not delayed by the passes
+ * or by the host, a ramp computes its set value from the time of the step on every pass.
+ * A condition on the measured values (or the temperature) skips the rest of a step or stops the program.
+ * Loop steps repeat the steps from a given step and can be nested. At the end of the program or on a stop
+ * condition the load is switched off; a mode command from the host stops the program first.
+ */
+
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define SEQUENCER_ENABLED                /* Programs run by the load, not on UNO (flash) */
+#endif
+#define SEQUENCER_PRESENT_VALUE             0xFFFFFFFFUL /* Value of a step that keeps the measured value of the mode */
+#define SEQUENCER_INFINITE_LOOPS            0 /* Loops of the program that repeat it until it is stopped */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum Sequencer_Status : uint8_t
+{
+  Sequencer_Idle, /* No program has run since the list was cleared */
+  Sequencer_Running,
+  Sequencer_Done, /* All loops of the program ran, the load is off */
+  Sequencer_Stopped, /* A stop condition of a step, the load is off */
+  Sequencer_Aborted, /* Stop command, mode command or limiter */
+  Sequencer_Invalid /* The last command was rejected, the program was not changed */
+};
+
+/**
+ * data[0] of WriteCommand_Sequencer
+ */
+enum Sequencer_Commands : uint8_t
+{
+  SequencerCommand_Clear = 0, /* Takes the ring buffer and empties the program */
+  SequencerCommand_Add = 1, /* Appends a step with the arguments in the order of Sequencer_Arguments */
+  SequencerCommand_Start = 2, /* data[1..3]: number of loops of the program, SEQUENCER_INFINITE_LOOPS until stopped */
+  SequencerCommand_Stop = 3, /* Stops the program and switches the load off */
+  SequencerCommand_Release = 4 /* Returns the ring buffer to the history, the program is lost */
+};
+
+/**
+ * Arguments of SequencerCommand_Add, sent by WriteCommand_Argument in this order
+ */
+enum Sequencer_Arguments : uint8_t
+{
+  SequencerArgument_Type, /* Sequencer_StepTypes */
+  SequencerArgument_Mode, /* Constant and ramp: write command of the mode; pin: data of WriteCommand_Pins; loop: first step */
+  SequencerArgument_Value, /* Constant: set value; ramp: start value (SEQUENCER_PRESENT_VALUE keeps the measured value); loop: repetitions */
+  SequencerArgument_Target, /* Ramp: final value */
+  SequencerArgument_Duration, /* ms, constant and ramp */
+  SequencerArgument_Quantity, /* Sequencer_Quantities of the condition */
+  SequencerArgument_Comparison, /* Sequencer_Comparisons */
+  SequencerArgument_Threshold, /* uA, uV, uW, mOhm or deg C */
+  SequencerArgument_Count
+};
+
+enum Sequencer_StepTypes : uint8_t
+{
+  SequencerStep_Constant, /* Modes WriteCommand_ConstantCurrent to WriteCommand_SimpleAmmeter */
+  SequencerStep_Ramp, /* Linear ramp, modes WriteCommand_ConstantCurrent to WriteCommand_ConstantVoltageSoftware */
+  SequencerStep_Pin, /* Sets or resets the user pins, takes no time */
+  SequencerStep_Loop, /* Repeats the steps from the first step, takes no time */
+  SequencerStep_TypesCount
+};
+
+/**
+ * Quantity compared by the condition of a step
+ */
+enum Sequencer_Quantities : uint8_t
+{
+  SequencerQuantity_None, /* The step runs for its duration */
+  SequencerQuantity_Current,
+  SequencerQuantity_Voltage,
+  SequencerQuantity_Power,
+  SequencerQuantity_Resistance,
+  SequencerQuantity_Temperature,
+  SequencerQuantity_Count
+};
+
+enum Sequencer_Comparisons : uint8_t
+{
+  SequencerComparison_SkipBelow, /* The next step starts when the quantity is below the threshold */
+  SequencerComparison_SkipAbove,
+  SequencerComparison_StopBelow, /* The program stops when the quantity is below the threshold */
+  SequencerComparison_StopAbove,
+  SequencerComparison_Count
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * One step of the program, one record of the ring buffer
+ */
+struct Sequencer_Step
+{
+  Sequencer_StepTypes type;
+  uint8_t mode; /* See SequencerArgument_Mode */
+  Sequencer_Quantities quantity;
+  Sequencer_Comparisons comparison;
+  uint32_t value;
+  uint32_t target; /* Ramp: final value; loop: repetitions done */
+  uint32_t duration; /* ms */
+  uint32_t threshold;
+};
+
+/**
+ * State of the program
+ */
+struct Sequencer_State
+{
+  Sequencer_Status status;
+  uint16_t steps; /* Steps in the program */
+  uint16_t step; /* Running step, or the step where the program ended */
+  uint32_t loops; /* Finished loops of the program */
+  uint32_t stepTime; /* ms, time of the running step */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void Sequencer_Init(void);
+
+/**
+ * Executable function which must be called periodically while the program runs, before the keeper of the mode
+ */
+void Sequencer_Do(void);
+
+/**
+ * Takes the ring buffer and empties the program
+ *
+ * @return - true if the buffer could be taken
+ */
+bool Sequencer_Clear(void);
+
+/**
+ * Appends a step to the program
+ *
+ * @param arguments - array of SequencerArgument_Count arguments in the order of Sequencer_Arguments
+ * @param count - number of the arguments in the array
+ *
+ * @return - true if the step is valid and there was room for it
+ */
+bool Sequencer_Add(const uint32_t * arguments, uint8_t count);
+
+/**
+ * Starts the program from its first step
+ *
+ * @param loops - number of runs of the program, SEQUENCER_INFINITE_LOOPS until stopped
+ *
+ * @return - true if there is a program
+ */
+bool Sequencer_Start(uint32_t loops);
+
+/**
+ * Stops a running program, the setters are left to the caller
+ */
+void Sequencer_Stop(void);
+
+/**
+ * Returns the ring buffer to the history when no program runs
+ */
+void Sequencer_Release(void);
+
+/**
+ * Returns whether the program runs
+ *
+ * @return - true while the mode is set by this module
+ */
+bool Sequencer_IsRunning(void);
+
+/**
+ * Returns the state of the program
+ *
+ * @return - Pointer to constant state
+ */
+const Sequencer_State * Sequencer_GetState(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* SEQUENCER_H */
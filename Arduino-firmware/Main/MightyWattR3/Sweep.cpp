@@ -0,0 +1,251 @@
+/**
+ * Sweep.cpp
+ * I-V curve sweep with the results in the shared ring buffer
+ *
+ * 2018-03-01
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "Sweep.h"
+#include "CurrentSetter.h"
+#include "VoltageSetter.h"
+#include "Measurement.h"
+#include "EventBus.h"
+#include "RingBuffer.h"
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static Sweep_State state;
+static const Measurement_Values * measurementValues;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+static uint32_t startValue, stopValue; /* uA in CC, uV in CV */
+static uint32_t dwell; /* ms */
+static uint8_t samples;
+static Sweep_AbortConditions abortCondition;
+static uint32_t threshold; /* uV or uA */
+static uint8_t skippedCount, averagedCount; /* Measurements skipped and averaged at the present point */
+static uint64_t voltageSum, currentSum;
+static uint32_t stepTime; /* ms, step to the present point */
+static uint32_t startTime; /* ms, start of the sweep */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Sets the setter to the next point and restarts the averaging
+ */
+static void Sweep_SetPoint(void);
+
+/**
+ * Checks the abort condition on the latest measurement
+ *
+ * @return - true if the sweep must stop
+ */
+static bool Sweep_IsAbortCondition(void);
+
+/**
+ * Ends the sweep
+ *
+ * @param status - Sweep_Done or Sweep_Aborted
+ */
+static void Sweep_Finish(Sweep_Status status);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Sweep_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  state.status = Sweep_Idle;
+}
+
+void Sweep_Do(void)
+{
+  if (state.status != Sweep_Running)
+  {
+    return;
+  }
+
+  if (EventBus_Take(&measurementSubscription))
+  {
+    if (Sweep_IsAbortCondition())
+    {
+      Sweep_Finish(Sweep_Aborted);
+      return;
+    }
+
+    /* The first skipped measurement may have been taken before the step, its timestamp is not compared */
+    if ((skippedCount < SWEEP_SETTLE_MEASUREMENTS) || (measurementValues->milliseconds - stepTime < dwell))
+    {
+      if (skippedCount < SWEEP_SETTLE_MEASUREMENTS)
+      {
+        skippedCount++;
+      }
+    }
+    else
+    {
+      voltageSum += measurementValues->unfilteredVoltage;
+      currentSum += measurementValues->unfilteredCurrent;
+      averagedCount++;
+      if (averagedCount >= samples)
+      {
+        Sweep_Point point;
+        point.current = (uint32_t)(currentSum / samples);
+        point.voltage = (uint32_t)(voltageSum / samples);
+        RingBuffer_Push(&point);
+        state.finishedPoints++;
+        if (state.finishedPoints >= state.points)
+        {
+          Sweep_Finish(Sweep_Done);
+          return;
+        }
+        Sweep_SetPoint();
+      }
+    }
+  }
+  state.duration = HAL_Milliseconds() - startTime;
+
+  if (state.phase == Control_CCCV_CV)
+  {
+    VoltageSetter_Do();
+  }
+  else
+  {
+    CurrentSetter_Do();
+  }
+}
+
+bool Sweep_Start(const uint32_t * arguments, uint8_t count)
+{
+  bool valid = count >= SweepArgument_Count;
+
+  if (valid)
+  {
+    uint32_t maximum = (arguments[SweepArgument_Phase] == Control_CCCV_CV) ? (uint32_t)VOLTAGE_SETTER_MAXIMUM_HIVOLTAGE : (uint32_t)CURRENT_SETTER_MAXIMUM_HICURRENT;
+    valid = ((arguments[SweepArgument_Phase] == Control_CCCV_CC) || (arguments[SweepArgument_Phase] == Control_CCCV_CV))
+            && (arguments[SweepArgument_Start] < maximum) && (arguments[SweepArgument_Stop] < maximum)
+            && (arguments[SweepArgument_Points] >= 2) && (arguments[SweepArgument_Dwell] <= SWEEP_MAXIMUM_DWELL)
+            && (arguments[SweepArgument_Samples] >= 1) && (arguments[SweepArgument_Samples] <= SWEEP_MAXIMUM_SAMPLES)
+            && (arguments[SweepArgument_Abort] < SweepAbort_ConditionsCount);
+  }
+
+  if (!valid)
+  {
+    if (state.status != Sweep_Running)
+    {
+      state.status = Sweep_Invalid;
+    }
+    return false;
+  }
+
+  /* The history gives way to the sweep */
+  RingBuffer_Release(RingBuffer_History);
+  if (!RingBuffer_Acquire(RingBuffer_Sweep, sizeof(Sweep_Point)))
+  {
+    if (state.status != Sweep_Running)
+    {
+      state.status = Sweep_Invalid;
+    }
+    return false;
+  }
+
+  state.phase = (Control_CCCVStates)arguments[SweepArgument_Phase];
+  startValue = arguments[SweepArgument_Start];
+  stopValue = arguments[SweepArgument_Stop];
+  state.points = (arguments[SweepArgument_Points] < RingBuffer_GetCapacity()) ? (uint16_t)arguments[SweepArgument_Points] : RingBuffer_GetCapacity();
+  dwell = arguments[SweepArgument_Dwell];
+  samples = (uint8_t)arguments[SweepArgument_Samples];
+  abortCondition = (Sweep_AbortConditions)arguments[SweepArgument_Abort];
+  threshold = arguments[SweepArgument_Threshold];
+  state.finishedPoints = 0;
+  state.duration = 0;
+  state.status = Sweep_Running;
+  startTime = HAL_Milliseconds();
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement); /* Only the measurements after the start */
+  Sweep_SetPoint();
+  return true;
+}
+
+void Sweep_Abort(void)
+{
+  if (state.status == Sweep_Running)
+  {
+    Sweep_Finish(Sweep_Aborted);
+  }
+}
+
+void Sweep_Release(void)
+{
+  if (state.status != Sweep_Running)
+  {
+    RingBuffer_Release(RingBuffer_Sweep);
+  }
+}
+
+bool Sweep_IsRunning(void)
+{
+  return state.status == Sweep_Running;
+}
+
+const Sweep_State * Sweep_GetState(void)
+{
+  return &state;
+}
+
+static void Sweep_SetPoint(void)
+{
+  /* Every point is computed from the ends, the steps do not accumulate rounding */
+  int64_t span = ((int64_t)stopValue) - startValue;
+  uint32_t value = (uint32_t)(startValue + (span * state.finishedPoints) / (state.points - 1));
+
+  if (state.phase == Control_CCCV_CV)
+  {
+    VoltageSetter_SetVoltage(value);
+  }
+  else
+  {
+    CurrentSetter_SetCurrent(value);
+  }
+  stepTime = HAL_Milliseconds();
+  skippedCount = 0;
+  averagedCount = 0;
+  voltageSum = 0;
+  currentSum = 0;
+}
+
+static bool Sweep_IsAbortCondition(void)
+{
+  switch (abortCondition)
+  {
+    case SweepAbort_VoltageBelow:
+      return measurementValues->unfilteredVoltage < threshold;
+    case SweepAbort_VoltageAbove:
+      return measurementValues->unfilteredVoltage > threshold;
+    case SweepAbort_CurrentBelow:
+      return measurementValues->unfilteredCurrent < threshold;
+    case SweepAbort_CurrentAbove:
+      return measurementValues->unfilteredCurrent > threshold;
+    default:
+      return false;
+  }
+}
+
+static void Sweep_Finish(Sweep_Status status)
+{
+  state.status = status;
+  state.duration = HAL_Milliseconds() - startTime;
+}
+
+/* </Implementations> */
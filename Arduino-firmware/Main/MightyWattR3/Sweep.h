@@ -0,0 +1,168 @@
+/**
+ * Sweep.h
+ * I-V curve sweep with the results in the shared ring buffer
+ *
+ * 2018-03-01
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The setter of the chosen phase (current in CC, voltage in CV) steps from the start to the stop value in equal
+ * steps. At every point the sweep waits for one measurement that may have begun before the step and for the dwell
+ * time, then averages the unfiltered voltage and current of the requested number of measurements and stores them
+ * as one record of the ring buffer, which the host reads in one frame (ReadCommand_Buffer). The sweep takes the
+ * buffer from the history and keeps it until the next sweep or the release command.
+ * The number of points is limited by the capacity of the buffer (20 points on UNO, 512 on ZERO).
+ * The abort condition is checked on every measurement; the load is switched off at the end of the sweep.
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "Control.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define SWEEP_ENABLED                    /* I-V sweeps, not on UNO (flash) */
+#endif
+#define SWEEP_SETTLE_MEASUREMENTS           1 /* Measurements skipped after every step, the first one may have begun before it */
+#define SWEEP_MAXIMUM_DWELL                 10000 /* ms */
+#define SWEEP_MAXIMUM_SAMPLES               255 /* Measurements averaged at one point */
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum Sweep_Status : uint8_t
+{
+  Sweep_Idle, /* No sweep since power-up */
+  Sweep_Running,
+  Sweep_Done, /* All points are in the buffer */
+  Sweep_Aborted, /* Abort condition, new mode or limiter, the buffer holds the finished points */
+  Sweep_Invalid /* The last start command had invalid arguments, nothing was changed */
+};
+
+/**
+ * data[0] of WriteCommand_Sweep
+ */
+enum Sweep_Commands : uint8_t
+{
+  SweepCommand_Start = 0, /* Starts a sweep with the arguments in the order of Sweep_Arguments */
+  SweepCommand_Abort = 1, /* Stops the sweep and switches the load off */
+  SweepCommand_Release = 2 /* Returns the ring buffer to the history */
+};
+
+/**
+ * Arguments of SweepCommand_Start, sent by WriteCommand_Argument in this order
+ */
+enum Sweep_Arguments : uint8_t
+{
+  SweepArgument_Phase, /* Control_CCCV_CC or Control_CCCV_CV */
+  SweepArgument_Start, /* uA in CC, uV in CV */
+  SweepArgument_Stop, /* uA in CC, uV in CV */
+  SweepArgument_Points, /* At least 2 */
+  SweepArgument_Dwell, /* ms after the step before the averaging */
+  SweepArgument_Samples, /* Measurements averaged at one point, at least 1 */
+  SweepArgument_Abort, /* Sweep_AbortConditions */
+  SweepArgument_Threshold, /* uV or uA of the abort condition */
+  SweepArgument_Count
+};
+
+/**
+ * Conditions that stop the sweep, checked on every measurement
+ */
+enum Sweep_AbortConditions : uint8_t
+{
+  SweepAbort_None,
+  SweepAbort_VoltageBelow,
+  SweepAbort_VoltageAbove,
+  SweepAbort_CurrentBelow,
+  SweepAbort_CurrentAbove,
+  SweepAbort_ConditionsCount
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * One point of the sweep, one record of the ring buffer
+ */
+struct Sweep_Point
+{
+  uint32_t current; /* uA */
+  uint32_t voltage; /* uV */
+};
+
+/**
+ * State of the last sweep
+ */
+struct Sweep_State
+{
+  Sweep_Status status;
+  Control_CCCVStates phase;
+  uint16_t points; /* Requested points, limited by the buffer */
+  uint16_t finishedPoints; /* Points stored in the buffer */
+  uint32_t duration; /* ms, from the start to the end, or until now while running */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void Sweep_Init(void);
+
+/**
+ * Executable function which must be called periodically while the sweep runs, runs the setter of the phase
+ */
+void Sweep_Do(void);
+
+/**
+ * Starts a sweep
+ *
+ * @param arguments - array of SweepArgument_Count arguments in the order of Sweep_Arguments
+ * @param count - number of the arguments in the array
+ *
+ * @return - true if the arguments are valid and the sweep runs
+ */
+bool Sweep_Start(const uint32_t * arguments, uint8_t count);
+
+/**
+ * Stops a running sweep, the setters are left to the caller
+ */
+void Sweep_Abort(void);
+
+/**
+ * Returns the ring buffer to the history when the sweep does not run
+ */
+void Sweep_Release(void);
+
+/**
+ * Returns whether the sweep runs
+ *
+ * @return - true while the setters are driven by this module
+ */
+bool Sweep_IsRunning(void);
+
+/**
+ * Returns the state of the last sweep
+ *
+ * @return - Pointer to constant state
+ */
+const Sweep_State * Sweep_GetState(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* SWEEP_H */
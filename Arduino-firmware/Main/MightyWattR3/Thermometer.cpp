@@ -9,11 +9,12 @@
  
  /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Thermometer.h"
 #include "ADC.h"
 #include "DACC.h"
 #include "Measurement.h"
+#include "EventBus.h"
 
 /* </Includes> */ 
 
@@ -22,7 +23,7 @@
 
 static TSCUChar temperature; /* struct containing temperature in Celsius */
 static const TSCADCLong * ADCRaw;
-static uint8_t adcCounter;
+static EventBus_Subscription adcSubscription; /* New raw temperature from ADC */
 static ErrorMessaging_Error thermometerError;
 
 /* </Module variables> */ 
@@ -34,7 +35,7 @@ void Thermometer_Init(void)
 { 
   ADC_SetupChannel(ADC_T, Measurement_Speed[Measurement_Fast]);
   ADCRaw = ADC_GetVoltage(ADC_T);
-  adcCounter = ADCRaw->counter;
+  EventBus_Subscribe(&adcSubscription, Event_ADC_T);
   temperature.counter = 0;
   temperature.value = 0;
   temperature.milliseconds = 0;
@@ -44,15 +45,14 @@ void Thermometer_Init(void)
 
 void Thermometer_Do(void)
 {   
-  if (adcCounter != ADCRaw->counter) /* Process only new reading from ADC */
+  if (EventBus_Take(&adcSubscription)) /* Process only new reading from ADC */
   {  
     float rawTemperature;
     int32_t thermistorResistance; 
     if ((ADCRaw->value <= 0) || (THERMOMETER_REFERENCE_VOLTAGE_IN_ADC_LSB <= ADCRaw->value))
     {
       /* ERROR */
-      thermometerError.errorCounter++;
-      thermometerError.error = ErrorMessaging_Thermometer_HardwareFault;
+      ErrorMessaging_Raise(&thermometerError, ErrorMessaging_Thermometer_HardwareFault);
       return;
     }
     /* calculate resistance of the thermistor */
@@ -60,8 +60,7 @@ void Thermometer_Do(void)
     if (thermistorResistance <= 0)
     {
       /* ERROR */      
-      thermometerError.errorCounter++;
-      thermometerError.error = ErrorMessaging_Thermometer_HardwareFault;
+      ErrorMessaging_Raise(&thermometerError, ErrorMessaging_Thermometer_HardwareFault);
       return;
     }
     
@@ -77,12 +76,17 @@ void Thermometer_Do(void)
     }
     
     temperature.value = (uint8_t)rawTemperature;    
-    adcCounter = ADCRaw->counter;
     temperature.counter++;
-    temperature.milliseconds = millis();
+    temperature.milliseconds = HAL_Milliseconds();
+    EventBus_Publish(Event_Thermometer);
   }
 }
 
+bool Thermometer_DataReady(void)
+{
+  return EventBus_Pending(&adcSubscription);
+}
+
 const TSCUChar * Thermometer_GetTemperature(void)
 {
   return &temperature;
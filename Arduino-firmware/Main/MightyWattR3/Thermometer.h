@@ -54,6 +54,14 @@ void Thermometer_Init(void);
  */
 void Thermometer_Do(void);
 
+/**
+ * Returns whether a new ADC reading is waiting to be processed
+ * Used as data-ready trigger by the scheduler
+ *
+ * @return - true if there is a new ADC reading
+ */
+bool Thermometer_DataReady(void);
+
 /**
  * Gets a pointer to the structure containing temperature underneath the main FET from the thermometer
  *
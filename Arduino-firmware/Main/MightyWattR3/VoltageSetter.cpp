@@ -9,12 +9,13 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Control.h"
 #include "DACC.h"
 #include "Voltmeter.h"
 #include "VoltageSetter.h"
 #include "RangeSwitcher.h"
+#include "Latency.h"
 
 /* </Includes> */ 
 
@@ -24,21 +25,57 @@
 //static uint16_t dacTargetValue;
 static ErrorMessaging_Error VoltageSetterError;
 static uint32_t presentVoltage;
+static bool dirty; /* Set when the set voltage changed and range, DAC value and CC/CV phase must be recomputed */
+static bool cachedAutorange; /* Autoranging permission used for the last computation */
+static RangeSwitcher_VoltageRanges cachedRange; /* Range resulting from the last computation */
+static uint16_t cachedDac; /* DAC value resulting from the last computation */
+static bool cachedOverload; /* The set voltage of the last computation was above the range, raised again on every pass */
 
 /* </Module variables> */ 
 
 
+/* <Declarations (prototypes)> */ 
+
+/**
+ * Computes the DAC value of a voltage in a range
+ *
+ * @param voltage - voltage in uV
+ * @param range - voltage range in which the value is computed
+ *
+ * @return - DAC value, may be above DAC_MAXIMUM if the voltage is out of the range
+ */
+static uint32_t VoltageSetter_GetDAC(uint32_t voltage, RangeSwitcher_VoltageRanges range);
+
+/* </Declarations (prototypes)> */ 
+
+
 /* <Implementations> */ 
 
 void VoltageSetter_Init(void)
 {
   VoltageSetterError.errorCounter = 0;
   VoltageSetterError.error = ErrorMessaging_VoltageSetter_SetVoltageOverload;
+  dirty = true;
 }
 
 void VoltageSetter_Do(void)
 {
-  uint32_t dac;    
+  /* Skip the computation if nothing that affects the result has changed since the last pass */
+  if (!dirty &&
+      (cachedAutorange == RangeSwitcher_CanAutorangeVoltage()) &&
+      (cachedRange == RangeSwitcher_GetVoltageRange()) &&
+      (cachedDac == DACC_GetValue()) &&
+      (Control_GetCCCV() == Control_CCCV_CV))
+  {
+    if (cachedOverload)
+    {
+      ErrorMessaging_Raise(&VoltageSetterError, ErrorMessaging_VoltageSetter_SetVoltageOverload);
+    }
+    return;
+  }
+
+  uint32_t dac = 0;
+  bool overload = false;
   RangeSwitcher_VoltageRanges previousRange = RangeSwitcher_GetVoltageRange();
   RangeSwitcher_VoltageRanges range;
   Control_CCCVStates previousCCCVState = Control_GetCCCV();  
@@ -60,60 +97,74 @@ void VoltageSetter_Do(void)
   switch (range)
   {
     case VoltageRange_HighVoltage:
-      if ((int32_t)presentVoltage + VOLTSETTER_OFFSET_HI > 0)
+      dac = VoltageSetter_GetDAC(presentVoltage, range);
+      if (dac > DAC_MAXIMUM) /* Set voltage higher than maximum */
       {
-        dac = ((((uint64_t)((int32_t)presentVoltage + VOLTSETTER_OFFSET_HI))) << 16) / VOLTSETTER_SLOPE_HI;
-        if (dac > DAC_MAXIMUM) /* Set voltage higher than maximum */
-        {
-          VoltageSetterError.errorCounter++;
-          VoltageSetterError.error = ErrorMessaging_VoltageSetter_SetVoltageOverload;
-          dac = DAC_MAXIMUM;
-        }
+        ErrorMessaging_Raise(&VoltageSetterError, ErrorMessaging_VoltageSetter_SetVoltageOverload);
+        overload = true;
+        dac = DAC_MAXIMUM;
       }
     break;
     case VoltageRange_LowVoltage:
-      if ((int32_t)presentVoltage + VOLTSETTER_OFFSET_LO > 0)
+      dac = VoltageSetter_GetDAC(presentVoltage, range);
+      if (dac > DAC_MAXIMUM) /* Set voltage higher than maximum */
       {
-          dac = ((((uint64_t)((int32_t)presentVoltage + VOLTSETTER_OFFSET_LO))) << 16) / VOLTSETTER_SLOPE_LO;
-          if (dac > DAC_MAXIMUM) /* Set voltage higher than maximum */
-          {
-            dac = DAC_MAXIMUM;
-          }
+        dac = DAC_MAXIMUM;
       }
     break;
     default:      
     return;
   }
 
-  /* Set range if high voltage */
-  if (range == VoltageRange_HighVoltage)
+  /* Set calculated DAC value and range. The high range sets about 5.8 times the voltage of the low range at the same
+   * DAC value. Between the DAC update and the range pin, for the stop condition of the I2C transaction, the new DAC
+   * value is on the old range. Between the pin and the DAC update, for the whole transaction, the old DAC value is on
+   * the new range. So on a change of the range, the DAC first moves to the set voltage on the old range, then the new
+   * DAC value follows and the pin changes right after it. Going down, the new DAC value on the high range sets a higher
+   * voltage, going up, a lower one for the stop condition only, which the voltage loop, slower than the current loop,
+   * does not follow. The failure of the intermediate value is reported by DACC, the switch goes on with the new value. */
+  #ifdef LATENCY_ENABLED
+    Latency_Probe(Probe_SetterComputed);
+  #endif
+  bool written;
+  if (range != previousRange)
   {
-    RangeSwitcher_SetVoltageRange(range);
+    uint32_t intermediate = VoltageSetter_GetDAC(presentVoltage, previousRange);
+    DACC_SetVoltage((intermediate > DAC_MAXIMUM) ? DAC_MAXIMUM : intermediate);
   }
-  /* Set calculated DAC value */
-  if (!DACC_SetVoltage(dac & 0xFFFF))
-  {
-    VoltageSetterError.errorCounter++;
-    VoltageSetterError.error = ErrorMessaging_VoltageSetter_SetVoltageOverload; 
-  }  
-  /* Set range if low voltage */
-  if (range == VoltageRange_LowVoltage)
+  written = DACC_SetVoltage(dac & 0xFFFF);
+  RangeSwitcher_SetVoltageRange(range);
+  if (written)
   {
-    RangeSwitcher_SetVoltageRange(range);
+    dirty = false;
   }
+  else
+  {
+    ErrorMessaging_Raise(&VoltageSetterError, ErrorMessaging_VoltageSetter_SetVoltageOverload); 
+  }  
   /* Set phase CV */
   Control_SetCCCV(Control_CCCV_CV);
 
-  /* If range or mode has changed, invalidate the next measurement because the measurement may occur during the change */
-  if ((previousRange != range) || (previousCCCVState != Control_CCCV_CV))
+  /* If mode has changed, invalidate the next measurement because the measurement may occur during the change, a range change blanks only the voltage */
+  if (previousCCCVState != Control_CCCV_CV)
   {
     Measurement_Invalidate();
   }
+
+  /* Remember the inputs and the result for the next pass */
+  cachedAutorange = RangeSwitcher_CanAutorangeVoltage();
+  cachedRange = range;
+  cachedDac = dac & 0xFFFF;
+  cachedOverload = overload;
 }
 
 void VoltageSetter_SetVoltage(uint32_t voltage)
 {
-  presentVoltage = voltage;
+  if (presentVoltage != voltage)
+  {
+    presentVoltage = voltage;
+    dirty = true;
+  }
 }
 
 uint32_t VoltageSetter_GetVoltage(void)
@@ -154,4 +205,20 @@ const ErrorMessaging_Error * VoltageSetter_GetError(void)
   return &VoltageSetterError;
 }
 
+static uint32_t VoltageSetter_GetDAC(uint32_t voltage, RangeSwitcher_VoltageRanges range)
+{
+  if (range == VoltageRange_HighVoltage)
+  {
+    if ((int32_t)voltage + VOLTSETTER_OFFSET_HI > 0)
+    {
+      return ((((uint64_t)((int32_t)voltage + VOLTSETTER_OFFSET_HI))) << 16) / VOLTSETTER_SLOPE_HI;
+    }
+  }
+  else if ((int32_t)voltage + VOLTSETTER_OFFSET_LO > 0)
+  {
+    return ((((uint64_t)((int32_t)voltage + VOLTSETTER_OFFSET_LO))) << 16) / VOLTSETTER_SLOPE_LO;
+  }
+  return 0;
+}
+
 /* </Implementations> */ 
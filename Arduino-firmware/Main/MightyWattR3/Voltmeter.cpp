@@ -9,7 +9,7 @@
 
 /* <Includes> */ 
 
-#include "Arduino.h"
+#include "HAL.h"
 #include "Voltmeter.h"
 #include "ADC.h"
 #include "Configuration.h"
@@ -17,6 +17,8 @@
 #include "DACC.h"
 #include "RangeSwitcher.h"
 #include "Control.h"
+#include "FastPin.h"
+#include "EventBus.h"
 
 /* </Includes> */ 
 
@@ -50,7 +52,8 @@ void Voltmeter_SetMode(Voltmeter_Modes mode);
 static TSCADCULong voltage; /* contains voltage in microvolts */
 static Voltmeter_Modes voltmeter_mode; /* 2-terminal or 4-terminal */
 static const TSCADCLong * ADCRaw;
-static uint8_t adcCounter, adcErrorCounter, commandCounter;
+static EventBus_Subscription adcSubscription; /* New raw voltage from ADC */
+static uint8_t adcErrorCounter, commandCounter;
 static ErrorMessaging_Error VoltmeterError;
 const static ErrorMessaging_Error * ADCError;
 const static Communication_WriteCommand * writeCommand;
@@ -62,11 +65,11 @@ const static Communication_WriteCommand * writeCommand;
 
 void Voltmeter_Init(void)
 { 
-  pinMode(VOLTMETER_4TERMINAL_PIN, OUTPUT);
+  HAL_PinMode(VOLTMETER_4TERMINAL_PIN, HAL_Output);
   Voltmeter_SetSpeed(VOLTMETER_DEFAULT_MEASUREMENT_SPEED);
   Voltmeter_SetMode(VOLTMETER_DEFAULT_MODE);
   ADCRaw = ADC_GetVoltage(ADC_V);
-  adcCounter = ADCRaw->counter;
+  EventBus_Subscribe(&adcSubscription, Event_ADC_V);
   voltage.counter = 0;
   voltage.milliseconds = 0;
   voltage.value = 0;
@@ -88,9 +91,8 @@ void Voltmeter_ProcessADC(void)
 {
   RangeSwitcher_VoltageRanges range = RangeSwitcher_GetVoltageRange();
   
-  if (adcCounter != ADCRaw->counter) /* Process only new reading from ADC */
+  if (EventBus_Take(&adcSubscription)) /* Process only new reading from ADC */
   {  
-    adcCounter = ADCRaw->counter;
     int32_t signedVoltage, signedUnfilteredVoltage;
 
     /* Finite state machine for hardware autoranging */
@@ -102,8 +104,7 @@ void Voltmeter_ProcessADC(void)
           adcErrorCounter = ADCError->errorCounter;
           if (ADCError->error == ErrorMessaging_ADC_Overload)
           {
-            VoltmeterError.errorCounter++;
-            VoltmeterError.error = ErrorMessaging_Voltmeter_VoltageOverload;
+            ErrorMessaging_Raise(&VoltmeterError, ErrorMessaging_Voltmeter_VoltageOverload);
           }
         }
 
@@ -133,8 +134,7 @@ void Voltmeter_ProcessADC(void)
     if (signedUnfilteredVoltage < VOLTMETER_MINIMUM_VOLTAGE)
     {
       /* Signal negative voltage */
-      VoltmeterError.errorCounter++;
-      VoltmeterError.error = ErrorMessaging_Voltmeter_NegativeVoltage;
+      ErrorMessaging_Raise(&VoltmeterError, ErrorMessaging_Voltmeter_NegativeVoltage);
     }
     
     if (signedVoltage < 0)
@@ -170,7 +170,8 @@ void Voltmeter_ProcessADC(void)
     }
     
     voltage.counter++;
-    voltage.milliseconds = millis();
+    voltage.milliseconds = HAL_Milliseconds();
+    EventBus_Publish(Event_Voltmeter);
   }
 }
 
@@ -212,16 +213,21 @@ void Voltmeter_SetMode(Voltmeter_Modes mode)
   switch (voltmeter_mode)
   {
     case Voltmeter_2Terminal:
-      digitalWrite(VOLTMETER_4TERMINAL_PIN, LOW);
+      FastPin<VOLTMETER_4TERMINAL_PIN>::Clear();
     break;
     case Voltmeter_4Terminal:
-      digitalWrite(VOLTMETER_4TERMINAL_PIN, HIGH);
+      FastPin<VOLTMETER_4TERMINAL_PIN>::Set();
     break;
     default:
     break;
   }  
 }
 
+bool Voltmeter_DataReady(void)
+{
+  return EventBus_Pending(&adcSubscription);
+}
+
 const TSCADCULong * Voltmeter_GetVoltage(void)
 {
   return &voltage;  
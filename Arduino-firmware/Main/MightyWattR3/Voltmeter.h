@@ -73,6 +73,14 @@ void Voltmeter_Init(void);
  */
 void Voltmeter_Do(void);
 
+/**
+ * Returns whether a new ADC reading is waiting to be processed
+ * Used as data-ready trigger by the scheduler
+ *
+ * @return - true if there is a new ADC reading
+ */
+bool Voltmeter_DataReady(void);
+
 /**
  * Sets the measurement speed of the voltmeter ADC
  *
@@ -0,0 +1,421 @@
+/**
+ * Waveform.cpp
+ * Arbitrary waveform playback of an uploaded table of current or power points
+ *
+ * 2018-03-04
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include <stddef.h>
+#include <string.h>
+#include "HAL.h"
+#include "Waveform.h"
+#include "Control.h"
+#include "CurrentSetter.h"
+#include "DACC.h"
+#include "Measurement.h"
+#include "EventBus.h"
+#include "Voltmeter.h"
+#include "RingBuffer.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define WAVEFORM_SAMPLE_LOOP                0x01 /* First tick of a loop after the first one */
+#define WAVEFORM_SAMPLE_END                 0x02 /* Last tick of the playback */
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * One tick computed by the main loop for the timer callback
+ */
+struct Waveform_Sample
+{
+  uint16_t dac;
+  uint16_t point; /* Point of the table the tick belongs to */
+  uint8_t flags;
+};
+
+/* </Structs> */
+
+
+/* <Module variables> */
+
+static Waveform_State state;
+static const Measurement_Values * measurementValues;
+static EventBus_Subscription measurementSubscription; /* New measurement values */
+static RangeSwitcher_CurrentRanges range; /* Locked current range */
+static Waveform_Playbacks playback;
+static uint32_t loopCount; /* Requested loops of a looped playback */
+static uint32_t ticks; /* Ticks between two points */
+static uint16_t segments; /* Interpolated segments of one loop */
+
+/* Next tick computed by the main loop */
+static uint16_t nextPoint;
+static uint32_t nextTick; /* 0 to ticks - 1 */
+static uint32_t computedLoops;
+static bool computing; /* The last tick has not been queued yet */
+
+/* Queue of the ticks, filled by the main loop and emptied by the timer callback */
+static Waveform_Sample queue[WAVEFORM_QUEUE_LENGTH];
+static volatile uint8_t queueHead; /* Written by the main loop */
+static volatile uint8_t queueTail; /* Written by the timer callback */
+static volatile uint16_t playingPoint;
+static volatile uint32_t playedLoops;
+static volatile uint32_t underruns;
+static volatile bool ended; /* The callback wrote the last tick */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Timer callback, writes the next tick from the queue
+ */
+static void Waveform_Tick(void);
+
+/**
+ * Computes ticks until the queue is full or the last tick is queued
+ */
+static void Waveform_Fill(void);
+
+/**
+ * Computes the DAC value of a point of the table or of a value interpolated between two points
+ *
+ * @param value - uA or uW
+ *
+ * @return - DAC value in the locked range
+ */
+static uint16_t Waveform_GetDAC(uint32_t value);
+
+/**
+ * Returns a point of the table
+ *
+ * @param index - index of the point
+ *
+ * @return - Value of the point in uA or uW
+ */
+static uint32_t Waveform_GetValue(uint16_t index);
+
+/**
+ * Ends the playback
+ *
+ * @param status - Waveform_Done or Waveform_Aborted
+ */
+static void Waveform_Finish(Waveform_Status status);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Waveform_Init(void)
+{
+  measurementValues = Measurement_GetValues();
+  state.status = Waveform_Idle;
+  state.points = 0;
+}
+
+void Waveform_Do(void)
+{
+  if (state.status != Waveform_Running)
+  {
+    return;
+  }
+
+  if (ended)
+  {
+    Waveform_Finish(Waveform_Done);
+    return;
+  }
+
+  Waveform_Fill();
+
+  if (EventBus_Take(&measurementSubscription))
+  {
+    HAL_DisableInterrupts();
+    uint16_t point = playingPoint;
+    HAL_EnableInterrupts();
+    uint32_t measured = (state.quantity == WaveformQuantity_Power) ? measurementValues->unfilteredPower : measurementValues->unfilteredCurrent;
+    memcpy(RingBuffer_Get(point) + offsetof(Waveform_Point, measured), &measured, sizeof(measured)); /* The records of the buffer need not be aligned */
+  }
+}
+
+bool Waveform_Clear(void)
+{
+  if (state.status == Waveform_Running)
+  {
+    return false;
+  }
+
+  /* The history gives way to the table */
+  RingBuffer_Release(RingBuffer_History);
+  if (!RingBuffer_Acquire(RingBuffer_Waveform, sizeof(Waveform_Point)))
+  {
+    state.status = Waveform_Invalid;
+    return false;
+  }
+  state.status = Waveform_Idle;
+  state.points = 0;
+  state.point = 0;
+  state.loops = 0;
+  state.underruns = 0;
+  return true;
+}
+
+bool Waveform_Add(const uint32_t * arguments, uint8_t count)
+{
+  if (state.status == Waveform_Running)
+  {
+    return false;
+  }
+  if ((count == 0) || (RingBuffer_GetOwner() != RingBuffer_Waveform) || ((uint32_t)RingBuffer_GetCount() + count > RingBuffer_GetCapacity()))
+  {
+    state.status = Waveform_Invalid;
+    return false;
+  }
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Waveform_Point point;
+    point.value = arguments[i];
+    point.measured = WAVEFORM_NOT_MEASURED;
+    RingBuffer_Push(&point);
+  }
+  state.points = RingBuffer_GetCount();
+  return true;
+}
+
+bool Waveform_Start(const uint32_t * arguments, uint8_t count)
+{
+  bool valid = (count >= WaveformArgument_Count) && (RingBuffer_GetOwner() == RingBuffer_Waveform) && (RingBuffer_GetCount() >= 2);
+  uint32_t highest = 0;
+
+  if (valid)
+  {
+    valid = (arguments[WaveformArgument_Quantity] < WaveformQuantity_Count) && (arguments[WaveformArgument_Playback] < WaveformPlayback_Count)
+            && (arguments[WaveformArgument_Interval] >= WAVEFORM_MINIMUM_TICK) && (arguments[WaveformArgument_Interval] <= WAVEFORM_MAXIMUM_INTERVAL);
+  }
+  if (valid && (arguments[WaveformArgument_Quantity] == WaveformQuantity_Current))
+  {
+    for (uint16_t i = 0; i < state.points; i++)
+    {
+      uint32_t value = Waveform_GetValue(i);
+      if (value > highest)
+      {
+        highest = value;
+      }
+    }
+    valid = highest < CURRENT_SETTER_MAXIMUM_HICURRENT;
+  }
+
+  if (!valid)
+  {
+    if (state.status != Waveform_Running)
+    {
+      state.status = Waveform_Invalid;
+    }
+    return false;
+  }
+
+  HAL_TimerStop();
+  state.quantity = (Waveform_Quantities)arguments[WaveformArgument_Quantity];
+  playback = (Waveform_Playbacks)arguments[WaveformArgument_Playback];
+  loopCount = arguments[WaveformArgument_Loops];
+  segments = (playback == WaveformPlayback_Loop) ? state.points : state.points - 1;
+  ticks = arguments[WaveformArgument_Interval] / WAVEFORM_MINIMUM_TICK; /* The tick is rounded down by less than 0.1 % */
+
+  /* The measured waveform of the last playback is replaced */
+  for (uint16_t i = 0; i < state.points; i++)
+  {
+    uint32_t measured = WAVEFORM_NOT_MEASURED;
+    memcpy(RingBuffer_Get(i) + offsetof(Waveform_Point, measured), &measured, sizeof(measured));
+  }
+
+  /* The current of a power table is not known in advance */
+  range = ((highest > CURRENTSETTER_HYSTERESIS_UP) || (state.quantity == WaveformQuantity_Power) || (RangeSwitcher_CanAutorangeCurrent() == false)) ? CurrentRange_HighCurrent : CurrentRange_LowCurrent;
+
+  nextPoint = 0;
+  nextTick = 0;
+  computedLoops = 0;
+  computing = true;
+  queueHead = 0;
+  queueTail = 0;
+  playingPoint = 0;
+  playedLoops = 0;
+  underruns = 0;
+  ended = false;
+  state.loops = 0;
+  state.underruns = 0;
+  state.point = 0;
+  Waveform_Fill();
+
+  /* The first tick is written now, the range switches on the side of the smaller current as in the current setter */
+  if (range == CurrentRange_LowCurrent)
+  {
+    RangeSwitcher_SetCurrentRange(range);
+  }
+  DACC_SetVoltage(queue[0].dac);
+  if (range == CurrentRange_HighCurrent)
+  {
+    RangeSwitcher_SetCurrentRange(range);
+  }
+  Control_SetCCCV(Control_CCCV_CC);
+  Measurement_Invalidate();
+  queueTail = 1;
+  EventBus_Subscribe(&measurementSubscription, Event_Measurement); /* Only the measurements of the playback */
+  state.status = Waveform_Running;
+  HAL_TimerStart(arguments[WaveformArgument_Interval] / ticks, &Waveform_Tick);
+  return true;
+}
+
+void Waveform_Stop(void)
+{
+  if (state.status == Waveform_Running)
+  {
+    Waveform_Finish(Waveform_Aborted);
+  }
+}
+
+void Waveform_Release(void)
+{
+  if (state.status != Waveform_Running)
+  {
+    RingBuffer_Release(RingBuffer_Waveform);
+    state.points = 0;
+  }
+}
+
+bool Waveform_IsRunning(void)
+{
+  return state.status == Waveform_Running;
+}
+
+const Waveform_State * Waveform_GetState(void)
+{
+  if (state.status == Waveform_Running)
+  {
+    HAL_DisableInterrupts();
+    state.point = playingPoint;
+    state.loops = playedLoops;
+    state.underruns = underruns;
+    HAL_EnableInterrupts();
+  }
+  return &state;
+}
+
+static void Waveform_Tick(void)
+{
+  uint8_t tail = queueTail;
+
+  if (tail == queueHead)
+  {
+    if (!ended)
+    {
+      underruns++; /* The DAC keeps the last tick */
+    }
+    return;
+  }
+
+  DACC_SetVoltageFromTimer(queue[tail].dac);
+  playingPoint = queue[tail].point;
+  if (queue[tail].flags & WAVEFORM_SAMPLE_LOOP)
+  {
+    playedLoops++;
+  }
+  if (queue[tail].flags & WAVEFORM_SAMPLE_END)
+  {
+    ended = true;
+  }
+  queueTail = (tail + 1) & (WAVEFORM_QUEUE_LENGTH - 1);
+}
+
+static void Waveform_Fill(void)
+{
+  while (computing && (((queueHead + 1) & (WAVEFORM_QUEUE_LENGTH - 1)) != queueTail))
+  {
+    Waveform_Sample * sample = &queue[queueHead];
+    sample->flags = 0;
+
+    if (nextPoint >= segments)
+    {
+      computedLoops++;
+      if ((playback == WaveformPlayback_OneShot) || ((loopCount != WAVEFORM_INFINITE_LOOPS) && (computedLoops >= loopCount)))
+      {
+        /* One-shot: the last point; looped: the first point that closes the period */
+        sample->point = (playback == WaveformPlayback_Loop) ? 0 : segments;
+        sample->dac = Waveform_GetDAC(Waveform_GetValue(sample->point));
+        sample->flags = WAVEFORM_SAMPLE_END | ((playback == WaveformPlayback_Loop) ? WAVEFORM_SAMPLE_LOOP : 0);
+        computing = false;
+        queueHead = (queueHead + 1) & (WAVEFORM_QUEUE_LENGTH - 1);
+        return;
+      }
+      nextPoint = 0;
+      sample->flags = WAVEFORM_SAMPLE_LOOP;
+    }
+
+    /* Every tick is computed from the two points, the steps do not accumulate rounding */
+    uint32_t from = Waveform_GetValue(nextPoint);
+    int64_t span = ((int64_t)Waveform_GetValue((nextPoint + 1 < state.points) ? nextPoint + 1 : 0)) - from;
+    sample->point = nextPoint;
+    sample->dac = Waveform_GetDAC((uint32_t)(from + (span * nextTick) / (int32_t)ticks));
+    nextTick++;
+    if (nextTick >= ticks)
+    {
+      nextTick = 0;
+      nextPoint++;
+    }
+    queueHead = (queueHead + 1) & (WAVEFORM_QUEUE_LENGTH - 1);
+  }
+}
+
+static uint16_t Waveform_GetDAC(uint32_t value)
+{
+  uint64_t current = value;
+
+  if (state.quantity == WaveformQuantity_Power)
+  {
+    if (measurementValues->unfilteredVoltage <= VOLTMETER_THRESHOLD_VOLTAGE)
+    {
+      return 0; /* No power can be drawn without the voltage */
+    }
+    current = (((uint64_t)value) * 1000000) / measurementValues->unfilteredVoltage;
+    if (current >= (uint64_t)CURRENT_SETTER_MAXIMUM_HICURRENT)
+    {
+      current = (uint64_t)(CURRENT_SETTER_MAXIMUM_HICURRENT - 1);
+    }
+  }
+
+  if (current == 0)
+  {
+    return 0; /* True zero on zero current, as the current setter */
+  }
+  uint32_t dac = CurrentSetter_GetDAC((uint32_t)current, range);
+  return (dac > DAC_MAXIMUM) ? DAC_MAXIMUM : (uint16_t)dac;
+}
+
+static uint32_t Waveform_GetValue(uint16_t index)
+{
+  uint32_t value;
+  memcpy(&value, RingBuffer_Get(index), sizeof(value));
+  return value;
+}
+
+static void Waveform_Finish(Waveform_Status status)
+{
+  HAL_TimerStop();
+  Waveform_GetState(); /* The last values of the callback */
+  state.status = status;
+}
+
+/* </Implementations> */
@@ -0,0 +1,193 @@
+/**
+ * Waveform.h
+ * Arbitrary waveform playback of an uploaded table of current or power points
+ *
+ * 2018-03-04
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The table is stored in the shared ring buffer (20 points on UNO, 512 on ZERO). The host clears it, adds the
+ * points (up to COMMUNICATION_ARGUMENTS_COUNT per command, staged by WriteCommand_Argument) and starts the playback
+ * with the quantity, the interval of the points and one-shot or looped playback. The points are interpolated
+ * linearly in ticks of at least WAVEFORM_MINIMUM_TICK; the main loop computes the DAC values of the next ticks
+ * into a short queue (a power point is divided by the latest measured voltage) and the timer callback writes one
+ * value per tick. A tick that finds the queue empty keeps the DAC and is counted as an underrun.
+ * The current range is locked during the playback: by the largest point for a current table, high for power.
+ * Every measurement is stored with the point that was playing when it finished, so the buffer holds the measured
+ * waveform (current or power) next to the table after the playback. The load is switched off at the end.
+ */
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "Dynamic.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#if defined(ZERO) || defined(NATIVE)
+  #define WAVEFORM_ENABLED                 /* Playback on the timer, not on UNO (flash) */
+#endif
+#define WAVEFORM_MINIMUM_TICK               DYNAMIC_MINIMUM_INTERVAL /* us, between DAC writes */
+#define WAVEFORM_MAXIMUM_INTERVAL           60000000UL /* us, between two points */
+#define WAVEFORM_NOT_MEASURED               0xFFFFFFFFUL /* Measured value of a point without a measurement */
+#define WAVEFORM_INFINITE_LOOPS             0 /* Loops of a looped playback that repeat it until it is stopped */
+#ifdef UNO
+  #define WAVEFORM_QUEUE_LENGTH             4 /* Ticks computed ahead, power of 2 */
+#elif defined(ZERO) || defined(NATIVE)
+  #define WAVEFORM_QUEUE_LENGTH             16 /* Ticks computed ahead, power of 2 */
+#endif
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+enum Waveform_Status : uint8_t
+{
+  Waveform_Idle, /* No playback since the table was cleared */
+  Waveform_Running,
+  Waveform_Done, /* The playback ended, the load is off */
+  Waveform_Aborted, /* Stop command, mode command or limiter */
+  Waveform_Invalid /* The last command was rejected, the table was not changed */
+};
+
+/**
+ * data[0] of WriteCommand_Waveform
+ */
+enum Waveform_Commands : uint8_t
+{
+  WaveformCommand_Clear = 0, /* Takes the ring buffer and empties the table */
+  WaveformCommand_Add = 1, /* Appends the staged arguments as points, uA or uW */
+  WaveformCommand_Start = 2, /* Starts the playback with the arguments in the order of Waveform_Arguments */
+  WaveformCommand_Stop = 3, /* Stops the playback and switches the load off */
+  WaveformCommand_Release = 4 /* Returns the ring buffer to the history, the table is lost */
+};
+
+/**
+ * Arguments of WaveformCommand_Start, sent by WriteCommand_Argument in this order
+ */
+enum Waveform_Arguments : uint8_t
+{
+  WaveformArgument_Quantity, /* Waveform_Quantities of the points */
+  WaveformArgument_Interval, /* us between the points, WAVEFORM_MINIMUM_TICK to WAVEFORM_MAXIMUM_INTERVAL */
+  WaveformArgument_Playback, /* Waveform_Playbacks */
+  WaveformArgument_Loops, /* Looped playback: number of loops, WAVEFORM_INFINITE_LOOPS until stopped */
+  WaveformArgument_Count
+};
+
+enum Waveform_Quantities : uint8_t
+{
+  WaveformQuantity_Current, /* uA */
+  WaveformQuantity_Power, /* uW, divided by the measured voltage */
+  WaveformQuantity_Count
+};
+
+enum Waveform_Playbacks : uint8_t
+{
+  WaveformPlayback_OneShot, /* From the first to the last point */
+  WaveformPlayback_Loop, /* The table is one period, the last point is interpolated to the first one */
+  WaveformPlayback_Count
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * One point of the table, one record of the ring buffer
+ */
+struct Waveform_Point
+{
+  uint32_t value; /* uA or uW */
+  uint32_t measured; /* uA or uW of the last measurement during the point, WAVEFORM_NOT_MEASURED if none */
+};
+
+/**
+ * State of the playback
+ */
+struct Waveform_State
+{
+  Waveform_Status status;
+  Waveform_Quantities quantity;
+  uint16_t points; /* Points in the table */
+  uint16_t point; /* Playing point, or the point where the playback ended */
+  uint32_t loops; /* Finished loops */
+  uint32_t underruns; /* Ticks without a computed value */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the module
+ */
+void Waveform_Init(void);
+
+/**
+ * Executable function which must be called periodically while the playback runs, computes the next ticks
+ */
+void Waveform_Do(void);
+
+/**
+ * Takes the ring buffer and empties the table
+ *
+ * @return - true if the buffer could be taken
+ */
+bool Waveform_Clear(void);
+
+/**
+ * Appends points to the table
+ *
+ * @param arguments - array of points in uA or uW
+ * @param count - number of the points in the array
+ *
+ * @return - true if all points fit in the table
+ */
+bool Waveform_Add(const uint32_t * arguments, uint8_t count);
+
+/**
+ * Starts the playback from the first point, a running playback is restarted
+ *
+ * @param arguments - array of WaveformArgument_Count arguments in the order of Waveform_Arguments
+ * @param count - number of the arguments in the array
+ *
+ * @return - true if the arguments and the table are valid and the playback runs
+ */
+bool Waveform_Start(const uint32_t * arguments, uint8_t count);
+
+/**
+ * Stops a running playback, the DAC is left at its last value for the caller
+ */
+void Waveform_Stop(void);
+
+/**
+ * Returns the ring buffer to the history when no playback runs
+ */
+void Waveform_Release(void);
+
+/**
+ * Returns whether the playback runs
+ *
+ * @return - true while the DAC is written by this module
+ */
+bool Waveform_IsRunning(void);
+
+/**
+ * Returns the state of the playback
+ *
+ * @return - Pointer to constant state, consistent with the timer callback at the time of the call
+ */
+const Waveform_State * Waveform_GetState(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* WAVEFORM_H */
@@ -0,0 +1,1025 @@
+/**
+ * Benchmark.cpp
+ * Closed-loop convergence benchmark of the control modes against simulated sources
+ *
+ * 2018-02-25
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * Usage: mightywatt-benchmark [step|pi|feedforward] [tune]
+ *        mightywatt-benchmark sweep
+ *        mightywatt-benchmark transfer
+ *        mightywatt-benchmark ranges
+ * The optional argument selects the control loop of the software-controlled modes (the firmware default otherwise).
+ * With "tune", the mode is first run at its set value for BENCHMARK_TUNE_TIME, identified by the auto-tune
+ * and stopped; the step response is then recorded with the tuned parameters, which are added to the report.
+ * Each scenario powers up the firmware (a fresh process), lets it idle, sends one mode command
+ * through the serial stream and records the true terminal quantity of the mode on every pass.
+ * The clock is virtual: every pass of MightyWatt_Do takes BENCHMARK_PASS_TIME, the ADC conversions
+ * take the time of their data rate, so the results do not depend on the PC.
+ * Reported per scenario:
+ *   settling - time after the command until the value stays within BENCHMARK_SETTLING_BAND of the target
+ *   overshoot - largest excursion past the target in the direction of the step, % of target
+ *   ripple - peak-to-peak value over the last BENCHMARK_STEADY_STATE_TIME, % of target
+ *   error - mean value over the last BENCHMARK_STEADY_STATE_TIME minus the target, % of target
+ * The target of MPPT is the maximum power of the source. Scenarios with a change of the source run the mode for
+ * BENCHMARK_CHANGE_TIME, then replace the source (shading) and record the response to the change instead of the command;
+ * the source column then shows "> " and the new source. MPPT rows end with the statistics reported by the tracker.
+ * With "sweep", I-V sweeps are run instead (arguments and start command through the serial stream); reported are the
+ * stored points, the duration reported by the sweep, the largest deviation of the measured quantity of the phase
+ * from its set value and the number of points left out of it because the source does not allow the set value.
+ * With "transfer", mode transitions are run instead: the first mode runs for BENCHMARK_CHANGE_TIME, then the second
+ * mode is commanded with the set value of the operating point reached by the first one (MPPT: the maximum power
+ * point), so an ideal transfer does not move the load, or with a new set value and a slew rate, so the second mode
+ * ramps from the operating point. Reported are the settling time of the quantity of the second mode, the largest
+ * deviation from its target after the switch and the largest current step, both in % of the target or of the current
+ * before the switch, and the largest change of the set quantity of the phase in one pass beyond the ramp in DAC codes.
+ * A ramp of CC or CV with more than one code is marked and the benchmark exits with 1; the software modes close the loop
+ * on the measurements and step by their noise, their codes are only reported.
+ * With "ranges", setpoint changes that switch the hardware range of the setter are run instead. The I2C transactions take
+ * the time of their bits at BENCHMARK_I2C_CLOCK and the plant follows every change of the DAC and of the pins, so the
+ * glitch between the DAC update and the range pin is seen. Reported are the largest excursion of the quantity of the mode
+ * beyond the values before and after the change (% of the target), the time it spends beyond BENCHMARK_GLITCH_BAND,
+ * the largest excursion of the published measurements beyond the same values (% of the target) and the number of
+ * measurements published, both over BENCHMARK_GLITCH_TIME after the command. Overshoot is the largest excursion in the
+ * direction of more load (current above, voltage below both values), a change with overshoot beyond
+ * BENCHMARK_GLITCH_BAND is marked and the benchmark exits with 1.
+ */
+
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "HAL_Native.h"
+#include "Devices.h"
+#include "Plant.h"
+#include "Communication.h"
+#include "Configuration.h"
+#include "Control.h"
+#include "AutoTune.h"
+#include "MPPT.h"
+#include "Sweep.h"
+#include "Measurement.h"
+#include "RingBuffer.h"
+#include "RangeSwitcher.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define BENCHMARK_PASS_TIME                 250 /* us, assumed duration of one pass of MightyWatt_Do on the target */
+#define BENCHMARK_IDLE_TIME                 100000UL /* us, power-up before the command */
+#define BENCHMARK_RUN_TIME                  3000000UL /* us, recorded after the command */
+#define BENCHMARK_STEADY_STATE_TIME         500000UL /* us, end of the run used for ripple and error */
+#define BENCHMARK_TUNE_TIME                 1000000UL /* us, operation before and after the auto-tune command */
+#define BENCHMARK_CHANGE_TIME               1000000UL /* us, operation before the change of the source */
+#define BENCHMARK_SETTLING_BAND             0.02 /* Relative to the target */
+#define BENCHMARK_SAMPLE_COUNT              (BENCHMARK_RUN_TIME / BENCHMARK_PASS_TIME)
+#define BENCHMARK_SCENARIO_COUNT            (sizeof(Scenarios) / sizeof(Benchmark_Scenario))
+#define BENCHMARK_SWEEP_TIMEOUT             10000000UL /* us, longest sweep */
+#define BENCHMARK_SWEEP_LIMITED             0.005 /* Relative to the range, points further from the set value are limited by the source */
+#define BENCHMARK_SWEEP_COUNT               (sizeof(Sweeps) / sizeof(Benchmark_Sweep))
+#define BENCHMARK_TRANSFER_COUNT            (sizeof(Transfers) / sizeof(Benchmark_Transfer))
+#define BENCHMARK_I2C_CLOCK                 100000UL /* Hz, default of Wire on UNO and ZERO */
+#define BENCHMARK_GLITCH_TIME               50000UL /* us, recorded after the setpoint change */
+#define BENCHMARK_GLITCH_BAND               0.005 /* Relative to the target, excursion counted in the duration of the glitch */
+#define BENCHMARK_RANGE_SWITCH_COUNT        (sizeof(RangeSwitches) / sizeof(Benchmark_RangeSwitch))
+
+/* </Defines> */
+
+
+/* <Enums> */
+
+/**
+ * Sources used in the scenarios, index to Sources[]
+ */
+enum Benchmark_Sources : uint8_t
+{
+  Benchmark_Ideal,
+  Benchmark_SeriesResistance,
+  Benchmark_PV,
+  Benchmark_Battery,
+  Benchmark_CurrentLimited,
+  Benchmark_PVShaded,
+  Benchmark_NoChange /* Not a source, the scenario does not change the source */
+};
+
+/**
+ * Quantity that a mode controls
+ */
+enum Benchmark_Quantities : uint8_t
+{
+  Quantity_Current, /* A */
+  Quantity_Voltage, /* V */
+  Quantity_Power, /* W */
+  Quantity_Resistance, /* Ohm */
+  Quantity_MaximumPower /* W, target is the maximum power of the source */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * One step response: mode command, source and set value
+ */
+struct Benchmark_Scenario
+{
+  const char * mode; /* Mode name for the report */
+  Communication_WriteCommands command;
+  Benchmark_Quantities quantity;
+  Benchmark_Sources source;
+  double setValue; /* In the unit of the quantity, not used for MPPT */
+  Benchmark_Sources change; /* Source after BENCHMARK_CHANGE_TIME of running, Benchmark_NoChange for a step of the command */
+};
+
+/**
+ * One I-V sweep, values in A (CC) or V (CV)
+ */
+struct Benchmark_Sweep
+{
+  Benchmark_Sources source;
+  Control_CCCVStates phase;
+  double start;
+  double stop;
+  uint16_t points;
+  uint32_t dwell; /* ms */
+  uint8_t samples;
+};
+
+/**
+ * One mode transition, the second mode gets the set value of the operating point of the first one or a new set value
+ */
+struct Benchmark_Transfer
+{
+  const char * fromMode; /* Mode names for the report */
+  Communication_WriteCommands fromCommand;
+  Benchmark_Quantities fromQuantity;
+  double fromValue; /* In the unit of the quantity */
+  const char * toMode;
+  Communication_WriteCommands toCommand;
+  Benchmark_Quantities toQuantity;
+  Benchmark_Sources source;
+  double toValue; /* In the unit of the quantity, 0 for the operating point of the first mode */
+  double slewRate; /* Per ms in the unit of the quantity, 0 applies the set value at once */
+};
+
+/**
+ * One setpoint change across the range threshold of the setter, values in the unit of the quantity
+ */
+struct Benchmark_RangeSwitch
+{
+  const char * mode; /* Mode name for the report */
+  Communication_WriteCommands command;
+  Benchmark_Quantities quantity;
+  Benchmark_Sources source;
+  double fromValue;
+  double toValue;
+};
+
+/* </Structs> */
+
+
+/* <Module variables> */
+
+static const Plant_Source Sources[] =
+{
+  /* type, name, voltage, resistance, current, I0, n*cells*kT/q, R1, C1, shaded current, shaded fraction */
+  {Source_Ideal,            "ideal 12 V",          12.0, 0,    0,   0,      0,    0,    0,    0,   0},
+  {Source_SeriesResistance, "12 V + 1 Ohm",        12.0, 1.0,  0,   0,      0,    0,    0,    0,   0},
+  {Source_PV,               "PV 36 cells 3 A",     0,    0.3,  3.0, 1e-7,   1.20, 0,    0,    0,   0},
+  {Source_Battery,          "battery 12.6 V RC",   12.6, 0.05, 0,   0,      0,    0.03, 20.0, 0,   0},
+  {Source_CurrentLimited,   "PSU 12 V / 2 A",      12.0, 0.01, 2.0, 0,      0,    0,    0,    0,   0},
+  {Source_PV,               "PV half at 1 A",      0,    0.3,  3.0, 1e-7,   1.20, 0,    0,    1.0, 0.5}
+};
+
+static const Plant_FrontEnd FrontEnd =
+{
+  0.002, /* V rms */
+  0.001, /* A rms */
+  50e-6, /* s, CC phase */
+  500e-6 /* s, CV phase */
+};
+
+static const Benchmark_Scenario Scenarios[] =
+{
+  {"CC",       WriteCommand_ConstantCurrent,        Quantity_Current,      Benchmark_Ideal,            1.5, Benchmark_NoChange},
+  {"CC",       WriteCommand_ConstantCurrent,        Quantity_Current,      Benchmark_SeriesResistance, 1.5, Benchmark_NoChange},
+  {"CC",       WriteCommand_ConstantCurrent,        Quantity_Current,      Benchmark_PV,               1.5, Benchmark_NoChange},
+  {"CC",       WriteCommand_ConstantCurrent,        Quantity_Current,      Benchmark_Battery,          1.5, Benchmark_NoChange},
+  {"CC",       WriteCommand_ConstantCurrent,        Quantity_Current,      Benchmark_CurrentLimited,   1.5, Benchmark_NoChange},
+  {"CV",       WriteCommand_ConstantVoltage,        Quantity_Voltage,      Benchmark_SeriesResistance, 6.0, Benchmark_NoChange},
+  {"CV",       WriteCommand_ConstantVoltage,        Quantity_Voltage,      Benchmark_PV,               16.0, Benchmark_NoChange},
+  {"CV",       WriteCommand_ConstantVoltage,        Quantity_Voltage,      Benchmark_Battery,          12.4, Benchmark_NoChange},
+  {"CV",       WriteCommand_ConstantVoltage,        Quantity_Voltage,      Benchmark_CurrentLimited,   6.0, Benchmark_NoChange},
+  {"CV-SW",    WriteCommand_ConstantVoltageSoftware, Quantity_Voltage,     Benchmark_SeriesResistance, 6.0, Benchmark_NoChange},
+  {"CV-SW",    WriteCommand_ConstantVoltageSoftware, Quantity_Voltage,     Benchmark_PV,               16.0, Benchmark_NoChange},
+  {"CV-SW",    WriteCommand_ConstantVoltageSoftware, Quantity_Voltage,     Benchmark_Battery,          12.4, Benchmark_NoChange},
+  {"CV-SW",    WriteCommand_ConstantVoltageSoftware, Quantity_Voltage,     Benchmark_CurrentLimited,   6.0, Benchmark_NoChange},
+  {"CP-CC",    WriteCommand_ConstantPowerCC,        Quantity_Power,        Benchmark_Ideal,            15.0, Benchmark_NoChange},
+  {"CP-CC",    WriteCommand_ConstantPowerCC,        Quantity_Power,        Benchmark_SeriesResistance, 15.0, Benchmark_NoChange},
+  {"CP-CC",    WriteCommand_ConstantPowerCC,        Quantity_Power,        Benchmark_PV,               15.0, Benchmark_NoChange},
+  {"CP-CC",    WriteCommand_ConstantPowerCC,        Quantity_Power,        Benchmark_Battery,          15.0, Benchmark_NoChange},
+  {"CP-CC",    WriteCommand_ConstantPowerCC,        Quantity_Power,        Benchmark_CurrentLimited,   15.0, Benchmark_NoChange},
+  {"CP-CV",    WriteCommand_ConstantPowerCV,        Quantity_Power,        Benchmark_SeriesResistance, 15.0, Benchmark_NoChange},
+  {"CP-CV",    WriteCommand_ConstantPowerCV,        Quantity_Power,        Benchmark_PV,               15.0, Benchmark_NoChange},
+  {"CP-CV",    WriteCommand_ConstantPowerCV,        Quantity_Power,        Benchmark_Battery,          15.0, Benchmark_NoChange},
+  {"CP-CV",    WriteCommand_ConstantPowerCV,        Quantity_Power,        Benchmark_CurrentLimited,   15.0, Benchmark_NoChange},
+  {"CR-CC",    WriteCommand_ConstantResistanceCC,   Quantity_Resistance,   Benchmark_Ideal,            8.0, Benchmark_NoChange},
+  {"CR-CC",    WriteCommand_ConstantResistanceCC,   Quantity_Resistance,   Benchmark_SeriesResistance, 8.0, Benchmark_NoChange},
+  {"CR-CC",    WriteCommand_ConstantResistanceCC,   Quantity_Resistance,   Benchmark_PV,               8.0, Benchmark_NoChange},
+  {"CR-CC",    WriteCommand_ConstantResistanceCC,   Quantity_Resistance,   Benchmark_Battery,          8.0, Benchmark_NoChange},
+  {"CR-CC",    WriteCommand_ConstantResistanceCC,   Quantity_Resistance,   Benchmark_CurrentLimited,   8.0, Benchmark_NoChange},
+  {"CR-CV",    WriteCommand_ConstantResistanceCV,   Quantity_Resistance,   Benchmark_SeriesResistance, 8.0, Benchmark_NoChange},
+  {"CR-CV",    WriteCommand_ConstantResistanceCV,   Quantity_Resistance,   Benchmark_PV,               8.0, Benchmark_NoChange},
+  {"CR-CV",    WriteCommand_ConstantResistanceCV,   Quantity_Resistance,   Benchmark_Battery,          8.0, Benchmark_NoChange},
+  {"CR-CV",    WriteCommand_ConstantResistanceCV,   Quantity_Resistance,   Benchmark_CurrentLimited,   8.0, Benchmark_NoChange},
+  {"MPPT",     WriteCommand_MPPT,                   Quantity_MaximumPower, Benchmark_SeriesResistance, 0, Benchmark_NoChange},
+  {"MPPT",     WriteCommand_MPPT,                   Quantity_MaximumPower, Benchmark_PV,               0, Benchmark_NoChange},
+  {"MPPT",     WriteCommand_MPPT,                   Quantity_MaximumPower, Benchmark_PVShaded,         0, Benchmark_NoChange},
+  {"MPPT",     WriteCommand_MPPT,                   Quantity_MaximumPower, Benchmark_PV,               0, Benchmark_PVShaded},
+  {"MPPT",     WriteCommand_MPPT,                   Quantity_MaximumPower, Benchmark_PVShaded,         0, Benchmark_PV}
+};
+
+static const Benchmark_Sweep Sweeps[] =
+{
+  {Benchmark_PV,               Control_CCCV_CV, 0,    21.0, 100, 0,  1},
+  {Benchmark_PV,               Control_CCCV_CV, 21.0, 0,    100, 0,  1},
+  {Benchmark_PV,               Control_CCCV_CC, 0,    3.0,  100, 0,  1},
+  {Benchmark_PV,               Control_CCCV_CV, 0,    21.0, 100, 0,  4},
+  {Benchmark_PV,               Control_CCCV_CV, 0,    21.0, 100, 10, 1},
+  {Benchmark_SeriesResistance, Control_CCCV_CC, 0,    5.0,  100, 0,  1},
+  {Benchmark_CurrentLimited,   Control_CCCV_CV, 12.0, 1.0,  100, 0,  1},
+  {Benchmark_Battery,          Control_CCCV_CC, 0,    5.0,  100, 0,  2}
+};
+
+static const Benchmark_Transfer Transfers[] =
+{
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CV",    WriteCommand_ConstantVoltage,         Quantity_Voltage,      Benchmark_SeriesResistance, 0,    0},
+  {"CV",    WriteCommand_ConstantVoltage,        Quantity_Voltage,    9.0,  "CC",    WriteCommand_ConstantCurrent,         Quantity_Current,      Benchmark_SeriesResistance, 0,    0},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CV-SW", WriteCommand_ConstantVoltageSoftware, Quantity_Voltage,      Benchmark_SeriesResistance, 0,    0},
+  {"CV",    WriteCommand_ConstantVoltage,        Quantity_Voltage,    9.0,  "CV-SW", WriteCommand_ConstantVoltageSoftware, Quantity_Voltage,      Benchmark_SeriesResistance, 0,    0},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CP-CC", WriteCommand_ConstantPowerCC,         Quantity_Power,        Benchmark_SeriesResistance, 0,    0},
+  {"CV",    WriteCommand_ConstantVoltage,        Quantity_Voltage,    9.0,  "CP-CC", WriteCommand_ConstantPowerCC,         Quantity_Power,        Benchmark_SeriesResistance, 0,    0},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CP-CV", WriteCommand_ConstantPowerCV,         Quantity_Power,        Benchmark_SeriesResistance, 0,    0},
+  {"CP-CC", WriteCommand_ConstantPowerCC,        Quantity_Power,      15.0, "CP-CV", WriteCommand_ConstantPowerCV,         Quantity_Power,        Benchmark_SeriesResistance, 0,    0},
+  {"CP-CV", WriteCommand_ConstantPowerCV,        Quantity_Power,      15.0, "CP-CC", WriteCommand_ConstantPowerCC,         Quantity_Power,        Benchmark_SeriesResistance, 0,    0},
+  {"CR-CC", WriteCommand_ConstantResistanceCC,   Quantity_Resistance, 8.0,  "CR-CV", WriteCommand_ConstantResistanceCV,    Quantity_Resistance,   Benchmark_SeriesResistance, 0,    0},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CR-CV", WriteCommand_ConstantResistanceCV,    Quantity_Resistance,   Benchmark_PV,               0,    0},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CP-CV", WriteCommand_ConstantPowerCV,         Quantity_Power,        Benchmark_Battery,          0,    0},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    2.5,  "MPPT",  WriteCommand_MPPT,                    Quantity_MaximumPower, Benchmark_PV,               0,    0},
+  {"CV",    WriteCommand_ConstantVoltage,        Quantity_Voltage,    16.0, "MPPT",  WriteCommand_MPPT,                    Quantity_MaximumPower, Benchmark_PV,               0,    0},
+  {"CV",    WriteCommand_ConstantVoltage,        Quantity_Voltage,    9.0,  "CC",    WriteCommand_ConstantCurrent,         Quantity_Current,      Benchmark_SeriesResistance, 2.0,  0.001}, /* Ramps from the operating point */
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CV",    WriteCommand_ConstantVoltage,         Quantity_Voltage,      Benchmark_SeriesResistance, 9.0,  0.001},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CV-SW", WriteCommand_ConstantVoltageSoftware, Quantity_Voltage,      Benchmark_SeriesResistance, 9.0,  0.001},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CP-CC", WriteCommand_ConstantPowerCC,         Quantity_Power,        Benchmark_SeriesResistance, 20.0, 0.005},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CP-CV", WriteCommand_ConstantPowerCV,         Quantity_Power,        Benchmark_SeriesResistance, 20.0, 0.005},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CR-CC", WriteCommand_ConstantResistanceCC,    Quantity_Resistance,   Benchmark_SeriesResistance, 5.0,  0.005},
+  {"CC",    WriteCommand_ConstantCurrent,        Quantity_Current,    1.5,  "CR-CV", WriteCommand_ConstantResistanceCV,    Quantity_Resistance,   Benchmark_SeriesResistance, 5.0,  0.005}
+};
+
+static const Benchmark_RangeSwitch RangeSwitches[] =
+{
+  {"CC", WriteCommand_ConstantCurrent, Quantity_Current, Benchmark_SeriesResistance, 2.85, 2.95}, /* Just across the thresholds */
+  {"CC", WriteCommand_ConstantCurrent, Quantity_Current, Benchmark_SeriesResistance, 2.95, 2.70},
+  {"CC", WriteCommand_ConstantCurrent, Quantity_Current, Benchmark_Ideal,            2.95, 2.70},
+  {"CC", WriteCommand_ConstantCurrent, Quantity_Current, Benchmark_SeriesResistance, 1.0,  6.0},
+  {"CC", WriteCommand_ConstantCurrent, Quantity_Current, Benchmark_SeriesResistance, 6.0,  1.0},
+  {"CC", WriteCommand_ConstantCurrent, Quantity_Current, Benchmark_Ideal,            3.05, 0.75}, /* Just within the bound of the DAC first */
+  {"CV", WriteCommand_ConstantVoltage, Quantity_Voltage, Benchmark_SeriesResistance, 4.7,  5.3},
+  {"CV", WriteCommand_ConstantVoltage, Quantity_Voltage, Benchmark_SeriesResistance, 5.3,  4.7},
+  {"CV", WriteCommand_ConstantVoltage, Quantity_Voltage, Benchmark_SeriesResistance, 3.0,  9.0},
+  {"CV", WriteCommand_ConstantVoltage, Quantity_Voltage, Benchmark_SeriesResistance, 9.0,  3.0}
+};
+
+static bool sweep = false; /* I-V sweeps instead of the step responses */
+static bool transfer = false; /* Mode transitions instead of the step responses */
+static bool ranges = false; /* Range switches instead of the step responses */
+static uint32_t plantTime; /* us, the plant has run up to this time (ranges) */
+static bool glitchRecording = false; /* Excursions are recorded (ranges) */
+static Benchmark_Quantities glitchQuantity;
+static double glitchLow, glitchHigh; /* Values before and after the change */
+static double glitchBand; /* Excursion counted in the duration, in the unit of the quantity */
+static double glitchAmplitude; /* Largest excursion, in the unit of the quantity */
+static double glitchOvershoot; /* Largest excursion in the direction of more load, in the unit of the quantity */
+static uint32_t glitchDuration; /* us */
+static const char * const AlgorithmNames[] = {"step", "pi", "feedforward"}; /* Index is Control_Algorithms */
+static int16_t algorithm = -1; /* Control_Algorithms, negative for the firmware default */
+static bool tune = false; /* Auto-tune before the step */
+static const char * const QuantityUnits[] = {"A", "V", "W", "Ohm", "W"};
+static const double QuantityScales[] = {1e6, 1e6, 1e6, 1e3, 1e6}; /* Firmware units (uA, uV, uW, mOhm) per unit */
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Runs one scenario in the present process and prints its row of the table
+ *
+ * @param scenario - pointer to the scenario
+ */
+static void Benchmark_Run(const Benchmark_Scenario * scenario);
+
+/**
+ * Runs one I-V sweep in the present process and prints its row of the table
+ *
+ * @param parameters - pointer to the sweep
+ */
+static void Benchmark_RunSweep(const Benchmark_Sweep * parameters);
+
+/**
+ * Runs one mode transition in the present process and prints its row of the table
+ *
+ * @param parameters - pointer to the transition
+ *
+ * @return - false if a ramp steps by more than one DAC code or the firmware does not start
+ */
+static bool Benchmark_RunTransfer(const Benchmark_Transfer * parameters);
+
+/**
+ * Gets the change of the set quantity of the present phase by one DAC code at the present range
+ *
+ * @return - Current (A) in CC, voltage (V) in CV
+ */
+static double Benchmark_GetDACStep(void);
+
+/**
+ * Runs one range switch in the present process and prints its row of the table
+ *
+ * @param parameters - pointer to the range switch
+ *
+ * @return - false if the change overshoots or the firmware does not start
+ */
+static bool Benchmark_RunRangeSwitch(const Benchmark_RangeSwitch * parameters);
+
+/**
+ * Sets up the firmware and the plant after power-up
+ *
+ * @param source - source connected to the load
+ *
+ * @return - File descriptor of the serial input of the firmware, negative on error
+ */
+static int Benchmark_PowerUp(Benchmark_Sources source);
+
+/**
+ * Runs the firmware and the plant for a time
+ *
+ * @param microseconds - time to run in us
+ * @param quantity - quantity to record
+ * @param samples - array with one sample per pass, NULL if nothing is recorded
+ */
+static void Benchmark_Simulate(uint32_t microseconds, Benchmark_Quantities quantity, double * samples);
+
+/**
+ * Runs the firmware and the plant for a time, the plant follows every change of the outputs (ranges)
+ *
+ * @param microseconds - time to run in us
+ * @param quantity - measured quantity to compare with the values before and after the change
+ * @param error - largest excursion of the published measurements, NULL if not compared
+ * @param published - incremented for every published measurement, NULL if not counted
+ */
+static void Benchmark_SimulateOutputs(uint32_t microseconds, Benchmark_Quantities quantity, double * error, uint16_t * published);
+
+/**
+ * Runs the plant up to the present time in steps of 1 us and records the excursions, output callback of the native HAL (ranges)
+ */
+static void Benchmark_AdvancePlant(void);
+
+/**
+ * Gets the present true value of a quantity
+ *
+ * @param quantity - quantity to get
+ *
+ * @return - Value in the unit of the quantity
+ */
+static double Benchmark_GetQuantity(Benchmark_Quantities quantity);
+
+/**
+ * Sends a write command with 4 data bytes to the firmware
+ *
+ * @param serial - file descriptor of the serial input of the firmware
+ * @param command - write command
+ * @param value - data, sent LSB first
+ */
+static void Benchmark_SendCommand(int serial, Communication_WriteCommands command, uint32_t value);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+int main(int argc, char * argv[])
+{
+  for (int i = 1; i < argc; i++)
+  {
+    bool valid = false;
+    if ((strcmp(argv[i], "tune") == 0) && !tune && !sweep)
+    {
+      tune = true;
+      valid = true;
+    }
+    if ((i == 1) && (argc == 2) && (strcmp(argv[i], "sweep") == 0))
+    {
+      sweep = true;
+      valid = true;
+    }
+    if ((i == 1) && (argc == 2) && (strcmp(argv[i], "transfer") == 0))
+    {
+      transfer = true;
+      valid = true;
+    }
+    if ((i == 1) && (argc == 2) && (strcmp(argv[i], "ranges") == 0))
+    {
+      ranges = true;
+      valid = true;
+    }
+    for (uint8_t j = 0; j < Control_AlgorithmsCount; j++)
+    {
+      if ((i == 1) && (strcmp(argv[i], AlgorithmNames[j]) == 0))
+      {
+        algorithm = j;
+        valid = true;
+      }
+    }
+    if (!valid)
+    {
+      fprintf(stderr, "Usage: %s [step|pi|feedforward] [tune]\n       %s sweep\n       %s transfer\n       %s ranges\n", argv[0], argv[0], argv[0], argv[0]);
+      return 1;
+    }
+  }
+
+  if (sweep)
+  {
+    printf("%-20s %-5s %16s %6s %6s %7s %7s %12s %10s %8s\n", "Source", "Phase", "Range", "Dwell", "Avg", "Points", "Stored", "Duration", "Deviation", "Limited");
+    fflush(stdout);
+    for (uint8_t i = 0; i < BENCHMARK_SWEEP_COUNT; i++)
+    {
+      pid_t child = fork();
+      if (child == 0)
+      {
+        Benchmark_RunSweep(&Sweeps[i]);
+        fflush(stdout);
+        _exit(0);
+      }
+      else if (child < 0)
+      {
+        perror("fork");
+        return 1;
+      }
+      waitpid(child, NULL, 0);
+    }
+    return 0;
+  }
+
+  if (transfer)
+  {
+    int result = 0;
+    printf("%-14s %-20s %12s %12s %10s %9s %7s\n", "Transfer", "Source", "Target", "Settling", "Deviation", "Step", "Codes");
+    fflush(stdout);
+    for (uint8_t i = 0; i < BENCHMARK_TRANSFER_COUNT; i++)
+    {
+      pid_t child = fork();
+      if (child == 0)
+      {
+        bool passed = Benchmark_RunTransfer(&Transfers[i]);
+        fflush(stdout);
+        _exit(passed ? 0 : 1);
+      }
+      else if (child < 0)
+      {
+        perror("fork");
+        return 1;
+      }
+      int status;
+      waitpid(child, &status, 0);
+      if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+      {
+        result = 1;
+      }
+    }
+    return result;
+  }
+
+  if (ranges)
+  {
+    int result = 0;
+    printf("%-6s %-20s %16s %9s %9s %10s %10s %8s\n", "Mode", "Source", "Change", "Glitch", "Overshoot", "Duration", "Measured", "Samples");
+    fflush(stdout);
+    for (uint8_t i = 0; i < BENCHMARK_RANGE_SWITCH_COUNT; i++)
+    {
+      pid_t child = fork();
+      if (child == 0)
+      {
+        bool passed = Benchmark_RunRangeSwitch(&RangeSwitches[i]);
+        fflush(stdout);
+        _exit(passed ? 0 : 1);
+      }
+      else if (child < 0)
+      {
+        perror("fork");
+        return 1;
+      }
+      int status;
+      waitpid(child, &status, 0);
+      if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+      {
+        result = 1;
+      }
+    }
+    return result;
+  }
+
+  printf("%-6s %-20s %12s %12s %10s %9s %9s", "Mode", "Source", "Target", "Settling", "Overshoot", "Ripple", "Error");
+  if (tune)
+  {
+    printf(" %10s %9s", "Source R", "Interval");
+  }
+  printf("\n");
+  fflush(stdout);
+
+  for (uint8_t i = 0; i < BENCHMARK_SCENARIO_COUNT; i++)
+  {
+    /* Every scenario starts from power-up, the firmware keeps its state in static variables */
+    pid_t child = fork();
+    if (child == 0)
+    {
+      Benchmark_Run(&Scenarios[i]);
+      fflush(stdout);
+      _exit(0);
+    }
+    else if (child < 0)
+    {
+      perror("fork");
+      return 1;
+    }
+    waitpid(child, NULL, 0);
+  }
+  return 0;
+}
+
+static void Benchmark_Run(const Benchmark_Scenario * scenario)
+{
+  static double samples[BENCHMARK_SAMPLE_COUNT];
+  int serial = Benchmark_PowerUp(scenario->source);
+
+  if (serial < 0)
+  {
+    return;
+  }
+  if (algorithm >= 0)
+  {
+    Benchmark_SendCommand(serial, WriteCommand_ControlParameter, ControlParameter_Algorithm | ((uint32_t)algorithm << 8));
+  }
+  if (tune)
+  {
+    Benchmark_Simulate(BENCHMARK_IDLE_TIME, scenario->quantity, NULL);
+    Benchmark_SendCommand(serial, scenario->command, (uint32_t)lround(scenario->setValue * QuantityScales[scenario->quantity]));
+    Benchmark_Simulate(BENCHMARK_TUNE_TIME, scenario->quantity, NULL);
+    Benchmark_SendCommand(serial, WriteCommand_AutoTune, AutoTuneCommand_Start);
+    Benchmark_Simulate(BENCHMARK_TUNE_TIME, scenario->quantity, NULL);
+    Benchmark_SendCommand(serial, WriteCommand_ConstantCurrent, 0);
+  }
+  Benchmark_Simulate(BENCHMARK_IDLE_TIME, scenario->quantity, NULL);
+  if (scenario->change != Benchmark_NoChange)
+  {
+    Benchmark_SendCommand(serial, scenario->command, (uint32_t)lround(scenario->setValue * QuantityScales[scenario->quantity]));
+    Benchmark_Simulate(BENCHMARK_CHANGE_TIME, scenario->quantity, NULL);
+    Plant_SetSource(&Sources[scenario->change]);
+  }
+  double target = (scenario->quantity == Quantity_MaximumPower) ? Plant_GetMaximumPower() : scenario->setValue;
+  double initial = Benchmark_GetQuantity(scenario->quantity);
+  if (scenario->change == Benchmark_NoChange)
+  {
+    Benchmark_SendCommand(serial, scenario->command, (uint32_t)lround(scenario->setValue * QuantityScales[scenario->quantity]));
+  }
+  Benchmark_Simulate(BENCHMARK_RUN_TIME, scenario->quantity, samples);
+
+  /* Settling time, overshoot */
+  double direction = (target >= initial) ? 1 : -1;
+  double overshoot = 0;
+  uint32_t lastOutside = 0; /* Number of samples up to and including the last one outside of the band */
+  for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; i++)
+  {
+    if (fabs(samples[i] - target) > BENCHMARK_SETTLING_BAND * target)
+    {
+      lastOutside = i + 1;
+    }
+    if ((samples[i] - target) * direction > overshoot)
+    {
+      overshoot = (samples[i] - target) * direction;
+    }
+  }
+
+  /* Ripple and error in steady state */
+  uint32_t first = BENCHMARK_SAMPLE_COUNT - BENCHMARK_STEADY_STATE_TIME / BENCHMARK_PASS_TIME;
+  double minimum = samples[first], maximum = samples[first], sum = 0;
+  for (uint32_t i = first; i < BENCHMARK_SAMPLE_COUNT; i++)
+  {
+    minimum = fmin(minimum, samples[i]);
+    maximum = fmax(maximum, samples[i]);
+    sum += samples[i];
+  }
+  double mean = sum / (BENCHMARK_SAMPLE_COUNT - first);
+
+  char sourceText[32], targetText[16], settlingText[16];
+  if (scenario->change != Benchmark_NoChange)
+  {
+    snprintf(sourceText, sizeof(sourceText), "> %s", Sources[scenario->change].name);
+  }
+  else
+  {
+    snprintf(sourceText, sizeof(sourceText), "%s", Sources[scenario->source].name);
+  }
+  snprintf(targetText, sizeof(targetText), "%.3f %s", target, QuantityUnits[scenario->quantity]);
+  if (lastOutside < BENCHMARK_SAMPLE_COUNT)
+  {
+    snprintf(settlingText, sizeof(settlingText), "%.2f ms", (lastOutside + 1) * BENCHMARK_PASS_TIME / 1000.0);
+  }
+  else
+  {
+    snprintf(settlingText, sizeof(settlingText), "not settled");
+  }
+  printf("%-6s %-20s %12s %12s %9.2f%% %8.3f%% %8.3f%%", scenario->mode, sourceText, targetText, settlingText,
+         100 * overshoot / target, 100 * (maximum - minimum) / target, 100 * (mean - target) / target);
+  if (tune)
+  {
+    const AutoTune_Result * result = AutoTune_GetResult();
+    if (result->status == AutoTune_Tuned)
+    {
+      printf(" %6.3f Ohm %6u ms", result->sourceResistance / 1000.0, result->updateInterval);
+    }
+    else
+    {
+      printf(" %10s %9s", "failed", "");
+    }
+  }
+  if (scenario->command == WriteCommand_MPPT)
+  {
+    const MPPT_Statistics * mppt = MPPT_GetStatistics();
+    printf("  efficiency %.2f %%, time to MPP ", mppt->efficiency / 100.0);
+    if (mppt->timeToMPP != MPPT_NOT_CONVERGED)
+    {
+      printf("%lu ms", (unsigned long)mppt->timeToMPP);
+    }
+    else
+    {
+      printf("not reached");
+    }
+    printf(", %u scans", mppt->scans);
+  }
+  printf("\n");
+}
+
+static void Benchmark_RunSweep(const Benchmark_Sweep * parameters)
+{
+  int serial = Benchmark_PowerUp(parameters->source);
+  Benchmark_Quantities quantity = (parameters->phase == Control_CCCV_CV) ? Quantity_Voltage : Quantity_Current;
+  uint32_t arguments[SweepArgument_Count];
+
+  if (serial < 0)
+  {
+    return;
+  }
+  arguments[SweepArgument_Phase] = parameters->phase;
+  arguments[SweepArgument_Start] = (uint32_t)lround(parameters->start * QuantityScales[quantity]);
+  arguments[SweepArgument_Stop] = (uint32_t)lround(parameters->stop * QuantityScales[quantity]);
+  arguments[SweepArgument_Points] = parameters->points;
+  arguments[SweepArgument_Dwell] = parameters->dwell;
+  arguments[SweepArgument_Samples] = parameters->samples;
+  arguments[SweepArgument_Abort] = SweepAbort_None;
+  arguments[SweepArgument_Threshold] = 0;
+
+  Benchmark_Simulate(BENCHMARK_IDLE_TIME, quantity, NULL);
+  for (uint8_t i = 0; i < SweepArgument_Count; i++)
+  {
+    Benchmark_SendCommand(serial, WriteCommand_Argument, arguments[i]);
+  }
+  Benchmark_SendCommand(serial, WriteCommand_Sweep, SweepCommand_Start);
+  /* One frame per pass: the start command is dispatched after the arguments */
+  Benchmark_Simulate((SweepArgument_Count + 2) * BENCHMARK_PASS_TIME, quantity, NULL);
+  for (uint32_t t = 0; (t < BENCHMARK_SWEEP_TIMEOUT) && Sweep_IsRunning(); t += BENCHMARK_PASS_TIME)
+  {
+    Benchmark_Simulate(BENCHMARK_PASS_TIME, quantity, NULL);
+  }
+
+  /* Deviation of the phase quantity from the set value, points where the source limits the load are counted apart */
+  const Sweep_State * state = Sweep_GetState();
+  double deviation = 0;
+  uint16_t limited = 0;
+  for (uint16_t i = 0; i < RingBuffer_GetCount(); i++)
+  {
+    const Sweep_Point * point = (const Sweep_Point *)RingBuffer_Get(i);
+    double set = parameters->start + (parameters->stop - parameters->start) * i / (state->points - 1);
+    double measured = ((parameters->phase == Control_CCCV_CV) ? point->voltage : point->current) / QuantityScales[quantity];
+    if (fabs(measured - set) < BENCHMARK_SWEEP_LIMITED * fabs(parameters->stop - parameters->start))
+    {
+      deviation = fmax(deviation, fabs(measured - set));
+    }
+    else
+    {
+      limited++;
+    }
+  }
+
+  char rangeText[24], durationText[16], deviationText[16];
+  snprintf(rangeText, sizeof(rangeText), "%.1f > %.1f %s", parameters->start, parameters->stop, QuantityUnits[quantity]);
+  if (state->status == Sweep_Done)
+  {
+    snprintf(durationText, sizeof(durationText), "%lu ms", (unsigned long)state->duration);
+  }
+  else
+  {
+    snprintf(durationText, sizeof(durationText), "not done");
+  }
+  snprintf(deviationText, sizeof(deviationText), "%.1f m%s", 1000 * deviation, QuantityUnits[quantity]);
+  printf("%-20s %-5s %16s %3lu ms %6u %7u %7u %12s %10s %8u\n", Sources[parameters->source].name, (parameters->phase == Control_CCCV_CV) ? "CV" : "CC",
+         rangeText, (unsigned long)parameters->dwell, parameters->samples, parameters->points, RingBuffer_GetCount(), durationText, deviationText, limited);
+}
+
+static bool Benchmark_RunTransfer(const Benchmark_Transfer * parameters)
+{
+  static double samples[BENCHMARK_SAMPLE_COUNT];
+  int serial = Benchmark_PowerUp(parameters->source);
+
+  if (serial < 0)
+  {
+    return false;
+  }
+  Benchmark_Simulate(BENCHMARK_IDLE_TIME, parameters->fromQuantity, NULL);
+  if (parameters->slewRate > 0)
+  {
+    Control_Parameters slew = ControlParameter_SlewPower;
+    switch (parameters->toCommand)
+    {
+      case WriteCommand_ConstantCurrent:
+        slew = ControlParameter_SlewCurrent;
+      break;
+      case WriteCommand_ConstantVoltage:
+      case WriteCommand_ConstantVoltageSoftware:
+        slew = ControlParameter_SlewVoltage;
+      break;
+      case WriteCommand_ConstantResistanceCC:
+      case WriteCommand_ConstantResistanceCV:
+        slew = ControlParameter_SlewResistance;
+      break;
+      default:
+      break;
+    }
+    Benchmark_SendCommand(serial, WriteCommand_ControlParameter, slew | ((uint32_t)lround(parameters->slewRate * QuantityScales[parameters->toQuantity]) << 8));
+    Benchmark_Simulate(BENCHMARK_PASS_TIME, parameters->fromQuantity, NULL);
+  }
+  Benchmark_SendCommand(serial, parameters->fromCommand, (uint32_t)lround(parameters->fromValue * QuantityScales[parameters->fromQuantity]));
+  Benchmark_Simulate(BENCHMARK_CHANGE_TIME, parameters->fromQuantity, NULL);
+
+  /* The second mode holds the operating point of the first one or ramps from there to its own set value */
+  double target = parameters->toValue;
+  if (parameters->toQuantity == Quantity_MaximumPower)
+  {
+    target = Plant_GetMaximumPower();
+  }
+  else if (target == 0)
+  {
+    target = Benchmark_GetQuantity(parameters->toQuantity);
+  }
+  double current = Plant_GetCurrent();
+  double step = 0;
+  double setQuantities[] = {Plant_GetCurrent(), Plant_GetVoltage()}; /* Index is the phase, Control_CCCV_CC or Control_CCCV_CV */
+  double codes = 0; /* Largest change of the set quantity of the phase in one pass beyond the ramp, in DAC codes */
+  bool hardware = (parameters->toCommand == WriteCommand_ConstantCurrent) || (parameters->toCommand == WriteCommand_ConstantVoltage);
+  double ramp = hardware ? (parameters->slewRate * BENCHMARK_PASS_TIME / 1000) : 0; /* Change of the set quantity in one pass */
+  Control_CCCVStates phase = Control_GetCCCV();
+  double dacStep = Benchmark_GetDACStep();
+  Benchmark_SendCommand(serial, parameters->toCommand, (parameters->toQuantity == Quantity_MaximumPower) ? 0 : (uint32_t)lround(target * QuantityScales[parameters->toQuantity]));
+  for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; i++)
+  {
+    Benchmark_Simulate(BENCHMARK_PASS_TIME, parameters->toQuantity, &samples[i]);
+    step = fmax(step, fabs(Plant_GetCurrent() - current));
+
+    /* A range switch in the pass is counted in the codes of the coarser range */
+    double previousStep = dacStep;
+    dacStep = Benchmark_GetDACStep();
+    double code = (Control_GetCCCV() == phase) ? fmax(dacStep, previousStep) : dacStep;
+    phase = Control_GetCCCV();
+    if (phase == Control_CCCV_CV)
+    {
+      codes = fmax(codes, (fabs(Plant_GetVoltage() - setQuantities[Control_CCCV_CV]) - ramp) / code);
+    }
+    else
+    {
+      codes = fmax(codes, (fabs(Plant_GetCurrent() - setQuantities[Control_CCCV_CC]) - ramp) / code);
+    }
+    setQuantities[Control_CCCV_CC] = Plant_GetCurrent();
+    setQuantities[Control_CCCV_CV] = Plant_GetVoltage();
+  }
+
+  double deviation = 0;
+  uint32_t lastOutside = 0; /* Number of samples up to and including the last one outside of the band */
+  for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; i++)
+  {
+    if (fabs(samples[i] - target) > BENCHMARK_SETTLING_BAND * target)
+    {
+      lastOutside = i + 1;
+    }
+    deviation = fmax(deviation, fabs(samples[i] - target));
+  }
+
+  char transferText[24], targetText[16], settlingText[16];
+  snprintf(transferText, sizeof(transferText), "%s > %s", parameters->fromMode, parameters->toMode);
+  snprintf(targetText, sizeof(targetText), "%.3f %s", target, QuantityUnits[parameters->toQuantity]);
+  if (lastOutside == 0)
+  {
+    snprintf(settlingText, sizeof(settlingText), "0 ms");
+  }
+  else if (lastOutside < BENCHMARK_SAMPLE_COUNT)
+  {
+    snprintf(settlingText, sizeof(settlingText), "%.2f ms", (lastOutside + 1) * BENCHMARK_PASS_TIME / 1000.0);
+  }
+  else
+  {
+    snprintf(settlingText, sizeof(settlingText), "not settled");
+  }
+  bool jump = hardware && (parameters->slewRate > 0) && (codes > 1); /* The software modes step by the noise of their measurements */
+  printf("%-14s %-20s %12s %12s %9.2f%% %8.2f%% %7.2f%s\n", transferText, Sources[parameters->source].name, targetText, settlingText,
+         100 * deviation / target, 100 * step / current, codes, jump ? "  JUMP" : "");
+  return !jump;
+}
+
+static double Benchmark_GetDACStep(void)
+{
+  if (Control_GetCCCV() == Control_CCCV_CV)
+  {
+    return ((RangeSwitcher_GetVoltageRange() == VoltageRange_HighVoltage) ? VOLTSETTER_SLOPE_HI : VOLTSETTER_SLOPE_LO) / 65536e6;
+  }
+  return ((RangeSwitcher_GetCurrentRange() == CurrentRange_HighCurrent) ? CURRENTSETTER_SLOPE_HI : CURRENTSETTER_SLOPE_LO) / 65536e6;
+}
+
+static bool Benchmark_RunRangeSwitch(const Benchmark_RangeSwitch * parameters)
+{
+  int serial = Benchmark_PowerUp(parameters->source);
+  double scale = QuantityScales[parameters->quantity];
+  double error = 0;
+  uint16_t published = 0;
+
+  if (serial < 0)
+  {
+    return false;
+  }
+  HAL_Native_SetI2CClock(BENCHMARK_I2C_CLOCK);
+  HAL_Native_SetOutputCallback(&Benchmark_AdvancePlant);
+  plantTime = HAL_Microseconds();
+  Benchmark_SimulateOutputs(BENCHMARK_IDLE_TIME, parameters->quantity, NULL, NULL);
+  Benchmark_SendCommand(serial, parameters->command, (uint32_t)lround(parameters->fromValue * scale));
+  Benchmark_SimulateOutputs(BENCHMARK_CHANGE_TIME, parameters->quantity, NULL, NULL);
+
+  /* Anything beyond the values before and after the change is the glitch */
+  double initial = Benchmark_GetQuantity(parameters->quantity);
+  glitchQuantity = parameters->quantity;
+  glitchLow = fmin(initial, parameters->toValue);
+  glitchHigh = fmax(initial, parameters->toValue);
+  glitchBand = BENCHMARK_GLITCH_BAND * parameters->toValue;
+  glitchAmplitude = 0;
+  glitchOvershoot = 0;
+  glitchDuration = 0;
+  glitchRecording = true;
+  Benchmark_SendCommand(serial, parameters->command, (uint32_t)lround(parameters->toValue * scale));
+  Benchmark_SimulateOutputs(BENCHMARK_GLITCH_TIME, parameters->quantity, &error, &published);
+  glitchRecording = false;
+
+  char changeText[24];
+  snprintf(changeText, sizeof(changeText), "%.2f > %.2f %s", parameters->fromValue, parameters->toValue, QuantityUnits[parameters->quantity]);
+  bool overshoot = glitchOvershoot > glitchBand;
+  printf("%-6s %-20s %16s %8.2f%% %8.2f%% %7lu us %9.3f%% %8u%s\n", parameters->mode, Sources[parameters->source].name, changeText,
+         100 * glitchAmplitude / parameters->toValue, 100 * glitchOvershoot / parameters->toValue, (unsigned long)glitchDuration,
+         100 * error / parameters->toValue, published, overshoot ? "  OVERSHOOT" : "");
+  return !overshoot;
+}
+
+static int Benchmark_PowerUp(Benchmark_Sources source)
+{
+  int serial[2];
+
+  if (pipe(serial) != 0)
+  {
+    perror("pipe");
+    return -1;
+  }
+  HAL_Native_SetSerialFiles(serial[0], open("/dev/null", O_WRONLY));
+  HAL_Native_UseVirtualClock();
+  Plant_Init(&Sources[source], &FrontEnd, 0x9E3779B97F4A7C15ULL);
+  Devices_Init(&Plant_AnalogInput);
+  HAL_I2CInit();
+  MightyWatt_Init();
+  return serial[1];
+}
+
+static void Benchmark_Simulate(uint32_t microseconds, Benchmark_Quantities quantity, double * samples)
+{
+  for (uint32_t i = 0; i < microseconds / BENCHMARK_PASS_TIME; i++)
+  {
+    Devices_Do();
+    MightyWatt_Do();
+    HAL_Native_AdvanceClock(BENCHMARK_PASS_TIME);
+    Plant_Do(BENCHMARK_PASS_TIME);
+    if (samples != NULL)
+    {
+      samples[i] = Benchmark_GetQuantity(quantity);
+    }
+  }
+}
+
+static void Benchmark_SimulateOutputs(uint32_t microseconds, Benchmark_Quantities quantity, double * error, uint16_t * published)
+{
+  const Measurement_Values * values = Measurement_GetValues();
+  uint32_t end = HAL_Microseconds() + microseconds;
+
+  while ((int32_t)(end - HAL_Microseconds()) > 0)
+  {
+    /* A pass takes BENCHMARK_PASS_TIME or the time of its I2C transactions if longer */
+    uint32_t passStart = HAL_Microseconds();
+    uint8_t counter = values->counter;
+    Devices_Do();
+    MightyWatt_Do();
+    if (HAL_Microseconds() - passStart < BENCHMARK_PASS_TIME)
+    {
+      HAL_Native_AdvanceClock(BENCHMARK_PASS_TIME - (HAL_Microseconds() - passStart));
+    }
+    Benchmark_AdvancePlant();
+
+    if (values->counter != counter)
+    {
+      /* A measurement beyond the values before and after the change comes from a glitch or a conversion across it */
+      double measured = ((quantity == Quantity_Current) ? values->unfilteredCurrent : values->unfilteredVoltage) / QuantityScales[quantity];
+      if (error != NULL)
+      {
+        *error = fmax(*error, fmax(glitchLow - measured, measured - glitchHigh));
+      }
+      if (published != NULL)
+      {
+        (*published)++;
+      }
+    }
+  }
+}
+
+static void Benchmark_AdvancePlant(void)
+{
+  for (uint32_t now = HAL_Microseconds(); plantTime != now; plantTime++)
+  {
+    Plant_Do(1);
+    if (glitchRecording)
+    {
+      double value = Benchmark_GetQuantity(glitchQuantity);
+      double excursion = fmax(glitchLow - value, value - glitchHigh);
+      glitchAmplitude = fmax(glitchAmplitude, excursion);
+      glitchOvershoot = fmax(glitchOvershoot, (glitchQuantity == Quantity_Voltage) ? (glitchLow - value) : (value - glitchHigh));
+      if (excursion > glitchBand)
+      {
+        glitchDuration++;
+      }
+    }
+  }
+}
+
+static double Benchmark_GetQuantity(Benchmark_Quantities quantity)
+{
+  double voltage = Plant_GetVoltage();
+  double current = Plant_GetCurrent();
+  switch (quantity)
+  {
+    case Quantity_Current:
+      return current;
+    case Quantity_Voltage:
+      return voltage;
+    case Quantity_Resistance:
+      /* Limited by the voltmeter input resistance as in Measurement */
+      return (current * VOLTMETER_INPUT_RESISTANCE > voltage * 1000) ? voltage / current : VOLTMETER_INPUT_RESISTANCE / 1000.0;
+    default:
+      return voltage * current;
+  }
+}
+
+static void Benchmark_SendCommand(int serial, Communication_WriteCommands command, uint32_t value)
+{
+  uint8_t frame[COMMUNICATION_PAYLOAD_MAXIMUM_LENGTH + 1];
+  frame[0] = (COMMUNICATION_WRITE << 7) | (3 << 5) | command; /* Write, 4 data bytes */
+  for (uint8_t i = 0; i < COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH; i++)
+  {
+    frame[i + 1] = (value >> (8 * i)) & 0xFF;
+  }
+  uint16_t crc = CRC16(COMMUNICATION_CRC_POLYNOMIAL_VALUE, frame, COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH + 1);
+  frame[COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH + 1] = crc & 0xFF;
+  frame[COMMUNICATION_PAYLOAD_MAXIMUM_DATA_LENGTH + 2] = (crc >> 8) & 0xFF;
+  if (write(serial, frame, sizeof(frame)) != (ssize_t)sizeof(frame))
+  {
+    perror("write");
+  }
+}
+
+/* </Implementations> */
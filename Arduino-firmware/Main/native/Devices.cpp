@@ -0,0 +1,195 @@
+/**
+ * Devices.cpp
+ * Register-level models of the ADS1x15 ADC and the AD569xR DAC for the native build
+ *
+ * 2018-02-24
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "Devices.h"
+#include "HAL_Native.h"
+#include "AD569xR.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define DEVICES_ADS1x15_MUX_MASK            (0b111 << 12)
+#define DEVICES_ADS1x15_PGA(config)         (((config) >> 9) & 0b111)
+#define DEVICES_ADS1x15_DATA_RATE(config)   (((config) >> 5) & 0b111)
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+static Devices_AnalogInput analogInput;
+static uint16_t adsRegisters[4]; /* Indexed by ADS1x15_Registers */
+static uint8_t adsPointer; /* Register addressed by the last write */
+static bool adsConverting;
+static uint32_t adsConversionStart; /* us */
+static uint16_t dacValue;
+
+static const uint16_t adsFullScale[8] = {6144, 4096, 2048, 1024, 512, 256, 256, 256}; /* mV, by PGA setting */
+#ifdef ADC_TYPE_ADS1015
+static const uint16_t adsDataRates[8] = {128, 250, 490, 920, 1600, 2400, 3300, 3300}; /* SPS, by data rate setting */
+#else
+static const uint16_t adsDataRates[8] = {8, 16, 32, 64, 128, 250, 475, 860}; /* SPS, by data rate setting */
+#endif
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * ADS1x15: register pointer write, optionally followed by a 16-bit register value (MSB first)
+ */
+static bool Devices_ADS1x15Write(const uint8_t * data, uint8_t length);
+
+/**
+ * ADS1x15: reads the register selected by the last pointer write (MSB first)
+ */
+static bool Devices_ADS1x15Read(uint8_t * data, uint8_t length);
+
+/**
+ * AD569xR: command byte followed by a 16-bit value (MSB first)
+ */
+static bool Devices_AD569xRWrite(const uint8_t * data, uint8_t length);
+
+/**
+ * ADS1x15: drives the ALERT/RDY pin in the conversion-ready mode used by the firmware
+ *
+ * @param ready - true if a conversion has finished
+ */
+static void Devices_ADS1x15SetReady(bool ready);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Devices_Init(Devices_AnalogInput input)
+{
+  static const HAL_Native_I2CDevice ADS1x15Device = {ADS1x15_ADDRESS, &Devices_ADS1x15Write, &Devices_ADS1x15Read};
+  static const HAL_Native_I2CDevice AD569xRDevice = {AD569xR_ADDRESS, &Devices_AD569xRWrite, NULL};
+
+  analogInput = input;
+  adsRegisters[ADS1x15_ConversionRegister] = 0;
+  adsRegisters[ADS1x15_ConfigRegister] = 0x8583; /* Power-on default */
+  adsRegisters[ADS1x15_LoThresholdRegister] = 0x8000;
+  adsRegisters[ADS1x15_HiThresholdRegister] = 0x7FFF;
+  adsPointer = ADS1x15_ConversionRegister;
+  adsConverting = false;
+  dacValue = 0;
+  Devices_ADS1x15SetReady(false);
+
+  HAL_Native_AttachI2CDevice(&ADS1x15Device);
+  HAL_Native_AttachI2CDevice(&AD569xRDevice);
+}
+
+void Devices_Do(void)
+{
+  if (!adsConverting)
+  {
+    return;
+  }
+
+  uint16_t config = adsRegisters[ADS1x15_ConfigRegister];
+  if ((uint32_t)(HAL_Microseconds() - adsConversionStart) < 1000000UL / adsDataRates[DEVICES_ADS1x15_DATA_RATE(config)])
+  {
+    return;
+  }
+
+  /* Conversion finished, the input is sampled at its end */
+  int64_t result = (int64_t)analogInput((ADS1x15_Inputs)(config & DEVICES_ADS1x15_MUX_MASK)) * 32768 / (adsFullScale[DEVICES_ADS1x15_PGA(config)] * 1000L);
+  if (result > ADS1x15_POSITIVE_OVERLOAD)
+  {
+    result = ADS1x15_POSITIVE_OVERLOAD;
+  }
+  else if (result < ADS1x15_NEGATIVE_OVERLOAD)
+  {
+    result = ADS1x15_NEGATIVE_OVERLOAD;
+  }
+  #ifdef ADC_TYPE_ADS1015
+    result &= ~0x0FL; /* 12-bit result is left-aligned */
+  #endif
+  adsRegisters[ADS1x15_ConversionRegister] = (uint16_t)result;
+  adsRegisters[ADS1x15_ConfigRegister] |= ADS1x15_OS_BEGIN_CONVERSION; /* OS reads 1 when the device is not converting */
+  adsConverting = false;
+  Devices_ADS1x15SetReady(true);
+}
+
+uint16_t Devices_GetDACValue(void)
+{
+  return dacValue;
+}
+
+static bool Devices_ADS1x15Write(const uint8_t * data, uint8_t length)
+{
+  if ((length != 1) && (length != 3))
+  {
+    return false;
+  }
+  adsPointer = data[0] & 0b11;
+  if ((length == 3) && (adsPointer != ADS1x15_ConversionRegister))
+  {
+    uint16_t value = ((uint16_t)data[1] << 8) | data[2];
+    if (adsPointer == ADS1x15_ConfigRegister)
+    {
+      adsRegisters[ADS1x15_ConfigRegister] = value & ~ADS1x15_OS_BEGIN_CONVERSION;
+      if (value & ADS1x15_OS_BEGIN_CONVERSION)
+      {
+        adsConverting = true;
+        adsConversionStart = HAL_Microseconds();
+        Devices_ADS1x15SetReady(false);
+      }
+    }
+    else
+    {
+      adsRegisters[adsPointer] = value;
+    }
+  }
+  return true;
+}
+
+static bool Devices_ADS1x15Read(uint8_t * data, uint8_t length)
+{
+  uint16_t value = adsRegisters[adsPointer];
+  for (uint8_t i = 0; i < length; i++)
+  {
+    data[i] = (i % 2 == 0) ? (uint8_t)(value >> 8) : (uint8_t)(value & 0xFF);
+  }
+  return true;
+}
+
+static bool Devices_AD569xRWrite(const uint8_t * data, uint8_t length)
+{
+  if (length != 3)
+  {
+    return false;
+  }
+  uint16_t value = ((uint16_t)data[1] << 8) | data[2];
+  if (data[0] == AD569xR_WRITE_DAC_AND_INPUT_REGISTERS)
+  {
+    dacValue = value;
+  }
+  else if ((data[0] == AD569xR_WRITE_CONTROL_REGISTER) && (value & AD569xR_RESET))
+  {
+    dacValue = 0; /* Power-on reset to zero scale */
+  }
+  return true;
+}
+
+static void Devices_ADS1x15SetReady(bool ready)
+{
+  bool activeHigh = (adsRegisters[ADS1x15_ConfigRegister] & ADS1x15_COMP_POL_HIGH) != 0;
+  HAL_Native_SetPin(ADS1x15_READY_PIN, ready == activeHigh);
+}
+
+/* </Implementations> */
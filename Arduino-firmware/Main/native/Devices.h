@@ -0,0 +1,62 @@
+/**
+ * Devices.h
+ * Register-level models of the ADS1x15 ADC and the AD569xR DAC for the native build
+ *
+ * 2018-02-24
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The models answer the I2C transactions of the firmware drivers and drive the ALERT/RDY pin.
+ * The analog side is a function that returns the ADC input voltage of a multiplexer setting,
+ * so that the executable decides what is connected to the load.
+ */
+
+#ifndef DEVICES_H
+#define DEVICES_H
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "ADS1x15.h"
+
+/* </Includes> */
+
+
+/* <Structs> */
+
+/**
+ * ADC input voltage of a multiplexer setting
+ *
+ * @param input - multiplexer setting of the conversion
+ *
+ * @return - Differential input voltage in uV
+ */
+typedef int32_t (* Devices_AnalogInput)(ADS1x15_Inputs input);
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Initializes the models and attaches them to the I2C bus
+ *
+ * @param analogInput - function that returns the ADC input voltages
+ */
+void Devices_Init(Devices_AnalogInput analogInput);
+
+/**
+ * Finishes the conversion in progress when its time has elapsed, call before each MightyWatt_Do
+ */
+void Devices_Do(void);
+
+/**
+ * Gets the present DAC output code
+ *
+ * @return - DAC code, 0 to AD569xR_MAXIMUM_VALUE
+ */
+uint16_t Devices_GetDACValue(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* DEVICES_H */
@@ -0,0 +1,413 @@
+/**
+ * HAL_Native.cpp
+ * Hardware abstraction layer, native Linux back end
+ *
+ * 2018-02-24
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "HAL_Native.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* </Includes> */
+
+
+/* <Module variables> */
+
+static int serialInput = STDIN_FILENO;
+static int serialOutput = STDOUT_FILENO;
+static bool pinLevels[HAL_NATIVE_PIN_COUNT];
+static HAL_PinModes pinModes[HAL_NATIVE_PIN_COUNT];
+static uint8_t pwmDuties[HAL_NATIVE_PIN_COUNT];
+static const HAL_Native_I2CDevice * i2cDevices[HAL_NATIVE_I2C_DEVICE_COUNT];
+static uint8_t i2cDeviceCount = 0;
+static bool virtualClock = false;
+static uint64_t virtualTime = 0; /* us */
+static void (* timerCallback)(void) = NULL;
+static uint64_t timerDue; /* us, time of the next callback */
+static uint32_t timerNextPeriod; /* us, period that starts with the next callback */
+static uint32_t i2cClock = 0; /* Hz, 0 if the transactions take no time */
+static bool i2cBusy = false; /* A transaction is in progress, the timer callbacks are held back */
+static bool timerRunning = false; /* A callback runs, its transactions do not start the next one */
+static void (* outputCallback)(void) = NULL;
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Gets the time elapsed since the first call
+ *
+ * @return - Elapsed time in us (64 bits, does not wrap)
+ */
+static uint64_t HAL_Native_Elapsed(void);
+
+/**
+ * Finds the attached device model with the address
+ *
+ * @param address - 7-bit slave address
+ *
+ * @return - Pointer to the device model or NULL if no device acknowledges the address
+ */
+static const HAL_Native_I2CDevice * HAL_Native_FindI2CDevice(uint8_t address);
+
+/**
+ * Advances the virtual clock by a number of I2C bits, the timer callbacks are not run
+ *
+ * @param bits - number of SCL periods
+ */
+static void HAL_Native_I2CWait(uint16_t bits);
+
+/**
+ * Notifies the simulator that an output is about to change
+ */
+static void HAL_Native_OutputChanging(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+uint32_t HAL_Milliseconds(void)
+{
+  return (uint32_t)(HAL_Native_Elapsed() / 1000);
+}
+
+uint32_t HAL_Microseconds(void)
+{
+  return (uint32_t)HAL_Native_Elapsed();
+}
+
+void HAL_TimerStart(uint32_t period, void (* callback)(void))
+{
+  timerCallback = callback;
+  timerNextPeriod = period;
+  timerDue = HAL_Native_Elapsed() + period;
+}
+
+void HAL_TimerSetPeriod(uint32_t period)
+{
+  timerNextPeriod = period;
+}
+
+void HAL_TimerStop(void)
+{
+  timerCallback = NULL;
+}
+
+void HAL_DisableInterrupts(void)
+{
+  /* The callbacks run between the passes of the main loop, nothing to disable */
+}
+
+void HAL_EnableInterrupts(void)
+{
+}
+
+void HAL_PinMode(uint8_t pin, HAL_PinModes mode)
+{
+  if (pin < HAL_NATIVE_PIN_COUNT)
+  {
+    pinModes[pin] = mode;
+  }
+}
+
+void HAL_DigitalWrite(uint8_t pin, bool high)
+{
+  if (pin < HAL_NATIVE_PIN_COUNT)
+  {
+    HAL_Native_OutputChanging();
+    pinLevels[pin] = high;
+    pwmDuties[pin] = high ? 255 : 0;
+  }
+}
+
+bool HAL_DigitalRead(uint8_t pin)
+{
+  return HAL_Native_GetPin(pin);
+}
+
+void HAL_PWMWrite(uint8_t pin, uint8_t duty)
+{
+  if (pin < HAL_NATIVE_PIN_COUNT)
+  {
+    HAL_Native_OutputChanging();
+    pwmDuties[pin] = duty;
+    pinLevels[pin] = duty >= 128;
+  }
+}
+
+void HAL_I2CInit(void)
+{
+  /* Device models are attached by the executable */
+}
+
+void HAL_I2CReserve(uint8_t length)
+{
+  if ((timerCallback == NULL) || timerRunning || !virtualClock || (i2cClock == 0))
+  {
+    return;
+  }
+  uint64_t end = virtualTime + (((uint64_t)length + 2) * HAL_NATIVE_I2C_BITS_PER_BYTE * 1000000ULL + i2cClock - 1) / i2cClock; /* Data, address, start and stop */
+  if (timerDue < end)
+  {
+    /* The main loop waits for the callback */
+    if (timerDue > virtualTime)
+    {
+      virtualTime = timerDue;
+    }
+    HAL_Native_RunTimer();
+  }
+}
+
+bool HAL_I2CWrite(uint8_t address, const uint8_t * data, uint8_t length)
+{
+  const HAL_Native_I2CDevice * device = HAL_Native_FindI2CDevice(address);
+  bool result;
+  if ((device == NULL) || (device->write == NULL))
+  {
+    return false;
+  }
+  HAL_I2CReserve(length);
+  i2cBusy = true;
+  HAL_Native_I2CWait((length + 1) * HAL_NATIVE_I2C_BITS_PER_BYTE); /* Address and data, the slave takes the data at the last acknowledge */
+  HAL_Native_OutputChanging();
+  result = device->write(data, length);
+  HAL_Native_I2CWait(1); /* Stop condition */
+  i2cBusy = false;
+  HAL_Native_RunTimer(); /* Held back callbacks */
+  return result;
+}
+
+bool HAL_I2CRead(uint8_t address, uint8_t * data, uint8_t length)
+{
+  const HAL_Native_I2CDevice * device = HAL_Native_FindI2CDevice(address);
+  bool result;
+  if ((device == NULL) || (device->read == NULL))
+  {
+    return false;
+  }
+  HAL_I2CReserve(length);
+  i2cBusy = true;
+  result = device->read(data, length);
+  HAL_Native_I2CWait((length + 1) * HAL_NATIVE_I2C_BITS_PER_BYTE + 1); /* Address, data and stop condition */
+  i2cBusy = false;
+  HAL_Native_RunTimer();
+  return result;
+}
+
+void HAL_SerialInit(uint32_t baudrate)
+{
+  (void)baudrate; /* Not used, the stream is a file */
+  fcntl(serialInput, F_SETFL, fcntl(serialInput, F_GETFL) | O_NONBLOCK);
+  if (isatty(serialInput))
+  {
+    /* Binary protocol, no line buffering or character translation */
+    struct termios settings;
+    tcgetattr(serialInput, &settings);
+    cfmakeraw(&settings);
+    if (serialInput == STDIN_FILENO)
+    {
+      settings.c_lflag |= ISIG; /* Keep Ctrl+C working on the console */
+    }
+    tcsetattr(serialInput, TCSANOW, &settings);
+  }
+}
+
+int16_t HAL_SerialAvailable(void)
+{
+  int available = 0;
+  if (ioctl(serialInput, FIONREAD, &available) < 0)
+  {
+    return 0;
+  }
+  return (available > 0x7FFF) ? 0x7FFF : (int16_t)available;
+}
+
+int16_t HAL_SerialRead(void)
+{
+  uint8_t value;
+  if (read(serialInput, &value, 1) == 1)
+  {
+    return value;
+  }
+  return -1;
+}
+
+void HAL_SerialWriteByte(uint8_t value)
+{
+  HAL_SerialWrite(&value, 1);
+}
+
+void HAL_SerialWrite(const uint8_t * data, uint16_t length)
+{
+  while (length > 0)
+  {
+    ssize_t written = write(serialOutput, data, length);
+    if (written > 0)
+    {
+      data += written;
+      length -= (uint16_t)written;
+    }
+    else if ((written < 0) && (errno != EAGAIN) && (errno != EINTR))
+    {
+      return; /* Stream closed, the bytes are lost as on a disconnected port */
+    }
+  }
+}
+
+void HAL_Native_SetSerialFiles(int input, int output)
+{
+  serialInput = input;
+  serialOutput = output;
+}
+
+void HAL_Native_UseVirtualClock(void)
+{
+  virtualTime = HAL_Native_Elapsed();
+  virtualClock = true;
+}
+
+void HAL_Native_AdvanceClock(uint32_t microseconds)
+{
+  uint64_t end = virtualTime + microseconds;
+
+  /* Every callback sees the clock at its own time */
+  while ((timerCallback != NULL) && (timerDue <= end))
+  {
+    if (timerDue > virtualTime)
+    {
+      virtualTime = timerDue;
+    }
+    HAL_Native_RunTimer();
+  }
+  if (end > virtualTime) /* The clock may have passed the end in an I2C transaction */
+  {
+    virtualTime = end;
+  }
+}
+
+void HAL_Native_SetI2CClock(uint32_t frequency)
+{
+  i2cClock = frequency;
+}
+
+void HAL_Native_SetOutputCallback(void (* callback)(void))
+{
+  outputCallback = callback;
+}
+
+void HAL_Native_RunTimer(void)
+{
+  while ((timerCallback != NULL) && !i2cBusy && !timerRunning && (HAL_Native_Elapsed() >= timerDue))
+  {
+    timerDue += timerNextPeriod;
+    timerRunning = true;
+    timerCallback(); /* May stop the timer or set the next period */
+    timerRunning = false;
+  }
+}
+
+bool HAL_Native_AttachI2CDevice(const HAL_Native_I2CDevice * device)
+{
+  if ((i2cDeviceCount >= HAL_NATIVE_I2C_DEVICE_COUNT) || (HAL_Native_FindI2CDevice(device->address) != NULL))
+  {
+    return false;
+  }
+  i2cDevices[i2cDeviceCount++] = device;
+  return true;
+}
+
+void HAL_Native_SetPin(uint8_t pin, bool high)
+{
+  if (pin < HAL_NATIVE_PIN_COUNT)
+  {
+    pinLevels[pin] = high;
+  }
+}
+
+bool HAL_Native_GetPin(uint8_t pin)
+{
+  if (pin < HAL_NATIVE_PIN_COUNT)
+  {
+    return pinLevels[pin];
+  }
+  return false;
+}
+
+HAL_PinModes HAL_Native_GetPinMode(uint8_t pin)
+{
+  if (pin < HAL_NATIVE_PIN_COUNT)
+  {
+    return pinModes[pin];
+  }
+  return HAL_Input;
+}
+
+uint8_t HAL_Native_GetPWM(uint8_t pin)
+{
+  if (pin < HAL_NATIVE_PIN_COUNT)
+  {
+    return pwmDuties[pin];
+  }
+  return 0;
+}
+
+static uint64_t HAL_Native_Elapsed(void)
+{
+  static struct timespec start;
+  static bool started = false;
+  struct timespec now;
+
+  if (virtualClock)
+  {
+    return virtualTime;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (!started)
+  {
+    start = now;
+    started = true;
+  }
+  return (uint64_t)(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+static const HAL_Native_I2CDevice * HAL_Native_FindI2CDevice(uint8_t address)
+{
+  for (uint8_t i = 0; i < i2cDeviceCount; i++)
+  {
+    if (i2cDevices[i]->address == address)
+    {
+      return i2cDevices[i];
+    }
+  }
+  return NULL;
+}
+
+static void HAL_Native_I2CWait(uint16_t bits)
+{
+  if (virtualClock && (i2cClock > 0))
+  {
+    virtualTime += ((uint64_t)bits * 1000000ULL + i2cClock / 2) / i2cClock;
+  }
+}
+
+static void HAL_Native_OutputChanging(void)
+{
+  if (outputCallback != NULL)
+  {
+    outputCallback();
+  }
+}
+
+/* </Implementations> */
@@ -0,0 +1,148 @@
+/**
+ * HAL_Native.h
+ * Hardware abstraction layer, native Linux back end
+ *
+ * 2018-02-24
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * Implements HAL.h on a PC: the clock is the monotonic system clock or a virtual clock advanced
+ * by a simulator, the serial stream is a pair of file descriptors (stdin/stdout or a pseudo-terminal),
+ * pins and PWM outputs are kept in memory and I2C transactions are routed to device models attached
+ * by the executable. The timer interrupt is emulated between the passes of the main loop.
+ * On the virtual clock, I2C transactions can optionally take the time of their bits, so that a simulator
+ * sees the outputs change in the order and at the time the firmware changes them within a pass.
+ */
+
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+/* <Includes> */
+
+#include "HAL.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define HAL_NATIVE_PIN_COUNT                 20 /* Digital pins 0-13 and analog pins A0-A5 of the Arduino header */
+#define HAL_NATIVE_I2C_DEVICE_COUNT          4 /* Maximum number of attached I2C device models */
+#define HAL_NATIVE_I2C_BITS_PER_BYTE         9 /* 8 data bits and the acknowledge */
+
+/* </Defines> */
+
+
+/* <Structs> */
+
+/**
+ * Model of an I2C slave, the functions return false for NACK
+ */
+struct HAL_Native_I2CDevice
+{
+  uint8_t address; /* 7-bit slave address */
+  bool (* write)(const uint8_t * data, uint8_t length); /* Master writes bytes to the slave */
+  bool (* read)(uint8_t * data, uint8_t length); /* Master reads bytes from the slave */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Selects the file descriptors of the serial stream, stdin and stdout by default
+ * Must be called before HAL_SerialInit
+ *
+ * @param input - file descriptor from which the received bytes are read
+ * @param output - file descriptor to which the sent bytes are written
+ */
+void HAL_Native_SetSerialFiles(int input, int output);
+
+/**
+ * Stops the clock, from now on it only advances with HAL_Native_AdvanceClock
+ * Simulations are then deterministic and independent of the speed of the PC
+ */
+void HAL_Native_UseVirtualClock(void);
+
+/**
+ * Advances the virtual clock
+ *
+ * The timer callbacks that fall into the time run at their own time.
+ *
+ * @param microseconds - time to add in us
+ */
+void HAL_Native_AdvanceClock(uint32_t microseconds);
+
+/**
+ * Sets the clock of the I2C bus on the virtual clock
+ *
+ * A transaction advances the clock by its address and data bytes, the slave takes the data at the acknowledge
+ * of the last byte and the stop condition takes one more bit. The timer callbacks that fall into a transaction
+ * are held back until its end, as on the target.
+ *
+ * @param frequency - SCL frequency in Hz, 0 for transactions that take no time (default)
+ */
+void HAL_Native_SetI2CClock(uint32_t frequency);
+
+/**
+ * Sets a function that is called right before an output changes: pin level, PWM duty or I2C data taken by a slave
+ * A simulator advances its model up to the present time there, with the outputs still at their previous state
+ *
+ * @param callback - function to call, NULL for none (default)
+ */
+void HAL_Native_SetOutputCallback(void (* callback)(void));
+
+/**
+ * Runs the timer callbacks that are due, stands in for the timer interrupt on the system clock
+ * Must be called on every pass of the main loop
+ */
+void HAL_Native_RunTimer(void);
+
+/**
+ * Attaches an I2C device model to the bus
+ *
+ * @param device - pointer to the device model, must exist for the whole run
+ *
+ * @return - false if the bus is full or the address is taken
+ */
+bool HAL_Native_AttachI2CDevice(const HAL_Native_I2CDevice * device);
+
+/**
+ * Sets the level of a pin from outside, as an external circuit would drive it
+ *
+ * @param pin - Arduino pin number
+ * @param high - true for logical high, false for logical low
+ */
+void HAL_Native_SetPin(uint8_t pin, bool high);
+
+/**
+ * Gets the level of a pin
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - true if the pin is high, false if low or if the pin does not exist
+ */
+bool HAL_Native_GetPin(uint8_t pin);
+
+/**
+ * Gets the direction of a pin
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - HAL_Input or HAL_Output
+ */
+HAL_PinModes HAL_Native_GetPinMode(uint8_t pin);
+
+/**
+ * Gets the duty cycle of a PWM output
+ *
+ * @param pin - Arduino pin number
+ *
+ * @return - Duty cycle, 0 is always low, 255 is always high
+ */
+uint8_t HAL_Native_GetPWM(uint8_t pin);
+
+/* </Declarations (prototypes)> */
+
+#endif /* HAL_NATIVE_H */
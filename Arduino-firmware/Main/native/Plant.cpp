@@ -0,0 +1,289 @@
+/**
+ * Plant.cpp
+ * Models of the source under test and of the analog front end of the load for closed-loop simulation
+ *
+ * 2018-02-25
+ * kaktus circuits
+ * GNU GPL v.3
+ */
+
+
+/* <Includes> */
+
+#include "Plant.h"
+#include "HAL_Native.h"
+#include "Devices.h"
+#include "ADC.h"
+#include "DACC.h"
+#include "Control.h"
+#include "CurrentSetter.h"
+#include "RangeSwitcher.h"
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define PLANT_MAXIMUM_CURRENT               (CURRENT_SETTER_MAXIMUM_HICURRENT / 1e6) /* A, largest current the load can sink */
+#define PLANT_CURRENT_LIMIT_SLOPE           1000.0 /* Ohm, output resistance of a power supply in current limit */
+#define PLANT_SOLVER_ITERATIONS             48 /* Bisection steps of the operating point, resolution far below the DAC LSB */
+#define PLANT_THERMISTOR_VOLTAGE            622000L /* uV, thermistor at 25 degC */
+#define PLANT_MPP_STEPS                     2000 /* Points of the power curve scanned for the maximum */
+#define PLANT_BYPASS_VOLTAGE                0.5 /* V, forward voltage of a PV bypass diode */
+
+/* </Defines> */
+
+
+/* <Module variables> */
+
+static const Plant_Source * source;
+static const Plant_FrontEnd * frontEnd;
+static double current; /* A */
+static double rcVoltage; /* V, battery RC pair */
+static uint64_t randomState;
+
+/* </Module variables> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Terminal voltage of the source at a load current, in the present state of the source
+ *
+ * @param load - load current in A
+ *
+ * @return - Terminal voltage in V, negative if the source cannot deliver the current
+ */
+static double Plant_SourceVoltage(double load);
+
+/**
+ * Terminal voltage of a part of the cells of a PV panel with its bypass diode
+ *
+ * @param load - load current in A
+ * @param photocurrent - photocurrent of the cells in A
+ * @param fraction - part of the cells
+ *
+ * @return - Voltage in V, the negative forward voltage of the bypass diode above the photocurrent
+ */
+static double Plant_CellsVoltage(double load, double photocurrent, double fraction);
+
+/**
+ * Finds the current at which the terminal voltage equals the requested voltage
+ *
+ * @param voltage - terminal voltage in V
+ * @param maximum - largest current considered in A
+ *
+ * @return - Current in A, 0 or maximum if the voltage is outside the range of the source
+ */
+static double Plant_SolveCurrent(double voltage, double maximum);
+
+/**
+ * Gaussian noise with zero mean and unit standard deviation
+ */
+static double Plant_Noise(void);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+void Plant_Init(const Plant_Source * plantSource, const Plant_FrontEnd * plantFrontEnd, uint64_t seed)
+{
+  source = plantSource;
+  frontEnd = plantFrontEnd;
+  current = 0;
+  rcVoltage = 0;
+  randomState = seed;
+}
+
+void Plant_SetSource(const Plant_Source * plantSource)
+{
+  source = plantSource;
+}
+
+void Plant_Do(uint32_t microseconds)
+{
+  double dt = microseconds / 1e6;
+  uint16_t dac = Devices_GetDACValue();
+  double target; /* Current that the load regulates to, A */
+  double timeConstant;
+
+  if (HAL_Native_GetPin(CONTROL_CCCV_PIN)) /* CV phase */
+  {
+    bool lowRange = HAL_Native_GetPin(VOLTAGE_GAIN_PIN);
+    double setVoltage = (((double)dac * (lowRange ? VOLTSETTER_SLOPE_LO : VOLTSETTER_SLOPE_HI)) / 65536 - (lowRange ? VOLTSETTER_OFFSET_LO : VOLTSETTER_OFFSET_HI)) / 1e6;
+    target = Plant_SolveCurrent(setVoltage, PLANT_MAXIMUM_CURRENT);
+    timeConstant = frontEnd->cvTimeConstant;
+  }
+  else /* CC phase */
+  {
+    bool lowRange = HAL_Native_GetPin(CURRENT_GAIN_PIN);
+    target = (((double)dac * (lowRange ? CURRENTSETTER_SLOPE_LO : CURRENTSETTER_SLOPE_HI)) / 65536 - (lowRange ? CURRENTSETTER_OFFSET_LO : CURRENTSETTER_OFFSET_HI)) / 1e6;
+    if (target < 0)
+    {
+      target = 0;
+    }
+    else if (target > PLANT_MAXIMUM_CURRENT)
+    {
+      target = PLANT_MAXIMUM_CURRENT;
+    }
+    if (Plant_SourceVoltage(target) < 0) /* The transistor is fully open, the source sets the current */
+    {
+      target = Plant_SolveCurrent(0, target);
+    }
+    timeConstant = frontEnd->ccTimeConstant;
+  }
+
+  current += (target - current) * (1 - exp(-dt / timeConstant));
+
+  if (source->type == Source_Battery)
+  {
+    double tau = source->rcResistance * source->rcCapacitance;
+    double steadyState = current * source->rcResistance;
+    rcVoltage = steadyState + (rcVoltage - steadyState) * exp(-dt / tau);
+  }
+}
+
+int32_t Plant_AnalogInput(ADS1x15_Inputs input)
+{
+  double sense; /* uV at the ADC input */
+  switch (input)
+  {
+    case ADC_V_CHANNEL:
+    {
+      bool lowRange = HAL_Native_GetPin(VOLTAGE_GAIN_PIN);
+      double voltage = (Plant_GetVoltage() + frontEnd->voltageNoise * Plant_Noise()) * 1e6;
+      sense = (voltage - (lowRange ? VOLTMETER_OFFSET_LO : VOLTMETER_OFFSET_HI)) * (DAC_REFERENCE_VOLTAGE * 1000.0) / (lowRange ? VOLTMETER_SLOPE_LO : VOLTMETER_SLOPE_HI);
+      break;
+    }
+    case ADC_I_CHANNEL:
+    {
+      bool lowRange = HAL_Native_GetPin(CURRENT_GAIN_PIN);
+      double load = (current + frontEnd->currentNoise * Plant_Noise()) * 1e6;
+      sense = (load - (lowRange ? AMMETER_OFFSET_LO : AMMETER_OFFSET_HI)) * (DAC_REFERENCE_VOLTAGE * 1000.0) / (lowRange ? AMMETER_SLOPE_LO : AMMETER_SLOPE_HI);
+      break;
+    }
+    case ADC_T_CHANNEL:
+      return PLANT_THERMISTOR_VOLTAGE;
+    default:
+      return 0;
+  }
+  return (int32_t)lround(sense);
+}
+
+double Plant_GetVoltage(void)
+{
+  double voltage = Plant_SourceVoltage(current);
+  return (voltage > 0) ? voltage : 0;
+}
+
+double Plant_GetCurrent(void)
+{
+  return current;
+}
+
+double Plant_GetMaximumPower(void)
+{
+  double maximum = 0;
+  double shortCircuit = Plant_SolveCurrent(0, PLANT_MAXIMUM_CURRENT);
+  for (uint16_t i = 1; i <= PLANT_MPP_STEPS; i++)
+  {
+    double load = shortCircuit * i / PLANT_MPP_STEPS;
+    double power = load * Plant_SourceVoltage(load);
+    if (power > maximum)
+    {
+      maximum = power;
+    }
+  }
+  return maximum;
+}
+
+static double Plant_SourceVoltage(double load)
+{
+  switch (source->type)
+  {
+    case Source_Ideal:
+      return source->voltage;
+    case Source_SeriesResistance:
+      return source->voltage - load * source->resistance;
+    case Source_PV:
+      if (source->shadedFraction <= 0)
+      {
+        double diodeCurrent = source->current - load;
+        if (diodeCurrent <= -source->diodeSaturationCurrent)
+        {
+          return -1; /* Beyond short circuit */
+        }
+        return source->diodeThermalVoltage * log(diodeCurrent / source->diodeSaturationCurrent + 1) - load * source->resistance;
+      }
+      if ((load >= source->current) && (load >= source->shadedCurrent))
+      {
+        return -1; /* Beyond short circuit of both parts */
+      }
+      return Plant_CellsVoltage(load, source->current, 1 - source->shadedFraction) + Plant_CellsVoltage(load, source->shadedCurrent, source->shadedFraction) - load * source->resistance;
+    case Source_Battery:
+      return source->voltage - load * source->resistance - rcVoltage;
+    case Source_CurrentLimited:
+      if (load <= source->current)
+      {
+        return source->voltage - load * source->resistance;
+      }
+      return source->voltage - load * source->resistance - (load - source->current) * PLANT_CURRENT_LIMIT_SLOPE;
+    default:
+      return 0;
+  }
+}
+
+static double Plant_CellsVoltage(double load, double photocurrent, double fraction)
+{
+  double diodeCurrent = photocurrent - load;
+  double voltage = -PLANT_BYPASS_VOLTAGE;
+  if (diodeCurrent > -source->diodeSaturationCurrent)
+  {
+    voltage = fraction * source->diodeThermalVoltage * log(diodeCurrent / source->diodeSaturationCurrent + 1);
+  }
+  return (voltage > -PLANT_BYPASS_VOLTAGE) ? voltage : -PLANT_BYPASS_VOLTAGE;
+}
+
+static double Plant_SolveCurrent(double voltage, double maximum)
+{
+  if (Plant_SourceVoltage(0) <= voltage)
+  {
+    return 0;
+  }
+  if (Plant_SourceVoltage(maximum) >= voltage)
+  {
+    return maximum;
+  }
+
+  double low = 0, high = maximum;
+  for (uint8_t i = 0; i < PLANT_SOLVER_ITERATIONS; i++)
+  {
+    double middle = (low + high) / 2;
+    if (Plant_SourceVoltage(middle) > voltage)
+    {
+      low = middle;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return (low + high) / 2;
+}
+
+static double Plant_Noise(void)
+{
+  /* xorshift64* and the Box-Muller transform, reproducible for a given seed */
+  double uniform[2];
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    uniform[i] = ((randomState * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+  }
+  return sqrt(-2 * log(uniform[0] + 1e-300)) * cos(2 * M_PI * uniform[1]);
+}
+
+/* </Implementations> */
@@ -0,0 +1,136 @@
+/**
+ * Plant.h
+ * Models of the source under test and of the analog front end of the load for closed-loop simulation
+ *
+ * 2018-02-25
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * The source is a terminal characteristic V(I), decreasing in I, with optional internal state (battery RC).
+ * The load sinks the current requested by the DAC in CC phase or the current that brings the terminal
+ * voltage to the DAC value in CV phase, both through a first-order lag. The DAC and range pins are read
+ * from the native HAL, the terminal voltage and current are returned to the ADC model as the sense voltages
+ * that the calibration constants imply, with gaussian noise. Quantisation happens in the ADC and DAC models.
+ * Plant quantities are in SI units (V, A, Ohm, F, s).
+ */
+
+#ifndef PLANT_H
+#define PLANT_H
+
+/* <Includes> */
+
+#include "HAL.h"
+#include "ADS1x15.h"
+
+/* </Includes> */
+
+
+/* <Enums> */
+
+/**
+ * Source models
+ */
+enum Plant_SourceTypes : uint8_t
+{
+  Source_Ideal, /* Ideal voltage source */
+  Source_SeriesResistance, /* Voltage source with series resistance */
+  Source_PV, /* Photovoltaic panel, single-diode model, optionally with a shaded part of the cells */
+  Source_Battery, /* Battery, open-circuit voltage with series resistance and one RC pair */
+  Source_CurrentLimited /* Laboratory power supply with current limit */
+};
+
+/* </Enums> */
+
+
+/* <Structs> */
+
+/**
+ * Parameters of the source, the meaning of the fields depends on the type
+ */
+struct Plant_Source
+{
+  Plant_SourceTypes type;
+  const char * name; /* Short description for reports */
+  double voltage; /* Source voltage; battery open-circuit voltage; not used by PV */
+  double resistance; /* Series resistance; battery R0; power supply output resistance */
+  double current; /* PV photocurrent; power supply current limit */
+  double diodeSaturationCurrent; /* PV: I0 */
+  double diodeThermalVoltage; /* PV: n * cells * kT/q */
+  double rcResistance; /* Battery: R1 of the RC pair */
+  double rcCapacitance; /* Battery: C1 of the RC pair */
+  double shadedCurrent; /* PV: photocurrent of the shaded cells */
+  double shadedFraction; /* PV: part of the cells that is shaded, the shaded and the unshaded cells have a bypass diode each */
+};
+
+/**
+ * Non-idealities of the analog front end of the load
+ */
+struct Plant_FrontEnd
+{
+  double voltageNoise; /* Voltage sense noise, V rms referred to the terminals */
+  double currentNoise; /* Current sense noise, A rms referred to the terminals */
+  double ccTimeConstant; /* Response of the current to the DAC in CC phase, s */
+  double cvTimeConstant; /* Response of the current to the DAC in CV phase, s */
+};
+
+/* </Structs> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * Connects the source to the load, load current is zero
+ *
+ * @param source - pointer to the source parameters, must exist for the whole run
+ * @param frontEnd - pointer to the front end parameters, must exist for the whole run
+ * @param seed - seed of the noise generator, non-zero
+ */
+void Plant_Init(const Plant_Source * source, const Plant_FrontEnd * frontEnd, uint64_t seed);
+
+/**
+ * Replaces the source while the load runs (change of irradiance or shading), the state of the load is kept
+ *
+ * @param source - pointer to the new source parameters, must exist for the whole run
+ */
+void Plant_SetSource(const Plant_Source * source);
+
+/**
+ * Advances the plant, the DAC value and pins are taken as constant during the step
+ *
+ * @param microseconds - length of the step in us
+ */
+void Plant_Do(uint32_t microseconds);
+
+/**
+ * ADC input voltage, to be passed to Devices_Init
+ *
+ * @param input - multiplexer setting of the conversion
+ *
+ * @return - Input voltage in uV
+ */
+int32_t Plant_AnalogInput(ADS1x15_Inputs input);
+
+/**
+ * Gets the true terminal voltage
+ *
+ * @return - Voltage in V
+ */
+double Plant_GetVoltage(void);
+
+/**
+ * Gets the true load current
+ *
+ * @return - Current in A
+ */
+double Plant_GetCurrent(void);
+
+/**
+ * Gets the largest power the source can deliver to the load in its present state
+ *
+ * @return - Power in W
+ */
+double Plant_GetMaximumPower(void);
+
+/* </Declarations (prototypes)> */
+
+#endif /* PLANT_H */
@@ -0,0 +1,85 @@
+/**
+ * main.cpp
+ * Native executable: runs the firmware on a PC with modelled ADC and DAC
+ *
+ * 2018-02-24
+ * kaktus circuits
+ * GNU GPL v.3
+ *
+ * Usage: mightywatt-native [serial device]
+ * Without a device, the protocol runs over stdin/stdout. A pseudo-terminal pair such as
+ * "socat -d -d pty,raw,echo=0 pty,raw,echo=0" lets the PC application connect to the native firmware.
+ * The load input is open: no voltage, no current and the heatsink at 25 degC.
+ */
+
+
+/* <Includes> */
+
+#include "MightyWatt.h"
+#include "HAL_Native.h"
+#include "Devices.h"
+#include "ADC.h"
+#include <fcntl.h>
+#include <stdio.h>
+
+/* </Includes> */
+
+
+/* <Defines> */
+
+#define MAIN_THERMISTOR_VOLTAGE    622000L /* uV, thermistor at 25 degC (R0 = 10 kOhm) */
+
+/* </Defines> */
+
+
+/* <Declarations (prototypes)> */
+
+/**
+ * ADC inputs of a load with nothing connected
+ *
+ * @param input - multiplexer setting of the conversion
+ *
+ * @return - Input voltage in uV
+ */
+static int32_t Main_OpenInput(ADS1x15_Inputs input);
+
+/* </Declarations (prototypes)> */
+
+
+/* <Implementations> */
+
+int main(int argc, char ** argv)
+{
+  if (argc > 1)
+  {
+    int port = open(argv[1], O_RDWR | O_NOCTTY);
+    if (port < 0)
+    {
+      perror(argv[1]);
+      return 1;
+    }
+    HAL_Native_SetSerialFiles(port, port);
+  }
+
+  Devices_Init(&Main_OpenInput);
+  HAL_I2CInit();
+  MightyWatt_Init();
+
+  for (;;)
+  {
+    Devices_Do();
+    HAL_Native_RunTimer();
+    MightyWatt_Do();
+  }
+}
+
+static int32_t Main_OpenInput(ADS1x15_Inputs input)
+{
+  if (input == ADC_T_CHANNEL)
+  {
+    return MAIN_THERMISTOR_VOLTAGE;
+  }
+  return 0;
+}
+
+/* </Implementations> */
@@ -0,0 +1,26 @@
+#!/bin/sh
+# ram-report.sh
+# RAM budget report of the Main sketch for Arduino Uno (2048 bytes of SRAM)
+# Builds the sketch with arduino-cli and lists the statically allocated RAM per symbol, largest first
+#
+# 2018-02-20
+# kaktus circuits
+# GNU GPL v.3
+#
+# Usage: ./ram-report.sh [number of symbols to list, default 30]
+
+SKETCH_DIR="$(cd "$(dirname "$0")/MightyWattR3" && pwd)"
+BUILD_DIR="${BUILD_DIR:-/tmp/MightyWattR3-ram-report}"
+FQBN="${FQBN:-arduino:avr:uno}"
+RAM_SIZE=2048
+COUNT="${1:-30}"
+
+arduino-cli compile --fqbn "$FQBN" --build-path "$BUILD_DIR" "$SKETCH_DIR" > /dev/null || exit 1
+ELF="$BUILD_DIR/MightyWattR3.ino.elf"
+
+echo "Section sizes (bytes):"
+avr-size -A "$ELF" | awk '$1 == ".data" || $1 == ".bss" || $1 == ".noinit" { print "  " $1 "\t" $2; total += $2 } END { print "  static total\t" total " of '"$RAM_SIZE"', " '"$RAM_SIZE"' - total " left for stack and heap" }'
+
+echo
+echo "Largest RAM symbols (bytes, d = initialized, b = zero-initialized):"
+avr-nm --radix=d --size-sort --reverse-sort --print-size --demangle "$ELF" | awk '$3 ~ /^[bBdD]$/ { printf "  %6d  %s  %s\n", $2, tolower($3), substr($0, index($0, $4)) }' | head -n "$COUNT"